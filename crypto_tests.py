@@ -10,6 +10,9 @@ Tests:
     5. Collision Resistance - birthday attack simulation
     6. Strict Avalanche Criterion (SAC)
     7. Bit Independence Criterion (BIC)
+
+For large sample counts use the native driver (same tests and report):
+    make quality && ./harmonia_quality -n 1e7
 """
 
 import hashlib
@@ -9,116 +9,12 @@
  */
 
 #include "harmonia.h"
+#include "harmonia_schedule.h"
+#include "harmonia_stats.h"
+#include "harmonia_iov.h"
 #include <string.h>
 #include <stdio.h>
 
-/* ============================================================================
- * CONSTANTS
- * ============================================================================ */
-
-/* Golden ratio derived constants (Hamming weight ~16) */
-static const uint32_t PHI_CONSTANTS[16] = {
-    0x9E37605A, 0xDAC1E0F2, 0xF287A338, 0xFA8CFC04,
-    0xFD805AA6, 0xCCF29760, 0xFF8184C3, 0xFF850D11,
-    0xCC32476B, 0x98767486, 0xFFF82080, 0x30E4E2F3,
-    0xFCC3ACC1, 0xE5216F38, 0xF30E4CC9, 0x948395F6
-};
-
-/* Reciprocal constants */
-static const uint32_t RECIPROCAL_CONSTANTS[16] = {
-    0x7249217F, 0x5890EB7C, 0x4786B47C, 0x4C51DBE8,
-    0x4E4DA61B, 0x4F76650C, 0x4F2F1A2A, 0x4F6CE289,
-    0x4F1ADF40, 0x4E84BABC, 0x4F22D993, 0x497FA704,
-    0x4F514F19, 0x4E8F43B8, 0x508E2FD9, 0x4B5F94A4
-};
-
-/* Fibonacci sequence */
-static const uint32_t FIBONACCI[12] = {
-    1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144
-};
-
-/* Fibonacci word for round scheduling (A=1, B=0) */
-/* "ABAABABAABAABABAABABAABAABABAABAABABAABABAABAABABAABAABABAABABAAB" */
-static const uint8_t FIBONACCI_WORD[64] = {
-    1,0,1,1,0,1,0,1,1,0,1,1,0,1,0,1,
-    1,0,1,0,1,1,0,1,1,0,1,0,1,1,0,1,
-    1,0,1,0,1,1,0,1,0,1,1,0,1,1,0,1,
-    0,1,1,0,1,1,0,1,0,1,1,0,1,0,1,1
-};
-
-/* Pre-computed quasicrystal rotation table [66][10] */
-static const uint8_t QUASICRYSTAL_ROTATIONS[66][10] = {
-    {14, 11, 5, 4, 11, 13, 11, 5, 3, 10},
-    {5, 11, 13, 11, 4, 5, 11, 13, 11, 5},
-    {20, 6, 11, 2, 5, 21, 7, 10, 1, 5},
-    {14, 18, 7, 7, 17, 14, 18, 9, 9, 15},
-    {6, 12, 18, 1, 3, 10, 9, 16, 2, 6},
-    {16, 2, 6, 14, 13, 18, 6, 11, 10, 11},
-    {19, 15, 14, 17, 3, 12, 12, 16, 2, 12},
-    {16, 20, 6, 12, 4, 7, 6, 16, 8, 9},
-    {16, 1, 6, 6, 21, 11, 10, 5, 5, 4},
-    {14, 16, 16, 5, 12, 19, 11, 10, 21, 2},
-    {11, 16, 14, 9, 17, 20, 8, 19, 10, 10},
-    {18, 3, 10, 13, 13, 1, 20, 20, 18, 4},
-    {4, 5, 11, 13, 11, 5, 4, 11, 13, 11},
-    {13, 10, 3, 5, 12, 13, 11, 4, 5, 11},
-    {12, 3, 5, 19, 5, 11, 2, 5, 20, 7},
-    {5, 5, 20, 15, 18, 7, 6, 18, 14, 18},
-    {20, 21, 21, 5, 14, 18, 1, 2, 8, 11},
-    {3, 20, 15, 16, 21, 4, 16, 14, 17, 5},
-    {10, 6, 10, 1, 16, 13, 14, 1, 15, 13},
-    {21, 17, 18, 11, 5, 11, 14, 2, 2, 12},
-    {20, 17, 2, 17, 18, 19, 15, 7, 13, 6},
-    {21, 1, 7, 7, 5, 18, 19, 19, 13, 1},
-    {11, 19, 2, 19, 15, 17, 3, 20, 8, 7},
-    {13, 10, 16, 20, 3, 8, 18, 8, 5, 2},
-    {12, 13, 10, 4, 5, 11, 13, 11, 4, 5},
-    {2, 6, 12, 13, 10, 3, 6, 12, 13, 10},
-    {5, 18, 4, 13, 3, 5, 19, 5, 12, 2},
-    {1, 16, 17, 5, 4, 20, 15, 18, 6, 6},
-    {17, 1, 17, 20, 21, 20, 3, 15, 19, 1},
-    {17, 13, 15, 5, 1, 16, 15, 20, 2, 18},
-    {1, 10, 19, 8, 3, 14, 4, 17, 12, 11},
-    {9, 15, 3, 4, 18, 16, 6, 10, 15, 15},
-    {2, 21, 3, 12, 5, 8, 19, 14, 11, 3},
-    {1, 15, 17, 1, 14, 14, 21, 15, 19, 12},
-    {2, 12, 20, 13, 13, 2, 5, 14, 19, 18},
-    {15, 10, 19, 10, 15, 10, 21, 3, 7, 2},
-    {10, 3, 6, 12, 13, 10, 3, 6, 12, 13},
-    {12, 13, 9, 2, 7, 12, 13, 10, 3, 6},
-    {2, 15, 4, 5, 18, 3, 13, 3, 5, 19},
-    {16, 2, 1, 2, 16, 17, 4, 3, 21, 15},
-    {21, 21, 19, 16, 2, 19, 20, 20, 18, 2},
-    {9, 12, 7, 18, 12, 13, 7, 3, 17, 14},
-    {21, 3, 14, 5, 13, 20, 7, 21, 17, 6},
-    {2, 18, 20, 6, 10, 9, 8, 18, 13, 1},
-    {6, 3, 15, 8, 1, 19, 3, 14, 15, 20},
-    {6, 1, 5, 8, 8, 5, 1, 6, 1, 15},
-    {2, 7, 17, 21, 18, 18, 14, 6, 2, 12},
-    {4, 4, 9, 9, 8, 15, 6, 19, 4, 21},
-    {7, 12, 13, 10, 2, 6, 12, 13, 10, 3},
-    {9, 1, 7, 12, 13, 9, 2, 7, 12, 13},
-    {4, 4, 16, 1, 15, 4, 5, 17, 2, 14},
-    {3, 4, 17, 16, 2, 1, 2, 16, 17, 3},
-    {18, 12, 7, 1, 1, 19, 15, 4, 20, 21},
-    {12, 19, 9, 7, 14, 9, 18, 12, 12, 9},
-    {3, 17, 21, 21, 1, 11, 8, 15, 20, 5},
-    {21, 17, 13, 7, 21, 21, 4, 5, 14, 12},
-    {3, 6, 1, 1, 15, 3, 14, 1, 14, 16},
-    {15, 21, 15, 14, 1, 17, 15, 1, 14, 1},
-    {17, 13, 5, 21, 8, 9, 20, 3, 16, 16},
-    {2, 3, 8, 18, 18, 13, 2, 6, 11, 1},
-    {13, 9, 1, 7, 12, 13, 9, 2, 7, 12},
-    {8, 13, 13, 8, 1, 8, 13, 13, 9, 2},
-    {15, 2, 17, 4, 4, 16, 1, 15, 4, 4},
-    {18, 15, 20, 4, 5, 17, 16, 1, 2, 3},
-    {12, 5, 2, 17, 11, 8, 2, 1, 18, 14},
-    {6, 21, 1, 14, 20, 8, 5, 17, 10, 19}
-};
-
-/* PHI for penrose_index calculation (fixed-point approximation) */
-#define PHI_FIXED 0x19E3779B9ULL  /* φ * 2^32 */
-
 /* ============================================================================
  * PRIMITIVE OPERATIONS
  * ============================================================================ */
@@ -141,18 +37,21 @@ static inline uint32_t penrose_index(int n) {
  * MIXING FUNCTIONS
  * ============================================================================ */
 
-static void mix_golden(uint32_t *a, uint32_t *b, uint32_t k, int r, int i) {
-    uint32_t rot1, rot2, mix;
+/*
+ * Rotation amounts are passed in resolved: rot1 = quasicrystal_rotation(r, i),
+ * rot2 = quasicrystal_rotation(r + 1, i + 1). With the schedule expanded inline
+ * these are compile-time constants.
+ */
+static inline void mix_golden(uint32_t *a, uint32_t *b, uint32_t k, uint32_t rot1, uint32_t rot2) {
+    uint32_t mix;
     uint32_t va = *a, vb = *b;  /* Work on copies to handle a==b case */
 
     /* Phase 1 */
-    rot1 = quasicrystal_rotation(r, i);
     va = ROTR32(va, rot1);
     va = (va + vb);
     va ^= k;
 
     /* Phase 2 */
-    rot2 = quasicrystal_rotation(r + 1, i + 1);
     vb = ROTL32(vb, rot2);
     vb ^= va;
     vb = (vb + k);
@@ -166,34 +65,39 @@ static void mix_golden(uint32_t *a, uint32_t *b, uint32_t k, int r, int i) {
     *b = vb;
 }
 
-static void mix_complementary(uint32_t *a, uint32_t *b, uint32_t k, int r, int i) {
+static inline void mix_complementary(uint32_t *a, uint32_t *b, uint32_t k, uint32_t rot1, uint32_t rot2) {
     uint32_t va = *a, vb = *b;  /* Work on copies to handle a==b case */
 
     va ^= vb;
-    va = ROTL32(va, quasicrystal_rotation(r, i));
+    va = ROTL32(va, rot1);
     va = (va + (k >> 1));
 
     vb = (vb + va);
-    vb = ROTR32(vb, quasicrystal_rotation(r + 1, i + 1));
+    vb = ROTR32(vb, rot2);
     vb ^= (k >> 1);
 
     *a = va;
     *b = vb;
 }
 
-static void exchange_quasi_periodic(uint32_t *g, uint32_t *c, int r, int round_type) {
+/*
+ * mask bit i is set where penrose_index(r + i) % 3 == 0. Written out per
+ * word: as a loop, AVX2 builds vectorize it into masked 8-word updates that
+ * force g and c out of registers every round (about 4x slower).
+ */
+static inline void exchange_quasi_periodic(uint32_t *g, uint32_t *c, int round_type, unsigned mask) {
     uint32_t temp;
-    int i, pi;
 
     if (round_type == 1) {  /* Type A - intensive */
-        for (i = 0; i < 8; i++) {
-            pi = penrose_index(r + i);
-            if (pi % 3 == 0) {
-                temp = g[i] ^ c[i];
-                g[i] += (temp >> 8);
-                c[i] += (temp & 0xFF00);
-            }
+#define EXCHANGE_WORD(i) \
+        if (mask & (1u << (i))) { \
+            temp = g[i] ^ c[i]; \
+            g[i] += (temp >> 8); \
+            c[i] += (temp & 0xFF00); \
         }
+        EXCHANGE_WORD(0) EXCHANGE_WORD(1) EXCHANGE_WORD(2) EXCHANGE_WORD(3)
+        EXCHANGE_WORD(4) EXCHANGE_WORD(5) EXCHANGE_WORD(6) EXCHANGE_WORD(7)
+#undef EXCHANGE_WORD
     } else {  /* Type B - light (edges only) */
         temp = g[0] ^ c[7];
         g[0] ^= (temp >> 16);
@@ -201,17 +105,15 @@ static void exchange_quasi_periodic(uint32_t *g, uint32_t *c, int r, int round_t
     }
 }
 
-static void edge_protection(uint32_t *s, int r) {
-    uint32_t rot_l, rot_r, fib_const, interaction;
+static inline void edge_protection_rot(uint32_t *s, uint32_t rot_l, uint32_t rot_r,
+                                       uint32_t fib_const) {
+    uint32_t interaction;
 
     /* Left edge */
-    rot_l = quasicrystal_rotation(r, 0);
     s[0] = ROTR32(s[0], rot_l);
-    fib_const = FIBONACCI[r % 12] * 0x9E3779B9U;
     s[0] ^= fib_const;
 
     /* Right edge */
-    rot_r = quasicrystal_rotation(r, 7);
     s[7] = ROTL32(s[7], rot_r);
     s[7] ^= ~fib_const;
 
@@ -221,76 +123,208 @@ static void edge_protection(uint32_t *s, int r) {
     s[7] += interaction;
 }
 
+static void edge_protection(uint32_t *s, int r) {
+    edge_protection_rot(s, quasicrystal_rotation(r, 0), quasicrystal_rotation(r, 7),
+                        FIBONACCI[r % 12] * 0x9E3779B9U);
+}
+
 /* ============================================================================
  * CORE FUNCTIONS
  * ============================================================================ */
 
-static void compress(const uint8_t *block, uint32_t *state_g, uint32_t *state_c) {
-    uint32_t words[64];
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+}
+
+/* ============================================================================
+ * MESSAGE EXPANSION
+ * ============================================================================ */
+
+/* Expand words[0..15] to 64 words */
+static inline void expand_words(uint32_t *words) {
+#define EXPAND(idx, rot1, rot2, shift) \
+    words[idx] = ROTR32(words[(idx) - 2], rot1) ^ ROTL32(words[(idx) - 7], rot2) ^ \
+                 (words[(idx) - 15] >> (shift)) ^ words[(idx) - 16];
+    EXPANSION_SCHEDULE(EXPAND)
+#undef EXPAND
+}
+
+/* ============================================================================
+ * COMPRESSION
+ * ============================================================================ */
+
+/*
+ * Compress one block given as 16 big-endian message words in words[0..15],
+ * running the first `rounds` rounds of the schedule. Always called with a
+ * constant round count, so the rounds past it fold away and each caller
+ * gets its own fully unrolled kernel.
+ *
+ * Every index, rotation and round type is a literal, so the kernel is
+ * straight-line code: no branches and no loads or stores at data-dependent
+ * addresses (constant-time, which the HMAC use relies on).
+ */
+static inline __attribute__((always_inline)) void compress_rounds(uint32_t *words, uint32_t *state_g,
+                                                                  uint32_t *state_c, const int rounds) {
     uint32_t g[8], c[8];
-    int r, i, j, idx;
-    uint32_t w1, w2, w3, w4, rot1, rot2, shift;
+
+    /* Expand to 64 words */
+    expand_words(words);
+
+    /* Initialize working state, word by word: g and c become 16 scalars */
+#define LOAD_WORD(k) g[k] = state_g[k]; c[k] = state_c[k];
+    LOAD_WORD(0) LOAD_WORD(1) LOAD_WORD(2) LOAD_WORD(3)
+    LOAD_WORD(4) LOAD_WORD(5) LOAD_WORD(6) LOAD_WORD(7)
+#undef LOAD_WORD
+
+    /* 64 rounds (fewer for the reduced-round kernels) */
+#define ROUND(r, i, j, type, g_rot1, g_rot2, c_rot1, c_rot2, xmask, edge_l, edge_r) \
+    if ((r) >= rounds) { \
+    } else if (type) {  /* Golden round */ \
+        mix_golden(&g[i], &g[j], PHI_CONSTANTS[(r) & 15], g_rot1, g_rot2); \
+        g[i] += words[r]; \
+        mix_golden(&c[i], &c[j], RECIPROCAL_CONSTANTS[(r) & 15], c_rot1, c_rot2); \
+        c[j] += words[63 - (r)]; \
+    } else {  /* Complementary round */ \
+        mix_complementary(&g[i], &g[j], PHI_CONSTANTS[(r) & 15], g_rot1, g_rot2); \
+        g[j] += words[r]; \
+        mix_complementary(&c[j], &c[i], RECIPROCAL_CONSTANTS[(r) & 15], c_rot1, c_rot2); \
+        c[i] += words[63 - (r)]; \
+    } \
+    if ((r) < rounds) { \
+        exchange_quasi_periodic(g, c, type, xmask); \
+    } \
+    if ((r) < rounds && ((r) & 7) == 7) {  /* Edge protection every 8 rounds */ \
+        edge_protection_rot(g, edge_l, edge_r, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+        edge_protection_rot(c, edge_l, edge_r, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+    }
+    ROUND_SCHEDULE(ROUND)
+#undef ROUND
+
+    /*
+     * Davies-Meyer construction. Unrolled like the load: as a loop it is
+     * vectorized behind a state_g/state_c overlap check, the only branch
+     * left in the kernel.
+     */
+#define FEED_WORD(k) state_g[k] += g[k]; state_c[k] += c[k];
+    FEED_WORD(0) FEED_WORD(1) FEED_WORD(2) FEED_WORD(3)
+    FEED_WORD(4) FEED_WORD(5) FEED_WORD(6) FEED_WORD(7)
+#undef FEED_WORD
+}
+
+static void compress_words(uint32_t *words, uint32_t *state_g, uint32_t *state_c) {
+    compress_rounds(words, state_g, state_c, 64);
+}
+
+static inline void compress(const uint8_t *block, uint32_t *state_g, uint32_t *state_c) {
+    uint32_t words[64];
+    int i;
 
     /* Parse block into 16 words (big-endian) */
     for (i = 0; i < 16; i++) {
-        words[i] = ((uint32_t)block[i*4] << 24) |
-                   ((uint32_t)block[i*4+1] << 16) |
-                   ((uint32_t)block[i*4+2] << 8) |
-                   ((uint32_t)block[i*4+3]);
+        words[i] = load_be32(block + i*4);
     }
+    compress_words(words, state_g, state_c);
+}
 
-    /* Expand to 64 words */
-    for (idx = 16; idx < 64; idx++) {
-        w1 = words[idx - 2];
-        w2 = words[idx - 7];
-        w3 = words[idx - 15];
-        w4 = words[idx - 16];
+/*
+ * Compress nblocks consecutive 64-byte blocks. The chaining state is held in
+ * locals for the whole run and written back once; the next block is
+ * prefetched while the current one is mixed.
+ */
+static void compress_blocks(const uint8_t *data, size_t nblocks,
+                            uint32_t *state_g, uint32_t *state_c) {
+    uint32_t hg[8], hc[8];
 
-        rot1 = quasicrystal_rotation(idx, 0);
-        rot2 = quasicrystal_rotation(idx, 1);
-        shift = (penrose_index(idx) & 0xF) + 1;
+    HARMONIA_PROBE2(compress__start, state_g, nblocks);
+    HARMONIA_STAT(blocks, nblocks);
+    HARMONIA_STAT(scalar_blocks, nblocks);
 
-        words[idx] = ROTR32(w1, rot1) ^ ROTL32(w2, rot2) ^ (w3 >> shift) ^ w4;
+    memcpy(hg, state_g, 32);
+    memcpy(hc, state_c, 32);
+
+    while (nblocks-- > 0) {
+        __builtin_prefetch(data + 64);
+        compress(data, hg, hc);
+        data += 64;
     }
 
-    /* Initialize working state */
-    memcpy(g, state_g, 32);
-    memcpy(c, state_c, 32);
+    memcpy(state_g, hg, 32);
+    memcpy(state_c, hc, 32);
 
-    /* 64 rounds */
-    for (r = 0; r < 64; r++) {
-        int round_type = FIBONACCI_WORD[r];
+    HARMONIA_PROBE2(compress__done, state_g, data);
+}
 
-        i = r & 7;
-        j = (r + FIBONACCI[r % 12]) & 7;
+/*
+ * Pad the last n (< 64) bytes of a total_len-byte message into message
+ * words, built directly from the tail: n <= 55 fits one block, 56..63
+ * needs a second block holding only the length. Returns the block count.
+ */
+static int pad_tail(const uint8_t *tail, size_t n, uint64_t total_len, uint32_t words[2][64]) {
+    uint64_t bit_len = total_len * 8;
+    size_t i, full = n / 4;
+    int last = (n >= 56);
 
-        if (round_type == 1) {  /* Golden round */
-            mix_golden(&g[i], &g[j], PHI_CONSTANTS[r & 15], r, i);
-            g[i] += words[r];
+    for (i = 0; i < 16; i++) {
+        words[0][i] = 0;
+        words[last][i] = 0;
+    }
+    for (i = 0; i < full; i++) {
+        words[0][i] = load_be32(tail + i*4);
+    }
+    for (i = full * 4; i < n; i++) {
+        words[0][i / 4] |= (uint32_t)tail[i] << (24 - 8 * (i & 3));
+    }
+    words[0][n / 4] |= 0x80U << (24 - 8 * (n & 3));
 
-            mix_golden(&c[i], &c[j], RECIPROCAL_CONSTANTS[r & 15], r, i);
-            c[j] += words[63 - r];
-        } else {  /* Complementary round */
-            mix_complementary(&g[i], &g[j], PHI_CONSTANTS[r & 15], r, i);
-            g[j] += words[r];
+    words[last][14] = (uint32_t)(bit_len >> 32);
+    words[last][15] = (uint32_t)bit_len;
+    return last + 1;
+}
 
-            mix_complementary(&c[j], &c[i], RECIPROCAL_CONSTANTS[r & 15], r, j);
-            c[i] += words[63 - r];
-        }
+/* Pad and compress the tail of a message */
+static void compress_tail(const uint8_t *tail, size_t n, uint64_t total_len,
+                          uint32_t *state_g, uint32_t *state_c) {
+    uint32_t words[2][64];
+    int b, nblocks = pad_tail(tail, n, total_len, words);
 
-        exchange_quasi_periodic(g, c, r, round_type);
+    HARMONIA_STAT(blocks, nblocks);
+    HARMONIA_STAT(scalar_blocks, nblocks);
+    HARMONIA_STAT(pad_blocks, nblocks);
 
-        /* Edge protection every 8 rounds */
-        if ((r & 7) == 7) {
-            edge_protection(g, r);
-            edge_protection(c, r);
-        }
+    for (b = 0; b < nblocks; b++) {
+        compress_words(words[b], state_g, state_c);
     }
+}
+
+/* Final edge protection and stream fusion */
+static void finalize(const uint32_t *state_g, const uint32_t *state_c, uint8_t *digest) {
+    uint32_t g[8], c[8];
+    uint32_t rot, g_rot, c_rot, fused;
+    int i;
+
+    HARMONIA_STAT(digests, 1);
+
+    /* Final edge protection */
+    memcpy(g, state_g, 32);
+    memcpy(c, state_c, 32);
+    edge_protection(g, 64);
+    edge_protection(c, 65);
 
-    /* Davies-Meyer construction */
+    /* Fuse streams */
     for (i = 0; i < 8; i++) {
-        state_g[i] += g[i];
-        state_c[i] += c[i];
+        rot = quasicrystal_rotation(i, i);
+        g_rot = ROTR32(g[i], rot);
+        c_rot = ROTL32(c[i], rot);
+
+        fused = g_rot ^ c_rot;
+        fused += PHI_CONSTANTS[i] + (penrose_index(i) * 0x01010101U);
+
+        /* Output big-endian */
+        digest[i*4 + 0] = (fused >> 24) & 0xFF;
+        digest[i*4 + 1] = (fused >> 16) & 0xFF;
+        digest[i*4 + 2] = (fused >> 8) & 0xFF;
+        digest[i*4 + 3] = fused & 0xFF;
     }
 }
 
@@ -309,6 +343,7 @@ void harmonia_init(harmonia_ctx *ctx) {
 }
 
 void harmonia_update(harmonia_ctx *ctx, const uint8_t *data, size_t len) {
+    HARMONIA_STAT(updates, 1);
     ctx->total_len += len;
 
     /* If we have buffered data, try to complete a block */
@@ -316,86 +351,68 @@ void harmonia_update(harmonia_ctx *ctx, const uint8_t *data, size_t len) {
         size_t needed = 64 - ctx->buffer_len;
         if (len >= needed) {
             memcpy(ctx->buffer + ctx->buffer_len, data, needed);
-            compress(ctx->buffer, ctx->state_g, ctx->state_c);
+            HARMONIA_STAT(buffer_copies, 1);
+            HARMONIA_STAT(buffer_bytes, needed);
+            compress_blocks(ctx->buffer, 1, ctx->state_g, ctx->state_c);
             data += needed;
             len -= needed;
             ctx->buffer_len = 0;
         } else {
             memcpy(ctx->buffer + ctx->buffer_len, data, len);
+            HARMONIA_STAT(buffer_copies, 1);
+            HARMONIA_STAT(buffer_bytes, len);
             ctx->buffer_len += len;
             return;
         }
     }
 
     /* Process complete blocks */
-    while (len >= 64) {
-        compress(data, ctx->state_g, ctx->state_c);
-        data += 64;
-        len -= 64;
+    if (len >= 64) {
+        compress_blocks(data, len / 64, ctx->state_g, ctx->state_c);
+        data += len & ~(size_t)63;
+        len &= 63;
     }
 
     /* Buffer remaining data */
     if (len > 0) {
         memcpy(ctx->buffer, data, len);
+        HARMONIA_STAT(buffer_copies, 1);
+        HARMONIA_STAT(buffer_bytes, len);
         ctx->buffer_len = len;
     }
 }
 
-void harmonia_final(harmonia_ctx *ctx, uint8_t *digest) {
-    uint8_t pad[128];
-    size_t pad_len;
-    uint64_t bit_len;
-    uint32_t g[8], c[8];
-    int i;
-    uint32_t rot, g_rot, c_rot, fused;
-
-    /* Calculate padding */
-    bit_len = ctx->total_len * 8;
-    pad_len = (ctx->buffer_len < 56) ? (56 - ctx->buffer_len) : (120 - ctx->buffer_len);
-
-    memset(pad, 0, pad_len + 8);
-    pad[0] = 0x80;
-
-    /* Append length (big-endian) */
-    pad[pad_len + 0] = (bit_len >> 56) & 0xFF;
-    pad[pad_len + 1] = (bit_len >> 48) & 0xFF;
-    pad[pad_len + 2] = (bit_len >> 40) & 0xFF;
-    pad[pad_len + 3] = (bit_len >> 32) & 0xFF;
-    pad[pad_len + 4] = (bit_len >> 24) & 0xFF;
-    pad[pad_len + 5] = (bit_len >> 16) & 0xFF;
-    pad[pad_len + 6] = (bit_len >> 8) & 0xFF;
-    pad[pad_len + 7] = bit_len & 0xFF;
-
-    harmonia_update(ctx, pad, pad_len + 8);
+void harmonia_updatev(harmonia_ctx *ctx, const struct iovec *iov, int iovcnt) {
+    ctx->total_len += harmonia_iov_absorb(iov, iovcnt, ctx->buffer, &ctx->buffer_len,
+                                          ctx->state_g, ctx->state_c, compress_blocks);
+}
 
-    /* Final edge protection */
-    memcpy(g, ctx->state_g, 32);
-    memcpy(c, ctx->state_c, 32);
-    edge_protection(g, 64);
-    edge_protection(c, 65);
+void harmonia_final(harmonia_ctx *ctx, uint8_t *digest) {
+    HARMONIA_PROBE2(final__start, ctx, digest);
+    compress_tail(ctx->buffer, ctx->buffer_len, ctx->total_len, ctx->state_g, ctx->state_c);
+    finalize(ctx->state_g, ctx->state_c, digest);
+    HARMONIA_PROBE2(final__done, ctx, digest);
+}
 
-    /* Fuse streams */
-    for (i = 0; i < 8; i++) {
-        rot = quasicrystal_rotation(i, i);
-        g_rot = ROTR32(g[i], rot);
-        c_rot = ROTL32(c[i], rot);
+/*
+ * One-shot hash without a context: full blocks go straight to the
+ * multi-block kernel and the tail is padded in place, so short messages
+ * (one block up to 55 bytes, two up to 119) cost only their compressions.
+ */
+void harmonia(const uint8_t *data, size_t len, uint8_t *digest) {
+    uint32_t state_g[8], state_c[8];
+    size_t full = len & ~(size_t)63;
 
-        fused = g_rot ^ c_rot;
-        fused += PHI_CONSTANTS[i] + (penrose_index(i) * 0x01010101U);
+    memcpy(state_g, PHI_CONSTANTS, 32);
+    memcpy(state_c, RECIPROCAL_CONSTANTS, 32);
 
-        /* Output big-endian */
-        digest[i*4 + 0] = (fused >> 24) & 0xFF;
-        digest[i*4 + 1] = (fused >> 16) & 0xFF;
-        digest[i*4 + 2] = (fused >> 8) & 0xFF;
-        digest[i*4 + 3] = fused & 0xFF;
+    if (full) {
+        compress_blocks(data, full / 64, state_g, state_c);
     }
-}
-
-void harmonia(const uint8_t *data, size_t len, uint8_t *digest) {
-    harmonia_ctx ctx;
-    harmonia_init(&ctx);
-    harmonia_update(&ctx, data, len);
-    harmonia_final(&ctx, digest);
+    HARMONIA_PROBE2(final__start, state_g, digest);
+    compress_tail(data + full, len - full, len, state_g, state_c);
+    finalize(state_g, state_c, digest);
+    HARMONIA_PROBE2(final__done, state_g, digest);
 }
 
 void harmonia_hex(const uint8_t *data, size_t len, char *hex_digest) {
@@ -410,10 +427,258 @@ void harmonia_hex(const uint8_t *data, size_t len, char *hex_digest) {
     hex_digest[64] = '\0';
 }
 
+/* ============================================================================
+ * REDUCED-ROUND KERNELS
+ * ============================================================================ */
+
+/*
+ * The v2.2 compressor truncated to every multiple of 8 rounds (the edge
+ * protection period), each instance fully unrolled. 64 is the full hash.
+ */
+#define REDUCED_ROUNDS(X) X(8) X(16) X(24) X(32) X(40) X(48) X(56) X(64)
+
+typedef void (*compress_words_fn)(uint32_t *words, uint32_t *state_g, uint32_t *state_c);
+
+#define DEFINE_REDUCED(n) \
+    static void compress_words_r##n(uint32_t *words, uint32_t *state_g, uint32_t *state_c) { \
+        compress_rounds(words, state_g, state_c, n); \
+    }
+REDUCED_ROUNDS(DEFINE_REDUCED)
+#undef DEFINE_REDUCED
+
+static compress_words_fn reduced_kernel(int rounds) {
+    switch (rounds) {
+#define REDUCED_CASE(n) case n: return compress_words_r##n;
+    REDUCED_ROUNDS(REDUCED_CASE)
+#undef REDUCED_CASE
+    default: return NULL;
+    }
+}
+
+int harmonia_compress_rounds(uint32_t *state_g, uint32_t *state_c, const uint8_t *block, int rounds) {
+    compress_words_fn fn = reduced_kernel(rounds);
+    uint32_t words[64];
+    int i;
+
+    if (fn == NULL) {
+        return -1;
+    }
+    for (i = 0; i < 16; i++) {
+        words[i] = load_be32(block + i*4);
+    }
+    fn(words, state_g, state_c);
+    return 0;
+}
+
+int harmonia_rounds(const uint8_t *data, size_t len, uint8_t *digest, int rounds) {
+    compress_words_fn fn = reduced_kernel(rounds);
+    uint32_t state_g[8], state_c[8], words[2][64];
+    size_t pos;
+    int b, i, nblocks;
+
+    if (fn == NULL) {
+        return -1;
+    }
+
+    memcpy(state_g, PHI_CONSTANTS, 32);
+    memcpy(state_c, RECIPROCAL_CONSTANTS, 32);
+
+    for (pos = 0; len - pos >= 64; pos += 64) {
+        for (i = 0; i < 16; i++) {
+            words[0][i] = load_be32(data + pos + i*4);
+        }
+        fn(words[0], state_g, state_c);
+    }
+    nblocks = pad_tail(data + pos, len - pos, len, words);
+    for (b = 0; b < nblocks; b++) {
+        fn(words[b], state_g, state_c);
+    }
+    finalize(state_g, state_c, digest);
+    return 0;
+}
+
 /* ============================================================================
  * SELF-TEST
  * ============================================================================ */
 
+/* Check the resolved schedule against the per-index formulas it replaces */
+static int schedule_self_check(void) {
+    int errors = 0;
+
+#define CHECK_EXPAND(idx, rot1, rot2, shift) \
+    errors += (rot1) != quasicrystal_rotation(idx, 0) || \
+              (rot2) != quasicrystal_rotation(idx, 1) || \
+              (shift) != (penrose_index(idx) & 0xF) + 1;
+    EXPANSION_SCHEDULE(CHECK_EXPAND)
+#undef CHECK_EXPAND
+
+#define CHECK_ROUND(r, i, j, type, g_rot1, g_rot2, c_rot1, c_rot2, xmask, edge_l, edge_r) \
+    { \
+        int ci = (type) ? (i) : (j); \
+        unsigned mask = 0; \
+        int k; \
+        for (k = 0; k < 8 && (type); k++) { \
+            if (penrose_index((r) + k) % 3 == 0) mask |= 1u << k; \
+        } \
+        errors += (type) != FIBONACCI_WORD[r] || (i) != ((r) & 7) || \
+                  (j) != (((r) + FIBONACCI[(r) % 12]) & 7) || \
+                  (g_rot1) != quasicrystal_rotation(r, i) || \
+                  (g_rot2) != quasicrystal_rotation((r) + 1, (i) + 1) || \
+                  (c_rot1) != quasicrystal_rotation(r, ci) || \
+                  (c_rot2) != quasicrystal_rotation((r) + 1, ci + 1) || \
+                  (xmask) != mask; \
+        if (((r) & 7) == 7) { \
+            errors += (edge_l) != quasicrystal_rotation(r, 0) || \
+                      (edge_r) != quasicrystal_rotation(r, 7); \
+        } \
+    }
+    ROUND_SCHEDULE(CHECK_ROUND)
+#undef CHECK_ROUND
+
+#define CHECK_EDGE(r) \
+    errors += (rot_l) != quasicrystal_rotation(r, 0) || (rot_r) != quasicrystal_rotation(r, 7) || \
+              (fib) != FIBONACCI[(r) % 12];
+#define CHECK_EDGE_G(rot_l_, rot_r_, fib_) { int rot_l = rot_l_, rot_r = rot_r_; uint32_t fib = fib_; CHECK_EDGE(64) }
+#define CHECK_EDGE_C(rot_l_, rot_r_, fib_) { int rot_l = rot_l_, rot_r = rot_r_; uint32_t fib = fib_; CHECK_EDGE(65) }
+    FINAL_EDGE_G(CHECK_EDGE_G)
+    FINAL_EDGE_C(CHECK_EDGE_C)
+#undef CHECK_EDGE_G
+#undef CHECK_EDGE_C
+#undef CHECK_EDGE
+
+#define CHECK_FUSION(i, rot, penrose) \
+    errors += (rot) != quasicrystal_rotation(i, i) || (penrose) != penrose_index(i);
+    FUSION_SCHEDULE(CHECK_FUSION)
+#undef CHECK_FUSION
+
+    return errors;
+}
+
+/*
+ * Hash every length 0..129 (one and two block tails, block boundaries) and
+ * compare the digest of the concatenated digests with harmonia.py; the
+ * streaming API (7-byte updates) must agree with the one-shot path.
+ */
+static int padding_self_check(void) {
+    static const char *expected =
+        "b28905d7cf569852df54cb615e5ebc94dc9658c33113e9067abde32a5641105f";
+    uint8_t msg[129], digests[130 * 32], stream[32];
+    char hex[65];
+    harmonia_ctx ctx;
+    size_t n, pos;
+    int errors = 0;
+
+    for (n = 0; n < sizeof(msg); n++) {
+        msg[n] = (uint8_t)(n * 7 + 1);
+    }
+
+    for (n = 0; n <= sizeof(msg); n++) {
+        harmonia(msg, n, digests + n * 32);
+
+        harmonia_init(&ctx);
+        for (pos = 0; pos < n; pos += 7) {
+            harmonia_update(&ctx, msg + pos, n - pos < 7 ? n - pos : 7);
+        }
+        harmonia_final(&ctx, stream);
+        errors += memcmp(stream, digests + n * 32, 32) != 0;
+    }
+
+    harmonia_hex(digests, sizeof(digests), hex);
+    errors += strcmp(hex, expected) != 0;
+
+    /* A midstate copy continues independently of the original */
+    harmonia_init(&ctx);
+    harmonia_update(&ctx, msg, 70);
+    {
+        harmonia_ctx clone;
+        harmonia_ctx_copy(&clone, &ctx);
+        harmonia_update(&clone, msg + 70, 59);
+        harmonia_final(&clone, stream);
+        errors += memcmp(stream, digests + 129 * 32, 32) != 0;
+        harmonia_update(&ctx, msg + 70, 10);
+        harmonia_final(&ctx, stream);
+        errors += memcmp(stream, digests + 80 * 32, 32) != 0;
+    }
+    return errors;
+}
+
+/*
+ * harmonia_updatev over fragment chains (empty, short, block-spanning and
+ * multi-block fragments, after 0..69 buffered bytes) against harmonia().
+ */
+static int updatev_self_check(void) {
+    static const size_t sizes[] = {0, 1, 3, 64, 0, 5, 63, 17, 130, 2, 71};
+    uint8_t msg[400], expected[32], stream[32];
+    struct iovec iov[16];
+    harmonia_ctx ctx;
+    size_t n, pos, head;
+    int k, errors = 0;
+
+    for (n = 0; n < sizeof(msg); n++) {
+        msg[n] = (uint8_t)(n * 7 + 1);
+    }
+
+    for (n = 0; n <= sizeof(msg); n += 13) {
+        harmonia(msg, n, expected);
+        for (head = 0; head < 70 && head <= n; head += 23) {
+            harmonia_init(&ctx);
+            harmonia_update(&ctx, msg, head);
+            for (pos = head, k = 0; pos < n; k++) {
+                size_t size = (k == 15) ? n - pos : sizes[(k + head) % 11];
+                if (size > n - pos) size = n - pos;
+                iov[k].iov_base = (void *)(msg + pos);
+                iov[k].iov_len = size;
+                pos += size;
+            }
+            harmonia_updatev(&ctx, iov, k);
+            harmonia_final(&ctx, stream);
+            errors += memcmp(stream, expected, 32) != 0;
+        }
+    }
+    return errors;
+}
+
+/*
+ * Reduced-round digests (same 0..129 length sweep as padding_self_check)
+ * against harmonia.py with its round loop cut to r rounds.
+ */
+static int rounds_self_check(void) {
+    static const struct {
+        int rounds;
+        const char *expected;
+    } vectors[] = {
+        { 8, "2db85bd518eb42f0c06582d391c67241ccfbc50c0d3738b89943ae0e8c8a13ec"},
+        {16, "7b8ce34ed916aede9c1865a07516ce77b7fe03b38c28a97032e7379486eeaca2"},
+        {24, "e7d1ef1678a04c1c773114cf403b47914ce040fa5a4df2fe640068bdadf432e2"},
+        {32, "4b75d4c5512498a712d657e516c085a7049a829227316cdf19049b9cbbf6e4e9"},
+        {40, "1866cf3b09ac3a74539eb7390a2b774d91453a9d8b3cc0fc2354f7b8fcac7822"},
+        {48, "3d31ba752a6d888f15c87ae141feaffbc1085b9a16fec931ec082333b6cd7fb1"},
+        {56, "3eecae76f86fdf2247c0f925580489412098746f03c236f4b6665e0742fe127f"},
+        {64, "b28905d7cf569852df54cb615e5ebc94dc9658c33113e9067abde32a5641105f"}
+    };
+    uint8_t msg[129], digests[130 * 32];
+    uint32_t g[8] = {0}, c[8] = {0};
+    char hex[65];
+    size_t n, v;
+    int errors = 0;
+
+    for (n = 0; n < sizeof(msg); n++) {
+        msg[n] = (uint8_t)(n * 7 + 1);
+    }
+
+    for (v = 0; v < sizeof(vectors) / sizeof(vectors[0]); v++) {
+        for (n = 0; n <= sizeof(msg); n++) {
+            errors += harmonia_rounds(msg, n, digests + n * 32, vectors[v].rounds) != 0;
+        }
+        harmonia_hex(digests, sizeof(digests), hex);
+        errors += strcmp(hex, vectors[v].expected) != 0;
+    }
+
+    errors += harmonia_rounds(msg, 1, digests, 12) != -1;
+    errors += harmonia_compress_rounds(g, c, msg, 0) != -1;
+    return errors;
+}
+
 int harmonia_self_test(void) {
     static const struct {
         const char *input;
@@ -448,6 +713,34 @@ int harmonia_self_test(void) {
         }
     }
 
+    if (padding_self_check() == 0) {
+        printf("  [PASS] padding boundaries (lengths 0..129, one-shot, streaming, ctx copy)\n");
+    } else {
+        printf("  [FAIL] padding boundaries\n");
+        passed = 0;
+    }
+
+    if (updatev_self_check() == 0) {
+        printf("  [PASS] scatter/gather updatev\n");
+    } else {
+        printf("  [FAIL] scatter/gather updatev\n");
+        passed = 0;
+    }
+
+    if (schedule_self_check() == 0) {
+        printf("  [PASS] compression schedule\n");
+    } else {
+        printf("  [FAIL] compression schedule does not match QUASICRYSTAL_ROTATIONS\n");
+        passed = 0;
+    }
+
+    if (rounds_self_check() == 0) {
+        printf("  [PASS] reduced rounds (8, 16, ..., 64)\n");
+    } else {
+        printf("  [FAIL] reduced rounds\n");
+        passed = 0;
+    }
+
     printf("============================================================\n");
     printf("Result: %s\n", passed ? "PASS" : "FAIL");
 
@@ -12,6 +12,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/uio.h>
 
 #define HARMONIA_BLOCK_SIZE   64   /* 512 bits */
 #define HARMONIA_DIGEST_SIZE  32   /* 256 bits */
@@ -26,12 +27,27 @@ typedef struct {
     size_t   buffer_len;      /* Bytes in buffer */
 } harmonia_ctx;
 
+/*
+ * Copy a context, e.g. a midstate snapshot after absorbing a shared prefix:
+ * the copy and the original continue independently.
+ */
+static inline void harmonia_ctx_copy(harmonia_ctx *dst, const harmonia_ctx *src) {
+    *dst = *src;
+}
+
 /* Initialize context */
 void harmonia_init(harmonia_ctx *ctx);
 
 /* Update context with data */
 void harmonia_update(harmonia_ctx *ctx, const uint8_t *data, size_t len);
 
+/*
+ * Update context with the concatenation of iovcnt fragments. Blocks inside
+ * a fragment are compressed in place; only blocks spanning fragments are
+ * assembled, and only the trailing partial block is buffered.
+ */
+void harmonia_updatev(harmonia_ctx *ctx, const struct iovec *iov, int iovcnt);
+
 /* Finalize and get digest */
 void harmonia_final(harmonia_ctx *ctx, uint8_t *digest);
 
@@ -41,6 +57,61 @@ void harmonia(const uint8_t *data, size_t len, uint8_t *digest);
 /* One-shot hash returning hex string (must provide 65-byte buffer) */
 void harmonia_hex(const uint8_t *data, size_t len, char *hex_digest);
 
+/*
+ * Reduced-round v2.2 for cryptanalysis: the same hash with its compressor
+ * cut to the first `rounds` rounds (8, 16, 24, ..., 64; 64 is harmonia()).
+ * Return 0, or -1 for an unsupported round count. Provided by harmonia.c
+ * (not by the runtime-dispatched harmonia_simd.c).
+ */
+int harmonia_rounds(const uint8_t *data, size_t len, uint8_t *digest, int rounds);
+
+/* One block into the chaining state (no padding, no finalization) */
+int harmonia_compress_rounds(uint32_t *state_g, uint32_t *state_c, const uint8_t *block, int rounds);
+
+/* ============================================================================
+ * MULTI-BUFFER HASHING (harmonia_multi.c)
+ * ============================================================================
+ *
+ * Independent messages hashed side by side, one per SIMD lane (AVX-512
+ * x16, AVX2 x8, SSE4.1 / NEON x4, picked at runtime). Digests equal
+ * harmonia() of each message.
+ */
+
+/* Hash 4 / 8 messages of the same length */
+void harmonia_x4(const uint8_t *msgs[4], size_t len, uint8_t *digests[4]);
+void harmonia_x8(const uint8_t *msgs[8], size_t len, uint8_t *digests[8]);
+
+/*
+ * Hash n messages of arbitrary lengths, keeping every lane busy.
+ * digests must hold n * HARMONIA_DIGEST_SIZE bytes (digest k at 32*k).
+ */
+void harmonia_multi(const uint8_t *const *msgs, const size_t *lens, uint8_t *digests, size_t n);
+
+/*
+ * Hash prefix || suffixes[k] for n suffixes. prefix is a context that has
+ * absorbed the shared prefix (harmonia_init/update, not finalized); every
+ * lane resumes from its midstate, so the prefix blocks are compressed once
+ * rather than per message. The context is not modified.
+ */
+void harmonia_multi_prefixed(const harmonia_ctx *prefix, const uint8_t *const *suffixes,
+                             const size_t *lens, uint8_t *digests, size_t n);
+
+/*
+ * Check n stored digests: message k against expected + 32*k, hashed on the
+ * lanes by nthreads threads (0 = one per online CPU). Each digest is
+ * compared as it is finalized and never written out. The indices of the
+ * messages that do not match are written to mismatches (room for n) in
+ * ascending order; returns their count.
+ */
+size_t harmonia_multi_verify(const uint8_t *const *msgs, const size_t *lens, const uint8_t *expected,
+                             size_t n, size_t *mismatches, int nthreads);
+
+/* Name of the lane kernel in use, e.g. "AVX2 x8" */
+const char *harmonia_multi_engine(void);
+
+/* Returns 0 on success, non-zero on failure */
+int harmonia_multi_self_test(void);
+
 /* Self-test function */
 int harmonia_self_test(void);
 
@@ -374,7 +374,8 @@ def _init_state() -> Tuple[List[int], List[int]]:
 def _compress(
     block: bytes, 
     state_g: List[int], 
-    state_c: List[int]
+    state_c: List[int],
+    rounds: int = NUM_ROUNDS
 ) -> Tuple[List[int], List[int]]:
     """
     Compress one 512-bit block into the state.
@@ -384,6 +385,8 @@ def _compress(
         - 64 rounds with Fibonacci word scheduling (A/B types)
         - Dual-stream processing with periodic exchange
         - Edge protection every 8 rounds
+
+    rounds < 64 runs only the first rounds rounds (reduced-round analysis).
     """
     # Parse block into 16 words
     words = list(struct.unpack('>16I', block))
@@ -413,7 +416,7 @@ def _compress(
     c = state_c.copy()
     
     # 64 rounds with quasi-periodic scheduling
-    for r in range(NUM_ROUNDS):
+    for r in range(rounds):
         round_type = FIBONACCI_WORD[r]
         
         i = r & 7  # r % 8
@@ -507,6 +510,27 @@ def harmonia(message: bytes) -> bytes:
     return _finalize(state_g, state_c)
 
 
+def harmonia_rounds(message: bytes, rounds: int) -> bytes:
+    """
+    HARMONIA with the compressor cut to its first rounds rounds, for
+    reduced-round analysis (matches harmonia_rounds() in harmonia.c, which
+    accepts the multiples of 8 from 8 to 64).
+    """
+    if not isinstance(message, (bytes, bytearray)):
+        raise TypeError("message must be bytes or bytearray")
+    if rounds % 8 != 0 or not 8 <= rounds <= NUM_ROUNDS:
+        raise ValueError(f"unsupported round count {rounds} (multiples of 8 up to {NUM_ROUNDS})")
+
+    padded = _pad_message(message)
+    state_g, state_c = _init_state()
+
+    for i in range(0, len(padded), BLOCK_SIZE):
+        block = padded[i:i + BLOCK_SIZE]
+        state_g, state_c = _compress(block, state_g, state_c, rounds)
+
+    return _finalize(state_g, state_c)
+
+
 def harmonia_hex(message: bytes) -> str:
     """
     Compute the HARMONIA hash and return as hexadecimal string.
@@ -581,6 +605,20 @@ def self_test() -> bool:
         print("  ✗ Avalanche effect out of range")
         all_passed = False
     
+    # Reduced rounds: the round counts harmonia.c accepts, and no others
+    print("\nReduced Rounds:")
+    rejected = 0
+    for bad in (0, 1, 4, 12, 63, 72):
+        try:
+            harmonia_rounds(b"test", bad)
+        except ValueError:
+            rejected += 1
+    if rejected == 6 and harmonia_rounds(b"test", NUM_ROUNDS) == h1:
+        print("  ✓ 8, 16, ..., 64 only (as harmonia.c)")
+    else:
+        print("  ✗ round count validation differs from harmonia.c")
+        all_passed = False
+
     print("=" * 60)
     print("Result:", "PASS" if all_passed else "FAIL")
     
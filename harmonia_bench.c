@@ -0,0 +1,469 @@
+/*
+ * HARMONIA - Unified Benchmark Harness
+ *
+ * Measures every engine with one method so results are comparable across
+ * variants and releases:
+ *   - each sample times one hash call with the CPU counter (rdtsc on x86,
+ *     cntvct_el0 on AArch64, clock_gettime elsewhere)
+ *   - per (engine, size): median and p99 latency, cycles/byte, MB/s
+ *   - message sizes from 16 B to 64 MB over pseudo-random input
+ *   - text table by default, JSON with --json for regression tracking
+ *
+ * The counter is calibrated against CLOCK_MONOTONIC. On x86 the TSC rate is
+ * the nominal core clock, so counter ticks are reported as cycles; on ARM the
+ * generic timer runs slower than the core, so pass --ghz to convert to core
+ * cycles (otherwise cycles_per_byte is counter ticks per byte).
+ *
+ * Build: make bench (OpenSSL SHA-256 baseline with USE_OPENSSL=1, BLAKE3 with
+ * USE_BLAKE3=1). harmonia.c and harmonia_simd.c export the same v2.2 symbols;
+ * BENCH_V22=harmonia_simd.c benchmarks the latter instead.
+ *
+ * License: MIT
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "harmonia.h"
+#include "harmonia_ng.h"
+#include "harmonia_xof.h"
+#include "harmonia_fast.h"
+
+#ifdef USE_OPENSSL
+#include <openssl/sha.h>
+#endif
+
+#ifdef USE_BLAKE3
+#include <blake3.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define MAX_SAMPLES     100000
+#define MIN_SAMPLES     5
+#define MAX_LANES       16
+#define LANE_STRIDE     64          /* multi-buffer lanes start LANE_STRIDE apart */
+#define STREAM_CHUNK    65536
+
+/* ============================================================================
+ * TIMING
+ * ============================================================================ */
+
+static const char *counter_name(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return "rdtsc";
+#elif defined(__aarch64__)
+    return "cntvct_el0";
+#else
+    return "clock_gettime";
+#endif
+}
+
+static inline uint64_t read_counter(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t v;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(v) :: "memory");
+    return v;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static double monotonic_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Counter ticks per second, measured over ~50 ms */
+static double calibrate_counter(void)
+{
+    double t0 = monotonic_sec(), t1;
+    uint64_t c0 = read_counter(), c1;
+
+    do {
+        t1 = monotonic_sec();
+    } while (t1 - t0 < 0.05);
+    c1 = read_counter();
+
+    return (double)(c1 - c0) / (t1 - t0);
+}
+
+/* ============================================================================
+ * ENGINES
+ * ============================================================================ */
+
+/*
+ * One hash call over `lanes` messages of `len` bytes each; lane k starts at
+ * data + k * LANE_STRIDE. Bytes processed per call = lanes * len.
+ */
+typedef void (*bench_fn)(const uint8_t *data, size_t len);
+
+typedef struct {
+    const char *name;
+    const char *description;
+    int lanes;
+    bench_fn run;
+} bench_engine;
+
+/* Digests are written here so the calls cannot be optimized away */
+static uint8_t sink[MAX_LANES][32];
+
+static void run_harmonia(const uint8_t *data, size_t len)
+{
+    harmonia(data, len, sink[0]);
+}
+
+static void run_harmonia_stream(const uint8_t *data, size_t len)
+{
+    harmonia_ctx ctx;
+    size_t pos;
+
+    harmonia_init(&ctx);
+    for (pos = 0; pos < len; pos += STREAM_CHUNK) {
+        harmonia_update(&ctx, data + pos, len - pos < STREAM_CHUNK ? len - pos : STREAM_CHUNK);
+    }
+    harmonia_final(&ctx, sink[0]);
+}
+
+static void run_harmonia_fast(const uint8_t *data, size_t len)
+{
+    harmonia_fast(data, len, sink[0]);
+}
+
+static void run_ng_scalar(const uint8_t *data, size_t len)
+{
+    harmonia_ng(data, len, sink[0]);
+}
+
+static void run_ng_simd(const uint8_t *data, size_t len)
+{
+    harmonia_ng_simd(data, len, sink[0]);
+}
+
+static void run_ng_stream(const uint8_t *data, size_t len)
+{
+    harmonia_ng_ctx ctx;
+    size_t pos;
+
+    harmonia_ng_simd_init(&ctx);
+    for (pos = 0; pos < len; pos += STREAM_CHUNK) {
+        harmonia_ng_simd_update(&ctx, data + pos, len - pos < STREAM_CHUNK ? len - pos : STREAM_CHUNK);
+    }
+    harmonia_ng_simd_final(&ctx, sink[0]);
+}
+
+static void lanes_setup(const uint8_t *data, int n, const uint8_t **msgs, uint8_t **digests)
+{
+    int k;
+
+    for (k = 0; k < n; k++) {
+        msgs[k] = data + (size_t)k * LANE_STRIDE;
+        digests[k] = sink[k];
+    }
+}
+
+static void run_ng_x4(const uint8_t *data, size_t len)
+{
+    const uint8_t *msgs[4];
+    uint8_t *digests[4];
+
+    lanes_setup(data, 4, msgs, digests);
+    harmonia_ng_x4(msgs, len, digests);
+}
+
+static void run_ng_x8(const uint8_t *data, size_t len)
+{
+    const uint8_t *msgs[8];
+    uint8_t *digests[8];
+
+    lanes_setup(data, 8, msgs, digests);
+    harmonia_ng_x8(msgs, len, digests);
+}
+
+static void run_ng_x16(const uint8_t *data, size_t len)
+{
+    const uint8_t *msgs[16];
+    uint8_t *digests[16];
+
+    lanes_setup(data, 16, msgs, digests);
+    harmonia_ng_x16(msgs, len, digests);
+}
+
+static void run_ng_tree(const uint8_t *data, size_t len)
+{
+    harmonia_ng_tree(data, len, sink[0], 1);
+}
+
+/* The input read as len / 32 leaf digests */
+static void run_ng_merkle(const uint8_t *data, size_t len)
+{
+    harmonia_ng_merkle_root(data, len / HARMONIA_NG_DIGEST_SIZE, sink[0], 1);
+}
+
+static void run_xof(const uint8_t *data, size_t len)
+{
+    harmonia_xof(data, len, sink[0], 32);
+}
+
+#ifdef USE_OPENSSL
+static void run_sha256(const uint8_t *data, size_t len)
+{
+    SHA256(data, len, sink[0]);
+}
+#endif
+
+#ifdef USE_BLAKE3
+static void run_blake3(const uint8_t *data, size_t len)
+{
+    blake3_hasher hasher;
+
+    blake3_hasher_init(&hasher);
+    blake3_hasher_update(&hasher, data, len);
+    blake3_hasher_finalize(&hasher, sink[0], 32);
+}
+#endif
+
+static const bench_engine ENGINES[] = {
+    {"harmonia",           "HARMONIA v2.2 one-shot",                    1,  run_harmonia},
+    {"harmonia-stream",    "HARMONIA v2.2 init/update(64 KB)/final",    1,  run_harmonia_stream},
+    {"harmonia-fast",      "HARMONIA-Fast (32 rounds)",                 1,  run_harmonia_fast},
+    {"harmonia-ng",        "HARMONIA-NG scalar (harmonia_ng.c)",         1,  run_ng_scalar},
+    {"harmonia-ng-simd",   "HARMONIA-NG optimized one-shot",            1,  run_ng_simd},
+    {"harmonia-ng-stream", "HARMONIA-NG simd init/update(64 KB)/final", 1,  run_ng_stream},
+    {"harmonia-ng-x4",     "HARMONIA-NG 4 messages per call",           4,  run_ng_x4},
+    {"harmonia-ng-x8",     "HARMONIA-NG 8 messages per call",           8,  run_ng_x8},
+    {"harmonia-ng-x16",    "HARMONIA-NG 16 messages per call",          16, run_ng_x16},
+    {"harmonia-ng-tree",   "HARMONIA-NG-Tree, 1 thread",                1,  run_ng_tree},
+    {"harmonia-ng-merkle", "HARMONIA-NG-Merkle root, 32-byte leaves",   1,  run_ng_merkle},
+    {"harmonia-xof",       "HARMONIA-XOF, 32-byte output",              1,  run_xof},
+#ifdef USE_OPENSSL
+    {"sha256",             "OpenSSL SHA-256 (baseline)",                1,  run_sha256},
+#endif
+#ifdef USE_BLAKE3
+    {"blake3",             "BLAKE3 (baseline)",                         1,  run_blake3},
+#endif
+    {NULL, NULL, 0, NULL}
+};
+
+static const size_t DEFAULT_SIZES[] = {
+    16, 64, 256, 1024, 4096, 16384, 65536,
+    1u << 20, 16u << 20, 64u << 20, 0
+};
+
+/* ============================================================================
+ * MEASUREMENT
+ * ============================================================================ */
+
+typedef struct {
+    size_t samples;
+    double median_ns;
+    double p99_ns;
+    double cycles_per_byte;
+    double mb_per_s;
+} bench_result;
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static uint64_t percentile(const uint64_t *sorted, size_t n, double p)
+{
+    size_t rank = (size_t)(p / 100.0 * n + 0.999999);
+    if (rank < 1) rank = 1;
+    if (rank > n) rank = n;
+    return sorted[rank - 1];
+}
+
+static void measure(const bench_engine *e, const uint8_t *data, size_t len,
+                    double budget_sec, double counter_hz, double cycles_per_tick,
+                    uint64_t *samples, bench_result *out)
+{
+    double bytes = (double)len * e->lanes;
+    double deadline;
+    uint64_t t0, t1, median;
+    size_t n = 0;
+
+    e->run(data, len);   /* warm-up: caches, lazy backend binding */
+
+    deadline = monotonic_sec() + budget_sec;
+    while (n < MAX_SAMPLES && (n < MIN_SAMPLES || monotonic_sec() < deadline)) {
+        t0 = read_counter();
+        e->run(data, len);
+        t1 = read_counter();
+        samples[n++] = t1 - t0;
+    }
+
+    qsort(samples, n, sizeof(uint64_t), cmp_u64);
+    median = percentile(samples, n, 50.0);
+
+    out->samples = n;
+    out->median_ns = median / counter_hz * 1e9;
+    out->p99_ns = percentile(samples, n, 99.0) / counter_hz * 1e9;
+    out->cycles_per_byte = bytes > 0 ? median * cycles_per_tick / bytes : 0.0;
+    out->mb_per_s = out->median_ns > 0 ? bytes / (out->median_ns / 1e9) / (1024.0 * 1024.0) : 0.0;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+static void usage(const char *prog)
+{
+    const bench_engine *e;
+
+    fprintf(stderr,
+            "Usage: %s [--json] [--engines a,b,...] [--sizes n,n,...] [--max-size n]\n"
+            "          [--budget-ms n] [--ghz f]\n\nEngines:\n", prog);
+    for (e = ENGINES; e->name; e++) {
+        fprintf(stderr, "  %-20s %s\n", e->name, e->description);
+    }
+}
+
+/* Is name in the comma-separated list (NULL list = all)? */
+static int selected(const char *list, const char *name)
+{
+    size_t n = strlen(name);
+    const char *p = list;
+
+    if (list == NULL) return 1;
+    while ((p = strstr(p, name)) != NULL) {
+        if ((p == list || p[-1] == ',') && (p[n] == ',' || p[n] == '\0')) return 1;
+        p += n;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *engine_list = NULL;
+    size_t sizes[32];
+    size_t max_size = 0, max_len = 0, nsizes = 0;
+    double budget_sec = 0.2, ghz = 0.0, counter_hz, cycles_per_tick;
+    int json = 0, first = 1;
+    const bench_engine *e;
+    uint64_t *samples;
+    uint8_t *data;
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    size_t i, s, alloc;
+
+    for (i = 0; DEFAULT_SIZES[i]; i++) sizes[nsizes++] = DEFAULT_SIZES[i];
+
+    for (i = 1; i < (size_t)argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--engines") == 0 && i + 1 < (size_t)argc) {
+            engine_list = argv[++i];
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < (size_t)argc) {
+            char *p = argv[++i];
+            nsizes = 0;
+            while (*p && nsizes < 32) {
+                sizes[nsizes++] = (size_t)strtoull(p, &p, 10);
+                if (*p == ',') p++;
+            }
+        } else if (strcmp(argv[i], "--max-size") == 0 && i + 1 < (size_t)argc) {
+            max_size = (size_t)strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--budget-ms") == 0 && i + 1 < (size_t)argc) {
+            budget_sec = atof(argv[++i]) / 1000.0;
+        } else if (strcmp(argv[i], "--ghz") == 0 && i + 1 < (size_t)argc) {
+            ghz = atof(argv[++i]);
+        } else {
+            usage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    if (max_size) {
+        size_t kept = 0;
+        for (s = 0; s < nsizes; s++) {
+            if (sizes[s] <= max_size) sizes[kept++] = sizes[s];
+        }
+        nsizes = kept;
+    }
+    for (s = 0; s < nsizes; s++) {
+        if (sizes[s] > max_len) max_len = sizes[s];
+    }
+
+    /* One buffer serves every lane: lane k reads [k * LANE_STRIDE, +len) */
+    alloc = max_len + (MAX_LANES - 1) * LANE_STRIDE;
+    data = (uint8_t *)malloc(alloc);
+    samples = (uint64_t *)malloc(MAX_SAMPLES * sizeof(uint64_t));
+    if (!data || !samples) {
+        fprintf(stderr, "Memory allocation failed\n");
+        return 1;
+    }
+    for (i = 0; i < alloc; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;   /* xorshift64 */
+        data[i] = (uint8_t)(x >> 56);
+    }
+
+    counter_hz = calibrate_counter();
+    if (ghz > 0) {
+        cycles_per_tick = ghz * 1e9 / counter_hz;
+    } else {
+        cycles_per_tick = 1.0;
+    }
+
+    if (json) {
+        printf("{\n  \"harmonia_version\": \"%s\",\n", HARMONIA_VERSION);
+        printf("  \"counter\": \"%s\",\n  \"counter_hz\": %.0f,\n", counter_name(), counter_hz);
+        printf("  \"cycles_per_tick\": %.6f,\n  \"budget_ms\": %.0f,\n", cycles_per_tick, budget_sec * 1000);
+        printf("  \"results\": [");
+    } else {
+        printf("HARMONIA Benchmark Harness (v%s, counter %s @ %.0f MHz)\n",
+               HARMONIA_VERSION, counter_name(), counter_hz / 1e6);
+        printf("==============================================================================\n");
+        printf("  %-20s %10s %8s %12s %12s %10s %10s\n",
+               "engine", "size", "samples", "median ns", "p99 ns", "cyc/byte", "MB/s");
+    }
+
+    for (e = ENGINES; e->name; e++) {
+        if (!selected(engine_list, e->name)) continue;
+
+        for (s = 0; s < nsizes; s++) {
+            bench_result r;
+
+            measure(e, data, sizes[s], budget_sec, counter_hz, cycles_per_tick, samples, &r);
+
+            if (json) {
+                printf("%s\n    {\"engine\": \"%s\", \"lanes\": %d, \"size\": %zu, \"samples\": %zu, "
+                       "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"cycles_per_byte\": %.3f, "
+                       "\"mb_per_s\": %.2f}",
+                       first ? "" : ",", e->name, e->lanes, sizes[s], r.samples,
+                       r.median_ns, r.p99_ns, r.cycles_per_byte, r.mb_per_s);
+                first = 0;
+            } else {
+                printf("  %-20s %10zu %8zu %12.1f %12.1f %10.2f %10.2f\n",
+                       e->name, sizes[s], r.samples, r.median_ns, r.p99_ns,
+                       r.cycles_per_byte, r.mb_per_s);
+            }
+            fflush(stdout);
+        }
+    }
+
+    if (json) {
+        printf("\n  ]\n}\n");
+    } else {
+        printf("==============================================================================\n");
+        printf("size = bytes per message; x4/x8/x16 hash lanes x size bytes per call\n");
+    }
+
+    free(samples);
+    free(data);
+    return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * HARMONIA - Shared Constants
+ *
+ * The constant tables common to the v2.2 and NG engines, and the NG round
+ * schedule, kept in one place so that every implementation (the reference
+ * and SIMD sources, the XOF, the CUDA kernel and harmonia_ng_inline.h)
+ * reads the same values. Must match the Python implementations.
+ *
+ * The tables are static: every translation unit gets its own copy, which the
+ * compiler drops when unused and constant-folds when indexed by a literal.
+ * HARMONIA_CONST is the storage class; the CUDA kernel defines it as
+ * __constant__ before including this header.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_CONSTANTS_H
+#define HARMONIA_CONSTANTS_H
+
+#include <stdint.h>
+
+#ifndef HARMONIA_CONST
+#define HARMONIA_CONST static const
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+/* Golden ratio derived constants (Hamming weight ~16); the v2.2 golden IV */
+HARMONIA_CONST uint32_t PHI_CONSTANTS[16] = {
+    0x9E37605A, 0xDAC1E0F2, 0xF287A338, 0xFA8CFC04,
+    0xFD805AA6, 0xCCF29760, 0xFF8184C3, 0xFF850D11,
+    0xCC32476B, 0x98767486, 0xFFF82080, 0x30E4E2F3,
+    0xFCC3ACC1, 0xE5216F38, 0xF30E4CC9, 0x948395F6
+};
+
+/* Reciprocal constants (derived from 1/φ); the v2.2 complementary IV */
+HARMONIA_CONST uint32_t RECIPROCAL_CONSTANTS[16] = {
+    0x7249217F, 0x5890EB7C, 0x4786B47C, 0x4C51DBE8,
+    0x4E4DA61B, 0x4F76650C, 0x4F2F1A2A, 0x4F6CE289,
+    0x4F1ADF40, 0x4E84BABC, 0x4F22D993, 0x497FA704,
+    0x4F514F19, 0x4E8F43B8, 0x508E2FD9, 0x4B5F94A4
+};
+
+/* Fibonacci sequence (first 12 values) */
+HARMONIA_CONST uint32_t FIBONACCI[12] = {
+    1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144
+};
+
+/* ============================================================================
+ * HARMONIA-NG
+ * ============================================================================ */
+
+/* Initial hash values (golden stream) */
+HARMONIA_CONST uint32_t NG_INITIAL_HASH_G[8] = {
+    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
+    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
+};
+
+/* Initial hash values (complementary stream) */
+HARMONIA_CONST uint32_t NG_INITIAL_HASH_C[8] = {
+    0x9E3779B9, 0x7F4A7C15, 0xF39CC060, 0x5CEDC834,
+    0x2FE12A6D, 0x4786B47C, 0xC8A5E2F0, 0x3A8D6B7F
+};
+
+/*
+ * Rotation schedule, X(round, r1, r2, r3, r4) per round. Generated from the
+ * Fibonacci word with rotation sets A=(7,12,8,16), B=(5,11,9,13); must match
+ * Python harmonia_ng._generate_rotation_schedule() exactly.
+ */
+#define NG_ROTATION_SCHEDULE(X) \
+    X( 0, 12,  8, 16,  7)   /* A */ \
+    X( 1, 11,  9, 13,  5)   /* B */ \
+    X( 2,  8, 16,  7, 12)   /* A */ \
+    X( 3, 16,  7, 12,  8)   /* A */ \
+    X( 4, 11,  9, 13,  5)   /* B */ \
+    X( 5,  7, 12,  8, 16)   /* A */ \
+    X( 6, 11,  9, 13,  5)   /* B */ \
+    X( 7, 12,  8, 16,  7)   /* A */ \
+    X( 8,  8, 16,  7, 12)   /* A */ \
+    X( 9, 13,  5, 11,  9)   /* B */ \
+    X(10, 12,  8, 16,  7)   /* A */ \
+    X(11,  7, 12,  8, 16)   /* A */ \
+    X(12, 11,  9, 13,  5)   /* B */ \
+    X(13, 12,  8, 16,  7)   /* A */ \
+    X(14,  9, 13,  5, 11)   /* B */ \
+    X(15, 16,  7, 12,  8)   /* A */ \
+    X(16, 12,  8, 16,  7)   /* A */ \
+    X(17,  5, 11,  9, 13)   /* B */ \
+    X(18, 12,  8, 16,  7)   /* A */ \
+    X(19, 11,  9, 13,  5)   /* B */ \
+    X(20,  8, 16,  7, 12)   /* A */ \
+    X(21, 16,  7, 12,  8)   /* A */ \
+    X(22, 11,  9, 13,  5)   /* B */ \
+    X(23,  7, 12,  8, 16)   /* A */ \
+    X(24, 12,  8, 16,  7)   /* A */ \
+    X(25, 11,  9, 13,  5)   /* B */ \
+    X(26,  8, 16,  7, 12)   /* A */ \
+    X(27, 13,  5, 11,  9)   /* B */ \
+    X(28, 12,  8, 16,  7)   /* A */ \
+    X(29,  7, 12,  8, 16)   /* A */ \
+    X(30, 11,  9, 13,  5)   /* B */ \
+    X(31, 12,  8, 16,  7)   /* A */
+
+/* Fixed rotations for edge protection */
+#define EDGE_ROT_LEFT  7
+#define EDGE_ROT_RIGHT 13
+
+/* Fixed rotation for cross-stream diffusion */
+#define CROSS_STREAM_ROT 11
+
+#endif /* HARMONIA_CONSTANTS_H */
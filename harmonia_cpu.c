@@ -0,0 +1,78 @@
+/*
+ * HARMONIA - CPU Feature Detection
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include "harmonia_cpu.h"
+#include <stdlib.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static unsigned probe_features(void)
+{
+    unsigned features = 0;
+
+#if defined(HARMONIA_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) features |= HARMONIA_CPU_SSE41;
+    if (__builtin_cpu_supports("avx2"))   features |= HARMONIA_CPU_AVX2;
+    if (__builtin_cpu_supports("avx512f") && (features & HARMONIA_CPU_AVX2)) {
+        features |= HARMONIA_CPU_AVX512;
+    }
+#elif defined(HARMONIA_ARM_NEON)
+#if defined(__linux__) && defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMD) features |= HARMONIA_CPU_NEON;
+#elif defined(__linux__) && defined(__arm__)
+    if (getauxval(AT_HWCAP) & HWCAP_NEON) features |= HARMONIA_CPU_NEON;
+#else
+    /* Compiled with NEON enabled and no OS probe available: trust the target */
+    features |= HARMONIA_CPU_NEON;
+#endif
+#endif
+
+    return features;
+}
+
+/* Marks the cached word as valid; kept in the same word as the feature bits
+ * so concurrent first calls either see nothing or the complete result */
+#define CPU_PROBED 0x80000000u
+
+unsigned harmonia_cpu_features(void)
+{
+    static volatile unsigned cached = 0;
+    unsigned f = cached;
+
+    if (!(f & CPU_PROBED)) {
+        const char *mask = getenv("HARMONIA_CPU_MASK");
+
+        f = probe_features();
+        if (mask != NULL && *mask != '\0') {
+            f &= (unsigned)strtoul(mask, NULL, 0);
+        }
+        f |= CPU_PROBED;
+        cached = f;
+    }
+    return f & ~CPU_PROBED;
+}
+
+int harmonia_cpu_count(void)
+{
+    long n;
+
+#ifdef __linux__
+    cpu_set_t set;
+
+    if (sched_getaffinity(0, sizeof(set), &set) == 0 && CPU_COUNT(&set) > 0) {
+        return CPU_COUNT(&set);
+    }
+#endif
+    n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (n > 0) ? (int)n : 1;
+}
@@ -0,0 +1,59 @@
+/*
+ * HARMONIA - CPU Feature Detection
+ *
+ * Runtime probing of the SIMD instruction sets used by the vectorized
+ * kernels, so one portable binary can bind the fastest implementation
+ * available on the host.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_CPU_H
+#define HARMONIA_CPU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Feature bits returned by harmonia_cpu_features() */
+#define HARMONIA_CPU_NEON    0x01u   /* ARM Advanced SIMD */
+#define HARMONIA_CPU_SSE41   0x02u   /* x86 SSE4.1 (implies SSSE3) */
+#define HARMONIA_CPU_AVX2    0x04u   /* x86 AVX2 */
+#define HARMONIA_CPU_AVX512  0x08u   /* x86 AVX-512F */
+
+/*
+ * x86 kernels are compiled per function with target attributes, so they are
+ * available regardless of -march and only ever called after a runtime check.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define HARMONIA_X86 1
+#define HARMONIA_TARGET_SSE41  __attribute__((target("sse4.1")))
+#define HARMONIA_TARGET_AVX2   __attribute__((target("avx2")))
+#define HARMONIA_TARGET_AVX512 __attribute__((target("avx512f,avx2")))
+#endif
+
+/* NEON is a compile-time property on ARM (baseline on AArch64) */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HARMONIA_ARM_NEON 1
+#endif
+
+/*
+ * Return the supported feature bits. The CPU is probed once and the result
+ * cached. Setting the environment variable HARMONIA_CPU_MASK (e.g. "0" or
+ * "0x4") before the first call restricts the result, which lets tests and
+ * benchmarks exercise the narrower backends on a wide machine.
+ */
+unsigned harmonia_cpu_features(void);
+
+/*
+ * Number of CPUs this process may run on: the affinity mask on Linux, so
+ * taskset and cpusets are respected, otherwise the online CPU count.
+ * Always at least 1; used wherever a thread count of 0 means "all CPUs".
+ */
+int harmonia_cpu_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARMONIA_CPU_H */
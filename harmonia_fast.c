@@ -11,37 +11,20 @@
 #include <stddef.h>
 #include <string.h>
 #include <stdio.h>
-
-#define HARMONIA_FAST_BLOCK_SIZE  64
-#define HARMONIA_FAST_DIGEST_SIZE 32
-#define HARMONIA_FAST_ROUNDS      32
-#define HARMONIA_FAST_VERSION     "1.0"
+#include "harmonia_fast.h"
+#include "harmonia_constants.h"
+#include "harmonia_cpu.h"
+
+#if defined(HARMONIA_X86)
+#include <immintrin.h>
+#elif defined(HARMONIA_ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 /* Bit rotation macros */
 #define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
 #define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
 
-/* Fibonacci sequence */
-static const uint32_t FIBONACCI[12] = {
-    1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144
-};
-
-/* PHI constants */
-static const uint32_t PHI_CONSTANTS[16] = {
-    0x9E37605A, 0xDAC1E0F2, 0xF287A338, 0xFA8CFC04,
-    0xFD805AA6, 0xCCF29760, 0xFF8184C3, 0xFF850D11,
-    0xCC32476B, 0x98767486, 0xFFF82080, 0x30E4E2F3,
-    0xFCC3ACC1, 0xE5216F38, 0xF30E4CC9, 0x948395F6
-};
-
-/* Reciprocal constants */
-static const uint32_t RECIPROCAL_CONSTANTS[16] = {
-    0x7249217F, 0x5890EB7C, 0x4786B47C, 0x4C51DBE8,
-    0x4E4DA61B, 0x4F76650C, 0x4F2F1A2A, 0x4F6CE289,
-    0x4F1ADF40, 0x4E84BABC, 0x4F22D993, 0x497FA704,
-    0x4F514F19, 0x4E8F43B8, 0x508E2FD9, 0x4B5F94A4
-};
-
 /* Fibonacci word for 32 rounds */
 static const char FIBONACCI_WORD[32] = "ABAABABAABAABABAABABAABAABABAAB";
 
@@ -179,25 +162,172 @@ static void parse_block(const uint8_t *block, uint32_t *w) {
     }
 }
 
-/* Expand message schedule */
-static void expand_message(uint32_t *w) {
+/*
+ * Expansion constants for words 16..31: rot1 = qc_rotation(i, 0),
+ * rot2 = qc_rotation(i, 1) and FIBONACCI[penrose_index(i) % 12], resolved
+ * ahead of time (checked against the formulas by the self-test).
+ */
+#define EXPAND_WORDS (HARMONIA_FAST_ROUNDS - 16)
+
+static const uint32_t EXPAND_ROT1[EXPAND_WORDS] __attribute__((aligned(16))) = {
+    9, 4, 15, 21, 7, 1, 13, 5, 9, 18, 15, 3, 17, 13, 2, 11
+};
+static const uint32_t EXPAND_ROT2[EXPAND_WORDS] __attribute__((aligned(16))) = {
+    4, 15, 5, 14, 16, 6, 21, 18, 19, 4, 18, 21, 7, 1, 13, 18
+};
+static const uint32_t EXPAND_FIB[EXPAND_WORDS] __attribute__((aligned(16))) = {
+    5, 144, 13, 3, 34, 144, 2, 1, 1, 55, 2, 1, 5, 8, 13, 3
+};
+
+/* Expand message schedule, one word at a time (reference) */
+static void expand_message_scalar(uint32_t *w) {
     int i;
-    uint32_t s0, s1, rot1, rot2, fib_idx, fib_factor;
+    uint32_t s0, s1, rot1, rot2;
 
     for (i = 16; i < HARMONIA_FAST_ROUNDS; i++) {
-        rot1 = qc_rotation(i, 0);
-        rot2 = qc_rotation(i, 1);
+        rot1 = EXPAND_ROT1[i - 16];
+        rot2 = EXPAND_ROT2[i - 16];
 
         s0 = ROTR32(w[i-15], rot1) ^ ROTR32(w[i-15], rot1 + 5) ^ (w[i-15] >> 3);
         s1 = ROTR32(w[i-2], rot2) ^ ROTR32(w[i-2], rot2 + 7) ^ (w[i-2] >> 10);
 
-        fib_idx = penrose_index(i);
-        fib_factor = FIBONACCI[fib_idx % 12];
+        w[i] = w[i-16] + s0 + w[i-7] + s1 + EXPAND_FIB[i - 16];
+    }
+}
+
+/*
+ * Vector expansion, four words per step, on AVX2 or NEON when
+ * harmonia_cpu_features() reports it (HARMONIA_SCALAR_EXPAND opts out).
+ * Within a group only s1(w[i-2]) of the last two lanes depends on the
+ * group itself, so the group is summed without it and the last two lanes
+ * get s1 of the first two in a second pass.
+ */
+#if defined(HARMONIA_SCALAR_EXPAND)
+/* scalar only */
+#elif defined(HARMONIA_X86)
+#define HARMONIA_VECTOR_EXPAND "AVX2"
+
+HARMONIA_TARGET_AVX2
+static inline __m128i rotr_lanes(__m128i x, __m128i n) {
+    return _mm_or_si128(_mm_srlv_epi32(x, n), _mm_sllv_epi32(x, _mm_sub_epi32(_mm_set1_epi32(32), n)));
+}
 
-        w[i] = w[i-16] + s0 + w[i-7] + s1 + fib_factor;
+HARMONIA_TARGET_AVX2
+static inline __m128i sigma1_lanes(__m128i x, __m128i rot2) {
+    return _mm_xor_si128(_mm_xor_si128(rotr_lanes(x, rot2),
+                                       rotr_lanes(x, _mm_add_epi32(rot2, _mm_set1_epi32(7)))),
+                         _mm_srli_epi32(x, 10));
+}
+
+HARMONIA_TARGET_AVX2
+static void expand_message_vector(uint32_t *w) {
+    const __m128i low = _mm_setr_epi32(-1, -1, 0, 0);
+    const __m128i high = _mm_setr_epi32(0, 0, -1, -1);
+    __m128i v0 = _mm_loadu_si128((const __m128i *)(w + 0));
+    __m128i v1 = _mm_loadu_si128((const __m128i *)(w + 4));
+    __m128i v2 = _mm_loadu_si128((const __m128i *)(w + 8));
+    __m128i v3 = _mm_loadu_si128((const __m128i *)(w + 12));
+    int k;
+
+    for (k = 0; k < EXPAND_WORDS; k += 4) {
+        __m128i rot1 = _mm_load_si128((const __m128i *)(EXPAND_ROT1 + k));
+        __m128i rot2 = _mm_load_si128((const __m128i *)(EXPAND_ROT2 + k));
+        __m128i w15 = _mm_alignr_epi8(v1, v0, 4);
+        __m128i w7 = _mm_alignr_epi8(v3, v2, 4);
+        __m128i s0, t;
+
+        s0 = _mm_xor_si128(_mm_xor_si128(rotr_lanes(w15, rot1),
+                                         rotr_lanes(w15, _mm_add_epi32(rot1, _mm_set1_epi32(5)))),
+                           _mm_srli_epi32(w15, 3));
+        t = _mm_add_epi32(_mm_add_epi32(v0, s0),
+                          _mm_add_epi32(w7, _mm_load_si128((const __m128i *)(EXPAND_FIB + k))));
+
+        /* Lanes 0-1 take w[i-2] from the previous group, lanes 2-3 from this one */
+        t = _mm_add_epi32(t, _mm_and_si128(sigma1_lanes(_mm_shuffle_epi32(v3, _MM_SHUFFLE(3, 2, 3, 2)), rot2), low));
+        t = _mm_add_epi32(t, _mm_and_si128(sigma1_lanes(_mm_shuffle_epi32(t, _MM_SHUFFLE(1, 0, 1, 0)), rot2), high));
+
+        _mm_storeu_si128((__m128i *)(w + 16 + k), t);
+        v0 = v1;
+        v1 = v2;
+        v2 = v3;
+        v3 = t;
     }
 }
 
+#elif defined(HARMONIA_ARM_NEON)
+#define HARMONIA_VECTOR_EXPAND "NEON"
+
+static inline uint32x4_t rotr_lanes(uint32x4_t x, uint32x4_t n) {
+    int32x4_t right = vnegq_s32(vreinterpretq_s32_u32(n));
+    int32x4_t left = vaddq_s32(right, vdupq_n_s32(32));
+    return vorrq_u32(vshlq_u32(x, right), vshlq_u32(x, left));
+}
+
+static inline uint32x4_t sigma1_lanes(uint32x4_t x, uint32x4_t rot2) {
+    return veorq_u32(veorq_u32(rotr_lanes(x, rot2), rotr_lanes(x, vaddq_u32(rot2, vdupq_n_u32(7)))),
+                     vshrq_n_u32(x, 10));
+}
+
+static void expand_message_vector(uint32_t *w) {
+    const uint32x4_t low = vcombine_u32(vdup_n_u32(0xFFFFFFFFU), vdup_n_u32(0));
+    const uint32x4_t high = vcombine_u32(vdup_n_u32(0), vdup_n_u32(0xFFFFFFFFU));
+    uint32x4_t v0 = vld1q_u32(w + 0);
+    uint32x4_t v1 = vld1q_u32(w + 4);
+    uint32x4_t v2 = vld1q_u32(w + 8);
+    uint32x4_t v3 = vld1q_u32(w + 12);
+    int k;
+
+    for (k = 0; k < EXPAND_WORDS; k += 4) {
+        uint32x4_t rot1 = vld1q_u32(EXPAND_ROT1 + k);
+        uint32x4_t rot2 = vld1q_u32(EXPAND_ROT2 + k);
+        uint32x4_t w15 = vextq_u32(v0, v1, 1);
+        uint32x4_t w7 = vextq_u32(v2, v3, 1);
+        uint32x4_t s0, t;
+
+        s0 = veorq_u32(veorq_u32(rotr_lanes(w15, rot1), rotr_lanes(w15, vaddq_u32(rot1, vdupq_n_u32(5)))),
+                       vshrq_n_u32(w15, 3));
+        t = vaddq_u32(vaddq_u32(v0, s0), vaddq_u32(w7, vld1q_u32(EXPAND_FIB + k)));
+
+        /* Lanes 0-1 take w[i-2] from the previous group, lanes 2-3 from this one */
+        t = vaddq_u32(t, vandq_u32(sigma1_lanes(vcombine_u32(vget_high_u32(v3), vget_high_u32(v3)), rot2), low));
+        t = vaddq_u32(t, vandq_u32(sigma1_lanes(vcombine_u32(vget_low_u32(t), vget_low_u32(t)), rot2), high));
+
+        vst1q_u32(w + 16 + k, t);
+        v0 = v1;
+        v1 = v2;
+        v2 = v3;
+        v3 = t;
+    }
+}
+#endif /* vector expansion */
+
+#ifdef HARMONIA_VECTOR_EXPAND
+#if defined(HARMONIA_X86)
+#define EXPAND_VECTOR_FEATURE HARMONIA_CPU_AVX2
+#else
+#define EXPAND_VECTOR_FEATURE HARMONIA_CPU_NEON
+#endif
+#endif
+
+/* Expand message schedule */
+static void expand_message(uint32_t *w) {
+#ifdef HARMONIA_VECTOR_EXPAND
+    if (harmonia_cpu_features() & EXPAND_VECTOR_FEATURE) {
+        expand_message_vector(w);
+        return;
+    }
+#endif
+    expand_message_scalar(w);
+}
+
+/* Expansion in use, for the self-test */
+static const char *expand_backend(void) {
+#ifdef HARMONIA_VECTOR_EXPAND
+    if (harmonia_cpu_features() & EXPAND_VECTOR_FEATURE) return HARMONIA_VECTOR_EXPAND;
+#endif
+    return "scalar";
+}
+
 /* Compression function */
 static void compress(const uint8_t *block, uint32_t *state_g, uint32_t *state_c) {
     uint32_t w[HARMONIA_FAST_ROUNDS];
@@ -276,32 +406,14 @@ static void finalize(uint32_t *state_g, uint32_t *state_c, uint8_t *digest) {
     }
 }
 
-/* Main hash function */
-void harmonia_fast(const uint8_t *data, size_t len, uint8_t *digest) {
-    uint32_t state_g[8], state_c[8];
+/* Pad and compress the last remaining (< 64) bytes of a len-byte message */
+static void compress_tail(const uint8_t *tail, size_t remaining, uint64_t len,
+                          uint32_t *state_g, uint32_t *state_c) {
     uint8_t buffer[128];
-    size_t remaining = len;
-    size_t offset = 0;
-    size_t pad_len;
-    int i;
-
-    /* Initialize state */
-    for (i = 0; i < 8; i++) {
-        state_g[i] = PHI_CONSTANTS[i];
-        state_c[i] = RECIPROCAL_CONSTANTS[i];
-    }
-
-    /* Process complete blocks */
-    while (remaining >= HARMONIA_FAST_BLOCK_SIZE) {
-        compress(data + offset, state_g, state_c);
-        offset += HARMONIA_FAST_BLOCK_SIZE;
-        remaining -= HARMONIA_FAST_BLOCK_SIZE;
-    }
 
-    /* Padding */
     memset(buffer, 0, 128);
     if (remaining > 0) {
-        memcpy(buffer, data + offset, remaining);
+        memcpy(buffer, tail, remaining);
     }
     buffer[remaining] = 0x80;
 
@@ -324,9 +436,80 @@ void harmonia_fast(const uint8_t *data, size_t len, uint8_t *digest) {
     }
 
     compress(buffer, state_g, state_c);
+}
+
+/* Main hash function */
+void harmonia_fast(const uint8_t *data, size_t len, uint8_t *digest) {
+    uint32_t state_g[8], state_c[8];
+    size_t remaining = len;
+    size_t offset = 0;
+    int i;
+
+    /* Initialize state */
+    for (i = 0; i < 8; i++) {
+        state_g[i] = PHI_CONSTANTS[i];
+        state_c[i] = RECIPROCAL_CONSTANTS[i];
+    }
+
+    /* Process complete blocks */
+    while (remaining >= HARMONIA_FAST_BLOCK_SIZE) {
+        compress(data + offset, state_g, state_c);
+        offset += HARMONIA_FAST_BLOCK_SIZE;
+        remaining -= HARMONIA_FAST_BLOCK_SIZE;
+    }
+
+    compress_tail(data + offset, remaining, len, state_g, state_c);
     finalize(state_g, state_c, digest);
 }
 
+/* Streaming API: same digest as harmonia_fast over the concatenated input */
+void harmonia_fast_init(harmonia_fast_ctx *ctx) {
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        ctx->state_g[i] = PHI_CONSTANTS[i];
+        ctx->state_c[i] = RECIPROCAL_CONSTANTS[i];
+    }
+    ctx->total_len = 0;
+    ctx->buffer_len = 0;
+}
+
+void harmonia_fast_update(harmonia_fast_ctx *ctx, const uint8_t *data, size_t len) {
+    ctx->total_len += len;
+
+    /* Complete a buffered partial block first */
+    if (ctx->buffer_len > 0) {
+        size_t to_copy = HARMONIA_FAST_BLOCK_SIZE - ctx->buffer_len;
+        if (to_copy > len) to_copy = len;
+
+        memcpy(ctx->buffer + ctx->buffer_len, data, to_copy);
+        ctx->buffer_len += to_copy;
+        data += to_copy;
+        len -= to_copy;
+
+        if (ctx->buffer_len < HARMONIA_FAST_BLOCK_SIZE) return;
+        compress(ctx->buffer, ctx->state_g, ctx->state_c);
+        ctx->buffer_len = 0;
+    }
+
+    /* Process full blocks in place */
+    while (len >= HARMONIA_FAST_BLOCK_SIZE) {
+        compress(data, ctx->state_g, ctx->state_c);
+        data += HARMONIA_FAST_BLOCK_SIZE;
+        len -= HARMONIA_FAST_BLOCK_SIZE;
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buffer, data, len);
+        ctx->buffer_len = len;
+    }
+}
+
+void harmonia_fast_final(harmonia_fast_ctx *ctx, uint8_t *digest) {
+    compress_tail(ctx->buffer, ctx->buffer_len, ctx->total_len, ctx->state_g, ctx->state_c);
+    finalize(ctx->state_g, ctx->state_c, digest);
+}
+
 /* Hex output */
 void harmonia_fast_hex(const uint8_t *data, size_t len, char *hex_digest) {
     uint8_t digest[32];
@@ -355,6 +538,55 @@ int harmonia_fast_self_test(void) {
     harmonia_fast_hex((uint8_t*)"HARMONIA", 8, hex);
     printf("  Name:     %s\n", hex);
 
+    /* Resolved expansion constants, and vector against scalar expansion */
+    {
+        uint32_t scalar[HARMONIA_FAST_ROUNDS], seed = 0x2545F491U;
+        int k, n, errors = 0;
+
+        for (k = 16; k < HARMONIA_FAST_ROUNDS; k++) {
+            errors += EXPAND_ROT1[k - 16] != qc_rotation(k, 0) ||
+                      EXPAND_ROT2[k - 16] != qc_rotation(k, 1) ||
+                      EXPAND_FIB[k - 16] != FIBONACCI[penrose_index(k) % 12];
+        }
+        for (n = 0; n < 64; n++) {
+            uint32_t w[HARMONIA_FAST_ROUNDS];
+            for (k = 0; k < 16; k++) {
+                seed = seed * 1103515245U + 12345U;
+                scalar[k] = w[k] = (n == 0) ? 0 : (n == 1) ? 0xFFFFFFFFU : seed;
+            }
+            expand_message_scalar(scalar);
+            expand_message(w);
+            errors += memcmp(scalar, w, sizeof(w)) != 0;
+        }
+        printf("  Schedule: %s (%s expansion)\n", errors ? "FAIL" : "OK", expand_backend());
+        if (errors) pass = 0;
+    }
+
+    /* Streaming in uneven pieces against the one-shot, every tail length */
+    {
+        static const size_t pieces[] = {1, 7, 63, 64, 65, 200};
+        uint8_t data[300], expected[32], streamed[32];
+        harmonia_fast_ctx ctx;
+        size_t len, pos, p, k;
+        int errors = 0;
+
+        for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)(k * 131 + 7);
+        for (len = 0; len <= sizeof(data); len++) {
+            harmonia_fast(data, len, expected);
+            harmonia_fast_init(&ctx);
+            for (pos = 0, p = len % 6; pos < len; p++) {
+                size_t n = pieces[p % 6];
+                if (n > len - pos) n = len - pos;
+                harmonia_fast_update(&ctx, data + pos, n);
+                pos += n;
+            }
+            harmonia_fast_final(&ctx, streamed);
+            errors += memcmp(expected, streamed, 32) != 0;
+        }
+        printf("  Stream:   %s (init/update/final, 0..300 bytes)\n", errors ? "FAIL" : "OK");
+        if (errors) pass = 0;
+    }
+
     return pass;
 }
 
@@ -362,7 +594,12 @@ int harmonia_fast_self_test(void) {
 #include <time.h>
 
 int main(int argc, char *argv[]) {
-    harmonia_fast_self_test();
+    int pass = harmonia_fast_self_test();
+
+    /* --test: self-test only, exit status reports the result */
+    if (argc > 1 && strcmp(argv[1], "--test") == 0) {
+        return pass ? 0 : 1;
+    }
 
     /* Benchmark */
     printf("\nBenchmark:\n");
@@ -381,6 +618,6 @@ int main(int argc, char *argv[]) {
 
     printf("  10 KB x 5000: %.2f MB/s\n", throughput);
 
-    return 0;
+    return pass ? 0 : 1;
 }
 #endif
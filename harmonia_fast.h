@@ -0,0 +1,56 @@
+/*
+ * HARMONIA-Fast v1.0 - 32-Round Optimized Variant
+ *
+ * The v2.2 construction with 32 rounds instead of 64 (see harmonia_fast.c).
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_FAST_H
+#define HARMONIA_FAST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HARMONIA_FAST_BLOCK_SIZE  64
+#define HARMONIA_FAST_DIGEST_SIZE 32
+#define HARMONIA_FAST_ROUNDS      32
+#define HARMONIA_FAST_VERSION     "1.0"
+
+/* Streaming context, laid out like harmonia_ctx */
+typedef struct {
+    uint32_t state_g[8];      /* Golden stream state */
+    uint32_t state_c[8];      /* Complementary stream state */
+    uint8_t  buffer[64];      /* Input buffer */
+    uint64_t total_len;       /* Total bytes processed */
+    size_t   buffer_len;      /* Bytes in buffer */
+} harmonia_fast_ctx;
+
+void harmonia_fast_init(harmonia_fast_ctx *ctx);
+void harmonia_fast_update(harmonia_fast_ctx *ctx, const uint8_t *data, size_t len);
+void harmonia_fast_final(harmonia_fast_ctx *ctx, uint8_t *digest);
+
+/*
+ * Compute the 32-byte HARMONIA-Fast digest of data.
+ */
+void harmonia_fast(const uint8_t *data, size_t len, uint8_t *digest);
+
+/*
+ * Same, as a NUL-terminated lowercase hex string (65 bytes).
+ */
+void harmonia_fast_hex(const uint8_t *data, size_t len, char *hex_digest);
+
+/*
+ * Check the built-in test vectors; returns 1 if all pass.
+ */
+int harmonia_fast_self_test(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARMONIA_FAST_H */
@@ -51,8 +51,10 @@ RECIPROCAL_CONSTANTS = (
     0x4F514F19, 0x4E8F43B8, 0x508E2FD9, 0x4B5F94A4,
 )
 
-# First 32 characters of Fibonacci word (truncated for 32 rounds)
-FIBONACCI_WORD = "ABAABABAABAABABAABABAABAABABAAB"
+# First 31 characters of the Fibonacci word; round 31 is a type-B round
+# (harmonia_fast.c reads the string terminator there, and the published
+# test vectors depend on it)
+FIBONACCI_WORD = "ABAABABAABAABABAABABAABAABABAAB" + "B"
 
 # Quasicrystal rotation lookup table (same as standard)
 QUASICRYSTAL_ROTATIONS = (
@@ -236,22 +238,23 @@ def _compress(block: bytes, state_g: List[int], state_c: List[int]) -> Tuple[Lis
     c = state_c[:]
 
     for r in range(NUM_ROUNDS):
-        round_type = FIBONACCI_WORD[r % len(FIBONACCI_WORD)]
+        round_type = FIBONACCI_WORD[r]
         k_phi = PHI_CONSTANTS[r % 16]
         k_rec = RECIPROCAL_CONSTANTS[r % 16]
 
+        # The complementary stream takes the opposite mix (as in harmonia_fast.c)
         if round_type == 'A':
             for idx in range(4):
                 i = idx
                 j = (idx + 4) % 8
                 g[i], g[j] = _mix_golden(g[i], g[j], k_phi ^ w[r], r, i)
-                c[i], c[j] = _mix_golden(c[i], c[j], k_rec ^ w[(r + 1) % NUM_ROUNDS], r, j)
+                c[i], c[j] = _mix_complementary(c[i], c[j], k_rec ^ w[(r + 1) % NUM_ROUNDS], r, j)
         else:
             for idx in range(4):
                 i = idx
                 j = (idx + 4) % 8
                 g[i], g[j] = _mix_complementary(g[i], g[j], k_phi ^ w[r], r, i)
-                c[i], c[j] = _mix_complementary(c[i], c[j], k_rec ^ w[(r + 1) % NUM_ROUNDS], r, j)
+                c[i], c[j] = _mix_golden(c[i], c[j], k_rec ^ w[(r + 1) % NUM_ROUNDS], r, j)
 
         if r > 0 and r % 8 == 0:
             g = _edge_protection(g, r)
@@ -0,0 +1,268 @@
+/*
+ * HARMONIA - File Hashing
+ *
+ * License: MIT
+ */
+
+#include "harmonia_file.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* ============================================================================
+ * ENGINES
+ * ============================================================================ */
+
+static void v22_init(harmonia_file_ctx *ctx) { harmonia_init(&ctx->v22); }
+static void v22_update(harmonia_file_ctx *ctx, const uint8_t *data, size_t len) { harmonia_update(&ctx->v22, data, len); }
+static void v22_final(harmonia_file_ctx *ctx, uint8_t *digest) { harmonia_final(&ctx->v22, digest); }
+
+static void ng_init(harmonia_file_ctx *ctx) { harmonia_ng_init(&ctx->ng); }
+static void ng_update(harmonia_file_ctx *ctx, const uint8_t *data, size_t len) { harmonia_ng_update(&ctx->ng, data, len); }
+static void ng_final(harmonia_file_ctx *ctx, uint8_t *digest) { harmonia_ng_final(&ctx->ng, digest); }
+
+static void ng_simd_init(harmonia_file_ctx *ctx) { harmonia_ng_simd_init(&ctx->ng); }
+static void ng_simd_update(harmonia_file_ctx *ctx, const uint8_t *data, size_t len) { harmonia_ng_simd_update(&ctx->ng, data, len); }
+static void ng_simd_final(harmonia_file_ctx *ctx, uint8_t *digest) { harmonia_ng_simd_final(&ctx->ng, digest); }
+
+static void fast_init(harmonia_file_ctx *ctx) { harmonia_fast_init(&ctx->fast); }
+static void fast_update(harmonia_file_ctx *ctx, const uint8_t *data, size_t len) { harmonia_fast_update(&ctx->fast, data, len); }
+static void fast_final(harmonia_file_ctx *ctx, uint8_t *digest) { harmonia_fast_final(&ctx->fast, digest); }
+
+static void tree_init(harmonia_file_ctx *ctx) { harmonia_ng_tree_init(&ctx->tree); }
+static void tree_update(harmonia_file_ctx *ctx, const uint8_t *data, size_t len) { harmonia_ng_tree_update(&ctx->tree, data, len); }
+static void tree_final(harmonia_file_ctx *ctx, uint8_t *digest) { harmonia_ng_tree_final(&ctx->tree, digest); }
+
+int harmonia_file_tree_threads = 1;
+
+static void tree_oneshot(const uint8_t *data, size_t len, uint8_t *digest)
+{
+    harmonia_ng_tree(data, len, digest, harmonia_file_tree_threads);
+}
+
+const harmonia_file_engine harmonia_file_engines[] = {
+    {"harmonia",      "HARMONIA v2.2 (default)",              harmonia,
+     v22_init, v22_update, v22_final},
+    {"harmonia-ng",   "HARMONIA-NG, scalar reference",        harmonia_ng,
+     ng_init, ng_update, ng_final},
+    {"harmonia-ng-simd", "HARMONIA-NG, optimized (same digest)", harmonia_ng_simd,
+     ng_simd_init, ng_simd_update, ng_simd_final},
+    {"harmonia-fast", "HARMONIA-Fast (32 rounds)",            harmonia_fast,
+     fast_init, fast_update, fast_final},
+    {"harmonia-ng-tree", "HARMONIA-NG-Tree, multi-threaded",  tree_oneshot,
+     tree_init, tree_update, tree_final},
+    {NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+const harmonia_file_engine *harmonia_file_find_engine(const char *name)
+{
+    const harmonia_file_engine *e;
+
+    for (e = harmonia_file_engines; e->name; e++) {
+        if (strcmp(e->name, name) == 0) return e;
+    }
+    return NULL;
+}
+
+/* ============================================================================
+ * READ PIPELINE
+ * ============================================================================ */
+
+/* Fill buf from fd until cap bytes or end of file; -1 on error (errno set) */
+static ssize_t read_full(int fd, uint8_t *buf, size_t cap)
+{
+    size_t got = 0;
+
+    while (got < cap) {
+        ssize_t n = read(fd, buf + got, cap - got);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (n == 0) break;
+        got += (size_t)n;
+    }
+    return (ssize_t)got;
+}
+
+/*
+ * Two buffers handed back and forth between the reader thread and the
+ * hashing thread. A buffer with len 0 marks end of input (or an error).
+ */
+typedef struct {
+    int fd;
+    uint8_t *buf[2];
+    size_t len[2];
+    int full[2];
+    int err;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} read_pipe;
+
+static void *reader_main(void *arg)
+{
+    read_pipe *p = (read_pipe *)arg;
+    int slot = 0;
+    ssize_t n;
+
+    do {
+        pthread_mutex_lock(&p->lock);
+        while (p->full[slot]) pthread_cond_wait(&p->cond, &p->lock);
+        pthread_mutex_unlock(&p->lock);
+
+        n = read_full(p->fd, p->buf[slot], HARMONIA_FILE_BUFFER);
+
+        pthread_mutex_lock(&p->lock);
+        if (n < 0) p->err = errno;
+        p->len[slot] = (n > 0) ? (size_t)n : 0;
+        p->full[slot] = 1;
+        pthread_cond_signal(&p->cond);
+        pthread_mutex_unlock(&p->lock);
+        slot ^= 1;
+    } while (n > 0);
+
+    return NULL;
+}
+
+/* Stream fd through a context; returns 0 or an errno value */
+static int stream_fd(int fd, const harmonia_file_engine *e, uint8_t *digest)
+{
+    read_pipe p;
+    pthread_t reader;
+    harmonia_file_ctx ctx;
+    int slot = 0, err = 0;
+
+    p.fd = fd;
+    p.buf[0] = (uint8_t *)malloc(2 * (size_t)HARMONIA_FILE_BUFFER);
+    if (!p.buf[0]) return ENOMEM;
+    p.buf[1] = p.buf[0] + HARMONIA_FILE_BUFFER;
+    p.full[0] = p.full[1] = 0;
+    p.err = 0;
+
+    e->init(&ctx);
+
+    /* Without a reader thread, read and hash in turn */
+    pthread_mutex_init(&p.lock, NULL);
+    pthread_cond_init(&p.cond, NULL);
+    if (pthread_create(&reader, NULL, reader_main, &p) != 0) {
+        ssize_t n;
+        while ((n = read_full(fd, p.buf[0], HARMONIA_FILE_BUFFER)) > 0) {
+            e->update(&ctx, p.buf[0], (size_t)n);
+        }
+        if (n < 0) err = errno;
+    } else {
+        for (;;) {
+            size_t len;
+
+            pthread_mutex_lock(&p.lock);
+            while (!p.full[slot]) pthread_cond_wait(&p.cond, &p.lock);
+            len = p.len[slot];
+            err = p.err;
+            pthread_mutex_unlock(&p.lock);
+            if (len == 0) break;
+
+            e->update(&ctx, p.buf[slot], len);
+
+            pthread_mutex_lock(&p.lock);
+            p.full[slot] = 0;
+            pthread_cond_signal(&p.cond);
+            pthread_mutex_unlock(&p.lock);
+            slot ^= 1;
+        }
+        pthread_join(reader, NULL);
+    }
+    pthread_cond_destroy(&p.cond);
+    pthread_mutex_destroy(&p.lock);
+
+    e->final(&ctx, digest);
+    free(p.buf[0]);
+    return err;
+}
+
+/* ============================================================================
+ * FILE HASHING
+ * ============================================================================ */
+
+int harmonia_file_use_mmap = 1;
+
+/* Map fd if it is a non-empty regular file; 0 on success */
+static int map_fd(int fd, const struct stat *st, const uint8_t **data, size_t *len)
+{
+    void *map;
+
+    if (!S_ISREG(st->st_mode) || st->st_size <= 0 || (uint64_t)st->st_size > (uint64_t)SIZE_MAX) {
+        return -1;
+    }
+    map = mmap(NULL, (size_t)st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) return -1;
+    madvise(map, (size_t)st->st_size, MADV_SEQUENTIAL);
+    *data = (const uint8_t *)map;
+    *len = (size_t)st->st_size;
+    return 0;
+}
+
+int harmonia_file_map(const char *path, const uint8_t **data, size_t *len)
+{
+    struct stat st;
+    int fd, err;
+
+    if ((fd = open(path, O_RDONLY)) < 0) return errno;
+    if (fstat(fd, &st) != 0) {
+        err = errno;
+        close(fd);
+        return err;
+    }
+    /* The mapping outlives the descriptor */
+    err = S_ISDIR(st.st_mode) ? EISDIR : map_fd(fd, &st, data, len);
+    close(fd);
+    return err;
+}
+
+void harmonia_file_unmap(const uint8_t *data, size_t len)
+{
+    munmap((void *)data, len);
+}
+
+int harmonia_file_hash(const char *path, const harmonia_file_engine *e, uint8_t *digest)
+{
+    struct stat st;
+    int fd, err;
+
+    if (strcmp(path, "-") == 0) {
+        fd = STDIN_FILENO;
+    } else if ((fd = open(path, O_RDONLY)) < 0) {
+        return errno;
+    }
+
+    if (fstat(fd, &st) != 0) {
+        err = errno;
+        if (fd != STDIN_FILENO) close(fd);
+        return err;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        if (fd != STDIN_FILENO) close(fd);
+        return EISDIR;
+    }
+
+    if (harmonia_file_use_mmap) {
+        const uint8_t *data;
+        size_t size;
+
+        if (map_fd(fd, &st, &data, &size) == 0) {
+            e->oneshot(data, size, digest);
+            harmonia_file_unmap(data, size);
+            if (fd != STDIN_FILENO) close(fd);
+            return 0;
+        }
+    }
+
+    err = stream_fd(fd, e, digest);
+
+    if (fd != STDIN_FILENO) close(fd);
+    return err;
+}
@@ -0,0 +1,78 @@
+/*
+ * HARMONIA - File Hashing
+ *
+ * The engine table and file pipeline shared by harmonia_sum and the
+ * driver's --verify mode. Regular files are hashed straight from a
+ * read-only mapping with MADV_SEQUENTIAL; anything that cannot be mapped
+ * (pipes, devices, empty or special files) is streamed through a
+ * double-buffered reader thread that fills one buffer while the other is
+ * hashed.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_FILE_H
+#define HARMONIA_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "harmonia.h"
+#include "harmonia_ng.h"
+#include "harmonia_fast.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HARMONIA_FILE_BUFFER    (1u << 20)      /* per pipeline buffer */
+
+typedef union {
+    harmonia_ctx v22;
+    harmonia_ng_ctx ng;
+    harmonia_fast_ctx fast;
+    harmonia_ng_tree_ctx tree;
+} harmonia_file_ctx;
+
+/*
+ * oneshot hashes a whole mapped file; init/update/final stream everything
+ * else through the read pipeline, so memory stays bounded at two
+ * HARMONIA_FILE_BUFFER buffers whatever the input size.
+ */
+typedef struct {
+    const char *name;
+    const char *description;
+    void (*oneshot)(const uint8_t *data, size_t len, uint8_t *digest);
+    void (*init)(harmonia_file_ctx *ctx);
+    void (*update)(harmonia_file_ctx *ctx, const uint8_t *data, size_t len);
+    void (*final)(harmonia_file_ctx *ctx, uint8_t *digest);
+} harmonia_file_engine;
+
+/* Every engine, ending with a NULL name; the first is the v2.2 default */
+extern const harmonia_file_engine harmonia_file_engines[];
+
+/* Look up an engine by name (e.g. "harmonia-ng"); NULL if unknown */
+const harmonia_file_engine *harmonia_file_find_engine(const char *name);
+
+/* 0 forces the read pipeline even for regular files (default 1) */
+extern int harmonia_file_use_mmap;
+
+/* Threads per mapped harmonia-ng-tree file (0 = one per CPU, default 1) */
+extern int harmonia_file_tree_threads;
+
+/* Hash one file ("-" = stdin) with engine e; returns 0 or an errno value */
+int harmonia_file_hash(const char *path, const harmonia_file_engine *e, uint8_t *digest);
+
+/*
+ * Map a non-empty regular file read-only for sequential access. Returns 0
+ * with *data / *len set (release with harmonia_file_unmap), an errno value
+ * if the file cannot be opened, or -1 if it exists but cannot be mapped;
+ * hash those with harmonia_file_hash().
+ */
+int harmonia_file_map(const char *path, const uint8_t **data, size_t *len);
+void harmonia_file_unmap(const uint8_t *data, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARMONIA_FILE_H */
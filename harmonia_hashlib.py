@@ -0,0 +1,249 @@
+#!/usr/bin/env python3
+"""
+HARMONIA hashlib-compatible interface
+
+Uses the native C engines from the _harmonia extension (harmonia_module.c,
+built with `make python`) and falls back to the pure-Python reference
+modules when the extension is not available.
+
+    import harmonia_hashlib
+
+    h = harmonia_hashlib.new("harmonia-ng")
+    h.update(b"message")
+    h.hexdigest()
+
+    harmonia_hashlib.harmonia_ng(b"message")          # one-shot bytes
+    harmonia_hashlib.harmonia_ng_x4([m0, m1, m2, m3])  # 4 digests
+    harmonia_hashlib.harmonia_rounds(b"message", 16)   # reduced-round v2.2
+
+The native module accepts any bytes-like object without copying and
+releases the GIL while hashing large inputs, so threads hash in parallel.
+
+Version: 1.0
+"""
+
+from typing import Callable, List, Sequence
+
+try:
+    import _harmonia
+    NATIVE = True
+except ImportError:
+    _harmonia = None
+    NATIVE = False
+
+# ============================================================================
+# CONSTANTS
+# ============================================================================
+
+VERSION = "1.0"
+DIGEST_SIZE = 32  # bytes
+BLOCK_SIZE = 64   # bytes
+
+algorithms_available = frozenset(("harmonia", "harmonia-ng", "harmonia-fast"))
+
+# ============================================================================
+# PURE-PYTHON FALLBACK
+# ============================================================================
+
+def _pure(name: str) -> Callable[[bytes], bytes]:
+    """Load the one-shot function of a pure-Python reference module."""
+    if name == "harmonia":
+        from harmonia import harmonia as fn
+    elif name == "harmonia-ng":
+        from harmonia_ng import harmonia_ng as fn
+    else:
+        from harmonia_fast import harmonia_fast as fn
+    return fn
+
+
+def _as_bytes(data) -> bytes:
+    if isinstance(data, str):
+        raise TypeError("Strings must be encoded before hashing")
+    return bytes(memoryview(data))
+
+
+class _BufferedHash:
+    """
+    hashlib-style object over a one-shot function.
+
+    The reference modules do not stream, so input is buffered and hashed
+    on digest(). Also used for HARMONIA-Fast, whose C engine is one-shot.
+    """
+
+    digest_size = DIGEST_SIZE
+    block_size = BLOCK_SIZE
+
+    def __init__(self, name: str, fn: Callable[[bytes], bytes], data=b""):
+        self.name = name
+        self._fn = fn
+        self._buffer = bytearray()
+        if data:
+            self.update(data)
+
+    def update(self, data) -> None:
+        self._buffer.extend(_as_bytes(data))
+
+    def digest(self) -> bytes:
+        return self._fn(bytes(self._buffer))
+
+    def hexdigest(self) -> str:
+        return self.digest().hex()
+
+    def copy(self) -> '_BufferedHash':
+        new = _BufferedHash(self.name, self._fn)
+        new._buffer = self._buffer[:]
+        return new
+
+# ============================================================================
+# PUBLIC API
+# ============================================================================
+
+def _canonical(name: str) -> str:
+    name = name.lower().replace("_", "-")
+    if name not in algorithms_available:
+        raise ValueError(f"unsupported hash type {name}")
+    return name
+
+
+def new(name: str, data=b""):
+    """Return a hashlib-style object for 'harmonia', 'harmonia-ng' or 'harmonia-fast'."""
+    name = _canonical(name)
+    if NATIVE and name != "harmonia-fast":
+        return _harmonia.new(name, data)
+    if NATIVE:
+        return _BufferedHash(name, _harmonia.harmonia_fast, data)
+    return _BufferedHash(name, _pure(name), data)
+
+
+def harmonia(data) -> bytes:
+    """HARMONIA v2.2 digest of a bytes-like object."""
+    if NATIVE:
+        return _harmonia.harmonia(data)
+    return _pure("harmonia")(_as_bytes(data))
+
+
+def harmonia_ng(data) -> bytes:
+    """HARMONIA-NG digest of a bytes-like object."""
+    if NATIVE:
+        return _harmonia.harmonia_ng(data)
+    return _pure("harmonia-ng")(_as_bytes(data))
+
+
+def harmonia_fast(data) -> bytes:
+    """HARMONIA-Fast digest of a bytes-like object."""
+    if NATIVE:
+        return _harmonia.harmonia_fast(data)
+    return _pure("harmonia-fast")(_as_bytes(data))
+
+
+def harmonia_ng_x4(msgs: Sequence) -> List[bytes]:
+    """HARMONIA-NG digests of four messages, computed in parallel natively."""
+    if len(msgs) != 4:
+        raise ValueError("harmonia_ng_x4() expects exactly 4 messages")
+    if NATIVE:
+        return _harmonia.harmonia_ng_x4(msgs)
+    fn = _pure("harmonia-ng")
+    return [fn(_as_bytes(m)) for m in msgs]
+
+
+def harmonia_rounds(data, rounds: int) -> bytes:
+    """HARMONIA v2.2 cut to rounds rounds (8, 16, ..., 64) for reduced-round analysis."""
+    if rounds not in range(8, 65, 8):
+        raise ValueError(f"unsupported round count {rounds} (multiples of 8 up to 64)")
+    if NATIVE:
+        return _harmonia.harmonia_rounds(data, rounds)
+    from harmonia import harmonia_rounds as fn
+    return fn(_as_bytes(data), rounds)
+
+# ============================================================================
+# SELF-TEST
+# ============================================================================
+
+def self_test() -> bool:
+    """
+    Check every entry point against the pure-Python reference modules.
+
+    Returns:
+        True if all tests pass
+    """
+    print(f"HARMONIA hashlib interface v{VERSION} Self-Test "
+          f"({'native' if NATIVE else 'pure-Python fallback'})")
+    print("=" * 60)
+
+    inputs = [b"", b"abc", b"HARMONIA", bytes(range(256)) * 5, b"x" * 3000]
+    all_passed = True
+
+    def check(label: str, ok: bool) -> None:
+        nonlocal all_passed
+        print(f"  {'OK  ' if ok else 'FAIL'} {label}")
+        all_passed &= ok
+
+    for name, fn in (("harmonia", harmonia), ("harmonia-ng", harmonia_ng),
+                     ("harmonia-fast", harmonia_fast)):
+        ref = _pure(name)
+        check(f"{name} one-shot", all(fn(m) == ref(m) for m in inputs))
+
+        # Streaming in uneven chunks, mixed buffer types, digest() mid-stream
+        h = new(name)
+        data = inputs[3]
+        h.update(bytearray(data[:7]))
+        h.update(memoryview(data)[7:100])
+        snapshot = h.copy()
+        h.update(data[100:])
+        ok = (h.digest() == ref(data) and h.hexdigest() == ref(data).hex() and
+              snapshot.digest() == ref(data[:100]) and h.name == name and
+              h.digest_size == DIGEST_SIZE)
+        check(f"{name} streaming / copy", ok)
+
+    msgs = [b"a", b"bb" * 40, b"", inputs[4]]
+    ref = _pure("harmonia-ng")
+    check("harmonia_ng_x4 (mixed lengths)", harmonia_ng_x4(msgs) == [ref(m) for m in msgs])
+    equal = [bytes([i]) * 200 for i in range(4)]
+    check("harmonia_ng_x4 (equal lengths)", harmonia_ng_x4(equal) == [ref(m) for m in equal])
+
+    from harmonia import harmonia_rounds as ref_rounds
+    check("harmonia_rounds (8..64)",
+          all(harmonia_rounds(m, r) == ref_rounds(m, r) for m in inputs[:4] for r in (8, 24, 56)) and
+          harmonia_rounds(inputs[2], 64) == harmonia(inputs[2]))
+
+    # Native and pure-Python paths reject the same round counts
+    rejected = 0
+    for bad in (0, 4, 12, 72):
+        for fn in (harmonia_rounds, ref_rounds):
+            try:
+                fn(inputs[0], bad)
+            except ValueError:
+                rejected += 1
+    check("harmonia_rounds rejects 0, 4, 12, 72 (native and Python)", rejected == 8)
+
+    try:
+        harmonia("text")
+        check("str rejected", False)
+    except TypeError:
+        check("str rejected", True)
+
+    print("=" * 60)
+    print(f"Result: {'PASS' if all_passed else 'FAIL'}")
+
+    return all_passed
+
+
+# ============================================================================
+# COMMAND LINE INTERFACE
+# ============================================================================
+
+if __name__ == "__main__":
+    import sys
+
+    if len(sys.argv) > 1 and sys.argv[1] == "--benchmark":
+        import time
+
+        data = b"\xa5" * ((1 << 20) if NATIVE else (1 << 12))
+        for name in sorted(algorithms_available):
+            start = time.perf_counter()
+            new(name, data).digest()
+            elapsed = time.perf_counter() - start
+            print(f"{name:14s} {len(data) / elapsed / 1e6:10.2f} MB/s")
+        sys.exit(0)
+
+    sys.exit(0 if self_test() else 1)
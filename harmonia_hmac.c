@@ -0,0 +1,396 @@
+/*
+ * HARMONIA-HMAC - Keyed message authentication with cached pad midstates
+ *
+ * See harmonia_hmac.h. The v2.2 functions run on whichever v2.2 engine is
+ * linked (harmonia.c or harmonia_simd.c); the NG functions use the
+ * optimized harmonia_ng_simd.c, whose lane scheduler also carries the
+ * batched MAC / verify path.
+ *
+ * License: MIT
+ */
+
+#include "harmonia_hmac.h"
+#include <string.h>
+#include <stdio.h>
+
+#define HMAC_BLOCK      64
+#define HMAC_IPAD       0x36
+#define HMAC_OPAD       0x5C
+#define BATCH_CHUNK     64      /* messages per multi-buffer batch */
+
+/* ============================================================================
+ * HELPERS
+ * ============================================================================ */
+
+/* K' = key zero-padded to the block, or H(key) padded when it is longer */
+typedef void (*hash_fn)(const uint8_t *data, size_t len, uint8_t *digest);
+
+static void block_key(const uint8_t *key, size_t key_len, hash_fn hash, uint8_t *kb)
+{
+    memset(kb, 0, HMAC_BLOCK);
+    if (key_len > HMAC_BLOCK) {
+        hash(key, key_len, kb);
+    } else if (key_len > 0) {
+        memcpy(kb, key, key_len);
+    }
+}
+
+static void xor_pad(const uint8_t *kb, uint8_t pad, uint8_t *out)
+{
+    int i;
+    for (i = 0; i < HMAC_BLOCK; i++) {
+        out[i] = kb[i] ^ pad;
+    }
+}
+
+/* Compare in constant time; 1 if equal */
+static int mac_equal(const uint8_t *a, const uint8_t *b)
+{
+    uint8_t diff = 0;
+    int i;
+
+    for (i = 0; i < HARMONIA_HMAC_SIZE; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+/* Best-effort wipe of key material on the stack */
+static void wipe(void *p, size_t n)
+{
+    volatile uint8_t *v = (volatile uint8_t *)p;
+    while (n--) *v++ = 0;
+}
+
+/* ============================================================================
+ * HARMONIA v2.2
+ * ============================================================================ */
+
+void harmonia_hmac_setkey(harmonia_hmac_key *hk, const uint8_t *key, size_t key_len)
+{
+    uint8_t kb[HMAC_BLOCK], pad[HMAC_BLOCK];
+
+    block_key(key, key_len, harmonia, kb);
+
+    xor_pad(kb, HMAC_IPAD, pad);
+    harmonia_init(&hk->inner);
+    harmonia_update(&hk->inner, pad, HMAC_BLOCK);
+
+    xor_pad(kb, HMAC_OPAD, pad);
+    harmonia_init(&hk->outer);
+    harmonia_update(&hk->outer, pad, HMAC_BLOCK);
+
+    wipe(kb, sizeof(kb));
+    wipe(pad, sizeof(pad));
+}
+
+void harmonia_hmac_mac(const harmonia_hmac_key *hk, const uint8_t *msg, size_t len, uint8_t *mac)
+{
+    harmonia_ctx ctx;
+    uint8_t inner[HARMONIA_DIGEST_SIZE];
+
+    harmonia_ctx_copy(&ctx, &hk->inner);
+    harmonia_update(&ctx, msg, len);
+    harmonia_final(&ctx, inner);
+
+    harmonia_ctx_copy(&ctx, &hk->outer);
+    harmonia_update(&ctx, inner, sizeof(inner));
+    harmonia_final(&ctx, mac);
+}
+
+void harmonia_hmac(const uint8_t *key, size_t key_len, const uint8_t *msg, size_t len, uint8_t *mac)
+{
+    harmonia_hmac_key hk;
+
+    harmonia_hmac_setkey(&hk, key, key_len);
+    harmonia_hmac_mac(&hk, msg, len, mac);
+    wipe(&hk, sizeof(hk));
+}
+
+int harmonia_hmac_verify(const harmonia_hmac_key *hk, const uint8_t *msg, size_t len,
+                         const uint8_t *mac)
+{
+    uint8_t expect[HARMONIA_HMAC_SIZE];
+
+    harmonia_hmac_mac(hk, msg, len, expect);
+    return mac_equal(expect, mac);
+}
+
+/* ============================================================================
+ * HARMONIA-NG
+ * ============================================================================ */
+
+void harmonia_ng_hmac_setkey(harmonia_ng_hmac_key *hk, const uint8_t *key, size_t key_len)
+{
+    uint8_t kb[HMAC_BLOCK], pad[HMAC_BLOCK];
+
+    block_key(key, key_len, harmonia_ng_simd, kb);
+
+    xor_pad(kb, HMAC_IPAD, pad);
+    harmonia_ng_simd_init(&hk->inner);
+    harmonia_ng_simd_update(&hk->inner, pad, HMAC_BLOCK);
+
+    xor_pad(kb, HMAC_OPAD, pad);
+    harmonia_ng_simd_init(&hk->outer);
+    harmonia_ng_simd_update(&hk->outer, pad, HMAC_BLOCK);
+
+    wipe(kb, sizeof(kb));
+    wipe(pad, sizeof(pad));
+}
+
+void harmonia_ng_hmac_mac(const harmonia_ng_hmac_key *hk, const uint8_t *msg, size_t len, uint8_t *mac)
+{
+    harmonia_ng_ctx ctx;
+    uint8_t inner[HARMONIA_NG_DIGEST_SIZE];
+
+    harmonia_ng_ctx_copy(&ctx, &hk->inner);
+    harmonia_ng_simd_update(&ctx, msg, len);
+    harmonia_ng_simd_final(&ctx, inner);
+
+    harmonia_ng_ctx_copy(&ctx, &hk->outer);
+    harmonia_ng_simd_update(&ctx, inner, sizeof(inner));
+    harmonia_ng_simd_final(&ctx, mac);
+}
+
+void harmonia_ng_hmac(const uint8_t *key, size_t key_len, const uint8_t *msg, size_t len, uint8_t *mac)
+{
+    harmonia_ng_hmac_key hk;
+
+    harmonia_ng_hmac_setkey(&hk, key, key_len);
+    harmonia_ng_hmac_mac(&hk, msg, len, mac);
+    wipe(&hk, sizeof(hk));
+}
+
+int harmonia_ng_hmac_verify(const harmonia_ng_hmac_key *hk, const uint8_t *msg, size_t len,
+                            const uint8_t *mac)
+{
+    uint8_t expect[HARMONIA_HMAC_SIZE];
+
+    harmonia_ng_hmac_mac(hk, msg, len, expect);
+    return mac_equal(expect, mac);
+}
+
+void harmonia_ng_hmac_multi(const harmonia_ng_hmac_key *hk, const uint8_t *const *msgs,
+                            const size_t *lens, uint8_t *macs, size_t n)
+{
+    uint8_t inner[BATCH_CHUNK * HARMONIA_NG_DIGEST_SIZE];
+    const uint8_t *inner_ptrs[BATCH_CHUNK];
+    size_t inner_lens[BATCH_CHUNK];
+    size_t done, k, m;
+
+    for (k = 0; k < BATCH_CHUNK; k++) {
+        inner_ptrs[k] = inner + k * HARMONIA_NG_DIGEST_SIZE;
+        inner_lens[k] = HARMONIA_NG_DIGEST_SIZE;
+    }
+
+    for (done = 0; done < n; done += m) {
+        m = (n - done < BATCH_CHUNK) ? n - done : BATCH_CHUNK;
+
+        /* Inner pass from K' ^ ipad, outer pass over the inner digests */
+        harmonia_ng_multi_prefixed(&hk->inner, msgs + done, lens + done, inner, m);
+        harmonia_ng_multi_prefixed(&hk->outer, inner_ptrs, inner_lens,
+                                   macs + done * HARMONIA_HMAC_SIZE, m);
+    }
+}
+
+size_t harmonia_ng_hmac_verify_batch(const harmonia_ng_hmac_key *hk,
+                                     const uint8_t *const *msgs, const size_t *lens,
+                                     const uint8_t *const *macs, int *results, size_t n)
+{
+    uint8_t expect[BATCH_CHUNK * HARMONIA_HMAC_SIZE];
+    size_t done, k, m, valid = 0;
+
+    for (done = 0; done < n; done += m) {
+        m = (n - done < BATCH_CHUNK) ? n - done : BATCH_CHUNK;
+        harmonia_ng_hmac_multi(hk, msgs + done, lens + done, expect, m);
+
+        for (k = 0; k < m; k++) {
+            int ok = mac_equal(expect + k * HARMONIA_HMAC_SIZE, macs[done + k]);
+            if (results) results[done + k] = ok;
+            valid += (size_t)ok;
+        }
+    }
+    return valid;
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+int harmonia_hmac_self_test(void)
+{
+    /* Python: hmac.new(key, msg, lambda d=b'': harmonia_hashlib.new(name, d)) */
+    static const struct {
+        size_t key_len;     /* key = "key", "", 0xAA * 100, bytes(range(64)) */
+        int key_kind;
+        const char *msg;
+        const char *v22;
+        const char *ng;
+    } vectors[] = {
+        {3, 0, "The quick brown fox jumps over the lazy dog",
+         "56dc3d4936d04303ce6c657a73d32c998e4b1f0e6e9231d3391ea170cfd48008",
+         "45f049f168c323ba220f1115b6b4c209f7c50eb457cb4d58007d3a57de7d2514"},
+        {0, 1, "",
+         "3c18813e62a277e271527f2573d6e65ba855281a8fd81dcaf522a3bd1a806bb7",
+         "567f0a6232e442866782b70cfea74cb9fa1d68517ca974b45465d373e48be954"},
+        {100, 2, "Test Using Larger Than Block-Size Key - Hash Key First",
+         "f497b42117c61e36e44d83b9bab259b41bf7080f3e34fbf400cc995e7207cfc1",
+         "363ad64d83e7ffe41238b625e01f774dbc6a4ccf1b4e058dfc1643c759e7fc30"},
+        {64, 3, NULL,   /* "x" * 120 */
+         "2430228e65c41548c9754650cd5540e8363a6f6135523b12f807c0e93881483e",
+         "bce97c844dcf59c7a7e203945375739e7a3042e173ebf1ea1d099ef8ff07f2c5"},
+    };
+
+    uint8_t key[100], msg[120], mac[32];
+    char hex[65];
+    size_t msg_len, k;
+    int i, j, failed = 0;
+
+    printf("HARMONIA-HMAC v%s Self-Test\n", HARMONIA_HMAC_VERSION);
+    printf("============================================================\n");
+
+    for (i = 0; i < (int)(sizeof(vectors) / sizeof(vectors[0])); i++) {
+        for (k = 0; k < vectors[i].key_len; k++) {
+            key[k] = vectors[i].key_kind == 0 ? (uint8_t)"key"[k] :
+                     vectors[i].key_kind == 2 ? 0xAA : (uint8_t)k;
+        }
+        if (vectors[i].msg) {
+            msg_len = strlen(vectors[i].msg);
+            memcpy(msg, vectors[i].msg, msg_len);
+        } else {
+            msg_len = 120;
+            memset(msg, 'x', msg_len);
+        }
+
+        for (j = 0; j < 2; j++) {
+            const char *expected = j ? vectors[i].ng : vectors[i].v22;
+
+            if (j) {
+                harmonia_ng_hmac(key, vectors[i].key_len, msg, msg_len, mac);
+            } else {
+                harmonia_hmac(key, vectors[i].key_len, msg, msg_len, mac);
+            }
+            for (k = 0; k < 32; k++) sprintf(hex + 2 * k, "%02x", mac[k]);
+
+            if (strcmp(hex, expected) == 0) {
+                printf("  OK   %-4s key %3zu bytes, msg %3zu bytes\n", j ? "NG" : "v2.2",
+                       vectors[i].key_len, msg_len);
+            } else {
+                printf("  FAIL %-4s key %3zu bytes, msg %3zu bytes\n", j ? "NG" : "v2.2",
+                       vectors[i].key_len, msg_len);
+                printf("       Expected: %s\n", expected);
+                printf("       Got:      %s\n", hex);
+                failed++;
+            }
+        }
+    }
+
+    /* Batch MAC / verify against single MACs (crosses BATCH_CHUNK) */
+    {
+        static uint8_t data[2000];
+        static uint8_t macs[150 * 32];
+        const uint8_t *msgs[150], *mac_ptrs[150];
+        size_t lens[150], valid;
+        int results[150], ok = 1;
+        harmonia_ng_hmac_key hk;
+        harmonia_hmac_key hk22;
+
+        for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)(k * 31 + 7);
+        harmonia_ng_hmac_setkey(&hk, (const uint8_t *)"batch key", 9);
+        harmonia_hmac_setkey(&hk22, (const uint8_t *)"batch key", 9);
+
+        for (k = 0; k < 150; k++) {
+            msgs[k] = data + k;
+            lens[k] = (k * 37) % 300;
+            mac_ptrs[k] = macs + 32 * k;
+        }
+        harmonia_ng_hmac_multi(&hk, msgs, lens, macs, 150);
+
+        for (k = 0; k < 150; k++) {
+            if (!harmonia_ng_hmac_verify(&hk, msgs[k], lens[k], macs + 32 * k)) ok = 0;
+        }
+        macs[32 * 77 + 5] ^= 1;     /* corrupt one tag */
+        valid = harmonia_ng_hmac_verify_batch(&hk, msgs, lens, mac_ptrs, results, 150);
+        if (valid != 149 || results[77] != 0 || results[76] != 1) ok = 0;
+
+        harmonia_hmac_mac(&hk22, msgs[3], lens[3], mac);
+        if (!harmonia_hmac_verify(&hk22, msgs[3], lens[3], mac)) ok = 0;
+        mac[0] ^= 0x80;
+        if (harmonia_hmac_verify(&hk22, msgs[3], lens[3], mac)) ok = 0;
+
+        if (ok) {
+            printf("  OK   batch MAC / verify (150 messages, 1 forged tag rejected)\n");
+        } else {
+            printf("  FAIL batch MAC / verify\n");
+            failed++;
+        }
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+
+    return failed;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+#ifdef HARMONIA_HMAC_MAIN
+#include <time.h>
+
+static void benchmark_hmac(void)
+{
+    enum { N = 4096, LEN = 64 };
+    static uint8_t data[N][LEN];
+    static uint8_t macs[N * 32];
+    const uint8_t *msgs[N];
+    size_t lens[N];
+    harmonia_ng_hmac_key hk;
+    clock_t start;
+    double t_naive, t_cached, t_batch;
+    int i, k, iterations = 10;
+
+    for (k = 0; k < N; k++) {
+        for (i = 0; i < LEN; i++) data[k][i] = (uint8_t)(k + i);
+        msgs[k] = data[k];
+        lens[k] = LEN;
+    }
+
+    printf("\nHARMONIA-NG HMAC Benchmark (%d x %d-byte messages)\n", N, LEN);
+    printf("============================================================\n");
+
+    start = clock();
+    for (i = 0; i < iterations; i++) {
+        for (k = 0; k < N; k++) harmonia_ng_hmac((const uint8_t *)"key", 3, msgs[k], LEN, macs + 32 * k);
+    }
+    t_naive = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    harmonia_ng_hmac_setkey(&hk, (const uint8_t *)"key", 3);
+    start = clock();
+    for (i = 0; i < iterations; i++) {
+        for (k = 0; k < N; k++) harmonia_ng_hmac_mac(&hk, msgs[k], LEN, macs + 32 * k);
+    }
+    t_cached = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (i = 0; i < iterations; i++) {
+        harmonia_ng_hmac_multi(&hk, msgs, lens, macs, N);
+    }
+    t_batch = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("key setup per message: %.2f M MAC/s\n", N * iterations / t_naive / 1e6);
+    printf("cached midstates:      %.2f M MAC/s (%.1fx)\n", N * iterations / t_cached / 1e6, t_naive / t_cached);
+    printf("batched (multi-lane):  %.2f M MAC/s (%.1fx)\n", N * iterations / t_batch / 1e6, t_naive / t_batch);
+    printf("============================================================\n");
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        benchmark_hmac();
+        return 0;
+    }
+    return harmonia_hmac_self_test();
+}
+#endif
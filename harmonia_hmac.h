@@ -0,0 +1,98 @@
+/*
+ * HARMONIA-HMAC - Keyed message authentication (RFC 2104 construction)
+ *
+ *   HMAC(K, m) = H((K' ^ opad) || H((K' ^ ipad) || m))
+ *
+ * with H = HARMONIA v2.2 or HARMONIA-NG, a 64-byte block and K' the key
+ * zero-padded to the block (keys longer than 64 bytes are hashed first).
+ *
+ * Key setup absorbs the two pad blocks once and keeps the inner and outer
+ * midstates; each MAC then resumes from them, so a message costs its own
+ * blocks plus one outer compression of the 32-byte inner digest.
+ *
+ * Version: 1.0
+ * License: MIT
+ */
+
+#ifndef HARMONIA_HMAC_H
+#define HARMONIA_HMAC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "harmonia.h"
+#include "harmonia_ng.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HARMONIA_HMAC_SIZE      32
+#define HARMONIA_HMAC_VERSION   "1.0"
+
+/* Per-key state: midstates after absorbing K' ^ ipad and K' ^ opad */
+typedef struct {
+    harmonia_ctx inner;
+    harmonia_ctx outer;
+} harmonia_hmac_key;
+
+typedef struct {
+    harmonia_ng_ctx inner;
+    harmonia_ng_ctx outer;
+} harmonia_ng_hmac_key;
+
+/* ============================================================================
+ * HARMONIA v2.2
+ * ============================================================================ */
+
+/* Derive the cached midstates for a key (any length) */
+void harmonia_hmac_setkey(harmonia_hmac_key *hk, const uint8_t *key, size_t key_len);
+
+/* MAC a message with a prepared key */
+void harmonia_hmac_mac(const harmonia_hmac_key *hk, const uint8_t *msg, size_t len, uint8_t *mac);
+
+/* One-shot MAC (key setup + MAC) */
+void harmonia_hmac(const uint8_t *key, size_t key_len, const uint8_t *msg, size_t len, uint8_t *mac);
+
+/* Recompute and compare in constant time. Returns 1 if mac is valid, else 0. */
+int harmonia_hmac_verify(const harmonia_hmac_key *hk, const uint8_t *msg, size_t len,
+                         const uint8_t *mac);
+
+/* ============================================================================
+ * HARMONIA-NG
+ * ============================================================================ */
+
+void harmonia_ng_hmac_setkey(harmonia_ng_hmac_key *hk, const uint8_t *key, size_t key_len);
+void harmonia_ng_hmac_mac(const harmonia_ng_hmac_key *hk, const uint8_t *msg, size_t len, uint8_t *mac);
+void harmonia_ng_hmac(const uint8_t *key, size_t key_len, const uint8_t *msg, size_t len, uint8_t *mac);
+int harmonia_ng_hmac_verify(const harmonia_ng_hmac_key *hk, const uint8_t *msg, size_t len,
+                            const uint8_t *mac);
+
+/*
+ * MAC n messages with one key across the multi-buffer lanes (x4/x8/x16 by
+ * CPU): the inner and the outer pass each run as one batch from the cached
+ * midstates. macs receives n * HARMONIA_HMAC_SIZE bytes.
+ */
+void harmonia_ng_hmac_multi(const harmonia_ng_hmac_key *hk, const uint8_t *const *msgs,
+                            const size_t *lens, uint8_t *macs, size_t n);
+
+/*
+ * Verify n (message, mac) pairs in one batch. results[k] is set to 1 when
+ * macs[k] is valid, else 0 (results may be NULL). Returns the number of
+ * valid MACs. Batches are processed in chunks, so n is unbounded.
+ */
+size_t harmonia_ng_hmac_verify_batch(const harmonia_ng_hmac_key *hk,
+                                     const uint8_t *const *msgs, const size_t *lens,
+                                     const uint8_t *const *macs, int *results, size_t n);
+
+/*
+ * Self-test (known answers from Python's hmac module over the reference
+ * implementations, batch vs single agreement).
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_hmac_self_test(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARMONIA_HMAC_H */
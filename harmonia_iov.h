@@ -0,0 +1,158 @@
+/*
+ * HARMONIA - Scatter/Gather Input (internal)
+ *
+ * A cursor over an iovec chain and the updatev driver shared by the v2.2
+ * and NG engines. Whole blocks inside one fragment are compressed straight
+ * from caller memory; only a block that spans fragments is assembled, on
+ * the stack, and only the final partial block is copied into ctx->buffer.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_IOV_H
+#define HARMONIA_IOV_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/uio.h>
+#include "harmonia_stats.h"
+
+typedef struct {
+    const struct iovec *iov;    /* Next fragment */
+    const struct iovec *end;
+    const uint8_t *p;           /* Next byte of the current fragment */
+    size_t left;                /* Bytes left in it */
+} harmonia_iov_cursor;
+
+/* Bytes in the chain */
+static inline size_t harmonia_iov_total(const struct iovec *iov, int iovcnt)
+{
+    size_t total = 0;
+    int k;
+
+    for (k = 0; k < iovcnt; k++) {
+        total += iov[k].iov_len;
+    }
+    return total;
+}
+
+/* Cursor over head[0..head_len) followed by the chain */
+static inline void harmonia_iov_init(harmonia_iov_cursor *cur, const uint8_t *head, size_t head_len,
+                                     const struct iovec *iov, int iovcnt)
+{
+    cur->iov = iov;
+    cur->end = iov + (iovcnt > 0 ? iovcnt : 0);
+    cur->p = head;
+    cur->left = head_len;
+}
+
+static inline void harmonia_iov_next(harmonia_iov_cursor *cur)
+{
+    while (cur->left == 0 && cur->iov < cur->end) {
+        cur->p = (const uint8_t *)cur->iov->iov_base;
+        cur->left = cur->iov->iov_len;
+        cur->iov++;
+    }
+}
+
+/* Copy the next n bytes to dst (n must not exceed what is left) */
+static inline void harmonia_iov_copy(harmonia_iov_cursor *cur, uint8_t *dst, size_t n)
+{
+    while (n > 0) {
+        size_t take;
+
+        harmonia_iov_next(cur);
+        take = (cur->left < n) ? cur->left : n;
+        memcpy(dst, cur->p, take);
+        cur->p += take;
+        cur->left -= take;
+        dst += take;
+        n -= take;
+    }
+}
+
+/* Skip the next n bytes */
+static inline void harmonia_iov_skip(harmonia_iov_cursor *cur, size_t n)
+{
+    while (n > 0) {
+        size_t take;
+
+        harmonia_iov_next(cur);
+        take = (cur->left < n) ? cur->left : n;
+        cur->p += take;
+        cur->left -= take;
+        n -= take;
+    }
+}
+
+/*
+ * Next 64-byte block: a pointer into the fragment when the block lies
+ * inside one, else the block assembled in scratch.
+ */
+static inline const uint8_t *harmonia_iov_block(harmonia_iov_cursor *cur, uint8_t scratch[64])
+{
+    harmonia_iov_next(cur);
+    if (cur->left >= 64) {
+        const uint8_t *block = cur->p;
+        cur->p += 64;
+        cur->left -= 64;
+        return block;
+    }
+    harmonia_iov_copy(cur, scratch, 64);
+    return scratch;
+}
+
+typedef void (*harmonia_iov_compress_fn)(const uint8_t *data, size_t nblocks,
+                                         uint32_t *state_g, uint32_t *state_c);
+
+/*
+ * Absorb the chain into a streaming context (buffer / buffer_len hold the
+ * pending partial block). Runs of whole blocks go to compress in one call.
+ * Returns the number of bytes absorbed, for the caller's total_len.
+ */
+static inline __attribute__((always_inline)) size_t harmonia_iov_absorb(
+    const struct iovec *iov, int iovcnt, uint8_t buffer[64], size_t *buffer_len,
+    uint32_t *state_g, uint32_t *state_c, harmonia_iov_compress_fn compress)
+{
+    harmonia_iov_cursor cur;
+    uint8_t scratch[64];
+    size_t total = harmonia_iov_total(iov, iovcnt);
+    size_t remaining = *buffer_len + total;
+
+    HARMONIA_STAT(updates, 1);
+
+    if (remaining < 64) {
+        /* Still no whole block: append behind the buffered bytes */
+        harmonia_iov_init(&cur, NULL, 0, iov, iovcnt);
+        harmonia_iov_copy(&cur, buffer + *buffer_len, total);
+        HARMONIA_STAT(buffer_copies, total > 0);
+        HARMONIA_STAT(buffer_bytes, total);
+        *buffer_len = remaining;
+        return total;
+    }
+
+    /* The buffered bytes start the chain; they are consumed by the first block */
+    harmonia_iov_init(&cur, buffer, *buffer_len, iov, iovcnt);
+    while (remaining >= 64) {
+        harmonia_iov_next(&cur);
+        if (cur.left >= 64) {
+            size_t nblocks = cur.left / 64;
+            compress(cur.p, nblocks, state_g, state_c);
+            cur.p += 64 * nblocks;
+            cur.left -= 64 * nblocks;
+            remaining -= 64 * nblocks;
+        } else {
+            compress(harmonia_iov_block(&cur, scratch), 1, state_g, state_c);
+            remaining -= 64;
+        }
+    }
+
+    harmonia_iov_copy(&cur, buffer, remaining);
+    HARMONIA_STAT(buffer_copies, remaining > 0);
+    HARMONIA_STAT(buffer_bytes, remaining);
+    *buffer_len = remaining;
+    return total;
+}
+
+#endif /* HARMONIA_IOV_H */
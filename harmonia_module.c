@@ -0,0 +1,501 @@
+/*
+ * HARMONIA - CPython extension (_harmonia)
+ *
+ * Native bindings for the C engines:
+ *   - HARMONIA v2.2     (harmonia.c, schedule-unrolled compressor, reduced rounds)
+ *   - HARMONIA-NG       (harmonia_ng_simd.c, including the x4 multi-buffer API)
+ *   - HARMONIA-Fast     (harmonia_fast.c, one-shot)
+ *
+ * Inputs are taken through the buffer protocol without copying, and the GIL
+ * is released while hashing inputs of HASHLIB_GIL_MINSIZE bytes or more. The
+ * HASH type follows the hashlib object interface (update / digest /
+ * hexdigest / copy, name, digest_size, block_size).
+ *
+ * Use harmonia_hashlib.py rather than importing this module directly: it
+ * falls back to the pure-Python implementations when the extension is not
+ * built.
+ *
+ * License: MIT
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include "pythread.h"
+
+#include "harmonia.h"
+#include "harmonia_ng.h"
+#include "harmonia_fast.h"
+
+/* Same threshold as CPython's hashlib */
+#define HASHLIB_GIL_MINSIZE 2048
+
+/* ============================================================================
+ * BUFFER HELPERS
+ * ============================================================================ */
+
+/* Borrow a contiguous byte view of obj; str is rejected as in hashlib */
+static int get_buffer(PyObject *obj, Py_buffer *view)
+{
+    if (PyUnicode_Check(obj)) {
+        PyErr_SetString(PyExc_TypeError, "Strings must be encoded before hashing");
+        return -1;
+    }
+    if (PyObject_GetBuffer(obj, view, PyBUF_SIMPLE) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static PyObject *hex_from_digest(const uint8_t *digest)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    char hex[HARMONIA_DIGEST_SIZE * 2];
+    int i;
+
+    for (i = 0; i < HARMONIA_DIGEST_SIZE; i++) {
+        hex[2 * i] = hexdigits[digest[i] >> 4];
+        hex[2 * i + 1] = hexdigits[digest[i] & 0x0F];
+    }
+    return PyUnicode_FromStringAndSize(hex, sizeof(hex));
+}
+
+/* ============================================================================
+ * HASH OBJECT
+ * ============================================================================ */
+
+typedef enum {
+    ALG_HARMONIA = 0,
+    ALG_HARMONIA_NG = 1
+} hash_alg;
+
+static const char *const ALG_NAMES[] = { "harmonia", "harmonia-ng" };
+
+typedef struct {
+    PyObject_HEAD
+    hash_alg alg;
+    union {
+        harmonia_ctx v22;
+        harmonia_ng_ctx ng;
+    } ctx;
+    /* Allocated on the first large update; guards ctx while the GIL is released */
+    PyThread_type_lock lock;
+} HashObject;
+
+static PyTypeObject HashType;
+
+/* Take the object lock, dropping the GIL if another thread holds it */
+#define ENTER_HASH(obj) \
+    if ((obj)->lock) { \
+        if (!PyThread_acquire_lock((obj)->lock, 0)) { \
+            Py_BEGIN_ALLOW_THREADS \
+            PyThread_acquire_lock((obj)->lock, 1); \
+            Py_END_ALLOW_THREADS \
+        } \
+    }
+
+#define LEAVE_HASH(obj) \
+    if ((obj)->lock) { \
+        PyThread_release_lock((obj)->lock); \
+    }
+
+static void ctx_init(HashObject *self)
+{
+    if (self->alg == ALG_HARMONIA_NG) {
+        harmonia_ng_simd_init(&self->ctx.ng);
+    } else {
+        harmonia_init(&self->ctx.v22);
+    }
+}
+
+static void ctx_update(HashObject *self, const uint8_t *data, size_t len)
+{
+    if (self->alg == ALG_HARMONIA_NG) {
+        harmonia_ng_simd_update(&self->ctx.ng, data, len);
+    } else {
+        harmonia_update(&self->ctx.v22, data, len);
+    }
+}
+
+/* Finalize a copy so the object can keep absorbing (hashlib semantics) */
+static void ctx_digest(HashObject *self, uint8_t *digest)
+{
+    if (self->alg == ALG_HARMONIA_NG) {
+        harmonia_ng_ctx tmp = self->ctx.ng;
+        harmonia_ng_simd_final(&tmp, digest);
+    } else {
+        harmonia_ctx tmp = self->ctx.v22;
+        harmonia_final(&tmp, digest);
+    }
+}
+
+static HashObject *new_hash_object(hash_alg alg)
+{
+    HashObject *self = PyObject_New(HashObject, &HashType);
+
+    if (self == NULL) {
+        return NULL;
+    }
+    self->alg = alg;
+    self->lock = NULL;
+    return self;
+}
+
+static int hash_absorb(HashObject *self, PyObject *obj)
+{
+    Py_buffer view;
+
+    if (get_buffer(obj, &view) < 0) {
+        return -1;
+    }
+
+    if (self->lock == NULL && view.len >= HASHLIB_GIL_MINSIZE) {
+        self->lock = PyThread_allocate_lock();
+        /* Without a lock the update simply keeps the GIL */
+    }
+
+    if (self->lock != NULL) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, 1);
+        ctx_update(self, (const uint8_t *)view.buf, (size_t)view.len);
+        PyThread_release_lock(self->lock);
+        Py_END_ALLOW_THREADS
+    } else {
+        ctx_update(self, (const uint8_t *)view.buf, (size_t)view.len);
+    }
+
+    PyBuffer_Release(&view);
+    return 0;
+}
+
+static void hash_dealloc(HashObject *self)
+{
+    if (self->lock) {
+        PyThread_free_lock(self->lock);
+    }
+    PyObject_Free(self);
+}
+
+PyDoc_STRVAR(hash_update_doc,
+"update($self, data, /)\n--\n\n"
+"Update this hash object's state with the provided bytes-like object.");
+
+static PyObject *hash_update(HashObject *self, PyObject *obj)
+{
+    if (hash_absorb(self, obj) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(hash_digest_doc,
+"digest($self, /)\n--\n\n"
+"Return the digest value as a bytes object.");
+
+static PyObject *hash_digest(HashObject *self, PyObject *Py_UNUSED(ignored))
+{
+    uint8_t digest[HARMONIA_DIGEST_SIZE];
+
+    ENTER_HASH(self);
+    ctx_digest(self, digest);
+    LEAVE_HASH(self);
+
+    return PyBytes_FromStringAndSize((const char *)digest, HARMONIA_DIGEST_SIZE);
+}
+
+PyDoc_STRVAR(hash_hexdigest_doc,
+"hexdigest($self, /)\n--\n\n"
+"Return the digest value as a string of hexadecimal digits.");
+
+static PyObject *hash_hexdigest(HashObject *self, PyObject *Py_UNUSED(ignored))
+{
+    uint8_t digest[HARMONIA_DIGEST_SIZE];
+
+    ENTER_HASH(self);
+    ctx_digest(self, digest);
+    LEAVE_HASH(self);
+
+    return hex_from_digest(digest);
+}
+
+PyDoc_STRVAR(hash_copy_doc,
+"copy($self, /)\n--\n\n"
+"Return a copy of the hash object.");
+
+static PyObject *hash_copy(HashObject *self, PyObject *Py_UNUSED(ignored))
+{
+    HashObject *copy = new_hash_object(self->alg);
+
+    if (copy == NULL) {
+        return NULL;
+    }
+
+    ENTER_HASH(self);
+    copy->ctx = self->ctx;
+    LEAVE_HASH(self);
+
+    return (PyObject *)copy;
+}
+
+static PyObject *hash_get_name(HashObject *self, void *Py_UNUSED(closure))
+{
+    return PyUnicode_FromString(ALG_NAMES[self->alg]);
+}
+
+static PyObject *hash_get_digest_size(HashObject *Py_UNUSED(self), void *Py_UNUSED(closure))
+{
+    return PyLong_FromLong(HARMONIA_DIGEST_SIZE);
+}
+
+static PyObject *hash_get_block_size(HashObject *Py_UNUSED(self), void *Py_UNUSED(closure))
+{
+    return PyLong_FromLong(HARMONIA_BLOCK_SIZE);
+}
+
+static PyMethodDef hash_methods[] = {
+    {"update",    (PyCFunction)hash_update,    METH_O,      hash_update_doc},
+    {"digest",    (PyCFunction)hash_digest,    METH_NOARGS, hash_digest_doc},
+    {"hexdigest", (PyCFunction)hash_hexdigest, METH_NOARGS, hash_hexdigest_doc},
+    {"copy",      (PyCFunction)hash_copy,      METH_NOARGS, hash_copy_doc},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyGetSetDef hash_getset[] = {
+    {"name",        (getter)hash_get_name,        NULL, NULL, NULL},
+    {"digest_size", (getter)hash_get_digest_size, NULL, NULL, NULL},
+    {"block_size",  (getter)hash_get_block_size,  NULL, NULL, NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyTypeObject HashType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "_harmonia.HASH",
+    .tp_basicsize = sizeof(HashObject),
+    .tp_dealloc = (destructor)hash_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "A HARMONIA hash object; see harmonia_hashlib.new().",
+    .tp_methods = hash_methods,
+    .tp_getset = hash_getset,
+};
+
+/* ============================================================================
+ * MODULE FUNCTIONS
+ * ============================================================================ */
+
+PyDoc_STRVAR(module_new_doc,
+"new($module, name, data=b'', /)\n--\n\n"
+"Return a new hash object for 'harmonia' or 'harmonia-ng'.");
+
+static PyObject *module_new(PyObject *Py_UNUSED(module), PyObject *args)
+{
+    const char *name;
+    PyObject *data = NULL;
+    HashObject *self;
+    hash_alg alg;
+
+    if (!PyArg_ParseTuple(args, "s|O:new", &name, &data)) {
+        return NULL;
+    }
+
+    if (strcmp(name, "harmonia") == 0) {
+        alg = ALG_HARMONIA;
+    } else if (strcmp(name, "harmonia-ng") == 0 || strcmp(name, "harmonia_ng") == 0) {
+        alg = ALG_HARMONIA_NG;
+    } else {
+        PyErr_Format(PyExc_ValueError, "unsupported hash type %s", name);
+        return NULL;
+    }
+
+    self = new_hash_object(alg);
+    if (self == NULL) {
+        return NULL;
+    }
+    ctx_init(self);
+
+    if (data != NULL && hash_absorb(self, data) < 0) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return (PyObject *)self;
+}
+
+typedef void (*oneshot_fn)(const uint8_t *data, size_t len, uint8_t *digest);
+
+static PyObject *oneshot(PyObject *obj, oneshot_fn fn)
+{
+    uint8_t digest[HARMONIA_DIGEST_SIZE];
+    Py_buffer view;
+
+    if (get_buffer(obj, &view) < 0) {
+        return NULL;
+    }
+
+    if (view.len >= HASHLIB_GIL_MINSIZE) {
+        Py_BEGIN_ALLOW_THREADS
+        fn((const uint8_t *)view.buf, (size_t)view.len, digest);
+        Py_END_ALLOW_THREADS
+    } else {
+        fn((const uint8_t *)view.buf, (size_t)view.len, digest);
+    }
+
+    PyBuffer_Release(&view);
+    return PyBytes_FromStringAndSize((const char *)digest, HARMONIA_DIGEST_SIZE);
+}
+
+PyDoc_STRVAR(module_harmonia_doc,
+"harmonia($module, data, /)\n--\n\n"
+"Compute the HARMONIA v2.2 digest of a bytes-like object.");
+
+static PyObject *module_harmonia(PyObject *Py_UNUSED(module), PyObject *obj)
+{
+    return oneshot(obj, harmonia);
+}
+
+PyDoc_STRVAR(module_harmonia_ng_doc,
+"harmonia_ng($module, data, /)\n--\n\n"
+"Compute the HARMONIA-NG digest of a bytes-like object.");
+
+static PyObject *module_harmonia_ng(PyObject *Py_UNUSED(module), PyObject *obj)
+{
+    return oneshot(obj, harmonia_ng_simd);
+}
+
+PyDoc_STRVAR(module_harmonia_fast_doc,
+"harmonia_fast($module, data, /)\n--\n\n"
+"Compute the HARMONIA-Fast digest of a bytes-like object.");
+
+static PyObject *module_harmonia_fast(PyObject *Py_UNUSED(module), PyObject *obj)
+{
+    return oneshot(obj, harmonia_fast);
+}
+
+PyDoc_STRVAR(module_harmonia_ng_x4_doc,
+"harmonia_ng_x4($module, msgs, /)\n--\n\n"
+"Hash four bytes-like objects in parallel; returns a list of four digests.\n"
+"Equal lengths use the x4 kernel, unequal lengths the lane scheduler.");
+
+static PyObject *module_harmonia_ng_x4(PyObject *Py_UNUSED(module), PyObject *arg)
+{
+    uint8_t digests[4][HARMONIA_DIGEST_SIZE];
+    uint8_t *outs[4];
+    const uint8_t *msgs[4];
+    size_t lens[4];
+    Py_buffer views[4];
+    PyObject *seq, *result;
+    int i, n = 0, equal = 1;
+
+    seq = PySequence_Fast(arg, "harmonia_ng_x4() expects a sequence of 4 buffers");
+    if (seq == NULL) {
+        return NULL;
+    }
+    if (PySequence_Fast_GET_SIZE(seq) != 4) {
+        PyErr_SetString(PyExc_ValueError, "harmonia_ng_x4() expects exactly 4 messages");
+        Py_DECREF(seq);
+        return NULL;
+    }
+
+    for (n = 0; n < 4; n++) {
+        if (get_buffer(PySequence_Fast_GET_ITEM(seq, n), &views[n]) < 0) {
+            goto done;
+        }
+        msgs[n] = (const uint8_t *)views[n].buf;
+        lens[n] = (size_t)views[n].len;
+        outs[n] = digests[n];
+        equal &= (lens[n] == lens[0]);
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    if (equal) {
+        harmonia_ng_x4(msgs, lens[0], outs);
+    } else {
+        harmonia_ng_multi(msgs, lens, &digests[0][0], 4);
+    }
+    Py_END_ALLOW_THREADS
+
+done:
+    for (i = 0; i < n; i++) {
+        PyBuffer_Release(&views[i]);
+    }
+    Py_DECREF(seq);
+    if (n < 4) {
+        return NULL;
+    }
+
+    result = PyList_New(4);
+    if (result == NULL) {
+        return NULL;
+    }
+    for (i = 0; i < 4; i++) {
+        PyObject *d = PyBytes_FromStringAndSize((const char *)digests[i], HARMONIA_DIGEST_SIZE);
+        if (d == NULL) {
+            Py_DECREF(result);
+            return NULL;
+        }
+        PyList_SET_ITEM(result, i, d);
+    }
+    return result;
+}
+
+PyDoc_STRVAR(module_harmonia_rounds_doc,
+"harmonia_rounds($module, data, rounds, /)\n--\n\n"
+"HARMONIA v2.2 digest with the compressor cut to rounds rounds\n"
+"(8, 16, ..., 64), for reduced-round analysis.");
+
+static PyObject *module_harmonia_rounds(PyObject *Py_UNUSED(module), PyObject *args)
+{
+    uint8_t digest[HARMONIA_DIGEST_SIZE];
+    Py_buffer view;
+    int rounds, rc;
+
+    if (!PyArg_ParseTuple(args, "y*i:harmonia_rounds", &view, &rounds)) {
+        return NULL;
+    }
+    rc = harmonia_rounds((const uint8_t *)view.buf, (size_t)view.len, digest, rounds);
+    PyBuffer_Release(&view);
+    if (rc != 0) {
+        PyErr_Format(PyExc_ValueError, "unsupported round count %d (multiples of 8 up to 64)", rounds);
+        return NULL;
+    }
+    return PyBytes_FromStringAndSize((const char *)digest, HARMONIA_DIGEST_SIZE);
+}
+
+static PyMethodDef module_methods[] = {
+    {"new",            module_new,            METH_VARARGS, module_new_doc},
+    {"harmonia",       module_harmonia,       METH_O,       module_harmonia_doc},
+    {"harmonia_ng",    module_harmonia_ng,    METH_O,       module_harmonia_ng_doc},
+    {"harmonia_fast",  module_harmonia_fast,  METH_O,       module_harmonia_fast_doc},
+    {"harmonia_ng_x4", module_harmonia_ng_x4, METH_O,       module_harmonia_ng_x4_doc},
+    {"harmonia_rounds", module_harmonia_rounds, METH_VARARGS, module_harmonia_rounds_doc},
+    {NULL, NULL, 0, NULL}
+};
+
+static struct PyModuleDef harmonia_module = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "_harmonia",
+    .m_doc = "Native HARMONIA engines (use harmonia_hashlib).",
+    .m_size = -1,
+    .m_methods = module_methods,
+};
+
+PyMODINIT_FUNC PyInit__harmonia(void)
+{
+    PyObject *m;
+
+    if (PyType_Ready(&HashType) < 0) {
+        return NULL;
+    }
+
+    m = PyModule_Create(&harmonia_module);
+    if (m == NULL) {
+        return NULL;
+    }
+
+    Py_INCREF(&HashType);
+    if (PyModule_AddObject(m, "HASH", (PyObject *)&HashType) < 0) {
+        Py_DECREF(&HashType);
+        Py_DECREF(m);
+        return NULL;
+    }
+    PyModule_AddIntConstant(m, "DIGEST_SIZE", HARMONIA_DIGEST_SIZE);
+    PyModule_AddIntConstant(m, "BLOCK_SIZE", HARMONIA_BLOCK_SIZE);
+    return m;
+}
@@ -0,0 +1,919 @@
+/*
+ * HARMONIA v2.2 - Multi-Buffer Hashing
+ *
+ * Hashes independent messages side by side, one message per SIMD lane:
+ * 16 lanes on AVX-512, 8 on AVX2, 4 on SSE4.1 and NEON, chosen at runtime
+ * from harmonia_cpu_features(). Digests are identical to harmonia().
+ *
+ * The v2.2 control flow depends only on the round number (Fibonacci word,
+ * i/j indices, rotations, exchange masks), so every lane runs the same
+ * instruction stream. The kernels expand the resolved schedule from
+ * harmonia_schedule.h against a small set of vector operation macros
+ * (VADD, VXOR, VROTL, ...), which each lane width defines before
+ * instantiating its compress function; all rotations stay immediates.
+ *
+ * Lanes are scheduled like harmonia_ng_multi: a lane that finishes its
+ * message is finalized and refilled at once, so messages of any length mix
+ * in one batch. Works with either v2.2 engine (harmonia.c or
+ * harmonia_simd.c).
+ *
+ * License: MIT
+ */
+
+#include "harmonia.h"
+#include "harmonia_schedule.h"
+#include "harmonia_cpu.h"
+#include "harmonia_stats.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define MAX_LANES 16
+
+/* Lane state in memory as [word][lane], one vector per row */
+typedef uint32_t lane_words[16][MAX_LANES];
+typedef uint32_t lane_state[8][MAX_LANES];
+
+typedef void (*compress_lanes_fn)(lane_words words, lane_state state_g, lane_state state_c);
+
+/* ============================================================================
+ * LANE-PARALLEL COMPRESSION (expands against the current V* ops)
+ * ============================================================================ */
+
+#define EXPAND_XN(idx, rot1, rot2, shift) \
+    w[idx] = VXOR(VXOR(VROTR(w[(idx) - 2], rot1), VROTL(w[(idx) - 7], rot2)), \
+                  VXOR(VSHR(w[(idx) - 15], shift), w[(idx) - 16]));
+
+/* mix_golden / mix_complementary; a and b may name the same word (i == j) */
+#define MIX_GOLDEN_XN(a, b, K, ROT1, ROT2) do { \
+    VEC va_ = VXOR(VADD(VROTR(a, ROT1), b), VSET1(K)); \
+    VEC vb_ = VADD(VXOR(VROTL(b, ROT2), va_), VSET1(K)); \
+    VEC mix_ = VXOR(VADD(VSHL(va_, 1), va_), VADD(VSHL(vb_, 2), vb_)); \
+    a = VXOR(va_, VSHR(mix_, 11)); \
+    b = VXOR(vb_, VSHL(mix_, 7)); \
+} while (0)
+
+#define MIX_COMPLEMENTARY_XN(a, b, K, ROT1, ROT2) do { \
+    VEC va_ = VADD(VROTL(VXOR(a, b), ROT1), VSET1((K) >> 1)); \
+    VEC vb_ = VXOR(VROTR(VADD(b, va_), ROT2), VSET1((K) >> 1)); \
+    a = va_; \
+    b = vb_; \
+} while (0)
+
+#define EXCHANGE_WORD_XN(k, xmask) \
+    if ((xmask) & (1u << (k))) { \
+        VEC t_ = VXOR(g[k], c[k]); \
+        g[k] = VADD(g[k], VSHR(t_, 8)); \
+        c[k] = VADD(c[k], VAND(t_, VSET1(0xFF00))); \
+    }
+
+#define EDGE_XN_STREAM(s, ROT_L, ROT_R, FIB) do { \
+    VEC ie_; \
+    s[0] = VXOR(VROTR(s[0], ROT_L), VSET1(FIB)); \
+    s[7] = VXOR(VROTL(s[7], ROT_R), VSET1(~(FIB))); \
+    ie_ = VSHR(VXOR(s[0], s[7]), 16); \
+    s[0] = VADD(s[0], ie_); \
+    s[7] = VADD(s[7], ie_); \
+} while (0)
+
+#define ROUND_XN(r, i, j, type, g_rot1, g_rot2, c_rot1, c_rot2, xmask, edge_l, edge_r) \
+    if (type) { \
+        MIX_GOLDEN_XN(g[i], g[j], PHI_CONSTANTS[(r) & 15], g_rot1, g_rot2); \
+        g[i] = VADD(g[i], w[r]); \
+        MIX_GOLDEN_XN(c[i], c[j], RECIPROCAL_CONSTANTS[(r) & 15], c_rot1, c_rot2); \
+        c[j] = VADD(c[j], w[63 - (r)]); \
+        EXCHANGE_WORD_XN(0, xmask) EXCHANGE_WORD_XN(1, xmask) \
+        EXCHANGE_WORD_XN(2, xmask) EXCHANGE_WORD_XN(3, xmask) \
+        EXCHANGE_WORD_XN(4, xmask) EXCHANGE_WORD_XN(5, xmask) \
+        EXCHANGE_WORD_XN(6, xmask) EXCHANGE_WORD_XN(7, xmask) \
+    } else { \
+        VEC t_; \
+        MIX_COMPLEMENTARY_XN(g[i], g[j], PHI_CONSTANTS[(r) & 15], g_rot1, g_rot2); \
+        g[j] = VADD(g[j], w[r]); \
+        MIX_COMPLEMENTARY_XN(c[j], c[i], RECIPROCAL_CONSTANTS[(r) & 15], c_rot1, c_rot2); \
+        c[i] = VADD(c[i], w[63 - (r)]); \
+        t_ = VXOR(g[0], c[7]); \
+        g[0] = VXOR(g[0], VSHR(t_, 16)); \
+        c[7] = VXOR(c[7], VAND(t_, VSET1(0xFFFF))); \
+    } \
+    if (((r) & 7) == 7) { \
+        EDGE_XN_STREAM(g, edge_l, edge_r, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+        EDGE_XN_STREAM(c, edge_l, edge_r, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+    }
+
+/* Body of a compress_lanes_xN function: one block per lane, Davies-Meyer */
+#define COMPRESS_LANES_XN() do { \
+    VEC w[64], g[8], c[8]; \
+    int k; \
+    for (k = 0; k < 16; k++) { \
+        w[k] = VLOAD(words[k]); \
+    } \
+    EXPANSION_SCHEDULE(EXPAND_XN) \
+    for (k = 0; k < 8; k++) { \
+        g[k] = VLOAD(state_g[k]); \
+        c[k] = VLOAD(state_c[k]); \
+    } \
+    ROUND_SCHEDULE(ROUND_XN) \
+    for (k = 0; k < 8; k++) { \
+        VSTORE(state_g[k], VADD(VLOAD(state_g[k]), g[k])); \
+        VSTORE(state_c[k], VADD(VLOAD(state_c[k]), c[k])); \
+    } \
+} while (0)
+
+/* ---------------------------------------------------------------------------
+ * Scalar: 1 lane (fallback and reference)
+ * --------------------------------------------------------------------------- */
+
+#define VEC          uint32_t
+#define VLOAD(p)     (*(p))
+#define VSTORE(p, v) (*(p) = (v))
+#define VADD(a, b)   ((a) + (b))
+#define VXOR(a, b)   ((a) ^ (b))
+#define VAND(a, b)   ((a) & (b))
+#define VSHR(x, n)   ((x) >> (n))
+#define VSHL(x, n)   ((x) << (n))
+#define VSET1(k)     ((uint32_t)(k))
+#define VROTL(x, n)  (((x) << ((n) & 31)) | ((x) >> ((32 - (n)) & 31)))
+#define VROTR(x, n)  VROTL(x, (32 - (n)) & 31)
+
+static void compress_lanes_x1(lane_words words, lane_state state_g, lane_state state_c)
+{
+    COMPRESS_LANES_XN();
+}
+
+#undef VEC
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VXOR
+#undef VAND
+#undef VSHR
+#undef VSHL
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+#if defined(HARMONIA_X86)
+#include <immintrin.h>
+
+/* ---------------------------------------------------------------------------
+ * SSE4.1: 4 lanes
+ * --------------------------------------------------------------------------- */
+
+#define VEC          __m128i
+#define VLOAD(p)     _mm_load_si128((const __m128i *)(p))
+#define VSTORE(p, v) _mm_store_si128((__m128i *)(p), (v))
+#define VADD         _mm_add_epi32
+#define VXOR         _mm_xor_si128
+#define VAND         _mm_and_si128
+#define VSHR         _mm_srli_epi32
+#define VSHL         _mm_slli_epi32
+#define VSET1(k)     _mm_set1_epi32((int)(k))
+#define VROTL(x, n)  _mm_or_si128(_mm_slli_epi32((x), (n) & 31), _mm_srli_epi32((x), (32 - (n)) & 31))
+#define VROTR(x, n)  VROTL(x, (32 - (n)) & 31)
+
+HARMONIA_TARGET_SSE41
+static void compress_lanes_x4(lane_words words, lane_state state_g, lane_state state_c)
+{
+    COMPRESS_LANES_XN();
+}
+
+#undef VEC
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VXOR
+#undef VAND
+#undef VSHR
+#undef VSHL
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+/* ---------------------------------------------------------------------------
+ * AVX2: 8 lanes
+ * --------------------------------------------------------------------------- */
+
+#define VEC          __m256i
+#define VLOAD(p)     _mm256_load_si256((const __m256i *)(p))
+#define VSTORE(p, v) _mm256_store_si256((__m256i *)(p), (v))
+#define VADD         _mm256_add_epi32
+#define VXOR         _mm256_xor_si256
+#define VAND         _mm256_and_si256
+#define VSHR         _mm256_srli_epi32
+#define VSHL         _mm256_slli_epi32
+#define VSET1(k)     _mm256_set1_epi32((int)(k))
+#define VROTL(x, n)  _mm256_or_si256(_mm256_slli_epi32((x), (n) & 31), _mm256_srli_epi32((x), (32 - (n)) & 31))
+#define VROTR(x, n)  VROTL(x, (32 - (n)) & 31)
+
+HARMONIA_TARGET_AVX2
+static void compress_lanes_x8(lane_words words, lane_state state_g, lane_state state_c)
+{
+    COMPRESS_LANES_XN();
+}
+
+#undef VEC
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VXOR
+#undef VAND
+#undef VSHR
+#undef VSHL
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+/* ---------------------------------------------------------------------------
+ * AVX-512: 16 lanes (native vector rotates)
+ * --------------------------------------------------------------------------- */
+
+#define VEC          __m512i
+#define VLOAD(p)     _mm512_load_si512((const void *)(p))
+#define VSTORE(p, v) _mm512_store_si512((void *)(p), (v))
+#define VADD         _mm512_add_epi32
+#define VXOR         _mm512_xor_si512
+#define VAND         _mm512_and_si512
+#define VSHR         _mm512_srli_epi32
+#define VSHL         _mm512_slli_epi32
+#define VSET1(k)     _mm512_set1_epi32((int)(k))
+#define VROTL(x, n)  _mm512_rol_epi32((x), (n) & 31)
+#define VROTR(x, n)  _mm512_ror_epi32((x), (n) & 31)
+
+HARMONIA_TARGET_AVX512
+static void compress_lanes_x16(lane_words words, lane_state state_g, lane_state state_c)
+{
+    COMPRESS_LANES_XN();
+}
+
+#undef VEC
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VXOR
+#undef VAND
+#undef VSHR
+#undef VSHL
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+#endif /* HARMONIA_X86 */
+
+#if defined(HARMONIA_ARM_NEON)
+#include <arm_neon.h>
+
+/* ---------------------------------------------------------------------------
+ * NEON: 4 lanes (shift + shift-right-insert rotates)
+ * --------------------------------------------------------------------------- */
+
+#define VEC          uint32x4_t
+#define VLOAD(p)     vld1q_u32(p)
+#define VSTORE(p, v) vst1q_u32((p), (v))
+#define VADD         vaddq_u32
+#define VXOR         veorq_u32
+#define VAND         vandq_u32
+#define VSHR         vshrq_n_u32
+#define VSHL         vshlq_n_u32
+#define VSET1(k)     vdupq_n_u32((uint32_t)(k))
+#define VROTL(x, n)  vsriq_n_u32(vshlq_n_u32((x), (n) & 31), (x), 32 - ((n) & 31))
+#define VROTR(x, n)  VROTL(x, (32 - (n)) & 31)
+
+static void compress_lanes_x4(lane_words words, lane_state state_g, lane_state state_c)
+{
+    COMPRESS_LANES_XN();
+}
+
+#undef VEC
+#undef VLOAD
+#undef VSTORE
+#undef VADD
+#undef VXOR
+#undef VAND
+#undef VSHR
+#undef VSHL
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+#endif /* HARMONIA_ARM_NEON */
+
+/* Widest lane kernel for this CPU, bound on first use */
+static struct {
+    int lanes;
+    compress_lanes_fn compress;
+    const char *name;
+} lane_engine;
+
+static void bind_lane_engine(void)
+{
+    unsigned features = harmonia_cpu_features();
+    int lanes = 1;
+    compress_lanes_fn fn = compress_lanes_x1;
+    const char *name = "scalar x1";
+
+#if defined(HARMONIA_X86)
+    if (features & HARMONIA_CPU_AVX512) {
+        lanes = 16;
+        fn = compress_lanes_x16;
+        name = "AVX-512 x16";
+    } else if (features & HARMONIA_CPU_AVX2) {
+        lanes = 8;
+        fn = compress_lanes_x8;
+        name = "AVX2 x8";
+    } else if (features & HARMONIA_CPU_SSE41) {
+        lanes = 4;
+        fn = compress_lanes_x4;
+        name = "SSE4.1 x4";
+    }
+#elif defined(HARMONIA_ARM_NEON)
+    if (features & HARMONIA_CPU_NEON) {
+        lanes = 4;
+        fn = compress_lanes_x4;
+        name = "NEON x4";
+    }
+#else
+    (void)features;
+#endif
+
+    lane_engine.name = name;
+    lane_engine.compress = fn;
+    lane_engine.lanes = lanes;
+}
+
+/* ============================================================================
+ * LANE SCHEDULING
+ * ============================================================================ */
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static inline uint32_t load_be32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+}
+
+/* Per-lane scheduling state */
+typedef struct {
+    const uint8_t *data;    /* Next full message block */
+    size_t full_blocks;     /* Full message blocks left */
+    int head_pending;       /* head[] (prefix bytes + suffix start) still to compress */
+    int tail_blocks;        /* Padding blocks left after the full blocks */
+    int tail_pos;           /* Next padding block in tail[] */
+    size_t msg;             /* Index of the message in this lane */
+    uint32_t head[16];      /* First block when resuming from a midstate, as words */
+    uint32_t tail[2][16];   /* Last partial block + padding + length, as words */
+} v22_lane;
+
+/*
+ * Load a message into lane `l`, continuing from chaining state g/c over
+ * (prefix_len bytes already compressed) + head[0..head_len) + data[0..len).
+ * Builds the first block when head bytes complete one, and the padding words.
+ */
+static void lane_resume(v22_lane *lane, int l, size_t msg, const uint32_t *g, const uint32_t *c,
+                        uint64_t prefix_len, const uint8_t *head, size_t head_len,
+                        const uint8_t *data, size_t len, lane_state state_g, lane_state state_c)
+{
+    uint64_t bit_len = (prefix_len + head_len + len) * 8;
+    const uint8_t *tail;
+    size_t i, n;
+    int last;
+
+    for (i = 0; i < 8; i++) {
+        state_g[i][l] = g[i];
+        state_c[i][l] = c[i];
+    }
+    lane->msg = msg;
+    lane->head_pending = 0;
+
+    if (head_len > 0 && head_len + len >= 64) {
+        /* Complete the midstate's partial block with the start of data */
+        uint8_t block[64];
+        size_t take = 64 - head_len;
+
+        memcpy(block, head, head_len);
+        memcpy(block + head_len, data, take);
+        for (i = 0; i < 16; i++) {
+            lane->head[i] = load_be32(block + 4 * i);
+        }
+        lane->head_pending = 1;
+        data += take;
+        len -= take;
+        head_len = 0;
+    }
+
+    lane->data = data;
+    lane->full_blocks = len / 64;
+    tail = data + (len & ~(size_t)63);
+    n = head_len + (len & 63);
+    last = (n >= 56);
+    lane->tail_blocks = last + 1;
+    lane->tail_pos = 0;
+    HARMONIA_STAT(pad_blocks, last + 1);
+
+    memset(lane->tail, 0, sizeof(lane->tail));
+    for (i = 0; i < n; i++) {
+        uint8_t byte = (i < head_len) ? head[i] : tail[i - head_len];
+        lane->tail[0][i / 4] |= (uint32_t)byte << (24 - 8 * (i & 3));
+    }
+    lane->tail[0][n / 4] |= 0x80U << (24 - 8 * (n & 3));
+    lane->tail[last][14] = (uint32_t)(bit_len >> 32);
+    lane->tail[last][15] = (uint32_t)bit_len;
+}
+
+/* Load message `msg` into lane `l` from the IV */
+static void lane_start(v22_lane *lane, int l, size_t msg, const uint8_t *data, size_t len,
+                       lane_state state_g, lane_state state_c)
+{
+    lane_resume(lane, l, msg, PHI_CONSTANTS, RECIPROCAL_CONSTANTS, 0, NULL, 0, data, len,
+                state_g, state_c);
+}
+
+/* Start message `next` in lane `l`: from the prefix midstate when given, else the IV */
+static void lane_load(v22_lane *lane, int l, size_t next, const harmonia_ctx *prefix,
+                      const uint8_t *const *msgs, const size_t *lens,
+                      lane_state state_g, lane_state state_c)
+{
+    if (prefix) {
+        lane_resume(lane, l, next, prefix->state_g, prefix->state_c,
+                    prefix->total_len - prefix->buffer_len, prefix->buffer, prefix->buffer_len,
+                    msgs[next], lens[next], state_g, state_c);
+    } else {
+        lane_start(lane, l, next, msgs[next], lens[next], state_g, state_c);
+    }
+}
+
+#define FINAL_EDGE_XN(s, ROT_L, ROT_R, FIB) do { \
+    uint32_t fib_ = (FIB) * 0x9E3779B9U, ie_; \
+    s[0] = ROTR32(s[0], ROT_L) ^ fib_; \
+    s[7] = ROTL32(s[7], ROT_R) ^ ~fib_; \
+    ie_ = (s[0] ^ s[7]) >> 16; \
+    s[0] += ie_; \
+    s[7] += ie_; \
+} while (0)
+
+#define FINAL_EDGE_LANE_G(ROT_L, ROT_R, FIB) FINAL_EDGE_XN(g, ROT_L, ROT_R, FIB);
+#define FINAL_EDGE_LANE_C(ROT_L, ROT_R, FIB) FINAL_EDGE_XN(c, ROT_L, ROT_R, FIB);
+
+#define FUSE_LANE(i, rot, penrose) \
+    fused = (ROTR32(g[i], rot) ^ ROTL32(c[i], rot)) + PHI_CONSTANTS[i] + (penrose) * 0x01010101U; \
+    digest[(i) * 4 + 0] = (uint8_t)(fused >> 24); \
+    digest[(i) * 4 + 1] = (uint8_t)(fused >> 16); \
+    digest[(i) * 4 + 2] = (uint8_t)(fused >> 8); \
+    digest[(i) * 4 + 3] = (uint8_t)fused;
+
+#define CHECK_LANE(i, rot, penrose) \
+    diff |= ((ROTR32(g[i], rot) ^ ROTL32(c[i], rot)) + PHI_CONSTANTS[i] + (penrose) * 0x01010101U) ^ \
+            load_be32(expected + 4 * (i));
+
+/* Finalize lane `l` against a stored digest: nonzero on mismatch, nothing is written */
+static uint32_t lane_check(int l, lane_state state_g, lane_state state_c, const uint8_t *expected)
+{
+    uint32_t g[8], c[8], diff = 0;
+    int i;
+
+    HARMONIA_STAT(digests, 1);
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i][l];
+        c[i] = state_c[i][l];
+    }
+    FINAL_EDGE_G(FINAL_EDGE_LANE_G)
+    FINAL_EDGE_C(FINAL_EDGE_LANE_C)
+    FUSION_SCHEDULE(CHECK_LANE)
+    return diff;
+}
+
+/* A harmonia_multi_verify call, shared by its threads */
+typedef struct {
+    const uint8_t *const *msgs;
+    const size_t *lens;
+    const uint8_t *expected;    /* Digest k at 32*k */
+    size_t n;
+    size_t next;                /* First message of the next chunk, claimed atomically */
+    size_t *mismatches;
+    size_t count;               /* Entries of mismatches[], claimed atomically */
+#ifdef HARMONIA_STATS
+    pthread_mutex_t lock;
+    harmonia_stats stats;       /* Worker counters, merged into the caller's */
+#endif
+} verify_job;
+
+/* Finalize the message in lane `l` from its column of the lane state */
+static void lane_finish(int l, lane_state state_g, lane_state state_c, uint8_t *digest)
+{
+    uint32_t g[8], c[8], fused;
+    int i;
+
+    HARMONIA_STAT(digests, 1);
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i][l];
+        c[i] = state_c[i][l];
+    }
+    FINAL_EDGE_G(FINAL_EDGE_LANE_G)
+    FINAL_EDGE_C(FINAL_EDGE_LANE_C)
+    FUSION_SCHEDULE(FUSE_LANE)
+}
+
+/*
+ * Hash n messages of arbitrary lengths, keeping every SIMD lane busy, from
+ * the IV or, with a prefix context, from its midstate.
+ * digest k is written to digests + 32*k; with a verify job it is compared
+ * with the job's expected digest base + k instead, and a mismatch appends
+ * base + k to the job's list.
+ */
+static void multi_run(const harmonia_ctx *prefix, const uint8_t *const *msgs, const size_t *lens,
+                      uint8_t *digests, size_t n, verify_job *verify, size_t base)
+{
+    static lane_words idle_words;
+    uint32_t words[16][MAX_LANES] __attribute__((aligned(64)));
+    uint32_t state_g[8][MAX_LANES] __attribute__((aligned(64)));
+    uint32_t state_c[8][MAX_LANES] __attribute__((aligned(64)));
+    v22_lane lane[MAX_LANES];
+    int active[MAX_LANES];
+    int k, l, lanes, busy = 0;
+    size_t next = 0;
+
+    if (lane_engine.lanes == 0) {
+        bind_lane_engine();
+    }
+    lanes = lane_engine.lanes;
+    memcpy(words, idle_words, sizeof(words));
+    memset(state_g, 0, sizeof(state_g));
+    memset(state_c, 0, sizeof(state_c));
+
+    for (l = 0; l < lanes; l++) {
+        active[l] = (next < n);
+        if (active[l]) {
+            lane_load(&lane[l], l, next, prefix, msgs, lens, state_g, state_c);
+            next++;
+            busy++;
+        }
+    }
+
+    while (busy > 0) {
+        /* Gather this step's block of every lane as message words */
+        for (l = 0; l < lanes; l++) {
+            if (!active[l]) continue;
+
+            if (lane[l].head_pending) {
+                for (k = 0; k < 16; k++) {
+                    words[k][l] = lane[l].head[k];
+                }
+            } else if (lane[l].full_blocks > 0) {
+                for (k = 0; k < 16; k++) {
+                    words[k][l] = load_be32(lane[l].data + 4 * k);
+                }
+            } else {
+                for (k = 0; k < 16; k++) {
+                    words[k][l] = lane[l].tail[lane[l].tail_pos][k];
+                }
+            }
+        }
+
+        lane_engine.compress(words, state_g, state_c);
+        HARMONIA_PROBE2(lane__step, lanes, busy);
+        HARMONIA_STAT(lane_calls, 1);
+        HARMONIA_STAT(lane_slots, lanes);
+        HARMONIA_STAT(lane_busy, busy);
+        HARMONIA_STAT(blocks, busy);
+        if (lanes > 1) HARMONIA_STAT(simd_blocks, busy); else HARMONIA_STAT(scalar_blocks, busy);
+
+        for (l = 0; l < lanes; l++) {
+            if (!active[l]) continue;
+
+            if (lane[l].head_pending) {
+                lane[l].head_pending = 0;
+                continue;
+            }
+            if (lane[l].full_blocks > 0) {
+                lane[l].data += 64;
+                lane[l].full_blocks--;
+                continue;
+            }
+            if (++lane[l].tail_pos < lane[l].tail_blocks) continue;
+
+            /* Message done: emit or check its digest and refill the lane */
+            if (!verify) {
+                lane_finish(l, state_g, state_c, digests + 32 * lane[l].msg);
+            } else if (lane_check(l, state_g, state_c, verify->expected + 32 * (base + lane[l].msg))) {
+                size_t slot = __atomic_fetch_add(&verify->count, 1, __ATOMIC_RELAXED);
+                verify->mismatches[slot] = base + lane[l].msg;
+            }
+            if (next < n) {
+                lane_load(&lane[l], l, next, prefix, msgs, lens, state_g, state_c);
+                next++;
+            } else {
+                active[l] = 0;
+                busy--;
+            }
+        }
+    }
+}
+
+void harmonia_multi(const uint8_t *const *msgs, const size_t *lens, uint8_t *digests, size_t n)
+{
+    multi_run(NULL, msgs, lens, digests, n, NULL, 0);
+}
+
+/*
+ * Hash prefix || suffixes[k] for every k, resuming each lane from the
+ * prefix midstate instead of recompressing the shared prefix.
+ */
+void harmonia_multi_prefixed(const harmonia_ctx *prefix, const uint8_t *const *suffixes,
+                             const size_t *lens, uint8_t *digests, size_t n)
+{
+    multi_run(prefix, suffixes, lens, digests, n, NULL, 0);
+}
+
+void harmonia_x4(const uint8_t *msgs[4], size_t len, uint8_t *digests[4])
+{
+    const size_t lens[4] = {len, len, len, len};
+    uint8_t out[4 * HARMONIA_DIGEST_SIZE];
+    int k;
+
+    harmonia_multi(msgs, lens, out, 4);
+    for (k = 0; k < 4; k++) {
+        memcpy(digests[k], out + k * HARMONIA_DIGEST_SIZE, HARMONIA_DIGEST_SIZE);
+    }
+}
+
+void harmonia_x8(const uint8_t *msgs[8], size_t len, uint8_t *digests[8])
+{
+    const size_t lens[8] = {len, len, len, len, len, len, len, len};
+    uint8_t out[8 * HARMONIA_DIGEST_SIZE];
+    int k;
+
+    harmonia_multi(msgs, lens, out, 8);
+    for (k = 0; k < 8; k++) {
+        memcpy(digests[k], out + k * HARMONIA_DIGEST_SIZE, HARMONIA_DIGEST_SIZE);
+    }
+}
+
+const char *harmonia_multi_engine(void)
+{
+    if (lane_engine.lanes == 0) {
+        bind_lane_engine();
+    }
+    return lane_engine.name;
+}
+
+/* ============================================================================
+ * VERIFICATION
+ * ============================================================================
+ *
+ * Threads claim chunks of VERIFY_CHUNK messages from a shared counter and
+ * run each through the lane scheduler in check mode: the final words are
+ * compared with the stored digest as they are fused, so no digest is
+ * written back and there is no second compare pass over memory.
+ */
+
+#define VERIFY_CHUNK        1024    /* messages per work item */
+#define VERIFY_MAX_THREADS  256
+
+static void verify_chunks(verify_job *job)
+{
+    size_t base;
+
+    while ((base = __atomic_fetch_add(&job->next, VERIFY_CHUNK, __ATOMIC_RELAXED)) < job->n) {
+        size_t count = (job->n - base < VERIFY_CHUNK) ? job->n - base : VERIFY_CHUNK;
+        multi_run(NULL, job->msgs + base, job->lens + base, NULL, count, job, base);
+    }
+}
+
+static void *verify_worker(void *arg)
+{
+    verify_job *job = (verify_job *)arg;
+#ifdef HARMONIA_STATS
+    harmonia_stats before;
+
+    harmonia_stats_get(&before);
+#endif
+    verify_chunks(job);
+#ifdef HARMONIA_STATS
+    /* Credit the work to the caller of harmonia_multi_verify() */
+    pthread_mutex_lock(&job->lock);
+    harmonia_stats_accumulate(&job->stats, &before);
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return NULL;
+}
+
+static int compare_index(const void *a, const void *b)
+{
+    size_t x = *(const size_t *)a, y = *(const size_t *)b;
+    return (x > y) - (x < y);
+}
+
+size_t harmonia_multi_verify(const uint8_t *const *msgs, const size_t *lens, const uint8_t *expected,
+                             size_t n, size_t *mismatches, int nthreads)
+{
+    pthread_t threads[VERIFY_MAX_THREADS];
+    size_t nchunks = (n + VERIFY_CHUNK - 1) / VERIFY_CHUNK;
+    verify_job job;
+    int t, started = 0;
+
+    /* Bind before the workers would race to */
+    if (lane_engine.lanes == 0) {
+        bind_lane_engine();
+    }
+    if (nthreads <= 0) nthreads = harmonia_cpu_count();
+    if (nthreads > VERIFY_MAX_THREADS) nthreads = VERIFY_MAX_THREADS;
+    if ((size_t)nthreads > nchunks) nthreads = (int)nchunks;
+
+    job.msgs = msgs;
+    job.lens = lens;
+    job.expected = expected;
+    job.n = n;
+    job.next = 0;
+    job.mismatches = mismatches;
+    job.count = 0;
+#ifdef HARMONIA_STATS
+    pthread_mutex_init(&job.lock, NULL);
+    memset(&job.stats, 0, sizeof(job.stats));
+#endif
+
+    /* The caller is one of the nthreads; a failed create just leaves fewer */
+    for (t = 1; t < nthreads; t++) {
+        if (pthread_create(&threads[started], NULL, verify_worker, &job) != 0) break;
+        started++;
+    }
+    verify_chunks(&job);
+    for (t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+#ifdef HARMONIA_STATS
+    harmonia_stats_merge(&job.stats);
+    pthread_mutex_destroy(&job.lock);
+#endif
+
+    /* Lanes and threads finish out of order */
+    qsort(mismatches, job.count, sizeof(*mismatches), compare_index);
+    return job.count;
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+int harmonia_multi_self_test(void)
+{
+    static const size_t counts[] = {1, 3, 4, 8, 17, 100};
+    const size_t max_n = 100;
+    const uint8_t *msgs[100];
+    size_t lens[100];
+    uint8_t *data, *digests, *expected;
+    uint32_t seed = 2024;
+    size_t t, k;
+    int failed = 0;
+
+    printf("\nHARMONIA v%s Multi-Buffer Self-Test (%s)\n", HARMONIA_VERSION, harmonia_multi_engine());
+    printf("============================================================\n");
+
+    data = (uint8_t *)malloc(2048 + 128);
+    digests = (uint8_t *)malloc(max_n * HARMONIA_DIGEST_SIZE);
+    expected = (uint8_t *)malloc(max_n * HARMONIA_DIGEST_SIZE);
+    if (!data || !digests || !expected) {
+        printf("  FAIL allocation\n");
+        failed = 1;
+        goto out;
+    }
+
+    /* Lengths around the 55/56/64-byte padding edges, and longer mixes */
+    for (k = 0; k < 2048 + 128; k++) data[k] = (uint8_t)(k * 29 + 3);
+    for (k = 0; k < max_n; k++) {
+        seed = seed * 1103515245U + 12345U;
+        lens[k] = (k < 20) ? 50 + k : (seed >> 8) % 2048;
+        msgs[k] = data + (k & 127);
+        harmonia(msgs[k], lens[k], expected + k * HARMONIA_DIGEST_SIZE);
+    }
+
+    for (t = 0; t < sizeof(counts) / sizeof(counts[0]); t++) {
+        memset(digests, 0, max_n * HARMONIA_DIGEST_SIZE);
+        harmonia_multi(msgs, lens, digests, counts[t]);
+        if (memcmp(digests, expected, counts[t] * HARMONIA_DIGEST_SIZE) == 0) {
+            printf("  OK   harmonia_multi, %3zu messages\n", counts[t]);
+        } else {
+            printf("  FAIL harmonia_multi, %3zu messages (!= harmonia)\n", counts[t]);
+            failed++;
+        }
+    }
+
+    /* Equal-length x4 / x8 against the one-shot hash */
+    {
+        static const size_t sizes[] = {0, 55, 56, 64, 200};
+        uint8_t out[8][HARMONIA_DIGEST_SIZE], ref[HARMONIA_DIGEST_SIZE];
+        uint8_t *outs[8];
+        int ok = 1, m;
+
+        for (m = 0; m < 8; m++) outs[m] = out[m];
+        for (t = 0; t < sizeof(sizes) / sizeof(sizes[0]); t++) {
+            harmonia_x4(msgs, sizes[t], outs);
+            for (m = 0; m < 4; m++) {
+                harmonia(msgs[m], sizes[t], ref);
+                ok &= memcmp(out[m], ref, HARMONIA_DIGEST_SIZE) == 0;
+            }
+            harmonia_x8(msgs, sizes[t], outs);
+            for (m = 0; m < 8; m++) {
+                harmonia(msgs[m], sizes[t], ref);
+                ok &= memcmp(out[m], ref, HARMONIA_DIGEST_SIZE) == 0;
+            }
+        }
+        if (ok) {
+            printf("  OK   harmonia_x4 / harmonia_x8 (0, 55, 56, 64, 200 bytes)\n");
+        } else {
+            printf("  FAIL harmonia_x4 / harmonia_x8\n");
+            failed++;
+        }
+    }
+
+    /* Prefix midstate: batched suffixes and ctx copies against one-shot hashing */
+    {
+        static const size_t prefix_lens[] = {0, 1, 40, 63, 64, 100, 200};
+        const uint8_t *suffixes[37];
+        size_t slens[37], p;
+        uint8_t msg[400], ref[HARMONIA_DIGEST_SIZE], got[HARMONIA_DIGEST_SIZE];
+        harmonia_ctx prefix, clone;
+        int ok = 1;
+
+        for (k = 0; k < 37; k++) {
+            slens[k] = (k * 23) % 150;        /* every head / tail combination */
+            suffixes[k] = data + 300 + k;
+        }
+        for (p = 0; p < sizeof(prefix_lens) / sizeof(prefix_lens[0]); p++) {
+            harmonia_init(&prefix);
+            harmonia_update(&prefix, data, prefix_lens[p]);
+            harmonia_multi_prefixed(&prefix, suffixes, slens, digests, 37);
+
+            for (k = 0; k < 37; k++) {
+                memcpy(msg, data, prefix_lens[p]);
+                memcpy(msg + prefix_lens[p], suffixes[k], slens[k]);
+                harmonia(msg, prefix_lens[p] + slens[k], ref);
+                ok &= memcmp(digests + k * HARMONIA_DIGEST_SIZE, ref, HARMONIA_DIGEST_SIZE) == 0;
+
+                /* A copy continues independently of the original */
+                harmonia_ctx_copy(&clone, &prefix);
+                harmonia_update(&clone, suffixes[k], slens[k]);
+                harmonia_final(&clone, got);
+                ok &= memcmp(got, ref, HARMONIA_DIGEST_SIZE) == 0;
+            }
+        }
+        if (ok) {
+            printf("  OK   harmonia_multi_prefixed, prefixes 0..200 x 37 suffixes (0..149 bytes)\n");
+        } else {
+            printf("  FAIL harmonia_multi_prefixed (!= harmonia)\n");
+            failed++;
+        }
+    }
+
+    /* Verification: corrupted digests come back as ascending indices */
+    {
+        enum { VN = 5000 };
+        static const int threads[] = {1, 3, 0};
+        static const size_t bad[] = {0, 1023, 1024, 2500, 4999};
+        const size_t nbad = sizeof(bad) / sizeof(bad[0]);
+        const uint8_t **vmsgs = (const uint8_t **)malloc(VN * sizeof(*vmsgs));
+        size_t *vlens = (size_t *)malloc(VN * sizeof(*vlens));
+        size_t *found = (size_t *)malloc(VN * sizeof(*found));
+        uint8_t *stored = (uint8_t *)malloc(VN * HARMONIA_DIGEST_SIZE);
+        size_t n;
+        int ok = vmsgs && vlens && found && stored;
+
+        for (k = 0; ok && k < VN; k++) {
+            vmsgs[k] = data + (k & 127);
+            vlens[k] = (k * 37) % 300;
+            harmonia(vmsgs[k], vlens[k], stored + k * HARMONIA_DIGEST_SIZE);
+        }
+        for (t = 0; ok && t < sizeof(threads) / sizeof(threads[0]); t++) {
+            ok &= harmonia_multi_verify(vmsgs, vlens, stored, VN, found, threads[t]) == 0;
+        }
+        for (k = 0; ok && k < nbad; k++) {
+            stored[bad[k] * HARMONIA_DIGEST_SIZE + (k * 7) % HARMONIA_DIGEST_SIZE] ^= 0x10;
+        }
+        for (t = 0; ok && t < sizeof(threads) / sizeof(threads[0]); t++) {
+            n = harmonia_multi_verify(vmsgs, vlens, stored, VN, found, threads[t]);
+            ok &= n == nbad && memcmp(found, bad, sizeof(bad)) == 0;
+        }
+        ok &= harmonia_multi_verify(vmsgs, vlens, stored, 0, found, 0) == 0;
+
+        if (ok) {
+            printf("  OK   harmonia_multi_verify, %d messages (1, 3, all threads)\n", VN);
+        } else {
+            printf("  FAIL harmonia_multi_verify\n");
+            failed++;
+        }
+        free(vmsgs);
+        free(vlens);
+        free(found);
+        free(stored);
+    }
+
+out:
+    free(data);
+    free(digests);
+    free(expected);
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
@@ -16,6 +16,9 @@
  */
 
 #include "harmonia_ng.h"
+#include "harmonia_stats.h"
+#include "harmonia_iov.h"
+#include "harmonia_constants.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -34,84 +37,13 @@
  * CONSTANTS
  * ============================================================================ */
 
-/* Fibonacci sequence (first 12 values) */
-static const uint32_t FIBONACCI[12] = {
-    1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144
-};
-
-/* Golden ratio constants (derived from φ) */
-static const uint32_t PHI_CONSTANTS[16] = {
-    0x9E37605A, 0xDAC1E0F2, 0xF287A338, 0xFA8CFC04,
-    0xFD805AA6, 0xCCF29760, 0xFF8184C3, 0xFF850D11,
-    0xCC32476B, 0x98767486, 0xFFF82080, 0x30E4E2F3,
-    0xFCC3ACC1, 0xE5216F38, 0xF30E4CC9, 0x948395F6
-};
-
-/* Reciprocal constants (derived from 1/φ) */
-static const uint32_t RECIPROCAL_CONSTANTS[16] = {
-    0x7249217F, 0x5890EB7C, 0x4786B47C, 0x4C51DBE8,
-    0x4E4DA61B, 0x4F76650C, 0x4F2F1A2A, 0x4F6CE289,
-    0x4F1ADF40, 0x4E84BABC, 0x4F22D993, 0x497FA704,
-    0x4F514F19, 0x4E8F43B8, 0x508E2FD9, 0x4B5F94A4
-};
-
-/* Initial hash values (golden stream) */
-static const uint32_t INITIAL_HASH_G[8] = {
-    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
-    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
-};
-
-/* Initial hash values (complementary stream) */
-static const uint32_t INITIAL_HASH_C[8] = {
-    0x9E3779B9, 0x7F4A7C15, 0xF39CC060, 0x5CEDC834,
-    0x2FE12A6D, 0x4786B47C, 0xC8A5E2F0, 0x3A8D6B7F
-};
-
-/* Pre-computed rotation schedule (32 rounds x 4 rotations)
- * Generated from Fibonacci word with rotation sets A=(7,12,8,16), B=(5,11,9,13)
- * Must match Python harmonia_ng._generate_rotation_schedule() exactly */
+/* Pre-computed rotation schedule (32 rounds x 4 rotations) */
 static const uint8_t ROUND_ROTATIONS[32][4] = {
-    {12, 8, 16, 7},   /* Round 0:  A */
-    {11, 9, 13, 5},   /* Round 1:  B */
-    {8, 16, 7, 12},   /* Round 2:  A */
-    {16, 7, 12, 8},   /* Round 3:  A */
-    {11, 9, 13, 5},   /* Round 4:  B */
-    {7, 12, 8, 16},   /* Round 5:  A */
-    {11, 9, 13, 5},   /* Round 6:  B */
-    {12, 8, 16, 7},   /* Round 7:  A */
-    {8, 16, 7, 12},   /* Round 8:  A */
-    {13, 5, 11, 9},   /* Round 9:  B */
-    {12, 8, 16, 7},   /* Round 10: A */
-    {7, 12, 8, 16},   /* Round 11: A */
-    {11, 9, 13, 5},   /* Round 12: B */
-    {12, 8, 16, 7},   /* Round 13: A */
-    {9, 13, 5, 11},   /* Round 14: B */
-    {16, 7, 12, 8},   /* Round 15: A */
-    {12, 8, 16, 7},   /* Round 16: A */
-    {5, 11, 9, 13},   /* Round 17: B */
-    {12, 8, 16, 7},   /* Round 18: A */
-    {11, 9, 13, 5},   /* Round 19: B */
-    {8, 16, 7, 12},   /* Round 20: A */
-    {16, 7, 12, 8},   /* Round 21: A */
-    {11, 9, 13, 5},   /* Round 22: B */
-    {7, 12, 8, 16},   /* Round 23: A */
-    {12, 8, 16, 7},   /* Round 24: A */
-    {11, 9, 13, 5},   /* Round 25: B */
-    {8, 16, 7, 12},   /* Round 26: A */
-    {13, 5, 11, 9},   /* Round 27: B */
-    {12, 8, 16, 7},   /* Round 28: A */
-    {7, 12, 8, 16},   /* Round 29: A */
-    {11, 9, 13, 5},   /* Round 30: B */
-    {12, 8, 16, 7},   /* Round 31: A */
+#define ROTATION_ROW(r, r1, r2, r3, r4) {r1, r2, r3, r4},
+    NG_ROTATION_SCHEDULE(ROTATION_ROW)
+#undef ROTATION_ROW
 };
 
-/* Fixed rotations for edge protection */
-#define EDGE_ROT_LEFT  7
-#define EDGE_ROT_RIGHT 13
-
-/* Fixed rotation for cross-stream diffusion */
-#define CROSS_STREAM_ROT 11
-
 /* ============================================================================
  * PRIMITIVE OPERATIONS
  * ============================================================================ */
@@ -219,21 +151,19 @@ static void cross_stream_diffusion(uint32_t *g, uint32_t *c)
  * MESSAGE EXPANSION
  * ============================================================================ */
 
-static void expand_message(const uint8_t *block, uint32_t *w)
+static inline uint32_t load_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | ((uint32_t)p[3]);
+}
+
+/* Expand w[0..15] (big-endian message words) to 32 words */
+static void expand_words(uint32_t *w)
 {
     int i;
     uint32_t s0, s1, fib_factor;
     int rot1, rot2;
 
-    /* Parse first 16 words (big-endian) */
-    for (i = 0; i < 16; i++) {
-        w[i] = ((uint32_t)block[i*4] << 24) |
-               ((uint32_t)block[i*4+1] << 16) |
-               ((uint32_t)block[i*4+2] << 8) |
-               ((uint32_t)block[i*4+3]);
-    }
-
-    /* Expand to 32 words */
     for (i = 16; i < 32; i++) {
         rot1 = 7 + (i % 5);
         rot2 = 17 + (i % 4);
@@ -251,16 +181,16 @@ static void expand_message(const uint8_t *block, uint32_t *w)
  * COMPRESSION FUNCTION (SCALAR)
  * ============================================================================ */
 
-static void compress_scalar(const uint8_t *block, uint32_t *state_g, uint32_t *state_c)
+/* Compress one block given as 16 big-endian message words in w[0..15] */
+static void compress_words(uint32_t *w, uint32_t *state_g, uint32_t *state_c)
 {
-    uint32_t w[32];
     uint32_t g[8], c[8];
     int r, i;
     int r1, r2, r3, r4;
     uint32_t k_phi, k_rec;
 
     /* Expand message */
-    expand_message(block, w);
+    expand_words(w);
 
     /* Copy state */
     for (i = 0; i < 8; i++) {
@@ -321,6 +251,58 @@ static void compress_scalar(const uint8_t *block, uint32_t *state_g, uint32_t *s
     }
 }
 
+static void compress_scalar(const uint8_t *block, uint32_t *state_g, uint32_t *state_c)
+{
+    uint32_t w[32];
+    int i;
+
+    HARMONIA_STAT(blocks, 1);
+    HARMONIA_STAT(scalar_blocks, 1);
+
+    for (i = 0; i < 16; i++) {
+        w[i] = load_be32(block + i*4);
+    }
+    compress_words(w, state_g, state_c);
+}
+
+/*
+ * Pad and compress the last n (< 64) bytes of a total_len-byte message,
+ * building the padded words directly: n <= 55 fits one block, 56..63 needs
+ * a second block holding only the length.
+ */
+static void compress_tail(const uint8_t *tail, size_t n, uint64_t total_len,
+                          uint32_t *state_g, uint32_t *state_c)
+{
+    uint32_t w[32];
+    uint64_t bit_len = total_len * 8;
+    size_t i, full = n / 4;
+
+    HARMONIA_STAT(blocks, (n >= 56) ? 2 : 1);
+    HARMONIA_STAT(scalar_blocks, (n >= 56) ? 2 : 1);
+    HARMONIA_STAT(pad_blocks, (n >= 56) ? 2 : 1);
+
+    for (i = 0; i < 16; i++) {
+        w[i] = 0;
+    }
+    for (i = 0; i < full; i++) {
+        w[i] = load_be32(tail + i*4);
+    }
+    for (i = full * 4; i < n; i++) {
+        w[i / 4] |= (uint32_t)tail[i] << (24 - 8 * (i & 3));
+    }
+    w[n / 4] |= 0x80U << (24 - 8 * (n & 3));
+
+    if (n >= 56) {
+        compress_words(w, state_g, state_c);
+        for (i = 0; i < 16; i++) {
+            w[i] = 0;
+        }
+    }
+    w[14] = (uint32_t)(bit_len >> 32);
+    w[15] = (uint32_t)bit_len;
+    compress_words(w, state_g, state_c);
+}
+
 /* ============================================================================
  * FINALIZATION
  * ============================================================================ */
@@ -331,6 +313,8 @@ static void finalize(uint32_t *state_g, uint32_t *state_c, uint8_t *digest)
     uint32_t fused;
     int i, rot;
 
+    HARMONIA_STAT(digests, 1);
+
     /* Copy state */
     for (i = 0; i < 8; i++) {
         g[i] = state_g[i];
@@ -364,8 +348,8 @@ void harmonia_ng_init(harmonia_ng_ctx *ctx)
 {
     int i;
     for (i = 0; i < 8; i++) {
-        ctx->state_g[i] = INITIAL_HASH_G[i];
-        ctx->state_c[i] = INITIAL_HASH_C[i];
+        ctx->state_g[i] = NG_INITIAL_HASH_G[i];
+        ctx->state_c[i] = NG_INITIAL_HASH_C[i];
     }
     ctx->buffer_len = 0;
     ctx->total_len = 0;
@@ -375,6 +359,7 @@ void harmonia_ng_update(harmonia_ng_ctx *ctx, const uint8_t *data, size_t len)
 {
     size_t remaining, to_copy;
 
+    HARMONIA_STAT(updates, 1);
     ctx->total_len += len;
 
     /* If we have buffered data, try to complete a block */
@@ -382,6 +367,8 @@ void harmonia_ng_update(harmonia_ng_ctx *ctx, const uint8_t *data, size_t len)
         remaining = 64 - ctx->buffer_len;
         to_copy = (len < remaining) ? len : remaining;
         memcpy(ctx->buffer + ctx->buffer_len, data, to_copy);
+        HARMONIA_STAT(buffer_copies, 1);
+        HARMONIA_STAT(buffer_bytes, to_copy);
         ctx->buffer_len += to_copy;
         data += to_copy;
         len -= to_copy;
@@ -402,50 +389,57 @@ void harmonia_ng_update(harmonia_ng_ctx *ctx, const uint8_t *data, size_t len)
     /* Buffer remaining data */
     if (len > 0) {
         memcpy(ctx->buffer, data, len);
+        HARMONIA_STAT(buffer_copies, 1);
+        HARMONIA_STAT(buffer_bytes, len);
         ctx->buffer_len = len;
     }
 }
 
-void harmonia_ng_final(harmonia_ng_ctx *ctx, uint8_t *digest)
+/* compress_scalar over consecutive blocks, for the updatev driver */
+static void compress_scalar_blocks(const uint8_t *data, size_t nblocks,
+                                   uint32_t *state_g, uint32_t *state_c)
 {
-    uint64_t bit_len = ctx->total_len * 8;
-    size_t pad_len;
-
-    /* Append 0x80 */
-    ctx->buffer[ctx->buffer_len++] = 0x80;
-
-    /* Pad to 56 bytes (mod 64) */
-    if (ctx->buffer_len > 56) {
-        /* Need another block */
-        memset(ctx->buffer + ctx->buffer_len, 0, 64 - ctx->buffer_len);
-        compress_scalar(ctx->buffer, ctx->state_g, ctx->state_c);
-        ctx->buffer_len = 0;
+    while (nblocks-- > 0) {
+        compress_scalar(data, state_g, state_c);
+        data += 64;
     }
+}
 
-    memset(ctx->buffer + ctx->buffer_len, 0, 56 - ctx->buffer_len);
-
-    /* Append 64-bit length (big-endian) */
-    ctx->buffer[56] = (bit_len >> 56) & 0xFF;
-    ctx->buffer[57] = (bit_len >> 48) & 0xFF;
-    ctx->buffer[58] = (bit_len >> 40) & 0xFF;
-    ctx->buffer[59] = (bit_len >> 32) & 0xFF;
-    ctx->buffer[60] = (bit_len >> 24) & 0xFF;
-    ctx->buffer[61] = (bit_len >> 16) & 0xFF;
-    ctx->buffer[62] = (bit_len >> 8) & 0xFF;
-    ctx->buffer[63] = bit_len & 0xFF;
-
-    compress_scalar(ctx->buffer, ctx->state_g, ctx->state_c);
+void harmonia_ng_updatev(harmonia_ng_ctx *ctx, const struct iovec *iov, int iovcnt)
+{
+    ctx->total_len += harmonia_iov_absorb(iov, iovcnt, ctx->buffer, &ctx->buffer_len,
+                                          ctx->state_g, ctx->state_c, compress_scalar_blocks);
+}
 
-    /* Finalize */
+void harmonia_ng_final(harmonia_ng_ctx *ctx, uint8_t *digest)
+{
+    HARMONIA_PROBE2(final__start, ctx, digest);
+    compress_tail(ctx->buffer, ctx->buffer_len, ctx->total_len, ctx->state_g, ctx->state_c);
     finalize(ctx->state_g, ctx->state_c, digest);
+    HARMONIA_PROBE2(final__done, ctx, digest);
 }
 
+/*
+ * One-shot hash without a context: full blocks are compressed in place and
+ * the tail is padded directly, so short messages (one block up to 55 bytes,
+ * two up to 119) cost only their compressions.
+ */
 void harmonia_ng(const uint8_t *data, size_t len, uint8_t *digest)
 {
-    harmonia_ng_ctx ctx;
-    harmonia_ng_init(&ctx);
-    harmonia_ng_update(&ctx, data, len);
-    harmonia_ng_final(&ctx, digest);
+    uint32_t state_g[8], state_c[8];
+    size_t full = len & ~(size_t)63;
+    size_t pos;
+
+    memcpy(state_g, NG_INITIAL_HASH_G, 32);
+    memcpy(state_c, NG_INITIAL_HASH_C, 32);
+
+    for (pos = 0; pos < full; pos += 64) {
+        compress_scalar(data + pos, state_g, state_c);
+    }
+    HARMONIA_PROBE2(final__start, state_g, digest);
+    compress_tail(data + full, len - full, len, state_g, state_c);
+    finalize(state_g, state_c, digest);
+    HARMONIA_PROBE2(final__done, state_g, digest);
 }
 
 void harmonia_ng_hex(const uint8_t *data, size_t len, char *hex_out)
@@ -463,6 +457,78 @@ void harmonia_ng_hex(const uint8_t *data, size_t len, char *hex_out)
  * SELF-TEST
  * ============================================================================ */
 
+/*
+ * Hash every length 0..129 (one and two block tails, block boundaries) and
+ * compare the digest of the concatenated digests with harmonia_ng.py; the
+ * streaming API (7-byte updates) must agree with the one-shot path.
+ */
+static int padding_self_check(void)
+{
+    static const char *expected =
+        "4dc42ce282b0abea0a52df396591e9364efb94d0f072d4af45281ffe565e0987";
+    uint8_t msg[129], digests[130 * 32], stream[32];
+    char hex[65];
+    harmonia_ng_ctx ctx;
+    size_t n, pos;
+    int errors = 0;
+
+    for (n = 0; n < sizeof(msg); n++) {
+        msg[n] = (uint8_t)(n * 7 + 1);
+    }
+
+    for (n = 0; n <= sizeof(msg); n++) {
+        harmonia_ng(msg, n, digests + n * 32);
+
+        harmonia_ng_init(&ctx);
+        for (pos = 0; pos < n; pos += 7) {
+            harmonia_ng_update(&ctx, msg + pos, n - pos < 7 ? n - pos : 7);
+        }
+        harmonia_ng_final(&ctx, stream);
+        errors += memcmp(stream, digests + n * 32, 32) != 0;
+    }
+
+    harmonia_ng_hex(digests, sizeof(digests), hex);
+    errors += strcmp(hex, expected) != 0;
+    return errors;
+}
+
+/*
+ * harmonia_ng_updatev over fragment chains (empty, short, block-spanning and
+ * multi-block fragments, after 0..69 buffered bytes) against harmonia_ng().
+ */
+static int updatev_self_check(void)
+{
+    static const size_t sizes[] = {0, 1, 3, 64, 0, 5, 63, 17, 130, 2, 71};
+    uint8_t msg[400], expected[32], stream[32];
+    struct iovec iov[16];
+    harmonia_ng_ctx ctx;
+    size_t n, pos, head;
+    int k, errors = 0;
+
+    for (n = 0; n < sizeof(msg); n++) {
+        msg[n] = (uint8_t)(n * 7 + 1);
+    }
+
+    for (n = 0; n <= sizeof(msg); n += 13) {
+        harmonia_ng(msg, n, expected);
+        for (head = 0; head < 70 && head <= n; head += 23) {
+            harmonia_ng_init(&ctx);
+            harmonia_ng_update(&ctx, msg, head);
+            for (pos = head, k = 0; pos < n; k++) {
+                size_t size = (k == 15) ? n - pos : sizes[(k + head) % 11];
+                if (size > n - pos) size = n - pos;
+                iov[k].iov_base = (void *)(msg + pos);
+                iov[k].iov_len = size;
+                pos += size;
+            }
+            harmonia_ng_updatev(&ctx, iov, k);
+            harmonia_ng_final(&ctx, stream);
+            errors += memcmp(stream, expected, 32) != 0;
+        }
+    }
+    return errors;
+}
+
 int harmonia_ng_self_test(void)
 {
     static const struct {
@@ -497,6 +563,20 @@ int harmonia_ng_self_test(void)
         }
     }
 
+    if (padding_self_check() == 0) {
+        printf("  OK  padding boundaries (lengths 0..129, one-shot and streaming)\n");
+    } else {
+        printf("  FAIL padding boundaries\n");
+        failed++;
+    }
+
+    if (updatev_self_check() == 0) {
+        printf("  OK  scatter/gather updatev\n");
+    } else {
+        printf("  FAIL scatter/gather updatev\n");
+        failed++;
+    }
+
     printf("============================================================\n");
     printf("Result: %s\n", failed ? "FAIL" : "PASS");
 
@@ -14,6 +14,7 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/uio.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,6 +34,15 @@ typedef struct {
     uint64_t total_len;     /* Total message length in bytes */
 } harmonia_ng_ctx;
 
+/*
+ * Copy a context, e.g. a midstate snapshot after absorbing a shared prefix:
+ * the copy and the original continue independently.
+ */
+static inline void harmonia_ng_ctx_copy(harmonia_ng_ctx *dst, const harmonia_ng_ctx *src)
+{
+    *dst = *src;
+}
+
 /*
  * Initialize a HARMONIA-NG context.
  */
@@ -43,6 +53,12 @@ void harmonia_ng_init(harmonia_ng_ctx *ctx);
  */
 void harmonia_ng_update(harmonia_ng_ctx *ctx, const uint8_t *data, size_t len);
 
+/*
+ * Update context with the concatenation of iovcnt fragments, compressing
+ * from the fragments in place; only blocks spanning fragments are assembled.
+ */
+void harmonia_ng_updatev(harmonia_ng_ctx *ctx, const struct iovec *iov, int iovcnt);
+
 /*
  * Finalize and produce digest.
  */
@@ -64,6 +80,350 @@ void harmonia_ng_hex(const uint8_t *data, size_t len, char *hex_out);
  */
 int harmonia_ng_self_test(void);
 
+/* ============================================================================
+ * OPTIMIZED AND MULTI-BUFFER API (harmonia_ng_simd.c)
+ * ============================================================================ */
+
+/*
+ * One-shot hash using the optimized compression function.
+ */
+void harmonia_ng_simd(const uint8_t *data, size_t len, uint8_t *digest);
+
+/*
+ * One-shot hash (optimized) with hexadecimal output.
+ */
+void harmonia_ng_simd_hex(const uint8_t *data, size_t len, char *hex_out);
+
+/*
+ * Incremental hashing with the optimized compression function.
+ * Uses the same context as harmonia_ng_init/update/final; block-aligned
+ * chunks are compressed in place without copying.
+ */
+void harmonia_ng_simd_init(harmonia_ng_ctx *ctx);
+void harmonia_ng_simd_update(harmonia_ng_ctx *ctx, const uint8_t *data, size_t len);
+void harmonia_ng_simd_updatev(harmonia_ng_ctx *ctx, const struct iovec *iov, int iovcnt);
+void harmonia_ng_simd_final(harmonia_ng_ctx *ctx, uint8_t *digest);
+
+/*
+ * Hash 4 / 8 / 16 messages in parallel, one message per SIMD lane.
+ * All messages in a call must have the same length `len`.
+ *
+ * x4 uses ARM NEON, x8 uses AVX2 and x16 uses AVX-512, detected at runtime;
+ * without the corresponding instruction set each falls back to the next
+ * narrower width (x4 on x86 runs on the widest available kernel).
+ */
+void harmonia_ng_x4(const uint8_t *msgs[4], size_t len, uint8_t *digests[4]);
+void harmonia_ng_x8(const uint8_t *msgs[8], size_t len, uint8_t *digests[8]);
+void harmonia_ng_x16(const uint8_t *msgs[16], size_t len, uint8_t *digests[16]);
+
+/*
+ * 64-bit truncated hashes of 8-, 16- and 32-byte keys, for bucket and shard
+ * indices: the first 8 digest bytes as a big-endian integer, so
+ * harmonia_ng_u64_fixed16(key) reads the same bits as harmonia_ng(key, 16).
+ * Padding is specialized per key size and only the two output words needed
+ * are finalized. The _x4 / _x8 forms hash 4 / 8 keys at once on the AVX2
+ * lanes when present (x4 runs on the 8-lane kernel).
+ */
+uint64_t harmonia_ng_u64_fixed8(const uint8_t key[8]);
+uint64_t harmonia_ng_u64_fixed16(const uint8_t key[16]);
+uint64_t harmonia_ng_u64_fixed32(const uint8_t key[32]);
+void harmonia_ng_u64_fixed8_x4(const uint8_t *keys[4], uint64_t out[4]);
+void harmonia_ng_u64_fixed16_x4(const uint8_t *keys[4], uint64_t out[4]);
+void harmonia_ng_u64_fixed32_x4(const uint8_t *keys[4], uint64_t out[4]);
+void harmonia_ng_u64_fixed8_x8(const uint8_t *keys[8], uint64_t out[8]);
+void harmonia_ng_u64_fixed16_x8(const uint8_t *keys[8], uint64_t out[8]);
+void harmonia_ng_u64_fixed32_x8(const uint8_t *keys[8], uint64_t out[8]);
+
+/*
+ * Hash n messages of arbitrary (and different) lengths.
+ * Messages are scheduled across the widest available SIMD lanes; a lane that
+ * finishes its message is refilled with the next one, so mixed lengths do not
+ * leave lanes idle. digests receives n * HARMONIA_NG_DIGEST_SIZE bytes.
+ */
+void harmonia_ng_multi(const uint8_t *const *msgs, const size_t *lens,
+                       uint8_t *digests, size_t n);
+
+/*
+ * Scatter/gather harmonia_ng_multi: message k is the concatenation of the
+ * iovcnts[k] fragments iovs[k]. Lanes read whole blocks from the fragments
+ * in place and assemble only blocks that span fragments.
+ * harmonia_ng_x4v hashes 4 such messages (any lengths) into digests[0..3].
+ */
+void harmonia_ng_multiv(const struct iovec *const *iovs, const int *iovcnts,
+                        uint8_t *digests, size_t n);
+void harmonia_ng_x4v(const struct iovec *const iovs[4], const int iovcnts[4], uint8_t *digests[4]);
+
+/*
+ * Hash prefix || suffixes[k] for n suffixes. prefix is a context that has
+ * absorbed the shared prefix (harmonia_ng_simd_init/update, not finalized);
+ * every lane resumes from its midstate, so the prefix blocks are compressed
+ * once rather than per message. The context is not modified.
+ */
+void harmonia_ng_multi_prefixed(const harmonia_ng_ctx *prefix,
+                                const uint8_t *const *suffixes, const size_t *lens,
+                                uint8_t *digests, size_t n);
+
+/*
+ * harmonia_ng_multi with a per-message IV tweak: flags[k] is XORed into the
+ * golden IV word 7 and counters[k] into complementary IV words 6-7. Either
+ * array may be NULL (zero tweak, i.e. plain HARMONIA-NG). Used by the tree
+ * mode for leaf/parent domain separation.
+ */
+void harmonia_ng_multi_tweaked(const uint8_t *const *msgs, const size_t *lens,
+                               const uint64_t *counters, const uint32_t *flags,
+                               uint8_t *digests, size_t n);
+
+/*
+ * Reusable batch arena for request-serving loops: one cache-line aligned
+ * allocation owning the message table, a capacity * 32-byte digest slab and
+ * the multi-buffer lane workspace (SoA lane state, padding blocks). Fill it
+ * with _add, hash with harmonia_ng_arena_hash, read the digests, then
+ * _reset (O(1)) for the next batch; nothing is allocated after _create.
+ * An arena is not thread-safe; keep one per thread.
+ */
+typedef struct harmonia_batch_arena harmonia_batch_arena;
+
+#define HARMONIA_BATCH_ARENA_FULL ((size_t)-1)
+
+/* capacity messages per batch; NULL if the allocation fails */
+harmonia_batch_arena *harmonia_batch_arena_create(size_t capacity);
+void harmonia_batch_arena_destroy(harmonia_batch_arena *arena);
+void harmonia_batch_arena_reset(harmonia_batch_arena *arena);
+
+/*
+ * Queue msg (not copied; it must stay valid until hashed). Returns its slot,
+ * or HARMONIA_BATCH_ARENA_FULL when the arena is at capacity.
+ */
+size_t harmonia_batch_arena_add(harmonia_batch_arena *arena, const uint8_t *msg, size_t len);
+size_t harmonia_batch_arena_count(const harmonia_batch_arena *arena);
+
+/* HARMONIA-NG of every queued message, like harmonia_ng_multi */
+void harmonia_ng_arena_hash(harmonia_batch_arena *arena);
+
+/* The digest of slot (HARMONIA_NG_DIGEST_SIZE bytes, valid until the next hash) */
+const uint8_t *harmonia_batch_arena_digest(const harmonia_batch_arena *arena, size_t slot);
+
+/*
+ * Self-test for the optimized implementation.
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_ng_simd_self_test(void);
+
+/* ============================================================================
+ * TREE HASHING MODE (harmonia_ng_tree.c)
+ * ============================================================================
+ *
+ * HARMONIA-NG-Tree: the input is split into HARMONIA_NG_TREE_CHUNK-byte
+ * chunks (the last may be shorter; empty input is one empty chunk). Each chunk
+ * is hashed as a leaf with the IV tweaked by its chunk index and the LEAF
+ * flag; pairs of 32-byte chaining values are hashed as 64-byte parent nodes
+ * with the PARENT flag, forming a left-complete binary tree (BLAKE3 layout).
+ * The top node additionally carries the ROOT flag and its output is the
+ * digest. The result differs from harmonia_ng() by design.
+ */
+
+#define HARMONIA_NG_TREE_CHUNK      4096
+#define HARMONIA_NG_TREE_LEAF       0x01u
+#define HARMONIA_NG_TREE_PARENT     0x02u
+#define HARMONIA_NG_TREE_ROOT       0x04u
+
+/*
+ * Tree-hash data using nthreads worker threads (0 = one per usable CPU).
+ * Chunks are spread over the SIMD lanes within each thread.
+ */
+void harmonia_ng_tree(const uint8_t *data, size_t len, uint8_t *digest, int nthreads);
+
+/*
+ * Streaming tree hash (same digest as harmonia_ng_tree) in constant
+ * memory: one chunk buffer plus a stack of pending left subtrees, one per
+ * level. Runs of whole chunks within an update go through the SIMD lanes
+ * together; the calling thread does all the work.
+ */
+typedef struct {
+    uint8_t  stack[64][HARMONIA_NG_DIGEST_SIZE];    /* Left subtree CVs */
+    size_t   stack_len;
+    uint64_t chunks;                                /* Chunks folded into the stack */
+    uint8_t  buffer[HARMONIA_NG_TREE_CHUNK];        /* Current (last seen) chunk */
+    size_t   buffer_len;
+} harmonia_ng_tree_ctx;
+
+void harmonia_ng_tree_init(harmonia_ng_tree_ctx *ctx);
+void harmonia_ng_tree_update(harmonia_ng_tree_ctx *ctx, const uint8_t *data, size_t len);
+void harmonia_ng_tree_final(harmonia_ng_tree_ctx *ctx, uint8_t *digest);
+
+/*
+ * Self-test for the tree mode (known answers and agreement between
+ * thread counts and a serial reference).
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_ng_tree_self_test(void);
+
+/* ============================================================================
+ * BATCH HASHING (harmonia_ng_batch.c)
+ * ============================================================================ */
+
+/*
+ * Hash n independent messages (digests receives n * 32 bytes) on a
+ * persistent worker pool: nthreads participants including the caller
+ * (0 = one per usable CPU, 1 = calling thread only). Work is split in
+ * chunks of messages that idle workers steal from busy ones; each chunk
+ * runs on the multi-buffer lanes like harmonia_ng_multi. Threads are
+ * started on first use and pinned to CPUs of the affinity mask when there
+ * are enough; concurrent calls are serialized.
+ */
+void harmonia_ng_batch(const uint8_t *const *msgs, const size_t *lens,
+                       uint8_t *digests, size_t n, int nthreads);
+
+/*
+ * Stop and join the pool threads (e.g. before exit or fork). A later
+ * harmonia_ng_batch() call starts them again.
+ */
+void harmonia_ng_batch_shutdown(void);
+
+/*
+ * Self-test for the batch API (agreement with harmonia_ng_simd across
+ * message counts and thread counts).
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_ng_batch_self_test(void);
+
+/* ============================================================================
+ * GPU BATCH HASHING (harmonia_ng_gpu.cu, "make gpu")
+ * ============================================================================
+ *
+ * Only present in programs linked with the CUDA backend.
+ */
+
+/*
+ * harmonia_ng_batch() on a CUDA device, one thread per message, with
+ * double-buffered pinned-memory transfers. Small batches (a few thousand
+ * messages), hosts without a device and CUDA errors fall back to
+ * harmonia_ng_batch() on all CPUs, so digests is always filled.
+ * Returns 1 if the GPU hashed the batch, 0 if the CPU did. Concurrent
+ * calls are serialized.
+ */
+int harmonia_ng_gpu_batch(const uint8_t *const *msgs, const size_t *lens,
+                          uint8_t *digests, size_t n);
+
+/* Name of the CUDA device used, or NULL if there is none */
+const char *harmonia_ng_gpu_device(void);
+
+/* Release the staging buffers and streams; the next batch allocates them again */
+void harmonia_ng_gpu_shutdown(void);
+
+/*
+ * Self-test for the GPU backend (agreement with harmonia_ng_batch across
+ * batch sizes, including batches spanning several staging chunks).
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_ng_gpu_self_test(void);
+
+/* ============================================================================
+ * MERKLE TREES (harmonia_ng_merkle.c)
+ * ============================================================================
+ *
+ * Binary Merkle tree over n 32-byte leaves (e.g. block digests): each level
+ * pairs adjacent nodes as parent = harmonia_ng(left || right), a plain
+ * 64-byte message, and carries an odd last node up unchanged. Parents of a
+ * level are hashed together on the multi-buffer lanes.
+ */
+
+/*
+ * Number of nodes above the leaves, i.e. the size (in 32-byte nodes) of the
+ * array filled by harmonia_ng_merkle_build. 0 for n <= 1.
+ */
+size_t harmonia_ng_merkle_nodes(size_t n);
+
+/*
+ * Root of the tree over leaves (n * 32 bytes) using nthreads worker threads
+ * (0 = one per usable CPU, 1 = calling thread only). n = 1 gives the leaf
+ * itself and n = 0 gives harmonia_ng of the empty message.
+ */
+void harmonia_ng_merkle_root(const uint8_t *leaves, size_t n, uint8_t *root, int nthreads);
+
+/*
+ * Build the whole tree: nodes receives harmonia_ng_merkle_nodes(n) nodes,
+ * level by level from the bottom (level 1 = ceil(n / 2) parents of the
+ * leaves, then ceil(n / 4), ...), so the root is the last node.
+ */
+void harmonia_ng_merkle_build(const uint8_t *leaves, size_t n, uint8_t *nodes, int nthreads);
+
+/*
+ * Self-test for the Merkle builder (known answer, agreement with a serial
+ * reference across block boundaries and thread counts).
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_ng_merkle_self_test(void);
+
+/* ============================================================================
+ * CONTENT-DEFINED CHUNKING (harmonia_ng_cdc.c)
+ * ============================================================================
+ *
+ * FastCDC-style chunking of a stream for deduplication: a Gear rolling hash
+ * places chunk boundaries by content, so an insertion only changes the
+ * chunks around it. Completed chunks are fingerprinted in batches on the
+ * multi-buffer lanes (digest = harmonia_ng of the chunk) and handed to the
+ * caller as (offset, length, digest) records.
+ */
+
+#define HARMONIA_NG_CDC_MIN     2048     /* Default chunk size bounds */
+#define HARMONIA_NG_CDC_AVG     8192
+#define HARMONIA_NG_CDC_MAX     65536
+#define HARMONIA_NG_CDC_BATCH   256      /* Chunks per lane batch */
+
+typedef struct {
+    uint64_t offset;                            /* Start in the stream */
+    size_t   len;
+    uint8_t  digest[HARMONIA_NG_DIGEST_SIZE];   /* harmonia_ng(chunk) */
+} harmonia_ng_chunk;
+
+/* Receives records in stream order, n <= HARMONIA_NG_CDC_BATCH per call */
+typedef void (*harmonia_ng_chunk_fn)(void *arg, const harmonia_ng_chunk *chunks, size_t n);
+
+typedef struct {
+    size_t min_size, avg_size, max_size;
+    uint64_t mask_s, mask_l;        /* Cut masks below / from avg_size */
+    int nthreads;
+    harmonia_ng_chunk_fn emit;
+    void *arg;
+    uint64_t hash;                  /* Gear hash of the open chunk */
+    uint64_t offset;                /* Stream offset of the open chunk */
+    uint8_t *carry;                 /* Open chunk bytes from earlier updates */
+    size_t carry_len;
+    size_t pending;                 /* Chunks queued for the lanes */
+    const uint8_t **msgs;           /* Batch tables (one allocation with carry) */
+    size_t *lens;
+    uint8_t *digests;
+    harmonia_ng_chunk *chunks;
+} harmonia_ng_cdc;
+
+/*
+ * Start a stream. Sizes of 0 take the HARMONIA_NG_CDC_* defaults; they must
+ * satisfy 64 <= min <= avg <= max. Batches are hashed by harmonia_ng_multi
+ * (nthreads = 1) or harmonia_ng_batch (nthreads participants, 0 = all
+ * CPUs). Returns 0, or -1 for bad sizes or a failed allocation.
+ */
+int harmonia_ng_cdc_init(harmonia_ng_cdc *cdc, size_t min_size, size_t avg_size, size_t max_size,
+                         int nthreads, harmonia_ng_chunk_fn emit, void *arg);
+
+/*
+ * Chunk the next len bytes of the stream. Every chunk completed within the
+ * call is hashed and emitted before it returns, so data need not outlive
+ * it; pass buffers of many average chunks to keep the lanes full. Only the
+ * open last chunk is copied.
+ */
+void harmonia_ng_cdc_update(harmonia_ng_cdc *cdc, const uint8_t *data, size_t len);
+
+/* Emit the last chunk and release the context's memory */
+void harmonia_ng_cdc_final(harmonia_ng_cdc *cdc);
+
+/*
+ * Self-test for the chunker (Gear table, known boundaries, independence
+ * from update sizes and threads, resynchronization after an insertion).
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_ng_cdc_self_test(void);
+
 #ifdef __cplusplus
 }
 #endif
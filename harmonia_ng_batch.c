@@ -0,0 +1,368 @@
+/*
+ * HARMONIA-NG-Batch - Persistent Thread Pool for Independent Messages
+ *
+ * harmonia_ng_batch() hashes n unrelated messages on a pool of worker
+ * threads that lives for the whole process, so a batch pays a wake-up
+ * instead of thread creation. The messages are cut into chunks of
+ * BATCH_CHUNK; each participant owns a contiguous range of chunks, takes
+ * them from the front and, once its range is empty, steals from the back
+ * of the others. A chunk is one harmonia_ng_multi() call, which spreads
+ * its messages over the x4 / x8 / x16 lanes.
+ *
+ * Workers are pinned to separate CPUs of the affinity mask when it has one
+ * per participant (Linux), and all per-worker state lives in the pool, so
+ * the batch path itself never allocates.
+ *
+ * License: MIT
+ */
+
+#define _GNU_SOURCE
+#include "harmonia_ng.h"
+#include "harmonia_cpu.h"
+#include "harmonia_stats.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define BATCH_CHUNK     64      /* messages per work item */
+#define MAX_WORKERS     256     /* pool threads (the caller is participant 0) */
+
+/* ============================================================================
+ * WORK STEALING
+ * ============================================================================ */
+
+/*
+ * Chunk range [head, tail) of one participant packed in 64 bits, so the
+ * owner (head++) and thieves (tail--) claim with one CAS each. Padded to a
+ * cache line so neighbouring ranges do not share one.
+ */
+typedef struct {
+    uint64_t range;
+    uint8_t pad[64 - sizeof(uint64_t)];
+} batch_deque;
+
+#define RANGE(head, tail)   ((uint64_t)(head) | ((uint64_t)(tail) << 32))
+#define RANGE_HEAD(r)       ((uint32_t)(r))
+#define RANGE_TAIL(r)       ((uint32_t)((r) >> 32))
+
+typedef struct {
+    const uint8_t *const *msgs;
+    const size_t *lens;
+    uint8_t *digests;
+    size_t n;
+    int participants;
+} batch_job;
+
+/* Claim one chunk: the front of our own range, else the back of another */
+static int claim_chunk(batch_deque *deques, int self, int participants, uint32_t *chunk)
+{
+    int k;
+
+    for (k = 0; k < participants; k++) {
+        int victim = (self + k) % participants;
+        uint64_t *range = &deques[victim].range;
+        uint64_t r = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+
+        while (RANGE_HEAD(r) < RANGE_TAIL(r)) {
+            uint32_t head = RANGE_HEAD(r), tail = RANGE_TAIL(r);
+            uint64_t claimed = (k == 0) ? RANGE(head + 1, tail) : RANGE(head, tail - 1);
+
+            if (__atomic_compare_exchange_n(range, &r, claimed, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                *chunk = (k == 0) ? head : tail - 1;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static void batch_run(const batch_job *job, batch_deque *deques, int self)
+{
+    uint32_t chunk;
+
+    while (claim_chunk(deques, self, job->participants, &chunk)) {
+        size_t first = (size_t)chunk * BATCH_CHUNK;
+        size_t count = job->n - first;
+        if (count > BATCH_CHUNK) count = BATCH_CHUNK;
+
+        harmonia_ng_multi(job->msgs + first, job->lens + first,
+                          job->digests + first * HARMONIA_NG_DIGEST_SIZE, count);
+    }
+}
+
+/* ============================================================================
+ * THREAD POOL
+ * ============================================================================ */
+
+static struct {
+    pthread_mutex_t call;       /* One batch at a time */
+    pthread_mutex_t lock;       /* Protects the fields below */
+    pthread_cond_t wake;
+    pthread_cond_t done;
+    pthread_t threads[MAX_WORKERS];
+    int nworkers;
+    int participants;           /* Of the current job, caller included */
+    int running;                /* Participants still working on the job */
+    unsigned generation;        /* Bumped for every posted job */
+    unsigned spawn_generation;  /* Generation new workers start from */
+    int pin;                    /* New workers pin themselves (see pin_worker) */
+    int shutdown;
+    const batch_job *job;
+#ifdef HARMONIA_STATS
+    harmonia_stats stats;       /* Workers' counters for the current job */
+#endif
+    batch_deque deques[MAX_WORKERS + 1];
+} pool = {
+    .call = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER
+};
+
+/*
+ * Pin worker id (1..) to the id-th CPU (counting from 0) of the affinity
+ * mask it inherited, so the pool stays inside taskset and cpuset limits
+ * and no two workers share a CPU. The caller is not pinned and may share
+ * a CPU with a worker.
+ */
+static void pin_worker(int id)
+{
+#ifdef __linux__
+    cpu_set_t allowed, set;
+    int cpu, k = 0;
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (!CPU_ISSET(cpu, &allowed) || k++ < id) continue;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        return;
+    }
+#else
+    (void)id;
+#endif
+}
+
+static void *pool_worker(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    unsigned seen;
+
+    /* Not pool.generation: a late start must still see the next job */
+    pthread_mutex_lock(&pool.lock);
+    seen = pool.spawn_generation;
+    if (pool.pin) pin_worker(id);
+    for (;;) {
+        const batch_job *job;
+#ifdef HARMONIA_STATS
+        harmonia_stats before;
+#endif
+
+        while (pool.generation == seen && !pool.shutdown) {
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        }
+        if (pool.shutdown) break;
+        /* Late wake-ups of non-participants may find the job finished */
+        seen = pool.generation;
+        if (id >= pool.participants) continue;
+        job = pool.job;
+        pthread_mutex_unlock(&pool.lock);
+
+#ifdef HARMONIA_STATS
+        harmonia_stats_get(&before);
+#endif
+        batch_run(job, pool.deques, id);
+
+        pthread_mutex_lock(&pool.lock);
+#ifdef HARMONIA_STATS
+        /* Credit the work to the caller of harmonia_ng_batch() */
+        harmonia_stats_accumulate(&pool.stats, &before);
+#endif
+        if (--pool.running == 0) pthread_cond_signal(&pool.done);
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/*
+ * Grow the pool to `wanted` workers (called with pool.call held). Workers
+ * are pinned only while the caller's affinity mask has a CPU for every
+ * participant; with fewer CPUs they are left to the scheduler.
+ */
+static void pool_grow(int wanted)
+{
+    if (wanted > MAX_WORKERS) wanted = MAX_WORKERS;
+
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 0;
+    pool.spawn_generation = pool.generation;
+    pool.pin = (harmonia_cpu_count() > wanted);
+    while (pool.nworkers < wanted) {
+        intptr_t id = pool.nworkers + 1;
+        if (pthread_create(&pool.threads[pool.nworkers], NULL, pool_worker, (void *)id) != 0) break;
+        pool.nworkers++;
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+void harmonia_ng_batch(const uint8_t *const *msgs, const size_t *lens,
+                       uint8_t *digests, size_t n, int nthreads)
+{
+    batch_job job;
+    size_t nchunks = (n + BATCH_CHUNK - 1) / BATCH_CHUNK;
+    int p;
+
+    if (nthreads <= 0) nthreads = harmonia_cpu_count();
+    if ((size_t)nthreads > nchunks) nthreads = (int)nchunks;
+
+    /* One participant: no pool, no locks */
+    if (nthreads <= 1 || nchunks > UINT32_MAX) {
+        harmonia_ng_multi(msgs, lens, digests, n);
+        return;
+    }
+
+    pthread_mutex_lock(&pool.call);
+    pool_grow(nthreads - 1);
+    if (nthreads > pool.nworkers + 1) nthreads = pool.nworkers + 1;
+
+    job.msgs = msgs;
+    job.lens = lens;
+    job.digests = digests;
+    job.n = n;
+    job.participants = nthreads;
+
+    /* Contiguous chunk ranges, so each participant walks adjacent messages */
+    for (p = 0; p < nthreads; p++) {
+        uint32_t head = (uint32_t)(nchunks * (size_t)p / (size_t)nthreads);
+        uint32_t tail = (uint32_t)(nchunks * (size_t)(p + 1) / (size_t)nthreads);
+        __atomic_store_n(&pool.deques[p].range, RANGE(head, tail), __ATOMIC_RELAXED);
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.job = &job;
+    pool.participants = nthreads;
+    pool.running = nthreads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    /* The caller is participant 0 */
+    batch_run(&job, pool.deques, 0);
+
+    pthread_mutex_lock(&pool.lock);
+    while (pool.running > 0) pthread_cond_wait(&pool.done, &pool.lock);
+#ifdef HARMONIA_STATS
+    harmonia_stats_merge(&pool.stats);
+    memset(&pool.stats, 0, sizeof(pool.stats));
+#endif
+    pool.job = NULL;
+    pool.participants = 0;
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.call);
+}
+
+void harmonia_ng_batch_shutdown(void)
+{
+    int t, nworkers;
+
+    pthread_mutex_lock(&pool.call);
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    nworkers = pool.nworkers;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (t = 0; t < nworkers; t++) {
+        pthread_join(pool.threads[t], NULL);
+    }
+    pool.nworkers = 0;
+    pthread_mutex_unlock(&pool.call);
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+int harmonia_ng_batch_self_test(void)
+{
+    static const size_t counts[] = {0, 1, BATCH_CHUNK - 1, BATCH_CHUNK + 1, 1000, 20000};
+    static const int threads[] = {1, 2, 5, 0};
+    const size_t max_n = 20000;
+    const uint8_t **msgs;
+    size_t *lens;
+    uint8_t *data, *digests, *expected;
+    size_t t, k;
+    uint32_t seed = 777;
+    int j, failed = 0;
+
+    printf("\nHARMONIA-NG-Batch Self-Test\n");
+    printf("============================================================\n");
+
+    msgs = (const uint8_t **)malloc(max_n * sizeof(*msgs));
+    lens = (size_t *)malloc(max_n * sizeof(*lens));
+    data = (uint8_t *)malloc(4096 + 256);
+    digests = (uint8_t *)malloc(max_n * HARMONIA_NG_DIGEST_SIZE);
+    expected = (uint8_t *)malloc(max_n * HARMONIA_NG_DIGEST_SIZE);
+    if (!msgs || !lens || !data || !digests || !expected) {
+        printf("  FAIL allocation\n");
+        failed = 1;
+        goto out;
+    }
+
+    for (k = 0; k < 4096 + 256; k++) data[k] = (uint8_t)(k * 13 + 5);
+    for (k = 0; k < max_n; k++) {
+        seed = seed * 1103515245U + 12345U;
+        lens[k] = (seed >> 8) % ((k % 97 == 0) ? 4096 : 300);
+        msgs[k] = data + (k & 255);
+        harmonia_ng_simd(msgs[k], lens[k], expected + k * HARMONIA_NG_DIGEST_SIZE);
+    }
+
+    for (t = 0; t < sizeof(counts) / sizeof(counts[0]); t++) {
+        int ok = 1;
+
+        for (j = 0; j < (int)(sizeof(threads) / sizeof(threads[0])); j++) {
+            memset(digests, 0, max_n * HARMONIA_NG_DIGEST_SIZE);
+            harmonia_ng_batch(msgs, lens, digests, counts[t], threads[j]);
+            if (memcmp(digests, expected, counts[t] * HARMONIA_NG_DIGEST_SIZE) != 0) ok = 0;
+        }
+
+        if (ok) {
+            printf("  OK   %5zu messages (1, 2, 5, all threads)\n", counts[t]);
+        } else {
+            printf("  FAIL %5zu messages (batch != harmonia_ng_simd)\n", counts[t]);
+            failed++;
+        }
+    }
+
+    /* The pool restarts after shutdown */
+    harmonia_ng_batch_shutdown();
+    memset(digests, 0, max_n * HARMONIA_NG_DIGEST_SIZE);
+    harmonia_ng_batch(msgs, lens, digests, 1000, 3);
+    if (memcmp(digests, expected, 1000 * HARMONIA_NG_DIGEST_SIZE) == 0) {
+        printf("  OK   pool restart after shutdown\n");
+    } else {
+        printf("  FAIL pool restart after shutdown\n");
+        failed++;
+    }
+    harmonia_ng_batch_shutdown();
+
+out:
+    free(msgs);
+    free(lens);
+    free(data);
+    free(digests);
+    free(expected);
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
@@ -0,0 +1,434 @@
+/*
+ * HARMONIA-NG-CDC - Content-Defined Chunking with Batched Fingerprints
+ *
+ * FastCDC over a stream: a Gear hash h = (h << 1) + GEAR[byte] runs from
+ * min_size into each chunk, and a chunk ends where the top bits of h are
+ * zero. Before avg_size the stricter mask_s (log2(avg) + 2 bits) applies,
+ * from avg_size the looser mask_l (log2(avg) - 2 bits), which keeps chunk
+ * sizes close to avg_size; max_size forces a cut. The shift moves every
+ * byte out of h after 64 steps, so boundaries depend only on nearby
+ * content and re-synchronize right after an edit.
+ *
+ * Chunks found in an update are queued as pointers into the caller's
+ * buffer and fingerprinted HARMONIA_NG_CDC_BATCH at a time on the
+ * multi-buffer lanes (or the batch pool), instead of one harmonia_ng()
+ * call each. Only the chunk left open at the end of an update is copied,
+ * into the carry buffer, and completed by the next one.
+ *
+ * License: MIT
+ */
+
+#include "harmonia_ng.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* ============================================================================
+ * GEAR TABLE
+ * ============================================================================ */
+
+/*
+ * GEAR[i] is output i of splitmix64 started from 0 (its increment is the
+ * 64-bit golden ratio 0x9E3779B97F4A7C15); the self-test regenerates it.
+ */
+static const uint64_t GEAR[256] = {
+    0xE220A8397B1DCDAFULL, 0x6E789E6AA1B965F4ULL, 0x06C45D188009454FULL, 0xF88BB8A8724C81ECULL,
+    0x1B39896A51A8749BULL, 0x53CB9F0C747EA2EAULL, 0x2C829ABE1F4532E1ULL, 0xC584133AC916AB3CULL,
+    0x3EE5789041C98AC3ULL, 0xF3B8488C368CB0A6ULL, 0x657EECDD3CB13D09ULL, 0xC2D326E0055BDEF6ULL,
+    0x8621A03FE0BBDB7BULL, 0x8E1F7555983AA92FULL, 0xB54E0F1600CC4D19ULL, 0x84BB3F97971D80ABULL,
+    0x7D29825C75521255ULL, 0xC3CF17102B7F7F86ULL, 0x3466E9A083914F64ULL, 0xD81A8D2B5A4485ACULL,
+    0xDB01602B100B9ED7ULL, 0xA9038A921825F10DULL, 0xEDF5F1D90DCA2F6AULL, 0x54496AD67BD2634CULL,
+    0xDD7C01D4F5407269ULL, 0x935E82F1DB4C4F7BULL, 0x69B82EBC92233300ULL, 0x40D29EB57DE1D510ULL,
+    0xA2F09DABB45C6316ULL, 0xEE521D7A0F4D3872ULL, 0xF16952EE72F3454FULL, 0x377D35DEA8E40225ULL,
+    0x0C7DE8064963BAB0ULL, 0x05582D37111AC529ULL, 0xD254741F599DC6F7ULL, 0x69630F7593D108C3ULL,
+    0x417EF96181DAA383ULL, 0x3C3C41A3B43343A1ULL, 0x6E19905DCBE531DFULL, 0x4FA9FA7324851729ULL,
+    0x84EB4454A792922AULL, 0x134F7096918175CEULL, 0x07DC930B302278A8ULL, 0x12C015A97019E937ULL,
+    0xCC06C31652EBF438ULL, 0xECEE65630A691E37ULL, 0x3E84ECB1763E79ADULL, 0x690ED476743AAE49ULL,
+    0x774615D7B1A1F2E1ULL, 0x22B353F04F4F52DAULL, 0xE3DDD86BA71A5EB1ULL, 0xDF268ADEB6513356ULL,
+    0x2098EB73D4367D77ULL, 0x03D6845323CE3C71ULL, 0xC952C5620043C714ULL, 0x9B196BCA844F1705ULL,
+    0x30260345DD9E0EC1ULL, 0xCF448A5882BB9698ULL, 0xF4A578DCCBC87656ULL, 0xBFDEAED9A17B3C8FULL,
+    0xED79402D1D5C5D7BULL, 0x55F070AB1CBBF170ULL, 0x3E00A34929A88F1DULL, 0xE255B237B8BB18FBULL,
+    0x2A7B67AF6C6AD50EULL, 0x466D5E7F3E46F143ULL, 0x42375CB399A4FC72ULL, 0x8C8A1F148A8BB259ULL,
+    0x32FCAB5DAED5BDFCULL, 0x9E60398C8D8553C0ULL, 0xEE89CCEB8C4064C0ULL, 0xDB0215941D86A66FULL,
+    0x5CCDE78203C367A8ULL, 0xF1BCBC6A1EC11786ULL, 0xEF054FCEEE954551ULL, 0xDF82012D0555C6DFULL,
+    0x292566FF72403C08ULL, 0xC4DD302A1BFA1137ULL, 0xD85F219DB5C554E1ULL, 0x6A27FF807441BCD2ULL,
+    0x96A573E9B48216E8ULL, 0x46A9FDAC40BF0048ULL, 0x3DD12464A0EE15B4ULL, 0x451E521296A7EEA1ULL,
+    0x56E4398A98F8A0FDULL, 0x7B7DC2160E3335A7ULL, 0xC679EE0BEBCB1CCAULL, 0x928D6F2D7453424EULL,
+    0x1B38994205234C6DULL, 0x8086D193A6F2B568ULL, 0x21C6E26639AC2C65ULL, 0xD9DCCAC414D23C6FULL,
+    0x91CD642057E00235ULL, 0x77FC607DC6589373ULL, 0x05B8ABE26DD3AEE7ULL, 0x12F6436AC376CC66ULL,
+    0x64952424897B2307ULL, 0xEE8C2BAF6343E5C3ULL, 0xDC4C613D9EBA2304ULL, 0x3505B7796BD1A506ULL,
+    0x8176DAF800A05F50ULL, 0x8BD8FF7A0385CDBCULL, 0x1A764A3CD78101DAULL, 0xBE4D15BF6CA266ACULL,
+    0xA85E1F38BB2DC749ULL, 0x56759A968493CD8CULL, 0xF3A9BCE7336BD182ULL, 0x365B15013741519BULL,
+    0x1F7A44A6B109AC94ULL, 0x3521D628813CB177ULL, 0x6A77AFAB0F7C9370ULL, 0x179642D8CDE95015ULL,
+    0x5EF102A8FB354461ULL, 0xF51C504764ED82F2ULL, 0xC58427F041CE6808ULL, 0xFAD8FC45C9643C37ULL,
+    0xCF8682F9A70FA9C0ULL, 0x7E1B3B75A4005729ULL, 0x992DD867927B52D8ULL, 0x7FBD5DB142F6791FULL,
+    0x370595AACAB4ADAEULL, 0xB1392DBDC5AB61D6ULL, 0x9FEA7DFC79D452D9ULL, 0x40B12B120085641CULL,
+    0xA192AFE3157C85D0ULL, 0xC847729F4E08F3A3ULL, 0x6F1384A306C41FC2ULL, 0x12D05C4045A39C19ULL,
+    0x9899202FD20F0841ULL, 0xE9C7191857E774B8ULL, 0x4EEAD809AF5B0CC3ULL, 0xE809ACAFA23864A4ULL,
+    0x4DA1EDABA1D0F7BDULL, 0x846EB9673349F8E4ULL, 0x87BAE55B86039FE8ULL, 0x7F367B8BD953EFF2ULL,
+    0x3884700F650D04E1ULL, 0xBFE4B2AB46980CADULL, 0xC5FC89075299106CULL, 0x37B2FA361ADEA7CDULL,
+    0x7D75D813F04895B4ULL, 0x702F5B393F62C0E0ULL, 0x0A3FC775F4ECF37FULL, 0xE4B23787A352437FULL,
+    0xF83FA245C34D6363ULL, 0xB99BCF040786CF50ULL, 0x38B6EA0A0E6C9D8AULL, 0x093FDC76776E37E1ULL,
+    0x1A75E6F76BA7EEE8ULL, 0x442CDCFEE9660C62ULL, 0x22D58D35116B5E0BULL, 0x87D4A5180F6A3645ULL,
+    0x589FB216BD82131BULL, 0x91D031CAD319AEC0ULL, 0xABECF76A553D320BULL, 0xB8686CB347612DCFULL,
+    0xFCAB66337C0A77F5ULL, 0xAC318214381EC437ULL, 0x6EB7F0FCA24494AEULL, 0xCF42861DCDC895A9ULL,
+    0x4ABAD7A1586D7A91ULL, 0xC21B318DC2F49745ULL, 0xD49474DC2ACBD1F0ULL, 0xB1D4873747C1C8E1ULL,
+    0x5434DC8C7D015BF6ULL, 0xE1C486287511B6A9ULL, 0xA8616DF62E89A193ULL, 0x31CE6319498D8347ULL,
+    0xAFD0B486123D6FAAULL, 0xE6495F5D102301EBULL, 0x0DC51CED17A43C52ULL, 0x8BCBCDE81355EF2DULL,
+    0x2412AF73FDEE7CFCULL, 0xC8D589E486E29EEDULL, 0x23390E8664517F89ULL, 0x251ADE58E8A6849DULL,
+    0xF8555DBD2E8F9CB0ULL, 0xCB417C3EEF54F7C3ULL, 0x8028F8E1AAC3A919ULL, 0x10E31052ACF748A0ULL,
+    0x2D886C073B1E1B78ULL, 0x972974D90DF9FAEEULL, 0xBC1B7B38796893BAULL, 0x1958ED432070E652ULL,
+    0xCA5F297197A12DCCULL, 0xE025A27375704F28ULL, 0x418010A570A924FBULL, 0x9828E2941BFC419CULL,
+    0x4FBACD2F52B85C1FULL, 0x33DD5B756211CC67ULL, 0x23C8DFDD1DB57FF0ULL, 0x32F81801A1A8E901ULL,
+    0x26884EAC5ADA36DAULL, 0xCAA82F9BB42E37D4ULL, 0x19FB1A7491D6A7D1ULL, 0x5AA0243AA357F38EULL,
+    0xB31D917809E447F0ULL, 0x3F9C197225215BE0ULL, 0xDC3C315A1E33C095ULL, 0x3DD399AD533E80ACULL,
+    0x566F32CCE8301D95ULL, 0xC880188083D9BA21ULL, 0xB9CC357F3B0E7D2EULL, 0x0237D2123A8A8D6CULL,
+    0xBF636E9AA7CBF6BDULL, 0xD7BD4284C4E2A6A7ULL, 0xDA2EBB47D50577A9ULL, 0x90BA1C11B539087DULL,
+    0x44993D31552B4F57ULL, 0x32C2D6F80A8A8898ULL, 0x450583ED7FB54B19ULL, 0xEC2B0B09E50EF3EFULL,
+    0xD918A0B6E2EFD65CULL, 0xE37A868D9785F572ULL, 0x7D1A6118F2B0F37AULL, 0x9E2E3CC13B343439ULL,
+    0xEFD82C11212E37E8ULL, 0xAF89C05CD4FC75EDULL, 0x55BC16BB9697108EULL, 0x6C4701FA5DB69BEEULL,
+    0x9237338441DAF445ULL, 0x248CF0831E81A5FCULL, 0xACC13557E77DE273ULL, 0x520970C25E06513AULL,
+    0x657329CB02987CABULL, 0xA9B0B3366A4E55A8ULL, 0xC4D06CA2F39ACDD4ULL, 0x5DCE37D68170CDE1ULL,
+    0x5F1E44E77E1854C9ULL, 0x6883D452D55DF899ULL, 0x05C5BD62F1067032ULL, 0xE680B683CE60FAB0ULL,
+    0x5DC9DA3F286D18B1ULL, 0x94B4BF3AB85ED6D8ULL, 0xCE65F449E3ACC5A3ULL, 0x34B0209642CEA639ULL,
+    0xC14C3C771D904827ULL, 0x6ADDCEE2BD9CDEE5ULL, 0xE24EED137FFBB613ULL, 0x75DD58EF79963D1BULL,
+    0xFDB83ECF6CC24920ULL, 0x7A1D0057C57169FBULL, 0x339200F4FEB62D07ULL, 0xD33F4D4AC88469F4ULL,
+    0x8226F234E68DFEE4ULL, 0x320DEF4F2A105536ULL, 0x7786F3B13AEFC159ULL, 0xB28225AC9DF63EE2ULL,
+    0x781B9D0376CC6044ULL, 0x05BD0115226C6AB6ULL, 0xD302230207BDFDABULL, 0xDB898ABD8E0D2933ULL,
+    0x9E79A397BA00B9CCULL, 0x89DF84A5F0003EE8ULL, 0x011F04F2A75FB9BEULL, 0x5A5832BB47BCF19EULL
+};
+
+/* Top k bits of a 64-bit word */
+#define TOP_BITS(k)     (~0ULL << (64 - (k)))
+
+/* ============================================================================
+ * BOUNDARY SCAN
+ * ============================================================================ */
+
+/*
+ * Scan p[0..n) as the continuation of a chunk that already has `have`
+ * bytes. Returns the bytes that belong to the chunk; *cut says whether it
+ * ends there (the hash is then reset for the next chunk).
+ */
+static size_t cdc_scan(harmonia_ng_cdc *cdc, size_t have, const uint8_t *p, size_t n, int *cut)
+{
+    uint64_t h = cdc->hash;
+    size_t i = 0, end;
+
+    *cut = 0;
+
+    /* No boundary before min_size: those bytes are not even hashed */
+    if (have < cdc->min_size) {
+        i = cdc->min_size - have;
+        if (i >= n) return n;
+    }
+
+    /* Stricter mask up to avg_size */
+    end = (cdc->avg_size > have) ? cdc->avg_size - have : 0;
+    if (end > n) end = n;
+    for (; i < end; i++) {
+        h = (h << 1) + GEAR[p[i]];
+        if (!(h & cdc->mask_s)) goto found;
+    }
+
+    /* Looser mask up to max_size */
+    end = cdc->max_size - have;
+    if (end > n) end = n;
+    for (; i < end; i++) {
+        h = (h << 1) + GEAR[p[i]];
+        if (!(h & cdc->mask_l)) goto found;
+    }
+
+    if (have + i == cdc->max_size) {
+        cdc->hash = 0;
+        *cut = 1;
+        return i;
+    }
+    cdc->hash = h;
+    return n;
+
+found:
+    cdc->hash = 0;
+    *cut = 1;
+    return i + 1;
+}
+
+/* ============================================================================
+ * BATCHED FINGERPRINTS
+ * ============================================================================ */
+
+static void cdc_flush(harmonia_ng_cdc *cdc)
+{
+    size_t k;
+
+    if (cdc->pending == 0) return;
+
+    if (cdc->nthreads == 1) {
+        harmonia_ng_multi(cdc->msgs, cdc->lens, cdc->digests, cdc->pending);
+    } else {
+        harmonia_ng_batch(cdc->msgs, cdc->lens, cdc->digests, cdc->pending, cdc->nthreads);
+    }
+    for (k = 0; k < cdc->pending; k++) {
+        memcpy(cdc->chunks[k].digest, cdc->digests + k * HARMONIA_NG_DIGEST_SIZE,
+               HARMONIA_NG_DIGEST_SIZE);
+    }
+    cdc->emit(cdc->arg, cdc->chunks, cdc->pending);
+    cdc->pending = 0;
+}
+
+/* Queue the next chunk of the stream (p must stay valid until the flush) */
+static void cdc_queue(harmonia_ng_cdc *cdc, const uint8_t *p, size_t len)
+{
+    size_t k = cdc->pending++;
+
+    cdc->msgs[k] = p;
+    cdc->lens[k] = len;
+    cdc->chunks[k].offset = cdc->offset;
+    cdc->chunks[k].len = len;
+    cdc->offset += len;
+    if (cdc->pending == HARMONIA_NG_CDC_BATCH) cdc_flush(cdc);
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+int harmonia_ng_cdc_init(harmonia_ng_cdc *cdc, size_t min_size, size_t avg_size, size_t max_size,
+                         int nthreads, harmonia_ng_chunk_fn emit, void *arg)
+{
+    size_t tables = HARMONIA_NG_CDC_BATCH * (sizeof(const uint8_t *) + sizeof(size_t) +
+                                             HARMONIA_NG_DIGEST_SIZE + sizeof(harmonia_ng_chunk));
+    uint8_t *mem;
+    int bits = 0;
+
+    if (min_size == 0) min_size = HARMONIA_NG_CDC_MIN;
+    if (avg_size == 0) avg_size = HARMONIA_NG_CDC_AVG;
+    if (max_size == 0) max_size = HARMONIA_NG_CDC_MAX;
+    if (min_size < 64 || min_size > avg_size || avg_size > max_size || max_size > SIZE_MAX - tables) {
+        return -1;
+    }
+
+    /* Chunk tables first, so every array is naturally aligned */
+    mem = (uint8_t *)malloc(tables + max_size);
+    if (!mem) return -1;
+
+    while (((size_t)2 << bits) <= avg_size) bits++;
+
+    memset(cdc, 0, sizeof(*cdc));
+    cdc->min_size = min_size;
+    cdc->avg_size = avg_size;
+    cdc->max_size = max_size;
+    cdc->mask_s = TOP_BITS(bits + 2);
+    cdc->mask_l = TOP_BITS(bits - 2);
+    cdc->nthreads = nthreads;
+    cdc->emit = emit;
+    cdc->arg = arg;
+    cdc->chunks = (harmonia_ng_chunk *)mem;
+    cdc->msgs = (const uint8_t **)(cdc->chunks + HARMONIA_NG_CDC_BATCH);
+    cdc->lens = (size_t *)(cdc->msgs + HARMONIA_NG_CDC_BATCH);
+    cdc->digests = (uint8_t *)(cdc->lens + HARMONIA_NG_CDC_BATCH);
+    cdc->carry = cdc->digests + HARMONIA_NG_CDC_BATCH * HARMONIA_NG_DIGEST_SIZE;
+    return 0;
+}
+
+void harmonia_ng_cdc_update(harmonia_ng_cdc *cdc, const uint8_t *data, size_t len)
+{
+    size_t used;
+    int cut;
+
+    /* Complete the chunk left open by the previous update */
+    if (cdc->carry_len > 0) {
+        used = cdc_scan(cdc, cdc->carry_len, data, len, &cut);
+        memcpy(cdc->carry + cdc->carry_len, data, used);
+        cdc->carry_len += used;
+        if (!cut) return;
+        data += used;
+        len -= used;
+        cdc_queue(cdc, cdc->carry, cdc->carry_len);
+    }
+
+    /* Whole chunks straight from data */
+    while (len > 0) {
+        used = cdc_scan(cdc, 0, data, len, &cut);
+        if (!cut) break;
+        cdc_queue(cdc, data, used);
+        data += used;
+        len -= used;
+    }
+
+    /* Hash everything queued (the carry included) before reusing the carry */
+    cdc_flush(cdc);
+    memcpy(cdc->carry, data, len);
+    cdc->carry_len = len;
+}
+
+void harmonia_ng_cdc_final(harmonia_ng_cdc *cdc)
+{
+    if (cdc->carry_len > 0) {
+        cdc_queue(cdc, cdc->carry, cdc->carry_len);
+    }
+    cdc_flush(cdc);
+    free(cdc->chunks);
+    cdc->chunks = NULL;
+    cdc->carry = NULL;
+    cdc->carry_len = 0;
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+/* Records of one stream, collected by the emit callback */
+typedef struct {
+    harmonia_ng_chunk *chunks;
+    size_t n, cap;
+    int order_ok;
+} cdc_records;
+
+static void collect(void *arg, const harmonia_ng_chunk *chunks, size_t n)
+{
+    cdc_records *rec = (cdc_records *)arg;
+    size_t k;
+
+    for (k = 0; k < n; k++) {
+        uint64_t expect = rec->n ? rec->chunks[rec->n - 1].offset + rec->chunks[rec->n - 1].len : 0;
+        if (chunks[k].offset != expect) rec->order_ok = 0;
+        if (rec->n < rec->cap) rec->chunks[rec->n++] = chunks[k];
+    }
+}
+
+/* Chunk data[0..len) in updates of step bytes (0 = pseudo-random sizes) */
+static int chunk_stream(const uint8_t *data, size_t len, size_t step, int nthreads, cdc_records *rec)
+{
+    harmonia_ng_cdc cdc;
+    uint32_t seed = 4242;
+    size_t pos = 0;
+
+    rec->n = 0;
+    rec->order_ok = 1;
+    if (harmonia_ng_cdc_init(&cdc, 0, 0, 0, nthreads, collect, rec) != 0) return -1;
+    while (pos < len) {
+        size_t take = step;
+        if (step == 0) {
+            seed = seed * 1103515245U + 12345U;
+            take = (seed >> 8) % ((seed & 1) ? 70000 : 40) + 1;
+        }
+        if (take > len - pos) take = len - pos;
+        harmonia_ng_cdc_update(&cdc, data + pos, take);
+        pos += take;
+    }
+    harmonia_ng_cdc_final(&cdc);
+    return 0;
+}
+
+static int same_records(const cdc_records *a, const cdc_records *b)
+{
+    return a->n == b->n && memcmp(a->chunks, b->chunks, a->n * sizeof(*a->chunks)) == 0;
+}
+
+int harmonia_ng_cdc_self_test(void)
+{
+    /* Python reference on the xorshift stream below: 120 chunks */
+    static const size_t first_lens[] = {11174, 9526, 8776, 9289, 10597, 5305};
+    const size_t len = (size_t)1 << 20, edit = 300000, inserted = 100;
+    uint8_t *data, *edited;
+    cdc_records ref, rec;
+    uint64_t x = 0;
+    uint32_t s = 0x12345678;
+    size_t k, j, unmatched;
+    int ok, failed = 0;
+
+    printf("\nHARMONIA-NG-CDC Self-Test\n");
+    printf("============================================================\n");
+
+    data = (uint8_t *)malloc(len + inserted);
+    edited = (uint8_t *)malloc(len + inserted);
+    ref.cap = rec.cap = 4096;
+    ref.chunks = (harmonia_ng_chunk *)malloc(ref.cap * sizeof(harmonia_ng_chunk));
+    rec.chunks = (harmonia_ng_chunk *)malloc(rec.cap * sizeof(harmonia_ng_chunk));
+    if (!data || !edited || !ref.chunks || !rec.chunks) {
+        printf("  FAIL allocation\n");
+        failed = 1;
+        goto out;
+    }
+
+    /* Gear table from its generator */
+    ok = 1;
+    for (k = 0; k < 256; k++) {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        if ((z ^ (z >> 31)) != GEAR[k]) ok = 0;
+    }
+    printf("  %s Gear table (splitmix64)\n", ok ? "OK  " : "FAIL");
+    failed += !ok;
+
+    for (k = 0; k < len; k++) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        data[k] = (uint8_t)(s >> 24);
+    }
+
+    /* Known boundaries, bounds, contiguity and digests from one update */
+    ok = chunk_stream(data, len, len, 1, &ref) == 0 && ref.order_ok && ref.n == 120;
+    for (k = 0; ok && k < sizeof(first_lens) / sizeof(first_lens[0]); k++) {
+        if (ref.chunks[k].len != first_lens[k]) ok = 0;
+    }
+    for (k = 0; ok && k < ref.n; k++) {
+        uint8_t digest[HARMONIA_NG_DIGEST_SIZE];
+        if (ref.chunks[k].len > HARMONIA_NG_CDC_MAX ||
+            (k + 1 < ref.n && ref.chunks[k].len < HARMONIA_NG_CDC_MIN)) ok = 0;
+        harmonia_ng_simd(data + ref.chunks[k].offset, ref.chunks[k].len, digest);
+        if (memcmp(digest, ref.chunks[k].digest, sizeof(digest)) != 0) ok = 0;
+    }
+    ok = ok && ref.chunks[ref.n - 1].offset + ref.chunks[ref.n - 1].len == len;
+    printf("  %s 1 MiB: %zu chunks, known boundaries, digests = harmonia_ng_simd\n",
+           ok ? "OK  " : "FAIL", ref.n);
+    failed += !ok;
+
+    /* Update sizes and threads do not move boundaries */
+    ok = chunk_stream(data, len, 0, 1, &rec) == 0 && rec.order_ok && same_records(&ref, &rec);
+    ok = ok && chunk_stream(data, len, 1, 1, &rec) == 0 && same_records(&ref, &rec);
+    ok = ok && chunk_stream(data, len, HARMONIA_NG_CDC_MAX, 3, &rec) == 0 && same_records(&ref, &rec);
+    printf("  %s random / 1-byte / 64 KB updates, 3 threads\n", ok ? "OK  " : "FAIL");
+    failed += !ok;
+
+    /* Short streams: nothing, and one chunk below min_size */
+    ok = chunk_stream(data, 0, 0, 1, &rec) == 0 && rec.n == 0;
+    ok = ok && chunk_stream(data, 100, 7, 1, &rec) == 0 && rec.n == 1 && rec.chunks[0].len == 100;
+    {
+        harmonia_ng_cdc bad;
+        ok = ok && harmonia_ng_cdc_init(&bad, 4096, 2048, 0, 1, collect, &rec) == -1;
+        ok = ok && harmonia_ng_cdc_init(&bad, 32, 0, 0, 1, collect, &rec) == -1;
+    }
+    printf("  %s empty / short streams, invalid sizes\n", ok ? "OK  " : "FAIL");
+    failed += !ok;
+
+    /* An insertion only changes the chunks around it */
+    memcpy(edited, data, edit);
+    memset(edited + edit, 0xA5, inserted);
+    memcpy(edited + edit + inserted, data + edit, len - edit);
+    ok = chunk_stream(edited, len + inserted, 0, 1, &rec) == 0;
+    unmatched = 0;
+    for (k = 0; ok && k < rec.n; k++) {
+        for (j = 0; j < ref.n; j++) {
+            if (memcmp(rec.chunks[k].digest, ref.chunks[j].digest, HARMONIA_NG_DIGEST_SIZE) == 0) break;
+        }
+        if (j == ref.n) unmatched++;
+    }
+    ok = ok && unmatched >= 1 && unmatched <= 2;
+    printf("  %s %zu-byte insertion: %zu of %zu chunks new\n", ok ? "OK  " : "FAIL",
+           inserted, unmatched, rec.n);
+    failed += !ok;
+
+out:
+    free(data);
+    free(edited);
+    free(ref.chunks);
+    free(rec.chunks);
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
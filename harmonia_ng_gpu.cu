@@ -0,0 +1,427 @@
+/*
+ * HARMONIA-NG-GPU - CUDA Batch Backend
+ *
+ * harmonia_ng_gpu_batch() hashes n independent messages with one GPU
+ * thread per message (harmonia_ng_gpu_core.h). Messages are packed into
+ * page-locked staging arenas of up to STAGE_BYTES / STAGE_MSGS and sent
+ * through two slots, each with its own stream and device buffers, so
+ * while the GPU copies and hashes one chunk the host packs the next one
+ * and collects the digests of the one before:
+ *
+ *     host    pack 0 | pack 1 | wait 0, pack 2 | wait 1, pack 3 | ...
+ *     slot 0  H2D, kernel, D2H |               H2D, kernel, D2H
+ *     slot 1           H2D, kernel, D2H |               H2D, ...
+ *
+ * The arguments and results are those of harmonia_ng_batch(). Batches
+ * below GPU_MIN_BATCH, hosts without a CUDA device and CUDA errors fall
+ * back to harmonia_ng_batch() on the CPU, so the call always produces the
+ * digests; the return value says where they came from.
+ *
+ * Build with "make gpu" (needs the CUDA toolkit).
+ *
+ * License: MIT
+ */
+
+#include "harmonia_ng.h"
+#include <cuda_runtime.h>
+#include "harmonia_ng_gpu_core.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GPU_SLOTS       2
+#define STAGE_BYTES     ((size_t)64 << 20)  /* packed message bytes per chunk */
+#define STAGE_MSGS      ((size_t)1 << 20)   /* messages per chunk */
+#define GPU_ALIGN       16                  /* arena offset alignment */
+#define GPU_THREADS     128                 /* threads per CUDA block */
+#define GPU_MIN_BATCH   4096                /* below this the CPU is faster */
+
+/* ============================================================================
+ * KERNEL
+ * ============================================================================ */
+
+__global__ void ng_gpu_kernel(const uint8_t *arena, const uint64_t *offsets,
+                              const uint64_t *lens, uint8_t *digests, uint32_t n)
+{
+    uint32_t t = blockIdx.x * blockDim.x + threadIdx.x;
+
+    if (t < n) {
+        ng_gpu_hash(arena + offsets[t], lens[t], digests + (size_t)t * HARMONIA_NG_DIGEST_SIZE);
+    }
+}
+
+/* ============================================================================
+ * STAGING SLOTS
+ * ============================================================================ */
+
+typedef struct {
+    cudaStream_t stream;
+    uint8_t *h_arena, *d_arena;         /* packed messages (pinned / device) */
+    uint64_t *h_offsets, *d_offsets;    /* arena offset of each message */
+    uint64_t *h_lens, *d_lens;
+    uint8_t *h_digests, *d_digests;
+    size_t *index;                      /* batch position of each message */
+    size_t count;                       /* messages in flight, 0 = idle */
+} gpu_slot;
+
+static struct {
+    int state;                          /* 0 = not probed, 1 = ready, -1 = unavailable */
+    char name[256];
+    gpu_slot slot[GPU_SLOTS];
+    pthread_mutex_t call;               /* serializes harmonia_ng_gpu_batch() */
+} gpu = { 0, "", {}, PTHREAD_MUTEX_INITIALIZER };
+
+static void slot_free(gpu_slot *s)
+{
+    if (s->stream) cudaStreamDestroy(s->stream);
+    cudaFreeHost(s->h_arena);
+    cudaFreeHost(s->h_offsets);
+    cudaFreeHost(s->h_lens);
+    cudaFreeHost(s->h_digests);
+    cudaFree(s->d_arena);
+    cudaFree(s->d_offsets);
+    cudaFree(s->d_lens);
+    cudaFree(s->d_digests);
+    free(s->index);
+    memset(s, 0, sizeof(*s));
+}
+
+static int slot_alloc(gpu_slot *s)
+{
+    memset(s, 0, sizeof(*s));
+    if (cudaStreamCreateWithFlags(&s->stream, cudaStreamNonBlocking) != cudaSuccess ||
+        cudaHostAlloc((void **)&s->h_arena, STAGE_BYTES, cudaHostAllocWriteCombined) != cudaSuccess ||
+        cudaHostAlloc((void **)&s->h_offsets, STAGE_MSGS * sizeof(uint64_t), cudaHostAllocWriteCombined) != cudaSuccess ||
+        cudaHostAlloc((void **)&s->h_lens, STAGE_MSGS * sizeof(uint64_t), cudaHostAllocWriteCombined) != cudaSuccess ||
+        cudaHostAlloc((void **)&s->h_digests, STAGE_MSGS * HARMONIA_NG_DIGEST_SIZE, cudaHostAllocDefault) != cudaSuccess ||
+        cudaMalloc((void **)&s->d_arena, STAGE_BYTES) != cudaSuccess ||
+        cudaMalloc((void **)&s->d_offsets, STAGE_MSGS * sizeof(uint64_t)) != cudaSuccess ||
+        cudaMalloc((void **)&s->d_lens, STAGE_MSGS * sizeof(uint64_t)) != cudaSuccess ||
+        cudaMalloc((void **)&s->d_digests, STAGE_MSGS * HARMONIA_NG_DIGEST_SIZE) != cudaSuccess ||
+        (s->index = (size_t *)malloc(STAGE_MSGS * sizeof(size_t))) == NULL) {
+        slot_free(s);
+        return -1;
+    }
+    return 0;
+}
+
+/* Probe the device and allocate both slots once; caller holds gpu.call */
+static int gpu_ready(void)
+{
+    struct cudaDeviceProp prop;
+    int count = 0, k;
+
+    if (gpu.state != 0) return gpu.state > 0;
+
+    gpu.state = -1;
+    if (cudaGetDeviceCount(&count) != cudaSuccess || count == 0 ||
+        cudaSetDevice(0) != cudaSuccess || cudaGetDeviceProperties(&prop, 0) != cudaSuccess) {
+        cudaGetLastError();
+        return 0;
+    }
+    for (k = 0; k < GPU_SLOTS; k++) {
+        if (slot_alloc(&gpu.slot[k]) != 0) {
+            while (k-- > 0) slot_free(&gpu.slot[k]);
+            cudaGetLastError();
+            return 0;
+        }
+    }
+    snprintf(gpu.name, sizeof(gpu.name), "%s", prop.name);
+    gpu.state = 1;
+    return 1;
+}
+
+/*
+ * Pack messages from *next into the slot until its arena or index is full.
+ * A message larger than the whole arena is hashed on the CPU in place.
+ * Returns the packed byte count.
+ */
+static size_t slot_pack(gpu_slot *s, const uint8_t *const *msgs, const size_t *lens,
+                        uint8_t *digests, size_t n, size_t *next)
+{
+    size_t k = *next, pos = 0;
+
+    s->count = 0;
+    while (k < n && s->count < STAGE_MSGS) {
+        size_t len = lens[k];
+        size_t span = (len + GPU_ALIGN - 1) & ~(size_t)(GPU_ALIGN - 1);
+
+        if (span > STAGE_BYTES) {
+            harmonia_ng_simd(msgs[k], len, digests + k * HARMONIA_NG_DIGEST_SIZE);
+            k++;
+            continue;
+        }
+        if (pos + span > STAGE_BYTES) break;
+
+        memcpy(s->h_arena + pos, msgs[k], len);
+        s->h_offsets[s->count] = pos;
+        s->h_lens[s->count] = len;
+        s->index[s->count] = k;
+        s->count++;
+        pos += span;
+        k++;
+    }
+    *next = k;
+    return pos;
+}
+
+/* Queue copy-in, kernel and copy-out of a packed slot on its stream */
+static int slot_launch(gpu_slot *s, size_t bytes)
+{
+    uint32_t blocks = (uint32_t)((s->count + GPU_THREADS - 1) / GPU_THREADS);
+
+    cudaMemcpyAsync(s->d_arena, s->h_arena, bytes, cudaMemcpyHostToDevice, s->stream);
+    cudaMemcpyAsync(s->d_offsets, s->h_offsets, s->count * sizeof(uint64_t),
+                    cudaMemcpyHostToDevice, s->stream);
+    cudaMemcpyAsync(s->d_lens, s->h_lens, s->count * sizeof(uint64_t),
+                    cudaMemcpyHostToDevice, s->stream);
+    ng_gpu_kernel<<<blocks, GPU_THREADS, 0, s->stream>>>(s->d_arena, s->d_offsets, s->d_lens,
+                                                         s->d_digests, (uint32_t)s->count);
+    cudaMemcpyAsync(s->h_digests, s->d_digests, s->count * HARMONIA_NG_DIGEST_SIZE,
+                    cudaMemcpyDeviceToHost, s->stream);
+    return cudaGetLastError() == cudaSuccess ? 0 : -1;
+}
+
+/* Wait for a slot and scatter its digests to their batch positions */
+static int slot_retire(gpu_slot *s, uint8_t *digests)
+{
+    size_t j;
+    int rc = cudaStreamSynchronize(s->stream) == cudaSuccess ? 0 : -1;
+
+    if (rc == 0) {
+        for (j = 0; j < s->count; j++) {
+            memcpy(digests + s->index[j] * HARMONIA_NG_DIGEST_SIZE,
+                   s->h_digests + j * HARMONIA_NG_DIGEST_SIZE, HARMONIA_NG_DIGEST_SIZE);
+        }
+    }
+    s->count = 0;
+    return rc;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+extern "C" int harmonia_ng_gpu_batch(const uint8_t *const *msgs, const size_t *lens,
+                                     uint8_t *digests, size_t n)
+{
+    size_t next = 0;
+    int k, cur = 0, failed = 0;
+
+    if (n < GPU_MIN_BATCH) {
+        harmonia_ng_batch(msgs, lens, digests, n, 0);
+        return 0;
+    }
+
+    pthread_mutex_lock(&gpu.call);
+    if (!gpu_ready()) {
+        pthread_mutex_unlock(&gpu.call);
+        harmonia_ng_batch(msgs, lens, digests, n, 0);
+        return 0;
+    }
+
+    while (next < n && !failed) {
+        gpu_slot *s = &gpu.slot[cur];
+        size_t bytes;
+
+        /* The slot's previous chunk must be out before its buffers are reused */
+        if (s->count > 0 && slot_retire(s, digests) != 0) failed = 1;
+        bytes = slot_pack(s, msgs, lens, digests, n, &next);
+        if (s->count > 0 && slot_launch(s, bytes) != 0) failed = 1;
+        cur = (cur + 1) % GPU_SLOTS;
+    }
+    for (k = 0; k < GPU_SLOTS; k++) {
+        if (gpu.slot[k].count > 0 && slot_retire(&gpu.slot[k], digests) != 0) failed = 1;
+    }
+
+    if (failed) {
+        /* Device lost mid-batch: do not trust any of it */
+        fprintf(stderr, "harmonia_ng_gpu: %s, falling back to the CPU\n",
+                cudaGetErrorString(cudaGetLastError()));
+        for (k = 0; k < GPU_SLOTS; k++) slot_free(&gpu.slot[k]);
+        gpu.state = -1;
+        pthread_mutex_unlock(&gpu.call);
+        harmonia_ng_batch(msgs, lens, digests, n, 0);
+        return 0;
+    }
+
+    pthread_mutex_unlock(&gpu.call);
+    return 1;
+}
+
+extern "C" const char *harmonia_ng_gpu_device(void)
+{
+    const char *name;
+
+    pthread_mutex_lock(&gpu.call);
+    name = gpu_ready() ? gpu.name : NULL;
+    pthread_mutex_unlock(&gpu.call);
+    return name;
+}
+
+extern "C" void harmonia_ng_gpu_shutdown(void)
+{
+    int k;
+
+    pthread_mutex_lock(&gpu.call);
+    if (gpu.state > 0) {
+        for (k = 0; k < GPU_SLOTS; k++) slot_free(&gpu.slot[k]);
+    }
+    gpu.state = 0;
+    pthread_mutex_unlock(&gpu.call);
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+extern "C" int harmonia_ng_gpu_self_test(void)
+{
+    /* The last count spans more than two slots, so both are reused */
+    static const size_t counts[] = {GPU_MIN_BATCH - 1, GPU_MIN_BATCH, 100000, 2 * STAGE_MSGS + 12345};
+    const size_t max_n = 2 * STAGE_MSGS + 12345;
+    const char *device = harmonia_ng_gpu_device();
+    const uint8_t **msgs;
+    size_t *lens;
+    uint8_t *data, *digests, *expected;
+    size_t t, k;
+    uint32_t seed = 4242;
+    int failed = 0;
+
+    printf("\nHARMONIA-NG-GPU Self-Test (%s)\n", device ? device : "no CUDA device, CPU fallback");
+    printf("============================================================\n");
+
+    msgs = (const uint8_t **)malloc(max_n * sizeof(*msgs));
+    lens = (size_t *)malloc(max_n * sizeof(*lens));
+    data = (uint8_t *)malloc(8192 + 256);
+    digests = (uint8_t *)malloc(max_n * HARMONIA_NG_DIGEST_SIZE);
+    expected = (uint8_t *)malloc(max_n * HARMONIA_NG_DIGEST_SIZE);
+    if (!msgs || !lens || !data || !digests || !expected) {
+        printf("  FAIL allocation\n");
+        failed = 1;
+        goto out;
+    }
+
+    /* Mixed lengths around the padding edges, a few long ones, odd alignment */
+    for (k = 0; k < 8192 + 256; k++) data[k] = (uint8_t)(k * 29 + 3);
+    for (k = 0; k < max_n; k++) {
+        seed = seed * 1103515245U + 12345U;
+        lens[k] = (seed >> 8) % ((k % 1009 == 0) ? 8192 : 200);
+        msgs[k] = data + (k & 255);
+    }
+    harmonia_ng_batch(msgs, lens, expected, max_n, 0);
+
+    for (t = 0; t < sizeof(counts) / sizeof(counts[0]); t++) {
+        int where;
+
+        memset(digests, 0, max_n * HARMONIA_NG_DIGEST_SIZE);
+        where = harmonia_ng_gpu_batch(msgs, lens, digests, counts[t]);
+        if (memcmp(digests, expected, counts[t] * HARMONIA_NG_DIGEST_SIZE) == 0) {
+            printf("  OK   %7zu messages (%s)\n", counts[t], where ? "GPU" : "CPU");
+        } else {
+            printf("  FAIL %7zu messages (gpu batch != harmonia_ng_batch)\n", counts[t]);
+            failed++;
+        }
+    }
+
+    /* Slots are allocated again after shutdown */
+    harmonia_ng_gpu_shutdown();
+    memset(digests, 0, max_n * HARMONIA_NG_DIGEST_SIZE);
+    harmonia_ng_gpu_batch(msgs, lens, digests, 100000);
+    if (memcmp(digests, expected, 100000 * HARMONIA_NG_DIGEST_SIZE) == 0) {
+        printf("  OK   restart after shutdown\n");
+    } else {
+        printf("  FAIL restart after shutdown\n");
+        failed++;
+    }
+
+out:
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    free(msgs);
+    free(lens);
+    free(data);
+    free(digests);
+    free(expected);
+    return failed;
+}
+
+/* ============================================================================
+ * TEST MAIN (harmonia_ng_gpu_test)
+ * ============================================================================ */
+
+#ifdef HARMONIA_NG_GPU_MAIN
+#include <time.h>
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* GPU vs. the CPU pool on n messages of one length */
+static void benchmark(size_t n, size_t len)
+{
+    const uint8_t **msgs = (const uint8_t **)malloc(n * sizeof(*msgs));
+    size_t *lens = (size_t *)malloc(n * sizeof(*lens));
+    uint8_t *data = (uint8_t *)calloc(1, len + 1);
+    uint8_t *digests = (uint8_t *)malloc(n * HARMONIA_NG_DIGEST_SIZE);
+    double t0, gpu_time, cpu_time;
+    size_t k;
+    int where;
+
+    if (!msgs || !lens || !data || !digests) {
+        printf("  allocation failed\n");
+        goto out;
+    }
+    for (k = 0; k < n; k++) {
+        msgs[k] = data;
+        lens[k] = len;
+    }
+
+    harmonia_ng_gpu_batch(msgs, lens, digests, n);     /* warm-up */
+    t0 = now_seconds();
+    where = harmonia_ng_gpu_batch(msgs, lens, digests, n);
+    gpu_time = now_seconds() - t0;
+
+    t0 = now_seconds();
+    harmonia_ng_batch(msgs, lens, digests, n, 0);
+    cpu_time = now_seconds() - t0;
+
+    printf("  %8zu x %5zu B   %s %8.2f Mmsg/s %8.1f MB/s   CPU pool %8.2f Mmsg/s %8.1f MB/s\n",
+           n, len, where ? "GPU" : "CPU",
+           (double)n / gpu_time / 1e6, (double)(n * len) / gpu_time / 1e6,
+           (double)n / cpu_time / 1e6, (double)(n * len) / cpu_time / 1e6);
+
+out:
+    free(msgs);
+    free(lens);
+    free(data);
+    free(digests);
+}
+
+int main(int argc, char **argv)
+{
+    int failed;
+
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        const char *device = harmonia_ng_gpu_device();
+
+        printf("\nHARMONIA-NG-GPU Benchmark (%s)\n", device ? device : "no CUDA device");
+        printf("============================================================\n");
+        benchmark(4000000, 32);
+        benchmark(4000000, 64);
+        benchmark(1000000, 256);
+        benchmark(100000, 4096);
+        harmonia_ng_gpu_shutdown();
+        return 0;
+    }
+
+    failed = harmonia_ng_gpu_self_test();
+    harmonia_ng_gpu_shutdown();
+    harmonia_ng_batch_shutdown();
+    return failed ? 1 : 0;
+}
+#endif /* HARMONIA_NG_GPU_MAIN */
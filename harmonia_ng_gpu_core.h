@@ -0,0 +1,184 @@
+/*
+ * HARMONIA-NG-GPU - Per-Thread Hash Kernel (internal)
+ *
+ * One whole HARMONIA-NG hash per GPU thread: the message is read from a
+ * packed device arena, compressed block by block and finalized in
+ * registers. The rounds are generated from NG_ROTATION_SCHEDULE, so every
+ * rotation and constant index is a literal and the state arrays stay in
+ * registers after unrolling; nothing is indexed at run time except the
+ * message itself.
+ *
+ * Under nvcc the functions are __device__ and the constants live in
+ * __constant__ memory. As plain C the same code builds as static inline
+ * host functions, which is how the kernel is checked against
+ * harmonia_ng_simd on machines without a GPU.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_NG_GPU_CORE_H
+#define HARMONIA_NG_GPU_CORE_H
+
+#include <stdint.h>
+
+#ifdef __CUDACC__
+#define HARMONIA_GPU_FN         static __device__ __forceinline__
+#define HARMONIA_GPU_CONST      static __constant__
+#define HARMONIA_GPU_UNROLL     _Pragma("unroll")
+#define NG_GPU_ROTL(x, n)       __funnelshift_l((x), (x), (n))
+#define NG_GPU_ROTR(x, n)       __funnelshift_r((x), (x), (n))
+#define NG_GPU_BSWAP(x)         __byte_perm((x), 0, 0x0123)
+#else
+#define HARMONIA_GPU_FN         static inline
+#define HARMONIA_GPU_CONST      static const
+#define HARMONIA_GPU_UNROLL
+#define NG_GPU_ROTL(x, n)       (((x) << (n)) | ((x) >> (32 - (n))))
+#define NG_GPU_ROTR(x, n)       (((x) >> (n)) | ((x) << (32 - (n))))
+#define NG_GPU_BSWAP(x)         __builtin_bswap32(x)
+#endif
+
+/* Shared tables in __constant__ memory under nvcc */
+#define HARMONIA_CONST HARMONIA_GPU_CONST
+#include "harmonia_constants.h"
+
+/* ============================================================================
+ * ROUND FUNCTION
+ * ============================================================================ */
+
+#define NG_GPU_QR(s, a, b, c, d, r1, r2, r3, r4) do { \
+    s[a] += s[b]; s[d] ^= s[a]; s[d] = NG_GPU_ROTL(s[d], r1); \
+    s[c] += s[d]; s[b] ^= s[c]; s[b] = NG_GPU_ROTL(s[b], r2); \
+    s[a] += s[b]; s[d] ^= s[a]; s[d] = NG_GPU_ROTL(s[d], r3); \
+    s[c] += s[d]; s[b] ^= s[c]; s[b] = NG_GPU_ROTL(s[b], r4); \
+} while (0)
+
+HARMONIA_GPU_FN void ng_gpu_edge(uint32_t *s, uint32_t fib_const)
+{
+    uint32_t interaction;
+
+    s[0] = NG_GPU_ROTR(s[0], 7) ^ fib_const;
+    s[7] = NG_GPU_ROTL(s[7], 13) ^ ~fib_const;
+    interaction = (s[0] ^ s[7]) >> 16;
+    s[0] += interaction;
+    s[7] += interaction;
+}
+
+/* In order: c[0..2] are already updated when g[5..7] read them */
+HARMONIA_GPU_FN void ng_gpu_cross(uint32_t *g, uint32_t *c)
+{
+    int i;
+
+    HARMONIA_GPU_UNROLL
+    for (i = 0; i < 8; i++) {
+        uint32_t t = g[i] ^ c[(i + 3) & 7];
+        g[i] += NG_GPU_ROTR(t, 11);
+        c[i] ^= NG_GPU_ROTL(t, 11);
+    }
+}
+
+#define NG_GPU_ROUND(r, r1, r2, r3, r4) \
+    g[0] += w[r]; \
+    c[0] += w[31 - (r)]; \
+    g[4] ^= PHI_CONSTANTS[(r) % 16]; \
+    c[4] ^= RECIPROCAL_CONSTANTS[(r) % 16]; \
+    NG_GPU_QR(g, 0, 1, 2, 3, r1, r2, r3, r4); \
+    NG_GPU_QR(g, 4, 5, 6, 7, r1, r2, r3, r4); \
+    NG_GPU_QR(g, 0, 5, 2, 7, r1, r2, r3, r4); \
+    NG_GPU_QR(g, 4, 1, 6, 3, r1, r2, r3, r4); \
+    NG_GPU_QR(c, 0, 1, 2, 3, r1, r2, r3, r4); \
+    NG_GPU_QR(c, 4, 5, 6, 7, r1, r2, r3, r4); \
+    NG_GPU_QR(c, 0, 5, 2, 7, r1, r2, r3, r4); \
+    NG_GPU_QR(c, 4, 1, 6, 3, r1, r2, r3, r4); \
+    if (((r) + 1) % 4 == 0) ng_gpu_cross(g, c); \
+    if (((r) + 1) % 8 == 0) { \
+        ng_gpu_edge(g, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+        ng_gpu_edge(c, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+    }
+
+/* Compress one block of 16 big-endian words in w[0..15] (w[16..31] are scratch) */
+HARMONIA_GPU_FN void ng_gpu_compress(uint32_t *w, uint32_t *state_g, uint32_t *state_c)
+{
+    uint32_t g[8], c[8];
+    int i;
+
+    HARMONIA_GPU_UNROLL
+    for (i = 16; i < 32; i++) {
+        int rot1 = 7 + (i % 5), rot2 = 17 + (i % 4);
+        uint32_t s0 = NG_GPU_ROTR(w[i - 15], rot1) ^ NG_GPU_ROTR(w[i - 15], rot1 + 11) ^ (w[i - 15] >> 3);
+        uint32_t s1 = NG_GPU_ROTR(w[i - 2], rot2) ^ NG_GPU_ROTR(w[i - 2], rot2 + 2) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1 + FIBONACCI[i % 12];
+    }
+
+    HARMONIA_GPU_UNROLL
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i];
+        c[i] = state_c[i];
+    }
+
+    NG_ROTATION_SCHEDULE(NG_GPU_ROUND)
+
+    HARMONIA_GPU_UNROLL
+    for (i = 0; i < 8; i++) {
+        state_g[i] += g[i];
+        state_c[i] += c[i];
+    }
+}
+
+/* ============================================================================
+ * WHOLE MESSAGE
+ * ============================================================================ */
+
+/*
+ * harmonia_ng(msg, len) into digest. msg and digest must be 4-byte aligned:
+ * full blocks are read as words, only the tail byte by byte.
+ */
+HARMONIA_GPU_FN void ng_gpu_hash(const uint8_t *msg, uint64_t len, uint8_t *digest)
+{
+    const uint32_t *words = (const uint32_t *)msg;
+    uint32_t *out = (uint32_t *)digest;
+    uint32_t g[8], c[8], w[32];
+    uint64_t full = len / 64, b;
+    uint32_t tail = (uint32_t)(len % 64), i;
+
+    HARMONIA_GPU_UNROLL
+    for (i = 0; i < 8; i++) {
+        g[i] = NG_INITIAL_HASH_G[i];
+        c[i] = NG_INITIAL_HASH_C[i];
+    }
+
+    for (b = 0; b < full; b++) {
+        HARMONIA_GPU_UNROLL
+        for (i = 0; i < 16; i++) {
+            w[i] = NG_GPU_BSWAP(words[16 * b + i]);
+        }
+        ng_gpu_compress(w, g, c);
+    }
+
+    /* SHA-style padding: 0x80, zeros, 64-bit big-endian bit length */
+    HARMONIA_GPU_UNROLL
+    for (i = 0; i < 16; i++) w[i] = 0;
+    for (i = 0; i < tail; i++) {
+        w[i / 4] |= (uint32_t)msg[64 * full + i] << (24 - 8 * (i & 3));
+    }
+    w[tail / 4] |= 0x80U << (24 - 8 * (tail & 3));
+    if (tail >= 56) {
+        ng_gpu_compress(w, g, c);
+        HARMONIA_GPU_UNROLL
+        for (i = 0; i < 16; i++) w[i] = 0;
+    }
+    w[14] = (uint32_t)((len * 8) >> 32);
+    w[15] = (uint32_t)(len * 8);
+    ng_gpu_compress(w, g, c);
+
+    /* Finalize: edge protection, fuse the streams, big-endian output */
+    ng_gpu_edge(g, FIBONACCI[32 % 12] * 0x9E3779B9U);
+    ng_gpu_edge(c, FIBONACCI[33 % 12] * 0x9E3779B9U);
+    HARMONIA_GPU_UNROLL
+    for (i = 0; i < 8; i++) {
+        uint32_t rot = (i * 3 + 5) % 16 + 1;
+        uint32_t fused = (NG_GPU_ROTR(g[i], rot) ^ NG_GPU_ROTL(c[i], rot)) + PHI_CONSTANTS[i];
+        out[i] = NG_GPU_BSWAP(fused);
+    }
+}
+
+#endif /* HARMONIA_NG_GPU_CORE_H */
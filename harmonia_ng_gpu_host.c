@@ -0,0 +1,46 @@
+/*
+ * HARMONIA-NG-GPU - Host Build of the Kernel
+ *
+ * Compiles harmonia_ng_gpu_core.h as plain C (static inline host
+ * functions, tables in ordinary memory) and checks ng_gpu_hash against
+ * harmonia_ng_simd, so the per-thread kernel is tested on machines
+ * without nvcc or a CUDA device. "make test-gpu-host" runs it.
+ *
+ * License: MIT
+ */
+
+#include "harmonia_ng_gpu_core.h"
+#include "harmonia_ng.h"
+#include <stdio.h>
+#include <string.h>
+
+int main(void)
+{
+    static uint32_t data[(2048 + 64) / 4];      /* the kernel reads blocks as aligned words */
+    const uint8_t *bytes = (const uint8_t *)data;
+    uint32_t out[HARMONIA_NG_DIGEST_SIZE / 4];
+    uint8_t expected[HARMONIA_NG_DIGEST_SIZE];
+    size_t len, k;
+    int failed = 0;
+
+    for (k = 0; k < sizeof(data); k++) ((uint8_t *)data)[k] = (uint8_t)(k * 29 + 3);
+
+    printf("HARMONIA-NG-GPU host kernel Test\n");
+    printf("============================================================\n");
+
+    /* Every tail length and both padding cases, up to 32 blocks */
+    for (len = 0; len <= 2048; len++) {
+        ng_gpu_hash(bytes, len, (uint8_t *)out);
+        harmonia_ng_simd(bytes, len, expected);
+        if (memcmp(out, expected, sizeof(expected)) != 0) {
+            if (failed++ < 5) printf("  FAIL %4zu bytes (ng_gpu_hash != harmonia_ng_simd)\n", len);
+        }
+    }
+    if (!failed) {
+        printf("  OK   ng_gpu_hash, 0..2048 bytes\n");
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,230 @@
+/*
+ * HARMONIA-NG - Header-Only Inline Hash
+ *
+ * The whole of HARMONIA-NG as static inline functions, for callers that hash
+ * short fixed-size keys in a hot loop (hash tables, bloom filters, dedup
+ * indexes) and cannot afford a call, a context or a length-dependent branch
+ * per key:
+ *
+ *     #include "harmonia_ng_inline.h"
+ *
+ *     uint8_t digest[HARMONIA_NG_INLINE_DIGEST_SIZE];
+ *     harmonia_ng_inline(key, 16, digest);
+ *
+ * When len is a compile-time constant the block loop, the tail copy, the
+ * 0x80 pad byte and both length words fold away: a 16-byte key becomes four
+ * big-endian loads followed by one straight-line compression whose other 12
+ * message words are literals. Every rotation and constant index in the
+ * rounds is a literal from NG_ROTATION_SCHEDULE, so the state stays in
+ * registers. With a run-time len it still works, but the library's
+ * harmonia_ng_simd() is the better choice for long or variable input.
+ *
+ * Digests are identical to harmonia_ng() and need no library to link.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_NG_INLINE_H
+#define HARMONIA_NG_INLINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "harmonia_constants.h"
+
+#define HARMONIA_NG_INLINE_DIGEST_SIZE 32
+
+#define HARMONIA_NG_INLINE_FN static inline __attribute__((always_inline))
+
+#define NG_INLINE_ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define NG_INLINE_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+/* ============================================================================
+ * COMPRESSION
+ * ============================================================================ */
+
+HARMONIA_NG_INLINE_FN uint32_t harmonia_ng_inline_load(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+#define NG_INLINE_QR(s, a, b, c, d, r1, r2, r3, r4) do { \
+    s[a] += s[b]; s[d] ^= s[a]; s[d] = NG_INLINE_ROTL(s[d], r1); \
+    s[c] += s[d]; s[b] ^= s[c]; s[b] = NG_INLINE_ROTL(s[b], r2); \
+    s[a] += s[b]; s[d] ^= s[a]; s[d] = NG_INLINE_ROTL(s[d], r3); \
+    s[c] += s[d]; s[b] ^= s[c]; s[b] = NG_INLINE_ROTL(s[b], r4); \
+} while (0)
+
+HARMONIA_NG_INLINE_FN void harmonia_ng_inline_edge(uint32_t s[8], uint32_t fib_const)
+{
+    uint32_t interaction;
+
+    s[0] = NG_INLINE_ROTR(s[0], EDGE_ROT_LEFT) ^ fib_const;
+    s[7] = NG_INLINE_ROTL(s[7], EDGE_ROT_RIGHT) ^ ~fib_const;
+    interaction = (s[0] ^ s[7]) >> 16;
+    s[0] += interaction;
+    s[7] += interaction;
+}
+
+/* In order: c[0..2] are already updated when g[5..7] read them */
+#define NG_INLINE_CROSS_WORD(i) do { \
+    uint32_t t = g[i] ^ c[((i) + 3) & 7]; \
+    g[i] += NG_INLINE_ROTR(t, CROSS_STREAM_ROT); \
+    c[i] ^= NG_INLINE_ROTL(t, CROSS_STREAM_ROT); \
+} while (0)
+
+HARMONIA_NG_INLINE_FN void harmonia_ng_inline_cross(uint32_t g[8], uint32_t c[8])
+{
+    NG_INLINE_CROSS_WORD(0); NG_INLINE_CROSS_WORD(1); NG_INLINE_CROSS_WORD(2); NG_INLINE_CROSS_WORD(3);
+    NG_INLINE_CROSS_WORD(4); NG_INLINE_CROSS_WORD(5); NG_INLINE_CROSS_WORD(6); NG_INLINE_CROSS_WORD(7);
+}
+
+/* Message expansion: rot1 = 7 + i%5, rot2 = 17 + i%4 */
+#define NG_INLINE_EXPAND(i) do { \
+    uint32_t s0 = NG_INLINE_ROTR(w[(i) - 15], 7 + (i) % 5) ^ \
+                  NG_INLINE_ROTR(w[(i) - 15], 18 + (i) % 5) ^ (w[(i) - 15] >> 3); \
+    uint32_t s1 = NG_INLINE_ROTR(w[(i) - 2], 17 + (i) % 4) ^ \
+                  NG_INLINE_ROTR(w[(i) - 2], 19 + (i) % 4) ^ (w[(i) - 2] >> 10); \
+    w[i] = w[(i) - 16] + s0 + w[(i) - 7] + s1 + FIBONACCI[(i) % 12]; \
+} while (0)
+
+#define NG_INLINE_ROUND(r, r1, r2, r3, r4) \
+    g[0] += w[r]; \
+    c[0] += w[31 - (r)]; \
+    g[4] ^= PHI_CONSTANTS[(r) % 16]; \
+    c[4] ^= RECIPROCAL_CONSTANTS[(r) % 16]; \
+    NG_INLINE_QR(g, 0, 1, 2, 3, r1, r2, r3, r4); \
+    NG_INLINE_QR(g, 4, 5, 6, 7, r1, r2, r3, r4); \
+    NG_INLINE_QR(g, 0, 5, 2, 7, r1, r2, r3, r4); \
+    NG_INLINE_QR(g, 4, 1, 6, 3, r1, r2, r3, r4); \
+    NG_INLINE_QR(c, 0, 1, 2, 3, r1, r2, r3, r4); \
+    NG_INLINE_QR(c, 4, 5, 6, 7, r1, r2, r3, r4); \
+    NG_INLINE_QR(c, 0, 5, 2, 7, r1, r2, r3, r4); \
+    NG_INLINE_QR(c, 4, 1, 6, 3, r1, r2, r3, r4); \
+    if (((r) + 1) % 4 == 0) harmonia_ng_inline_cross(g, c); \
+    if (((r) + 1) % 8 == 0) { \
+        harmonia_ng_inline_edge(g, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+        harmonia_ng_inline_edge(c, FIBONACCI[(r) % 12] * 0x9E3779B9U); \
+    }
+
+/* Compress one block of 16 big-endian words in w[0..15] (w[16..31] are scratch) */
+HARMONIA_NG_INLINE_FN void harmonia_ng_inline_compress(uint32_t w[32], uint32_t state_g[8],
+                                                       uint32_t state_c[8])
+{
+    uint32_t g[8], c[8];
+
+    NG_INLINE_EXPAND(16); NG_INLINE_EXPAND(17); NG_INLINE_EXPAND(18); NG_INLINE_EXPAND(19);
+    NG_INLINE_EXPAND(20); NG_INLINE_EXPAND(21); NG_INLINE_EXPAND(22); NG_INLINE_EXPAND(23);
+    NG_INLINE_EXPAND(24); NG_INLINE_EXPAND(25); NG_INLINE_EXPAND(26); NG_INLINE_EXPAND(27);
+    NG_INLINE_EXPAND(28); NG_INLINE_EXPAND(29); NG_INLINE_EXPAND(30); NG_INLINE_EXPAND(31);
+
+    memcpy(g, state_g, sizeof(g));
+    memcpy(c, state_c, sizeof(c));
+
+    NG_ROTATION_SCHEDULE(NG_INLINE_ROUND)
+
+#define NG_INLINE_FEED_WORD(k) state_g[k] += g[k]; state_c[k] += c[k];
+    NG_INLINE_FEED_WORD(0) NG_INLINE_FEED_WORD(1) NG_INLINE_FEED_WORD(2) NG_INLINE_FEED_WORD(3)
+    NG_INLINE_FEED_WORD(4) NG_INLINE_FEED_WORD(5) NG_INLINE_FEED_WORD(6) NG_INLINE_FEED_WORD(7)
+#undef NG_INLINE_FEED_WORD
+}
+
+/* Fused word i, big-endian; rot = (i*3+5)%16+1 = 6,9,12,15,2,5,8,11 */
+#define NG_INLINE_FUSE_WORD(i, rot) do { \
+    uint32_t fused = (NG_INLINE_ROTR(g[i], rot) ^ NG_INLINE_ROTL(c[i], rot)) + PHI_CONSTANTS[i]; \
+    digest[(i) * 4 + 0] = (uint8_t)(fused >> 24); \
+    digest[(i) * 4 + 1] = (uint8_t)(fused >> 16); \
+    digest[(i) * 4 + 2] = (uint8_t)(fused >> 8); \
+    digest[(i) * 4 + 3] = (uint8_t)fused; \
+} while (0)
+
+/* Final edge protection, stream fusion and big-endian output */
+HARMONIA_NG_INLINE_FN void harmonia_ng_inline_finalize(const uint32_t state_g[8],
+                                                       const uint32_t state_c[8],
+                                                       uint8_t digest[32])
+{
+    uint32_t g[8], c[8];
+
+    memcpy(g, state_g, sizeof(g));
+    memcpy(c, state_c, sizeof(c));
+    harmonia_ng_inline_edge(g, FIBONACCI[32 % 12] * 0x9E3779B9U);
+    harmonia_ng_inline_edge(c, FIBONACCI[33 % 12] * 0x9E3779B9U);
+
+    NG_INLINE_FUSE_WORD(0, 6);  NG_INLINE_FUSE_WORD(1, 9);
+    NG_INLINE_FUSE_WORD(2, 12); NG_INLINE_FUSE_WORD(3, 15);
+    NG_INLINE_FUSE_WORD(4, 2);  NG_INLINE_FUSE_WORD(5, 5);
+    NG_INLINE_FUSE_WORD(6, 8);  NG_INLINE_FUSE_WORD(7, 11);
+}
+
+/* ============================================================================
+ * ONE-SHOT
+ * ============================================================================ */
+
+/* Compress data and its padding into state_g / state_c, starting from the IV */
+HARMONIA_NG_INLINE_FN void harmonia_ng_inline_absorb(const void *data, size_t len,
+                                                     uint32_t state_g[8], uint32_t state_c[8])
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t w[32];
+    size_t tail = len % 64, i;
+    uint64_t bits = (uint64_t)len * 8;
+
+    memcpy(state_g, NG_INITIAL_HASH_G, sizeof(NG_INITIAL_HASH_G));
+    memcpy(state_c, NG_INITIAL_HASH_C, sizeof(NG_INITIAL_HASH_C));
+
+    for (i = 0; i < len / 64; i++, p += 64) {
+        int k;
+
+        for (k = 0; k < 16; k++) {
+            w[k] = harmonia_ng_inline_load(p + 4 * k);
+        }
+        harmonia_ng_inline_compress(w, state_g, state_c);
+    }
+
+    /* SHA-style padding: whole words, then the 0-3 trailing bytes and 0x80 */
+    for (i = 0; i < 16; i++) w[i] = 0;
+    for (i = 0; i < tail / 4; i++) {
+        w[i] = harmonia_ng_inline_load(p + 4 * i);
+    }
+    for (i = tail & ~(size_t)3; i < tail; i++) {
+        w[i / 4] |= (uint32_t)p[i] << (24 - 8 * (i & 3));
+    }
+    w[tail / 4] |= 0x80U << (24 - 8 * (tail & 3));
+    if (tail >= 56) {
+        harmonia_ng_inline_compress(w, state_g, state_c);
+        for (i = 0; i < 16; i++) w[i] = 0;
+    }
+    w[14] = (uint32_t)(bits >> 32);
+    w[15] = (uint32_t)bits;
+    harmonia_ng_inline_compress(w, state_g, state_c);
+}
+
+/* harmonia_ng(data, len) into digest */
+HARMONIA_NG_INLINE_FN void harmonia_ng_inline(const void *data, size_t len, uint8_t digest[32])
+{
+    uint32_t g[8], c[8];
+
+    harmonia_ng_inline_absorb(data, len, g, c);
+    harmonia_ng_inline_finalize(g, c, digest);
+}
+
+/*
+ * The first 8 digest bytes of harmonia_ng(data, len) as a big-endian
+ * integer, for bucket and shard indices. Only fused words 0 and 1 are
+ * computed: they read g[0..1] and c[0..1], of which only word 0 depends on
+ * the final edge protection.
+ */
+HARMONIA_NG_INLINE_FN uint64_t harmonia_ng_inline_u64(const void *data, size_t len)
+{
+    uint32_t g[8], c[8], f0, f1;
+
+    harmonia_ng_inline_absorb(data, len, g, c);
+    harmonia_ng_inline_edge(g, FIBONACCI[32 % 12] * 0x9E3779B9U);
+    harmonia_ng_inline_edge(c, FIBONACCI[33 % 12] * 0x9E3779B9U);
+    f0 = (NG_INLINE_ROTR(g[0], 6) ^ NG_INLINE_ROTL(c[0], 6)) + PHI_CONSTANTS[0];
+    f1 = (NG_INLINE_ROTR(g[1], 9) ^ NG_INLINE_ROTL(c[1], 9)) + PHI_CONSTANTS[1];
+    return ((uint64_t)f0 << 32) | f1;
+}
+
+#endif /* HARMONIA_NG_INLINE_H */
@@ -0,0 +1,418 @@
+/*
+ * HARMONIA-NG-Merkle - Batched Merkle Tree Construction
+ *
+ * Builds a binary Merkle tree over n 32-byte leaves, one level at a time:
+ *
+ *   parent   = NG(left || right)      plain HARMONIA-NG of 64 bytes
+ *   odd last = carried up unchanged
+ *
+ * Every level is a batch of equal-length messages, so parents go through
+ * the lane engine (harmonia_ng_multi: x4 on NEON, x8 / x16 on x86) instead
+ * of one compression at a time. Leaves are processed in aligned blocks of
+ * BLOCK_LEAVES, reduced while they are still in cache; blocks are the unit
+ * of work for the optional threads.
+ *
+ * License: MIT
+ */
+
+#include "harmonia_ng.h"
+#include "harmonia_cpu.h"
+#include "harmonia_stats.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define NODE_SIZE       HARMONIA_NG_DIGEST_SIZE
+
+/*
+ * Work unit: BLOCK_LEAVES aligned leaves (32 KB), reduced BLOCK_LEVELS
+ * levels to one node. With the carry-up rule, node i of level L covers
+ * leaves [i << L, (i + 1) << L), so aligned blocks never interact below
+ * BLOCK_LEVELS and the partial last block reduces like the tail of a level.
+ */
+#define BLOCK_LEVELS    10
+#define BLOCK_LEAVES    (1u << BLOCK_LEVELS)
+
+#define LEVEL_BATCH     128     /* parents per harmonia_ng_multi call */
+#define MAX_LEVELS      64
+
+/* ============================================================================
+ * LEVEL REDUCTION
+ * ============================================================================ */
+
+/* Number of levels above the leaves (0 for a single leaf) */
+static int tree_levels(size_t n)
+{
+    int levels = 0;
+
+    while (n > 1) {
+        n = (n + 1) / 2;
+        levels++;
+    }
+    return levels;
+}
+
+/*
+ * Hash one level: dst[k] = NG(src[2k] || src[2k+1]), an odd last node is
+ * copied. Returns the number of nodes written. src and dst must not overlap.
+ */
+static size_t merkle_level(const uint8_t *src, size_t count, uint8_t *dst)
+{
+    const uint8_t *msgs[LEVEL_BATCH];
+    size_t lens[LEVEL_BATCH];
+    size_t pairs = count / 2;
+    size_t done, batch, k;
+
+    for (k = 0; k < LEVEL_BATCH; k++) {
+        lens[k] = 2 * NODE_SIZE;
+    }
+
+    for (done = 0; done < pairs; done += batch) {
+        batch = (pairs - done < LEVEL_BATCH) ? pairs - done : LEVEL_BATCH;
+        for (k = 0; k < batch; k++) {
+            msgs[k] = src + 2 * NODE_SIZE * (done + k);
+        }
+        harmonia_ng_multi(msgs, lens, dst + NODE_SIZE * done, batch);
+    }
+
+    if (count & 1) {
+        memcpy(dst + NODE_SIZE * pairs, src + NODE_SIZE * (count - 1), NODE_SIZE);
+    }
+    return pairs + (count & 1);
+}
+
+/* ============================================================================
+ * THREAD POOL
+ * ============================================================================ */
+
+typedef struct {
+    const uint8_t *leaves;
+    size_t n;
+    size_t nblocks;
+    int block_levels;        /* Levels reduced inside a block */
+    uint8_t **level;         /* build: level[L] for L = 1..levels, else NULL */
+    uint8_t *block_nodes;    /* root: nblocks nodes, one per block */
+    size_t next;             /* Next block to claim (atomic) */
+#ifdef HARMONIA_STATS
+    pthread_mutex_t lock;
+    harmonia_stats stats;    /* Worker counters, merged into the caller's */
+#endif
+} merkle_job;
+
+/*
+ * Reduce block b to its node (stored in out unless NULL). When building,
+ * each level is written into its slice of the node array; otherwise two
+ * stack buffers alternate.
+ */
+static void merkle_block(const merkle_job *job, size_t b, uint8_t *out)
+{
+    uint8_t scratch[2][BLOCK_LEAVES / 2 * NODE_SIZE];
+    size_t first = b * BLOCK_LEAVES;
+    size_t count = job->n - first;
+    const uint8_t *src = job->leaves + first * NODE_SIZE;
+    uint8_t *dst;
+    int L;
+
+    if (count > BLOCK_LEAVES) count = BLOCK_LEAVES;
+
+    for (L = 1; L <= job->block_levels; L++) {
+        dst = job->level ? job->level[L] + (first >> L) * NODE_SIZE : scratch[L & 1];
+        count = merkle_level(src, count, dst);
+        src = dst;
+    }
+
+    if (out) {
+        memcpy(out, src, NODE_SIZE);
+    }
+}
+
+/* Claim and reduce blocks until none are left */
+static void merkle_blocks(merkle_job *job)
+{
+    size_t b;
+
+    while ((b = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->nblocks) {
+        merkle_block(job, b, job->block_nodes ? job->block_nodes + b * NODE_SIZE : NULL);
+    }
+}
+
+static void *merkle_worker(void *arg)
+{
+    merkle_job *job = (merkle_job *)arg;
+#ifdef HARMONIA_STATS
+    harmonia_stats before;
+
+    harmonia_stats_get(&before);
+#endif
+    merkle_blocks(job);
+#ifdef HARMONIA_STATS
+    /* Credit the work to the thread that called run_blocks() */
+    pthread_mutex_lock(&job->lock);
+    harmonia_stats_accumulate(&job->stats, &before);
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return NULL;
+}
+
+/* Run the blocks on nthreads threads (0 = one per CPU); the caller is worker 0 */
+static void run_blocks(merkle_job *job, int nthreads)
+{
+    pthread_t *threads = NULL;
+    int t, started = 0;
+
+    job->next = 0;
+    if (nthreads <= 0) nthreads = harmonia_cpu_count();
+    if ((size_t)nthreads > job->nblocks) nthreads = (int)job->nblocks;
+
+    if (nthreads > 1) {
+        threads = (pthread_t *)malloc((size_t)(nthreads - 1) * sizeof(pthread_t));
+    }
+#ifdef HARMONIA_STATS
+    pthread_mutex_init(&job->lock, NULL);
+    memset(&job->stats, 0, sizeof(job->stats));
+#endif
+    for (t = 0; threads && t < nthreads - 1; t++) {
+        if (pthread_create(&threads[t], NULL, merkle_worker, job) != 0) break;
+        started++;
+    }
+    merkle_blocks(job);
+    for (t = 0; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+#ifdef HARMONIA_STATS
+    harmonia_stats_merge(&job->stats);
+    pthread_mutex_destroy(&job->lock);
+#endif
+    free(threads);
+}
+
+static void job_init(merkle_job *job, const uint8_t *leaves, size_t n)
+{
+    int levels = tree_levels(n);
+
+    job->leaves = leaves;
+    job->n = n;
+    job->nblocks = (n + BLOCK_LEAVES - 1) / BLOCK_LEAVES;
+    job->block_levels = (levels < BLOCK_LEVELS) ? levels : BLOCK_LEVELS;
+    job->level = NULL;
+    job->block_nodes = NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+size_t harmonia_ng_merkle_nodes(size_t n)
+{
+    size_t total = 0;
+
+    while (n > 1) {
+        n = (n + 1) / 2;
+        total += n;
+    }
+    return total;
+}
+
+void harmonia_ng_merkle_build(const uint8_t *leaves, size_t n, uint8_t *nodes, int nthreads)
+{
+    uint8_t *level[MAX_LEVELS + 1];
+    merkle_job job;
+    size_t count = n;
+    int levels = tree_levels(n);
+    int L;
+
+    if (levels == 0) return;
+
+    /* Levels are stored bottom-up, back to back */
+    level[1] = nodes;
+    for (L = 1; L < levels; L++) {
+        count = (count + 1) / 2;
+        level[L + 1] = level[L] + count * NODE_SIZE;
+    }
+
+    job_init(&job, leaves, n);
+    job.level = level;
+    run_blocks(&job, nthreads);
+
+    /* Levels above the blocks are small: finish them on this thread */
+    count = job.nblocks;
+    for (L = job.block_levels + 1; L <= levels; L++) {
+        count = merkle_level(level[L - 1], count, level[L]);
+    }
+}
+
+/*
+ * Node i of level L computed without the block array: aligned blocks are
+ * reduced directly and higher nodes recurse on their children. Used only
+ * when the block array cannot be allocated.
+ */
+static void merkle_node(const merkle_job *job, int L, size_t i, uint8_t *node)
+{
+    uint8_t pair[2 * NODE_SIZE];
+    size_t children = (job->n + ((size_t)1 << (L - 1)) - 1) >> (L - 1);
+
+    if (L == job->block_levels) {
+        merkle_block(job, i, node);
+        return;
+    }
+
+    merkle_node(job, L - 1, 2 * i, pair);
+    if (2 * i + 1 == children) {
+        memcpy(node, pair, NODE_SIZE);
+        return;
+    }
+    merkle_node(job, L - 1, 2 * i + 1, pair + NODE_SIZE);
+    harmonia_ng_simd(pair, sizeof(pair), node);
+}
+
+void harmonia_ng_merkle_root(const uint8_t *leaves, size_t n, uint8_t *root, int nthreads)
+{
+    merkle_job job;
+    uint8_t *src, *dst, *tmp;
+    size_t count;
+
+    if (n == 0) {
+        harmonia_ng_simd(NULL, 0, root);
+        return;
+    }
+    if (n == 1) {
+        memcpy(root, leaves, NODE_SIZE);
+        return;
+    }
+
+    job_init(&job, leaves, n);
+
+    /* Single block: no allocation or threads */
+    if (job.nblocks == 1) {
+        merkle_block(&job, 0, root);
+        return;
+    }
+
+    /* Block nodes followed by room for the alternate top level */
+    job.block_nodes = (uint8_t *)malloc((job.nblocks + job.nblocks / 2 + 1) * NODE_SIZE);
+    if (!job.block_nodes) {
+        merkle_node(&job, tree_levels(n), 0, root);
+        return;
+    }
+    run_blocks(&job, nthreads);
+
+    /* Top levels alternate between the two areas */
+    src = job.block_nodes;
+    dst = job.block_nodes + job.nblocks * NODE_SIZE;
+    count = job.nblocks;
+    while (count > 1) {
+        count = merkle_level(src, count, dst);
+        tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+    memcpy(root, src, NODE_SIZE);
+    free(job.block_nodes);
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+/* Serial reference: pairs hashed one by one with the streaming API */
+static void ref_root(const uint8_t *leaves, size_t n, uint8_t *nodes, uint8_t *root)
+{
+    const uint8_t *src = leaves;
+    uint8_t *dst = nodes;
+    harmonia_ng_ctx ctx;
+    size_t k;
+
+    while (n > 1) {
+        for (k = 0; k + 1 < n; k += 2) {
+            harmonia_ng_simd_init(&ctx);
+            harmonia_ng_simd_update(&ctx, src + k * NODE_SIZE, 2 * NODE_SIZE);
+            harmonia_ng_simd_final(&ctx, dst + (k / 2) * NODE_SIZE);
+        }
+        if (n & 1) {
+            memcpy(dst + (n / 2) * NODE_SIZE, src + (n - 1) * NODE_SIZE, NODE_SIZE);
+        }
+        n = (n + 1) / 2;
+        src = dst;
+        dst += n * NODE_SIZE;
+    }
+    memcpy(root, src, NODE_SIZE);
+}
+
+int harmonia_ng_merkle_self_test(void)
+{
+    static const size_t counts[] = {
+        1, 2, 3, 5, 16, 17, BLOCK_LEAVES - 1, BLOCK_LEAVES, BLOCK_LEAVES + 1,
+        3 * BLOCK_LEAVES + 123, 5 * BLOCK_LEAVES
+    };
+    /* Python: leaves[k] = harmonia_ng(bytes([k])), k = 0..4 */
+    static const char *expected5 =
+        "a1882e9c4aba1c52098dec36f557ee9d0e6b071a2fb457f849e41db6ad84654c";
+    const size_t max_n = 5 * BLOCK_LEAVES;
+    uint8_t *leaves, *nodes, *ref_nodes;
+    uint8_t root[NODE_SIZE], expected[NODE_SIZE];
+    char hex[65];
+    size_t t, k;
+    int failed = 0;
+
+    printf("\nHARMONIA-NG-Merkle Self-Test\n");
+    printf("============================================================\n");
+
+    leaves = (uint8_t *)malloc(max_n * NODE_SIZE);
+    nodes = (uint8_t *)malloc(2 * max_n * NODE_SIZE);
+    ref_nodes = (uint8_t *)malloc(2 * max_n * NODE_SIZE);
+    if (!leaves || !nodes || !ref_nodes) {
+        printf("  FAIL allocation\n");
+        free(leaves);
+        free(nodes);
+        free(ref_nodes);
+        return 1;
+    }
+
+    for (k = 0; k < 5; k++) {
+        uint8_t byte = (uint8_t)k;
+        harmonia_ng_simd(&byte, 1, leaves + k * NODE_SIZE);
+    }
+    harmonia_ng_merkle_root(leaves, 5, root, 1);
+    for (k = 0; k < NODE_SIZE; k++) sprintf(hex + 2 * k, "%02x", root[k]);
+    if (strcmp(hex, expected5) == 0) {
+        printf("  OK   known answer (5 leaves)\n");
+    } else {
+        printf("  FAIL known answer (5 leaves)\n");
+        printf("       Expected: %s\n", expected5);
+        printf("       Got:      %s\n", hex);
+        failed++;
+    }
+
+    for (k = 0; k < max_n * NODE_SIZE; k++) leaves[k] = (uint8_t)(k * 167 + (k >> 11));
+
+    for (t = 0; t < sizeof(counts) / sizeof(counts[0]); t++) {
+        size_t n = counts[t], total = harmonia_ng_merkle_nodes(n);
+        uint8_t r1[NODE_SIZE], r3[NODE_SIZE];
+        int ok;
+
+        ref_root(leaves, n, ref_nodes, expected);
+        harmonia_ng_merkle_root(leaves, n, r1, 1);
+        harmonia_ng_merkle_root(leaves, n, r3, 3);
+        ok = memcmp(r1, expected, NODE_SIZE) == 0 && memcmp(r3, expected, NODE_SIZE) == 0;
+
+        memset(nodes, 0, 2 * max_n * NODE_SIZE);
+        harmonia_ng_merkle_build(leaves, n, nodes, 3);
+        ok &= memcmp(nodes, ref_nodes, total * NODE_SIZE) == 0;
+
+        if (ok) {
+            printf("  OK   %zu leaves (%zu nodes)\n", n, total);
+        } else {
+            printf("  FAIL %zu leaves (tree != serial reference)\n", n);
+            failed++;
+        }
+    }
+
+    free(leaves);
+    free(nodes);
+    free(ref_nodes);
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
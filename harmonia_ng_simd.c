@@ -3,13 +3,22 @@
  *
  * Optimized ARM NEON implementation of HARMONIA-NG.
  * Processes both golden and complementary streams in parallel.
+ * Multi-message hashing: 4 lanes (NEON), 8 lanes (AVX2), 16 lanes (AVX-512).
+ * The x86 multi-buffer kernels are built with per-function target attributes
+ * and chosen at runtime from harmonia_cpu_features().
  *
  * Performance target: 500-1000 MB/s on Apple M2
  */
 
 #include "harmonia_ng.h"
+#include "harmonia_cpu.h"
+#include "harmonia_stats.h"
+#include "harmonia_iov.h"
+#include "harmonia_ng_inline.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
 
 /* Note: This file uses optimized scalar code that benefits from compile-time
  * constant rotations. NEON intrinsics were removed after benchmarking showed
@@ -18,42 +27,11 @@
  */
 
 /* ============================================================================
- * CONSTANTS (same as harmonia_ng.c)
+ * CONSTANTS (shared tables in harmonia_constants.h)
  * ============================================================================ */
 
-static const uint32_t FIBONACCI[12] = {
-    1, 1, 2, 3, 5, 8, 13, 21, 34, 55, 89, 144
-};
-
-static const uint32_t PHI_CONSTANTS[16] = {
-    0x9E37605A, 0xDAC1E0F2, 0xF287A338, 0xFA8CFC04,
-    0xFD805AA6, 0xCCF29760, 0xFF8184C3, 0xFF850D11,
-    0xCC32476B, 0x98767486, 0xFFF82080, 0x30E4E2F3,
-    0xFCC3ACC1, 0xE5216F38, 0xF30E4CC9, 0x948395F6
-};
-
-static const uint32_t RECIPROCAL_CONSTANTS[16] = {
-    0x7249217F, 0x5890EB7C, 0x4786B47C, 0x4C51DBE8,
-    0x4E4DA61B, 0x4F76650C, 0x4F2F1A2A, 0x4F6CE289,
-    0x4F1ADF40, 0x4E84BABC, 0x4F22D993, 0x497FA704,
-    0x4F514F19, 0x4E8F43B8, 0x508E2FD9, 0x4B5F94A4
-};
-
-static const uint32_t INITIAL_HASH_G[8] = {
-    0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A,
-    0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
-};
-
-static const uint32_t INITIAL_HASH_C[8] = {
-    0x9E3779B9, 0x7F4A7C15, 0xF39CC060, 0x5CEDC834,
-    0x2FE12A6D, 0x4786B47C, 0xC8A5E2F0, 0x3A8D6B7F
-};
-
-/* Round rotation patterns - index into which pattern to use */
-static const uint8_t ROUND_PATTERN[32] = {
-    0, 1, 2, 3, 1, 4, 1, 0, 2, 5, 0, 4, 1, 0, 6, 3,
-    0, 7, 0, 1, 2, 3, 1, 4, 0, 1, 2, 5, 0, 4, 1, 0
-};
+/* Key sizes with a 64-bit truncated fixed-size API (harmonia_ng_u64_fixedN) */
+#define NG_U64_KEY_SIZES(X) X(8) X(16) X(32)
 
 /* Pre-computed edge protection constants: FIBONACCI[r%12] * 0x9E3779B9 */
 static const uint32_t EDGE_CONSTANTS[32] = {
@@ -84,159 +62,53 @@ static const uint32_t EDGE_CONSTANTS[32] = {
  * process 4 independent messages simultaneously, achieving ~4x throughput.
  */
 
-/* Optimized scalar round - compiler can auto-vectorize parts */
-static void round_scalar_opt(uint32_t *g, uint32_t *c, int pattern)
-{
-    #define QR_SCALAR(s, a, b, c_, d, R1, R2, R3, R4) do { \
-        s[a] += s[b]; s[d] ^= s[a]; s[d] = (s[d] << R1) | (s[d] >> (32 - R1)); \
-        s[c_] += s[d]; s[b] ^= s[c_]; s[b] = (s[b] << R2) | (s[b] >> (32 - R2)); \
-        s[a] += s[b]; s[d] ^= s[a]; s[d] = (s[d] << R3) | (s[d] >> (32 - R3)); \
-        s[c_] += s[d]; s[b] ^= s[c_]; s[b] = (s[b] << R4) | (s[b] >> (32 - R4)); \
-    } while(0)
-
-    switch (pattern) {
-        case 0:
-            QR_SCALAR(g, 0,1,2,3, 12,8,16,7); QR_SCALAR(g, 4,5,6,7, 12,8,16,7);
-            QR_SCALAR(g, 0,5,2,7, 12,8,16,7); QR_SCALAR(g, 4,1,6,3, 12,8,16,7);
-            QR_SCALAR(c, 0,1,2,3, 12,8,16,7); QR_SCALAR(c, 4,5,6,7, 12,8,16,7);
-            QR_SCALAR(c, 0,5,2,7, 12,8,16,7); QR_SCALAR(c, 4,1,6,3, 12,8,16,7);
-            break;
-        case 1:
-            QR_SCALAR(g, 0,1,2,3, 11,9,13,5); QR_SCALAR(g, 4,5,6,7, 11,9,13,5);
-            QR_SCALAR(g, 0,5,2,7, 11,9,13,5); QR_SCALAR(g, 4,1,6,3, 11,9,13,5);
-            QR_SCALAR(c, 0,1,2,3, 11,9,13,5); QR_SCALAR(c, 4,5,6,7, 11,9,13,5);
-            QR_SCALAR(c, 0,5,2,7, 11,9,13,5); QR_SCALAR(c, 4,1,6,3, 11,9,13,5);
-            break;
-        case 2:
-            QR_SCALAR(g, 0,1,2,3, 8,16,7,12); QR_SCALAR(g, 4,5,6,7, 8,16,7,12);
-            QR_SCALAR(g, 0,5,2,7, 8,16,7,12); QR_SCALAR(g, 4,1,6,3, 8,16,7,12);
-            QR_SCALAR(c, 0,1,2,3, 8,16,7,12); QR_SCALAR(c, 4,5,6,7, 8,16,7,12);
-            QR_SCALAR(c, 0,5,2,7, 8,16,7,12); QR_SCALAR(c, 4,1,6,3, 8,16,7,12);
-            break;
-        case 3:
-            QR_SCALAR(g, 0,1,2,3, 16,7,12,8); QR_SCALAR(g, 4,5,6,7, 16,7,12,8);
-            QR_SCALAR(g, 0,5,2,7, 16,7,12,8); QR_SCALAR(g, 4,1,6,3, 16,7,12,8);
-            QR_SCALAR(c, 0,1,2,3, 16,7,12,8); QR_SCALAR(c, 4,5,6,7, 16,7,12,8);
-            QR_SCALAR(c, 0,5,2,7, 16,7,12,8); QR_SCALAR(c, 4,1,6,3, 16,7,12,8);
-            break;
-        case 4:
-            QR_SCALAR(g, 0,1,2,3, 7,12,8,16); QR_SCALAR(g, 4,5,6,7, 7,12,8,16);
-            QR_SCALAR(g, 0,5,2,7, 7,12,8,16); QR_SCALAR(g, 4,1,6,3, 7,12,8,16);
-            QR_SCALAR(c, 0,1,2,3, 7,12,8,16); QR_SCALAR(c, 4,5,6,7, 7,12,8,16);
-            QR_SCALAR(c, 0,5,2,7, 7,12,8,16); QR_SCALAR(c, 4,1,6,3, 7,12,8,16);
-            break;
-        case 5:
-            QR_SCALAR(g, 0,1,2,3, 13,5,11,9); QR_SCALAR(g, 4,5,6,7, 13,5,11,9);
-            QR_SCALAR(g, 0,5,2,7, 13,5,11,9); QR_SCALAR(g, 4,1,6,3, 13,5,11,9);
-            QR_SCALAR(c, 0,1,2,3, 13,5,11,9); QR_SCALAR(c, 4,5,6,7, 13,5,11,9);
-            QR_SCALAR(c, 0,5,2,7, 13,5,11,9); QR_SCALAR(c, 4,1,6,3, 13,5,11,9);
-            break;
-        case 6:
-            QR_SCALAR(g, 0,1,2,3, 9,13,5,11); QR_SCALAR(g, 4,5,6,7, 9,13,5,11);
-            QR_SCALAR(g, 0,5,2,7, 9,13,5,11); QR_SCALAR(g, 4,1,6,3, 9,13,5,11);
-            QR_SCALAR(c, 0,1,2,3, 9,13,5,11); QR_SCALAR(c, 4,5,6,7, 9,13,5,11);
-            QR_SCALAR(c, 0,5,2,7, 9,13,5,11); QR_SCALAR(c, 4,1,6,3, 9,13,5,11);
-            break;
-        case 7:
-            QR_SCALAR(g, 0,1,2,3, 5,11,9,13); QR_SCALAR(g, 4,5,6,7, 5,11,9,13);
-            QR_SCALAR(g, 0,5,2,7, 5,11,9,13); QR_SCALAR(g, 4,1,6,3, 5,11,9,13);
-            QR_SCALAR(c, 0,1,2,3, 5,11,9,13); QR_SCALAR(c, 4,5,6,7, 5,11,9,13);
-            QR_SCALAR(c, 0,5,2,7, 5,11,9,13); QR_SCALAR(c, 4,1,6,3, 5,11,9,13);
-            break;
-    }
-    #undef QR_SCALAR
-}
-
-/* Note: round_simd_transposed kept for potential future 4-message parallel hashing */
-
-/* ============================================================================
- * OPTIMIZED COMPRESSION FUNCTION (scalar with compile-time constants)
- * ============================================================================ */
+/* One block: the straight-line rounds of harmonia_ng_inline.h, generated
+ * from NG_ROTATION_SCHEDULE with every rotation a literal */
 
-static void compress_simd(const uint8_t *block, uint32_t *state_g, uint32_t *state_c)
+static inline __attribute__((always_inline)) void compress_block(const uint8_t *block,
+                                                                uint32_t *state_g, uint32_t *state_c)
 {
     uint32_t w[32];
-    uint32_t g[8], c[8];
-    int r, i;
+    int i;
 
     /* Parse block (big-endian) */
     for (i = 0; i < 16; i++) {
-        w[i] = ((uint32_t)block[i*4] << 24) |
-               ((uint32_t)block[i*4+1] << 16) |
-               ((uint32_t)block[i*4+2] << 8) |
-               ((uint32_t)block[i*4+3]);
+        w[i] = harmonia_ng_inline_load(block + 4 * i);
     }
+    harmonia_ng_inline_compress(w, state_g, state_c);
+}
 
-    /* Expand to 32 words */
-    #define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
-    for (i = 16; i < 32; i++) {
-        int rot1 = 7 + (i % 5);
-        int rot2 = 17 + (i % 4);
-        uint32_t s0 = ROTR32(w[i-15], rot1) ^ ROTR32(w[i-15], rot1 + 11) ^ (w[i-15] >> 3);
-        uint32_t s1 = ROTR32(w[i-2], rot2) ^ ROTR32(w[i-2], rot2 + 2) ^ (w[i-2] >> 10);
-        w[i] = w[i-16] + s0 + w[i-7] + s1 + FIBONACCI[i % 12];
-    }
-    #undef ROTR32
+/*
+ * Compress nblocks consecutive blocks. The 16 chaining words stay in locals
+ * across the whole run instead of going back through the caller's state on
+ * every block, and the next block is prefetched while the current one mixes.
+ */
+static void compress_simd(const uint8_t *data, size_t nblocks, uint32_t *state_g, uint32_t *state_c)
+{
+    uint32_t hg[8], hc[8];
+    int i;
+
+    HARMONIA_PROBE2(compress__start, state_g, nblocks);
+    HARMONIA_STAT(blocks, nblocks);
+    HARMONIA_STAT(scalar_blocks, nblocks);
 
-    /* Initialize working state */
     for (i = 0; i < 8; i++) {
-        g[i] = state_g[i];
-        c[i] = state_c[i];
+        hg[i] = state_g[i];
+        hc[i] = state_c[i];
     }
 
-    /* 32 rounds */
-    for (r = 0; r < 32; r++) {
-        int pattern = ROUND_PATTERN[r];
-
-        /* Message and constant injection */
-        g[0] += w[r];
-        c[0] += w[31 - r];
-        g[4] ^= PHI_CONSTANTS[r % 16];
-        c[4] ^= RECIPROCAL_CONSTANTS[r % 16];
-
-        /* Apply round function */
-        round_scalar_opt(g, c, pattern);
-
-        /* Cross-stream diffusion every 4 rounds */
-        if ((r + 1) % 4 == 0) {
-            for (i = 0; i < 8; i++) {
-                uint32_t temp = g[i] ^ c[(i + 3) % 8];
-                uint32_t tl = (temp << 11) | (temp >> 21);
-                uint32_t tr = (temp >> 11) | (temp << 21);
-                g[i] += tr;
-                c[i] ^= tl;
-            }
-        }
-
-        /* Edge protection every 8 rounds */
-        if ((r + 1) % 8 == 0) {
-            uint32_t fib = EDGE_CONSTANTS[r];
-
-            /* Golden stream */
-            g[0] = (g[0] >> 7) | (g[0] << 25);
-            g[0] ^= fib;
-            g[7] = (g[7] << 13) | (g[7] >> 19);
-            g[7] ^= ~fib;
-            uint32_t inter_g = (g[0] ^ g[7]) >> 16;
-            g[0] += inter_g;
-            g[7] += inter_g;
-
-            /* Complementary stream */
-            c[0] = (c[0] >> 7) | (c[0] << 25);
-            c[0] ^= fib;
-            c[7] = (c[7] << 13) | (c[7] >> 19);
-            c[7] ^= ~fib;
-            uint32_t inter_c = (c[0] ^ c[7]) >> 16;
-            c[0] += inter_c;
-            c[7] += inter_c;
-        }
+    while (nblocks-- > 0) {
+        __builtin_prefetch(data + 64);
+        compress_block(data, hg, hc);
+        data += 64;
     }
 
-    /* Davies-Meyer: add to original state */
     for (i = 0; i < 8; i++) {
-        state_g[i] += g[i];
-        state_c[i] += c[i];
+        state_g[i] = hg[i];
+        state_c[i] = hc[i];
     }
+
+    HARMONIA_PROBE2(compress__done, state_g, data);
 }
 
 /* ============================================================================
@@ -253,7 +125,7 @@ static void compress_simd(const uint8_t *block, uint32_t *state_g, uint32_t *sta
  * All ARX operations are completely independent between lanes, giving true 4x speedup.
  */
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#if defined(HARMONIA_ARM_NEON)
 #include <arm_neon.h>
 
 /* NEON rotation macro */
@@ -607,7 +479,8 @@ static void finalize_x4(uint32x4_t state_g[8], uint32x4_t state_c[8], uint8_t *d
  * Hash 4 messages in parallel using SIMD.
  *
  * This function achieves ~4x throughput compared to calling harmonia_ng() 4 times.
- * Ideal for: servers hashing many requests, Merkle tree construction, batch validation.
+ * Ideal for: servers hashing many requests, batch validation. Merkle trees are
+ * built level by level on these lanes by harmonia_ng_merkle_build / _root.
  *
  * All 4 messages must have the same length for this simplified API.
  */
@@ -622,8 +495,8 @@ void harmonia_ng_x4(const uint8_t *msgs[4], size_t len, uint8_t *digests[4])
 
     /* Initialize state: each lane gets the same initial value */
     for (i = 0; i < 8; i++) {
-        state_g[i] = vdupq_n_u32(INITIAL_HASH_G[i]);
-        state_c[i] = vdupq_n_u32(INITIAL_HASH_C[i]);
+        state_g[i] = vdupq_n_u32(NG_INITIAL_HASH_G[i]);
+        state_c[i] = vdupq_n_u32(NG_INITIAL_HASH_C[i]);
     }
 
     /* Process full blocks */
@@ -671,228 +544,1907 @@ void harmonia_ng_x4(const uint8_t *msgs[4], size_t len, uint8_t *digests[4])
 
     compress_x4(blocks, state_g, state_c);
     finalize_x4(state_g, state_c, digests);
+
+    /* Every lane of every step carried a block */
+    HARMONIA_STAT(lane_calls, processed / 64 + (remaining < 56 ? 1 : 2));
+    HARMONIA_STAT(lane_slots, 4 * (processed / 64 + (remaining < 56 ? 1 : 2)));
+    HARMONIA_STAT(lane_busy, 4 * (processed / 64 + (remaining < 56 ? 1 : 2)));
+    HARMONIA_STAT(blocks, 4 * (processed / 64 + (remaining < 56 ? 1 : 2)));
+    HARMONIA_STAT(simd_blocks, 4 * (processed / 64 + (remaining < 56 ? 1 : 2)));
+    HARMONIA_STAT(pad_blocks, 4 * (remaining < 56 ? 1 : 2));
+    HARMONIA_STAT(digests, 4);
 }
 
 #else
-/* Fallback for non-NEON: just call scalar version 4 times */
+/* Without NEON: run the 4 messages through the widest multi-buffer kernel
+ * available at runtime (AVX2 / AVX-512 with idle lanes, else scalar) */
 void harmonia_ng_x4(const uint8_t *msgs[4], size_t len, uint8_t *digests[4])
 {
+    const size_t lens[4] = {len, len, len, len};
+    uint8_t out[4][HARMONIA_NG_DIGEST_SIZE];
     int i;
+
+    harmonia_ng_multi(msgs, lens, out[0], 4);
     for (i = 0; i < 4; i++) {
-        harmonia_ng_simd(msgs[i], len, digests[i]);
+        memcpy(digests[i], out[i], HARMONIA_NG_DIGEST_SIZE);
     }
 }
-#endif /* __ARM_NEON */
+#endif /* HARMONIA_ARM_NEON */
 
 /* ============================================================================
- * FINALIZATION (same as scalar)
- * ============================================================================ */
+ * 8- AND 16-MESSAGE PARALLEL HASHING (AVX2 / AVX-512)
+ * ============================================================================
+ *
+ * x86 counterpart of harmonia_ng_x4: same lane layout (vector g[i] holds word
+ * i of every message), 8 lanes per __m256i and 16 lanes per __m512i.
+ *
+ * The round schedule, message expansion and mixing steps below are written
+ * once against a small set of vector operation macros (VADD, VXOR, VROTL, ...)
+ * which each lane width defines before instantiating its compress function.
+ *
+ * Every function here carries a target attribute, so the kernels build with
+ * the default (baseline x86-64) flags and are only called once
+ * harmonia_cpu_features() reports the matching extension.
+ */
 
-static void finalize_simd(uint32_t *state_g, uint32_t *state_c, uint8_t *digest)
+#if defined(HARMONIA_X86)
+#include <immintrin.h>
+
+/* One HARMONIA-NG round: column then diagonal quarter-rounds on both streams */
+#define NG_ROUND_QRS(QR, g, c, R1, R2, R3, R4) do { \
+    QR(g[0], g[1], g[2], g[3], R1, R2, R3, R4); \
+    QR(g[4], g[5], g[6], g[7], R1, R2, R3, R4); \
+    QR(g[0], g[5], g[2], g[7], R1, R2, R3, R4); \
+    QR(g[4], g[1], g[6], g[3], R1, R2, R3, R4); \
+    QR(c[0], c[1], c[2], c[3], R1, R2, R3, R4); \
+    QR(c[4], c[5], c[6], c[7], R1, R2, R3, R4); \
+    QR(c[0], c[5], c[2], c[7], R1, R2, R3, R4); \
+    QR(c[4], c[1], c[6], c[3], R1, R2, R3, R4); \
+} while(0)
+
+/* Rotation set for each pattern index of NG_ROUND_SCHEDULE */
+#define NG_ROUND_SWITCH(QR, g, c, pattern) do { \
+    switch (pattern) { \
+        case 0: NG_ROUND_QRS(QR, g, c, 12, 8, 16, 7); break; \
+        case 1: NG_ROUND_QRS(QR, g, c, 11, 9, 13, 5); break; \
+        case 2: NG_ROUND_QRS(QR, g, c, 8, 16, 7, 12); break; \
+        case 3: NG_ROUND_QRS(QR, g, c, 16, 7, 12, 8); break; \
+        case 4: NG_ROUND_QRS(QR, g, c, 7, 12, 8, 16); break; \
+        case 5: NG_ROUND_QRS(QR, g, c, 13, 5, 11, 9); break; \
+        case 6: NG_ROUND_QRS(QR, g, c, 9, 13, 5, 11); break; \
+        case 7: NG_ROUND_QRS(QR, g, c, 5, 11, 9, 13); break; \
+    } \
+} while(0)
+
+/* Fully unrolled 32-round schedule: ROUND(r, pattern), CROSS() after every
+ * 4th round and EDGE(r) after every 8th (same order as compress_x4) */
+#define NG_ROUND_SCHEDULE(ROUND, CROSS, EDGE) do { \
+    ROUND(0, 0);  ROUND(1, 1);  ROUND(2, 2);  ROUND(3, 3);  CROSS(); \
+    ROUND(4, 1);  ROUND(5, 4);  ROUND(6, 1);  ROUND(7, 0);  CROSS(); EDGE(7); \
+    ROUND(8, 2);  ROUND(9, 5);  ROUND(10, 0); ROUND(11, 4); CROSS(); \
+    ROUND(12, 1); ROUND(13, 0); ROUND(14, 6); ROUND(15, 3); CROSS(); EDGE(15); \
+    ROUND(16, 0); ROUND(17, 7); ROUND(18, 0); ROUND(19, 1); CROSS(); \
+    ROUND(20, 2); ROUND(21, 3); ROUND(22, 1); ROUND(23, 4); CROSS(); EDGE(23); \
+    ROUND(24, 0); ROUND(25, 1); ROUND(26, 2); ROUND(27, 5); CROSS(); \
+    ROUND(28, 0); ROUND(29, 4); ROUND(30, 1); ROUND(31, 0); CROSS(); EDGE(31); \
+} while(0)
+
+/* Generic lane-parallel building blocks (expand against the current V* ops) */
+#define QR_XN(a, b, c, d, R1, R2, R3, R4) do { \
+    a = VADD(a, b); d = VXOR(d, a); d = VROTL(d, R1); \
+    c = VADD(c, d); b = VXOR(b, c); b = VROTL(b, R2); \
+    a = VADD(a, b); d = VXOR(d, a); d = VROTL(d, R3); \
+    c = VADD(c, d); b = VXOR(b, c); b = VROTL(b, R4); \
+} while(0)
+
+#define SIGMA0_XN(x, R1, R2) VXOR(VXOR(VROTR(x, R1), VROTR(x, R2)), VSHR(x, 3))
+#define SIGMA1_XN(x, R1, R2) VXOR(VXOR(VROTR(x, R1), VROTR(x, R2)), VSHR(x, 10))
+
+#define EXPAND_WORD_XN(w, idx, R1A, R1B, R2A, R2B) \
+    w[idx] = VADD(VADD(VADD(w[idx-16], SIGMA0_XN(w[idx-15], R1A, R1B)), w[idx-7]), \
+                  VADD(SIGMA1_XN(w[idx-2], R2A, R2B), VSET1(FIBONACCI[(idx) % 12])))
+
+/* Rotation amounts as in compress_x4: rot1 = 7 + i%5, rot2 = 17 + i%4 */
+#define EXPAND_MESSAGE_XN(w) do { \
+    EXPAND_WORD_XN(w, 16, 8, 19, 17, 19);  EXPAND_WORD_XN(w, 17, 9, 20, 18, 20); \
+    EXPAND_WORD_XN(w, 18, 10, 21, 19, 21); EXPAND_WORD_XN(w, 19, 11, 22, 20, 22); \
+    EXPAND_WORD_XN(w, 20, 7, 18, 17, 19);  EXPAND_WORD_XN(w, 21, 8, 19, 18, 20); \
+    EXPAND_WORD_XN(w, 22, 9, 20, 19, 21);  EXPAND_WORD_XN(w, 23, 10, 21, 20, 22); \
+    EXPAND_WORD_XN(w, 24, 11, 22, 17, 19); EXPAND_WORD_XN(w, 25, 7, 18, 18, 20); \
+    EXPAND_WORD_XN(w, 26, 8, 19, 19, 21);  EXPAND_WORD_XN(w, 27, 9, 20, 20, 22); \
+    EXPAND_WORD_XN(w, 28, 10, 21, 17, 19); EXPAND_WORD_XN(w, 29, 11, 22, 18, 20); \
+    EXPAND_WORD_XN(w, 30, 7, 18, 19, 21);  EXPAND_WORD_XN(w, 31, 8, 19, 20, 22); \
+} while(0)
+
+#define ROUND_XN(R, PAT) do { \
+    g[0] = VADD(g[0], w[R]); \
+    c[0] = VADD(c[0], w[31-(R)]); \
+    g[4] = VXOR(g[4], VSET1(PHI_CONSTANTS[(R) % 16])); \
+    c[4] = VXOR(c[4], VSET1(RECIPROCAL_CONSTANTS[(R) % 16])); \
+    NG_ROUND_SWITCH(QR_XN, g, c, PAT); \
+} while(0)
+
+#define CROSS_XN() do { \
+    for (i = 0; i < 8; i++) { \
+        VEC temp = VXOR(g[i], c[(i + 3) % 8]); \
+        g[i] = VADD(g[i], VROTR(temp, 11)); \
+        c[i] = VXOR(c[i], VROTL(temp, 11)); \
+    } \
+} while(0)
+
+#define EDGE_XN_STREAM(s, FIB) do { \
+    VEC ie; \
+    s[0] = VXOR(VROTR(s[0], 7), VSET1(FIB)); \
+    s[7] = VXOR(VROTL(s[7], 13), VSET1(~(FIB))); \
+    ie = VSHR(VXOR(s[0], s[7]), 16); \
+    s[0] = VADD(s[0], ie); s[7] = VADD(s[7], ie); \
+} while(0)
+
+#define EDGE_XN(R) do { \
+    EDGE_XN_STREAM(g, EDGE_CONSTANTS[R]); \
+    EDGE_XN_STREAM(c, EDGE_CONSTANTS[R]); \
+} while(0)
+
+/* Final edge protection and stream fusion; fused word i lands in g[i].
+ * Rotation amounts: (i*3+5)%16+1 = 6,9,12,15,2,5,8,11 */
+#define FUSE_WORD_XN(idx, ROT) \
+    g[idx] = VADD(VXOR(VROTR(g[idx], ROT), VROTL(c[idx], ROT)), VSET1(PHI_CONSTANTS[idx]))
+
+#define FINALIZE_XN() do { \
+    EDGE_XN_STREAM(g, FIBONACCI[32 % 12] * 0x9E3779B9U); \
+    EDGE_XN_STREAM(c, FIBONACCI[33 % 12] * 0x9E3779B9U); \
+    FUSE_WORD_XN(0, 6);  FUSE_WORD_XN(1, 9); \
+    FUSE_WORD_XN(2, 12); FUSE_WORD_XN(3, 15); \
+    FUSE_WORD_XN(4, 2);  FUSE_WORD_XN(5, 5); \
+    FUSE_WORD_XN(6, 8);  FUSE_WORD_XN(7, 11); \
+} while(0)
+
+/* ---------------------------------------------------------------------------
+ * AVX2: 8 lanes
+ * --------------------------------------------------------------------------- */
+
+/* Rotations by 8 and 16 are byte permutations: one shuffle instead of three ops */
+#define ROTL_X8(x, n) \
+    ((n) == 16 ? _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+                     2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13, \
+                     2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13)) : \
+     (n) == 8  ? _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+                     3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14, \
+                     3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14)) : \
+     _mm256_or_si256(_mm256_slli_epi32((x), (n) & 31), _mm256_srli_epi32((x), (32 - (n)) & 31)))
+#define ROTR_X8(x, n) ROTL_X8(x, 32 - (n))
+
+/* Byte-swap each 32-bit word (big-endian load/store) */
+#define BSWAP32_X8(x) _mm256_shuffle_epi8((x), _mm256_setr_epi8( \
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, \
+    3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12))
+
+/* 8x8 transpose of 32-bit elements: row k <-> lane k */
+HARMONIA_TARGET_AVX2
+static inline __attribute__((always_inline)) void transpose_x8(__m256i r[8])
 {
-    uint32_t g[8], c[8];
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+/* Load 16 big-endian words from 8 blocks as 16 lane vectors */
+HARMONIA_TARGET_AVX2
+static inline __attribute__((always_inline)) void parse_words_x8(const uint8_t *const blocks[8],
+                                                                 __m256i w[16])
+{
+    int k;
+
+    for (k = 0; k < 8; k++) {
+        w[k]     = _mm256_loadu_si256((const __m256i *)blocks[k]);
+        w[k + 8] = _mm256_loadu_si256((const __m256i *)(blocks[k] + 32));
+    }
+    transpose_x8(w);
+    transpose_x8(w + 8);
+    for (k = 0; k < 16; k++) {
+        w[k] = BSWAP32_X8(w[k]);
+    }
+}
+
+/* Store 8 fused digest-word vectors as 8 big-endian digests */
+HARMONIA_TARGET_AVX2
+static inline __attribute__((always_inline)) void store_digests_x8(__m256i f[8], uint8_t *const digests[8])
+{
+    int k;
+
+    transpose_x8(f);
+    for (k = 0; k < 8; k++) {
+        _mm256_storeu_si256((__m256i *)digests[k], BSWAP32_X8(f[k]));
+    }
+}
+
+#define VEC          __m256i
+#define VADD         _mm256_add_epi32
+#define VXOR         _mm256_xor_si256
+#define VSHR         _mm256_srli_epi32
+#define VSET1(k)     _mm256_set1_epi32((int)(k))
+#define VROTL        ROTL_X8
+#define VROTR        ROTR_X8
+
+/* Compress 8 blocks in parallel */
+HARMONIA_TARGET_AVX2
+static void compress_x8(const uint8_t *const blocks[8], __m256i state_g[8], __m256i state_c[8])
+{
+    __m256i w[32];
+    __m256i g[8], c[8];
     int i;
 
+    parse_words_x8(blocks, w);
+    EXPAND_MESSAGE_XN(w);
+
     for (i = 0; i < 8; i++) {
         g[i] = state_g[i];
         c[i] = state_c[i];
     }
 
-    /* Final edge protection for g */
-    uint32_t fib_g = FIBONACCI[32 % 12] * 0x9E3779B9U;
-    g[0] = (g[0] >> 7) | (g[0] << 25);
-    g[0] ^= fib_g;
-    g[7] = (g[7] << 13) | (g[7] >> 19);
-    g[7] ^= ~fib_g;
-    uint32_t inter_g = (g[0] ^ g[7]) >> 16;
-    g[0] += inter_g;
-    g[7] += inter_g;
-
-    /* Final edge protection for c */
-    uint32_t fib_c = FIBONACCI[33 % 12] * 0x9E3779B9U;
-    c[0] = (c[0] >> 7) | (c[0] << 25);
-    c[0] ^= fib_c;
-    c[7] = (c[7] << 13) | (c[7] >> 19);
-    c[7] ^= ~fib_c;
-    uint32_t inter_c = (c[0] ^ c[7]) >> 16;
-    c[0] += inter_c;
-    c[7] += inter_c;
-
-    /* Fuse streams */
-    for (i = 0; i < 8; i++) {
-        int rot = (i * 3 + 5) % 16 + 1;
-        uint32_t gr = (g[i] >> rot) | (g[i] << (32 - rot));
-        uint32_t cr = (c[i] << rot) | (c[i] >> (32 - rot));
-        uint32_t fused = gr ^ cr;
-        fused += PHI_CONSTANTS[i];
+    NG_ROUND_SCHEDULE(ROUND_XN, CROSS_XN, EDGE_XN);
 
-        digest[i*4 + 0] = (fused >> 24) & 0xFF;
-        digest[i*4 + 1] = (fused >> 16) & 0xFF;
-        digest[i*4 + 2] = (fused >> 8) & 0xFF;
-        digest[i*4 + 3] = fused & 0xFF;
+    /* Davies-Meyer: add to original state */
+    for (i = 0; i < 8; i++) {
+        state_g[i] = _mm256_add_epi32(state_g[i], g[i]);
+        state_c[i] = _mm256_add_epi32(state_c[i], c[i]);
     }
 }
 
-/* ============================================================================
- * PUBLIC API
- * ============================================================================ */
+/* Finalize 8 hashes in parallel */
+HARMONIA_TARGET_AVX2
+static void finalize_x8(const __m256i state_g[8], const __m256i state_c[8], uint8_t *const digests[8])
+{
+    __m256i g[8], c[8];
+    int i;
 
-/* Forward declaration */
-void harmonia_ng_simd_full(const uint8_t *data, size_t len, uint8_t *digest);
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i];
+        c[i] = state_c[i];
+    }
 
-void harmonia_ng_simd(const uint8_t *data, size_t len, uint8_t *digest)
-{
-    /* Delegate to full implementation */
-    harmonia_ng_simd_full(data, len, digest);
+    FINALIZE_XN();
+    store_digests_x8(g, digests);
 }
 
-/* Full API with proper length tracking */
-void harmonia_ng_simd_full(const uint8_t *data, size_t len, uint8_t *digest)
+#undef VEC
+#undef VADD
+#undef VXOR
+#undef VSHR
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+/* ---------------------------------------------------------------------------
+ * AVX-512: 16 lanes
+ * --------------------------------------------------------------------------- */
+
+#define VEC          __m512i
+#define VADD         _mm512_add_epi32
+#define VXOR         _mm512_xor_si512
+#define VSHR         _mm512_srli_epi32
+#define VSET1(k)     _mm512_set1_epi32((int)(k))
+#define VROTL        _mm512_rol_epi32
+#define VROTR        _mm512_ror_epi32
+
+/* Compress 16 blocks in parallel (lanes 0-7 in the low half, 8-15 in the high) */
+HARMONIA_TARGET_AVX512
+static void compress_x16(const uint8_t *const blocks[16], __m512i state_g[8], __m512i state_c[8])
 {
-    uint32_t state_g[8], state_c[8];
-    uint8_t buffer[64];
-    size_t processed = 0;
-    size_t remaining = len;
-    uint64_t bit_len = (uint64_t)len * 8;
+    __m256i lo[16], hi[16];
+    __m512i w[32];
+    __m512i g[8], c[8];
     int i;
 
-    /* Initialize */
-    for (i = 0; i < 8; i++) {
-        state_g[i] = INITIAL_HASH_G[i];
-        state_c[i] = INITIAL_HASH_C[i];
+    /* Parse with the AVX2 transpose, then join the two 8-lane halves */
+    parse_words_x8(blocks, lo);
+    parse_words_x8(blocks + 8, hi);
+    for (i = 0; i < 16; i++) {
+        w[i] = _mm512_inserti64x4(_mm512_castsi256_si512(lo[i]), hi[i], 1);
     }
+    EXPAND_MESSAGE_XN(w);
 
-    /* Process full blocks */
-    while (remaining >= 64) {
-        compress_simd(data + processed, state_g, state_c);
-        processed += 64;
-        remaining -= 64;
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i];
+        c[i] = state_c[i];
     }
 
-    /* Copy remaining to buffer */
-    memcpy(buffer, data + processed, remaining);
-    buffer[remaining] = 0x80;
+    NG_ROUND_SCHEDULE(ROUND_XN, CROSS_XN, EDGE_XN);
 
-    if (remaining < 56) {
-        memset(buffer + remaining + 1, 0, 55 - remaining);
-    } else {
-        memset(buffer + remaining + 1, 0, 63 - remaining);
-        compress_simd(buffer, state_g, state_c);
-        memset(buffer, 0, 56);
+    /* Davies-Meyer: add to original state */
+    for (i = 0; i < 8; i++) {
+        state_g[i] = _mm512_add_epi32(state_g[i], g[i]);
+        state_c[i] = _mm512_add_epi32(state_c[i], c[i]);
     }
-
-    /* Append 64-bit length (big-endian) */
-    buffer[56] = (bit_len >> 56) & 0xFF;
-    buffer[57] = (bit_len >> 48) & 0xFF;
-    buffer[58] = (bit_len >> 40) & 0xFF;
-    buffer[59] = (bit_len >> 32) & 0xFF;
-    buffer[60] = (bit_len >> 24) & 0xFF;
-    buffer[61] = (bit_len >> 16) & 0xFF;
-    buffer[62] = (bit_len >> 8) & 0xFF;
-    buffer[63] = bit_len & 0xFF;
-
-    compress_simd(buffer, state_g, state_c);
-    finalize_simd(state_g, state_c, digest);
 }
 
-void harmonia_ng_simd_hex(const uint8_t *data, size_t len, char *hex_out)
+/* Finalize 16 hashes in parallel */
+HARMONIA_TARGET_AVX512
+static void finalize_x16(const __m512i state_g[8], const __m512i state_c[8], uint8_t *const digests[16])
 {
-    uint8_t digest[32];
+    __m512i g[8], c[8];
+    __m256i lo[8], hi[8];
     int i;
-    harmonia_ng_simd_full(data, len, digest);
-    for (i = 0; i < 32; i++) {
-        sprintf(hex_out + i*2, "%02x", digest[i]);
+
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i];
+        c[i] = state_c[i];
     }
-    hex_out[64] = '\0';
+
+    FINALIZE_XN();
+
+    for (i = 0; i < 8; i++) {
+        lo[i] = _mm512_castsi512_si256(g[i]);
+        hi[i] = _mm512_extracti64x4_epi64(g[i], 1);
+    }
+    store_digests_x8(lo, digests);
+    store_digests_x8(hi, digests + 8);
 }
 
-/* ============================================================================
- * SELF-TEST
- * ============================================================================ */
+#undef VEC
+#undef VADD
+#undef VXOR
+#undef VSHR
+#undef VSET1
+#undef VROTL
+#undef VROTR
 
-int harmonia_ng_simd_self_test(void)
+/*
+ * Build the final padding block(s) for `lanes` equal-length messages whose
+ * first `processed` bytes have been compressed. Returns the number of blocks
+ * left to compress (1 or 2); blocks1[] is only used when two remain.
+ */
+static int pad_tail_lanes(const uint8_t *const *msgs, size_t len, size_t processed, int lanes,
+                          uint8_t (*buffers)[128], const uint8_t **blocks0,
+                          const uint8_t **blocks1)
 {
-    static const struct {
-        const char *input;
-        const char *expected;
-    } tests[] = {
-        {"", "f0861e3ad1a2a438b4ceea78d14f21074dcd712b073917b28d7ae7fad8f6a562"},
-        {"Harmonia", "11cd23650f8fd4818848bc6f09da18b06403ed6f5250447c5d1036730cb8987c"},
-        {"HARMONIA-NG", "6d310650be2092be611cf35ea8dcc46b8199a3f6299398fa68dcf73f80f8a334"},
-        {NULL, NULL}
-    };
-
-    char hex[65];
-    int i, failed = 0;
+    size_t remaining = len - processed;
+    size_t total = (remaining < 56) ? 64 : 128;
+    uint64_t bit_len = (uint64_t)len * 8;
+    int m, b;
 
-    printf("HARMONIA-NG SIMD Self-Test\n");
-    printf("============================================================\n");
+    for (m = 0; m < lanes; m++) {
+        uint8_t *buf = buffers[m];
 
-    for (i = 0; tests[i].input != NULL; i++) {
-        harmonia_ng_simd_hex((const uint8_t*)tests[i].input,
-                             strlen(tests[i].input), hex);
+        memcpy(buf, msgs[m] + processed, remaining);
+        buf[remaining] = 0x80;
+        memset(buf + remaining + 1, 0, total - 8 - remaining - 1);
 
-        if (strcmp(hex, tests[i].expected) == 0) {
-            printf("  OK   %s\n", tests[i].input[0] ? tests[i].input : "(empty)");
-        } else {
-            printf("  FAIL %s\n", tests[i].input[0] ? tests[i].input : "(empty)");
-            printf("       Expected: %s\n", tests[i].expected);
-            printf("       Got:      %s\n", hex);
-            failed++;
+        /* Append length (big-endian) */
+        for (b = 0; b < 8; b++) {
+            buf[total - 8 + b] = (uint8_t)(bit_len >> (56 - 8 * b));
         }
+
+        blocks0[m] = buf;
+        blocks1[m] = buf + 64;
     }
 
-    printf("============================================================\n");
-    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    /* The caller runs processed/64 + total/64 steps with every lane busy */
+    HARMONIA_STAT(lane_calls, (processed + total) / 64);
+    HARMONIA_STAT(lane_slots, (size_t)lanes * ((processed + total) / 64));
+    HARMONIA_STAT(lane_busy, (size_t)lanes * ((processed + total) / 64));
+    HARMONIA_STAT(blocks, (size_t)lanes * ((processed + total) / 64));
+    HARMONIA_STAT(simd_blocks, (size_t)lanes * ((processed + total) / 64));
+    HARMONIA_STAT(pad_blocks, (size_t)lanes * (total / 64));
+    HARMONIA_STAT(digests, lanes);
 
-    return failed;
+    return (total == 128) ? 2 : 1;
 }
 
-/* ============================================================================
- * BENCHMARK
- * ============================================================================ */
-
-#include <time.h>
-
-/* Test harmonia_ng_x4 correctness */
-static int test_x4(void)
+/* Hash 8 equal-length messages with the AVX2 kernel */
+HARMONIA_TARGET_AVX2
+static void ng_x8_avx2(const uint8_t *msgs[8], size_t len, uint8_t *digests[8])
 {
-    const char *inputs[4] = {"", "Harmonia", "HARMONIA-NG", "Test message"};
+    __m256i state_g[8], state_c[8];
+    uint8_t buffers[8][128];
+    const uint8_t *blocks[8], *blocks1[8];
+    size_t processed = 0;
+    int i, m;
 
-    printf("\nHARMONIA-NG x4 Test\n");
-    printf("============================================================\n");
+    for (i = 0; i < 8; i++) {
+        state_g[i] = _mm256_set1_epi32((int)NG_INITIAL_HASH_G[i]);
+        state_c[i] = _mm256_set1_epi32((int)NG_INITIAL_HASH_C[i]);
+    }
 
-    /* Test with same-length messages (required by x4 API) */
-    uint8_t data[4][64];
-    const uint8_t *msgs[4];
-    uint8_t digests_mem[4][32];
-    uint8_t *digests[4];
+    /* Process full blocks */
+    while (len - processed >= 64) {
+        for (m = 0; m < 8; m++) {
+            blocks[m] = msgs[m] + processed;
+        }
+        compress_x8(blocks, state_g, state_c);
+        processed += 64;
+    }
 
-    /* Pad all messages to same length */
-    memset(data, 0, sizeof(data));
-    for (int i = 0; i < 4; i++) {
-        memcpy(data[i], inputs[i], strlen(inputs[i]));
-        msgs[i] = data[i];
-        digests[i] = digests_mem[i];
+    /* Padding (same layout for all 8 messages since they have same length) */
+    if (pad_tail_lanes(msgs, len, processed, 8, buffers, blocks, blocks1) == 2) {
+        compress_x8(blocks, state_g, state_c);
+        compress_x8(blocks1, state_g, state_c);
+    } else {
+        compress_x8(blocks, state_g, state_c);
     }
 
-    /* Hash using x4 - use max length of inputs */
-    size_t max_len = 12;  /* "Test message" is longest */
-    harmonia_ng_x4(msgs, max_len, digests);
+    finalize_x8(state_g, state_c, digests);
+}
 
-    /* Verify each result against scalar version */
-    int failed = 0;
-    for (int i = 0; i < 4; i++) {
-        uint8_t scalar_digest[32];
-        harmonia_ng_simd(data[i], max_len, scalar_digest);
+/* Hash 16 equal-length messages with the AVX-512 kernel */
+HARMONIA_TARGET_AVX512
+static void ng_x16_avx512(const uint8_t *msgs[16], size_t len, uint8_t *digests[16])
+{
+    __m512i state_g[8], state_c[8];
+    uint8_t buffers[16][128];
+    const uint8_t *blocks[16], *blocks1[16];
+    size_t processed = 0;
+    int i, m;
 
-        if (memcmp(digests[i], scalar_digest, 32) == 0) {
-            printf("  OK   msg %d\n", i);
-        } else {
-            printf("  FAIL msg %d (x4 != scalar)\n", i);
-            failed++;
-        }
+    for (i = 0; i < 8; i++) {
+        state_g[i] = _mm512_set1_epi32((int)NG_INITIAL_HASH_G[i]);
+        state_c[i] = _mm512_set1_epi32((int)NG_INITIAL_HASH_C[i]);
+    }
+
+    /* Process full blocks */
+    while (len - processed >= 64) {
+        for (m = 0; m < 16; m++) {
+            blocks[m] = msgs[m] + processed;
+        }
+        compress_x16(blocks, state_g, state_c);
+        processed += 64;
+    }
+
+    if (pad_tail_lanes(msgs, len, processed, 16, buffers, blocks, blocks1) == 2) {
+        compress_x16(blocks, state_g, state_c);
+        compress_x16(blocks1, state_g, state_c);
+    } else {
+        compress_x16(blocks, state_g, state_c);
+    }
+
+    finalize_x16(state_g, state_c, digests);
+}
+
+/* ---------------------------------------------------------------------------
+ * AVX2: 64-bit truncated hashes of 8 fixed-size keys
+ * --------------------------------------------------------------------------- */
+
+#define VEC          __m256i
+#define VADD         _mm256_add_epi32
+#define VXOR         _mm256_xor_si256
+#define VSHR         _mm256_srli_epi32
+#define VSET1(k)     _mm256_set1_epi32((int)(k))
+#define VROTL        ROTL_X8
+#define VROTR        ROTR_X8
+
+/*
+ * harmonia_ng_inline_u64 of 8 keys of len bytes (8, 16 or 32): one block
+ * whose padding and length words are literals once len is, and only fused
+ * words 0 and 1 of the finalization.
+ */
+HARMONIA_TARGET_AVX2
+static inline __attribute__((always_inline)) void u64_x8_avx2(const uint8_t *const keys[8], size_t len,
+                                                              uint64_t out[8])
+{
+    __m256i w[32], g[8], c[8], lo, hi;
+    const int nwords = (int)(len / 4);
+    int i;
+
+    /* Key k in row k, then words across lanes; rows past the key are padding */
+    for (i = 0; i < 8; i++) {
+        if (len == 32) {
+            w[i] = _mm256_loadu_si256((const __m256i *)keys[i]);
+        } else if (len == 16) {
+            w[i] = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)keys[i]));
+        } else {
+            w[i] = _mm256_castsi128_si256(_mm_loadl_epi64((const __m128i *)keys[i]));
+        }
+    }
+    transpose_x8(w);
+    for (i = 0; i < nwords; i++) w[i] = BSWAP32_X8(w[i]);
+    for (i = nwords; i < 16; i++) w[i] = _mm256_setzero_si256();
+    w[nwords] = VSET1(0x80000000U);
+    w[15] = VSET1((uint32_t)(len * 8));
+    EXPAND_MESSAGE_XN(w);
+
+    for (i = 0; i < 8; i++) {
+        g[i] = VSET1(NG_INITIAL_HASH_G[i]);
+        c[i] = VSET1(NG_INITIAL_HASH_C[i]);
+    }
+
+    NG_ROUND_SCHEDULE(ROUND_XN, CROSS_XN, EDGE_XN);
+
+    /* Davies-Meyer against the IV, then the two output words */
+    for (i = 0; i < 8; i++) {
+        g[i] = VADD(g[i], VSET1(NG_INITIAL_HASH_G[i]));
+        c[i] = VADD(c[i], VSET1(NG_INITIAL_HASH_C[i]));
+    }
+    EDGE_XN_STREAM(g, FIBONACCI[32 % 12] * 0x9E3779B9U);
+    EDGE_XN_STREAM(c, FIBONACCI[33 % 12] * 0x9E3779B9U);
+    FUSE_WORD_XN(0, 6);
+    FUSE_WORD_XN(1, 9);
+
+    /* (f0 << 32) | f1 per lane; unpack pairs lanes 0,1,4,5 and 2,3,6,7 */
+    lo = _mm256_unpacklo_epi32(g[1], g[0]);
+    hi = _mm256_unpackhi_epi32(g[1], g[0]);
+    _mm256_storeu_si256((__m256i *)out, _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(out + 4), _mm256_permute2x128_si256(lo, hi, 0x31));
+}
+
+#define U64_X8_AVX2(n) \
+    HARMONIA_TARGET_AVX2 \
+    static void u64_fixed##n##_x8_avx2(const uint8_t *const keys[8], uint64_t out[8]) \
+    { \
+        u64_x8_avx2(keys, n, out); \
+    }
+NG_U64_KEY_SIZES(U64_X8_AVX2)
+#undef U64_X8_AVX2
+
+#undef VEC
+#undef VADD
+#undef VXOR
+#undef VSHR
+#undef VSET1
+#undef VROTL
+#undef VROTR
+
+#endif /* HARMONIA_X86 */
+
+/*
+ * Hash 8 messages in parallel (AVX2 when available, else two 4-lane batches).
+ *
+ * x86 counterpart of harmonia_ng_x4; all 8 messages must have the same length.
+ */
+void harmonia_ng_x8(const uint8_t *msgs[8], size_t len, uint8_t *digests[8])
+{
+#if defined(HARMONIA_X86)
+    if (harmonia_cpu_features() & HARMONIA_CPU_AVX2) {
+        ng_x8_avx2(msgs, len, digests);
+        return;
+    }
+#endif
+    harmonia_ng_x4(msgs, len, digests);
+    harmonia_ng_x4(msgs + 4, len, digests + 4);
+}
+
+/*
+ * Hash 16 messages in parallel (AVX-512 when available, else two 8-lane batches).
+ *
+ * All 16 messages must have the same length.
+ */
+void harmonia_ng_x16(const uint8_t *msgs[16], size_t len, uint8_t *digests[16])
+{
+#if defined(HARMONIA_X86)
+    if (harmonia_cpu_features() & HARMONIA_CPU_AVX512) {
+        ng_x16_avx512(msgs, len, digests);
+        return;
+    }
+#endif
+    harmonia_ng_x8(msgs, len, digests);
+    harmonia_ng_x8(msgs + 8, len, digests + 8);
+}
+
+/* ============================================================================
+ * 64-BIT TRUNCATED FIXED-SIZE KEYS
+ * ============================================================================
+ *
+ * harmonia_ng_u64_fixedN(key) is the first 8 digest bytes of harmonia_ng(key,
+ * N) as a big-endian integer. Each size is its own instantiation, so the
+ * padding block is built from literals; the batch forms run 8 keys per AVX2
+ * call (x4 fills the 8-lane kernel twice over) and fall back to the inline
+ * scalar path elsewhere.
+ */
+
+#define U64_FIXED(n) \
+    uint64_t harmonia_ng_u64_fixed##n(const uint8_t key[n]) \
+    { \
+        HARMONIA_STAT(blocks, 1); \
+        HARMONIA_STAT(scalar_blocks, 1); \
+        HARMONIA_STAT(digests, 1); \
+        return harmonia_ng_inline_u64(key, n); \
+    } \
+    \
+    void harmonia_ng_u64_fixed##n##_x8(const uint8_t *keys[8], uint64_t out[8]) \
+    { \
+        int k; \
+        \
+        HARMONIA_STAT(blocks, 8); \
+        HARMONIA_STAT(digests, 8); \
+        U64_X8_DISPATCH(n, keys, out); \
+        HARMONIA_STAT(scalar_blocks, 8); \
+        for (k = 0; k < 8; k++) { \
+            out[k] = harmonia_ng_inline_u64(keys[k], n); \
+        } \
+    } \
+    \
+    void harmonia_ng_u64_fixed##n##_x4(const uint8_t *keys[4], uint64_t out[4]) \
+    { \
+        int k; \
+        \
+        HARMONIA_STAT(blocks, 4); \
+        HARMONIA_STAT(digests, 4); \
+        U64_X4_DISPATCH(n, keys, out); \
+        HARMONIA_STAT(scalar_blocks, 4); \
+        for (k = 0; k < 4; k++) { \
+            out[k] = harmonia_ng_inline_u64(keys[k], n); \
+        } \
+    }
+
+#if defined(HARMONIA_X86)
+#define U64_X8_DISPATCH(n, keys, out) \
+    if (harmonia_cpu_features() & HARMONIA_CPU_AVX2) { \
+        HARMONIA_STAT(simd_blocks, 8); \
+        u64_fixed##n##_x8_avx2(keys, out); \
+        return; \
+    }
+#define U64_X4_DISPATCH(n, keys, out) \
+    if (harmonia_cpu_features() & HARMONIA_CPU_AVX2) { \
+        const uint8_t *lanes[8] = {keys[0], keys[1], keys[2], keys[3], \
+                                   keys[0], keys[1], keys[2], keys[3]}; \
+        uint64_t wide[8]; \
+        \
+        HARMONIA_STAT(simd_blocks, 4); \
+        u64_fixed##n##_x8_avx2(lanes, wide); \
+        memcpy(out, wide, 4 * sizeof(*out)); \
+        return; \
+    }
+#else
+#define U64_X8_DISPATCH(n, keys, out)
+#define U64_X4_DISPATCH(n, keys, out)
+#endif
+
+NG_U64_KEY_SIZES(U64_FIXED)
+
+#undef U64_FIXED
+#undef U64_X8_DISPATCH
+#undef U64_X4_DISPATCH
+
+/* ============================================================================
+ * FINALIZATION (same as scalar)
+ * ============================================================================ */
+
+static void finalize_simd(uint32_t *state_g, uint32_t *state_c, uint8_t *digest)
+{
+    HARMONIA_STAT(digests, 1);
+    harmonia_ng_inline_finalize(state_g, state_c, digest);
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+/* Forward declaration */
+void harmonia_ng_simd_full(const uint8_t *data, size_t len, uint8_t *digest);
+
+void harmonia_ng_simd(const uint8_t *data, size_t len, uint8_t *digest)
+{
+    /* Delegate to full implementation */
+    harmonia_ng_simd_full(data, len, digest);
+}
+
+/* Full API with proper length tracking */
+void harmonia_ng_simd_full(const uint8_t *data, size_t len, uint8_t *digest)
+{
+    uint32_t state_g[8], state_c[8];
+    uint8_t buffer[64];
+    size_t processed = len & ~(size_t)63;
+    size_t remaining = len & 63;
+    uint64_t bit_len = (uint64_t)len * 8;
+    int i;
+
+    /* Initialize */
+    for (i = 0; i < 8; i++) {
+        state_g[i] = NG_INITIAL_HASH_G[i];
+        state_c[i] = NG_INITIAL_HASH_C[i];
+    }
+
+    /* Process full blocks */
+    compress_simd(data, len / 64, state_g, state_c);
+
+    /* Copy remaining to buffer */
+    memcpy(buffer, data + processed, remaining);
+    buffer[remaining] = 0x80;
+
+    HARMONIA_PROBE2(final__start, state_g, digest);
+    HARMONIA_STAT(pad_blocks, (remaining < 56) ? 1 : 2);
+    if (remaining < 56) {
+        memset(buffer + remaining + 1, 0, 55 - remaining);
+    } else {
+        memset(buffer + remaining + 1, 0, 63 - remaining);
+        compress_simd(buffer, 1, state_g, state_c);
+        memset(buffer, 0, 56);
+    }
+
+    /* Append 64-bit length (big-endian) */
+    buffer[56] = (bit_len >> 56) & 0xFF;
+    buffer[57] = (bit_len >> 48) & 0xFF;
+    buffer[58] = (bit_len >> 40) & 0xFF;
+    buffer[59] = (bit_len >> 32) & 0xFF;
+    buffer[60] = (bit_len >> 24) & 0xFF;
+    buffer[61] = (bit_len >> 16) & 0xFF;
+    buffer[62] = (bit_len >> 8) & 0xFF;
+    buffer[63] = bit_len & 0xFF;
+
+    compress_simd(buffer, 1, state_g, state_c);
+    finalize_simd(state_g, state_c, digest);
+    HARMONIA_PROBE2(final__done, state_g, digest);
+}
+
+void harmonia_ng_simd_hex(const uint8_t *data, size_t len, char *hex_out)
+{
+    uint8_t digest[32];
+    int i;
+    harmonia_ng_simd_full(data, len, digest);
+    for (i = 0; i < 32; i++) {
+        sprintf(hex_out + i*2, "%02x", digest[i]);
+    }
+    hex_out[64] = '\0';
+}
+
+/* ============================================================================
+ * STREAMING API
+ * ============================================================================
+ *
+ * Same harmonia_ng_ctx as harmonia_ng.c, driven by compress_simd. Whole
+ * blocks are compressed straight from the caller's buffer; only a partial
+ * block at either end of a chunk is staged in ctx->buffer.
+ */
+
+void harmonia_ng_simd_init(harmonia_ng_ctx *ctx)
+{
+    int i;
+    for (i = 0; i < 8; i++) {
+        ctx->state_g[i] = NG_INITIAL_HASH_G[i];
+        ctx->state_c[i] = NG_INITIAL_HASH_C[i];
+    }
+    ctx->buffer_len = 0;
+    ctx->total_len = 0;
+}
+
+void harmonia_ng_simd_update(harmonia_ng_ctx *ctx, const uint8_t *data, size_t len)
+{
+    HARMONIA_STAT(updates, 1);
+    ctx->total_len += len;
+
+    /* Complete a buffered partial block first */
+    if (ctx->buffer_len > 0) {
+        size_t to_copy = 64 - ctx->buffer_len;
+        if (to_copy > len) to_copy = len;
+
+        memcpy(ctx->buffer + ctx->buffer_len, data, to_copy);
+        HARMONIA_STAT(buffer_copies, 1);
+        HARMONIA_STAT(buffer_bytes, to_copy);
+        ctx->buffer_len += to_copy;
+        data += to_copy;
+        len -= to_copy;
+
+        if (ctx->buffer_len < 64) return;
+        compress_simd(ctx->buffer, 1, ctx->state_g, ctx->state_c);
+        ctx->buffer_len = 0;
+    }
+
+    /* Process full blocks in place */
+    if (len >= 64) {
+        compress_simd(data, len / 64, ctx->state_g, ctx->state_c);
+        data += len & ~(size_t)63;
+        len &= 63;
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buffer, data, len);
+        HARMONIA_STAT(buffer_copies, 1);
+        HARMONIA_STAT(buffer_bytes, len);
+        ctx->buffer_len = len;
+    }
+}
+
+void harmonia_ng_simd_updatev(harmonia_ng_ctx *ctx, const struct iovec *iov, int iovcnt)
+{
+    ctx->total_len += harmonia_iov_absorb(iov, iovcnt, ctx->buffer, &ctx->buffer_len,
+                                          ctx->state_g, ctx->state_c, compress_simd);
+}
+
+void harmonia_ng_simd_final(harmonia_ng_ctx *ctx, uint8_t *digest)
+{
+    uint64_t bit_len = ctx->total_len * 8;
+    size_t used = ctx->buffer_len;
+    int i;
+
+    HARMONIA_PROBE2(final__start, ctx, digest);
+    ctx->buffer[used++] = 0x80;
+
+    if (used > 56) {
+        memset(ctx->buffer + used, 0, 64 - used);
+        compress_simd(ctx->buffer, 1, ctx->state_g, ctx->state_c);
+        HARMONIA_STAT(pad_blocks, 1);
+        used = 0;
+    }
+    memset(ctx->buffer + used, 0, 56 - used);
+
+    /* Append 64-bit length (big-endian) */
+    for (i = 0; i < 8; i++) {
+        ctx->buffer[56 + i] = (uint8_t)(bit_len >> (56 - 8 * i));
+    }
+
+    compress_simd(ctx->buffer, 1, ctx->state_g, ctx->state_c);
+    HARMONIA_STAT(pad_blocks, 1);
+    finalize_simd(ctx->state_g, ctx->state_c, digest);
+    HARMONIA_PROBE2(final__done, ctx, digest);
+}
+
+/* ============================================================================
+ * VARIABLE-LENGTH BATCH HASHING (LANE SCHEDULED)
+ * ============================================================================
+ *
+ * Each SIMD lane works through its own message. When a lane's message has
+ * consumed its last (padding) block, the lane is finalized and immediately
+ * refilled with the next queued message, so every compress call runs with
+ * all lanes busy until the queue drains.
+ *
+ * Lane state lives in memory as state[word][lane] so that a lane can be
+ * reset or extracted independently; each compress call loads it as one
+ * vector per state word.
+ */
+
+#define NG_MAX_LANES 16
+
+typedef void (*compress_lanes_fn)(const uint8_t *const *blocks,
+                                  uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES]);
+
+#if defined(HARMONIA_X86)
+HARMONIA_TARGET_AVX512
+static void compress_lanes_x16(const uint8_t *const *blocks,
+                               uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    __m512i g[8], c[8];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        g[i] = _mm512_load_si512((const void *)state_g[i]);
+        c[i] = _mm512_load_si512((const void *)state_c[i]);
+    }
+    compress_x16(blocks, g, c);
+    for (i = 0; i < 8; i++) {
+        _mm512_store_si512((void *)state_g[i], g[i]);
+        _mm512_store_si512((void *)state_c[i], c[i]);
+    }
+}
+
+HARMONIA_TARGET_AVX2
+static void compress_lanes_x8(const uint8_t *const *blocks,
+                              uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    __m256i g[8], c[8];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        g[i] = _mm256_load_si256((const __m256i *)state_g[i]);
+        c[i] = _mm256_load_si256((const __m256i *)state_c[i]);
+    }
+    compress_x8(blocks, g, c);
+    for (i = 0; i < 8; i++) {
+        _mm256_store_si256((__m256i *)state_g[i], g[i]);
+        _mm256_store_si256((__m256i *)state_c[i], c[i]);
+    }
+}
+#endif /* HARMONIA_X86 */
+
+#if defined(HARMONIA_ARM_NEON)
+static void compress_lanes_x4(const uint8_t *const *blocks,
+                              uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    uint32x4_t g[8], c[8];
+    const uint8_t *b[4] = {blocks[0], blocks[1], blocks[2], blocks[3]};
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        g[i] = vld1q_u32(state_g[i]);
+        c[i] = vld1q_u32(state_c[i]);
+    }
+    compress_x4(b, g, c);
+    for (i = 0; i < 8; i++) {
+        vst1q_u32(state_g[i], g[i]);
+        vst1q_u32(state_c[i], c[i]);
+    }
+}
+#endif /* HARMONIA_ARM_NEON */
+
+static void compress_lanes_x1(const uint8_t *const *blocks,
+                              uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    uint32_t g[8], c[8];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i][0];
+        c[i] = state_c[i][0];
+    }
+    compress_simd(blocks[0], 1, g, c);
+    for (i = 0; i < 8; i++) {
+        state_g[i][0] = g[i];
+        state_c[i][0] = c[i];
+    }
+}
+
+/*
+ * Widest lane kernel for this CPU, bound once on first use. Batch, tree and
+ * Merkle workers reach the scheduler concurrently on a cold process, so the
+ * bind goes through pthread_once, which also orders the stores before any
+ * caller reads the engine.
+ */
+static struct {
+    int lanes;
+    compress_lanes_fn compress;
+    const char *name;
+} lane_engine;
+static pthread_once_t lane_engine_once = PTHREAD_ONCE_INIT;
+
+static void bind_lane_engine(void)
+{
+    unsigned features = harmonia_cpu_features();
+    int lanes = 1;
+    compress_lanes_fn fn = compress_lanes_x1;
+    const char *name = "scalar x1";
+
+#if defined(HARMONIA_X86)
+    if (features & HARMONIA_CPU_AVX512) {
+        lanes = 16;
+        fn = compress_lanes_x16;
+        name = "AVX-512 x16";
+    } else if (features & HARMONIA_CPU_AVX2) {
+        lanes = 8;
+        fn = compress_lanes_x8;
+        name = "AVX2 x8";
+    }
+#elif defined(HARMONIA_ARM_NEON)
+    if (features & HARMONIA_CPU_NEON) {
+        lanes = 4;
+        fn = compress_lanes_x4;
+        name = "NEON x4";
+    }
+#else
+    (void)features;
+#endif
+
+    lane_engine.name = name;
+    lane_engine.compress = fn;
+    lane_engine.lanes = lanes;
+}
+
+/* Per-lane scheduling state */
+typedef struct {
+    const uint8_t *data;    /* Next full message block */
+    size_t full_blocks;     /* Full message blocks left */
+    int scattered;          /* Full blocks come from cur instead of data */
+    harmonia_iov_cursor cur;
+    uint8_t block[64];      /* A scattered block spanning fragments */
+    int head_pending;       /* head[] (prefix bytes + suffix start) still to compress */
+    int tail_blocks;        /* Padding blocks left after the full blocks */
+    int tail_pos;           /* Next padding block in tail[] */
+    size_t msg;             /* Index of the message in this lane */
+    uint8_t head[64];       /* First block when resuming from a midstate */
+    uint8_t tail[128];      /* Last partial block + padding + length */
+} ng_lane;
+
+/* Scheduler workspace: the lane state and each lane's staging blocks */
+typedef struct {
+    uint32_t state_g[8][NG_MAX_LANES] __attribute__((aligned(64)));
+    uint32_t state_c[8][NG_MAX_LANES] __attribute__((aligned(64)));
+    ng_lane lane[NG_MAX_LANES];
+} ng_lanes;
+
+/*
+ * Load a message into lane `l`, continuing from chaining state g/c over
+ * (prefix_len bytes already compressed) + head[0..head_len) + data[0..len).
+ * Builds the first block when head bytes are pending, and the padding.
+ */
+static void lane_resume(ng_lane *lane, int l, size_t msg,
+                        const uint32_t *g, const uint32_t *c, uint64_t prefix_len,
+                        const uint8_t *head, size_t head_len, const uint8_t *data, size_t len,
+                        uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    uint64_t bit_len = (prefix_len + head_len + len) * 8;
+    size_t remaining, total;
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        state_g[i][l] = g[i];
+        state_c[i][l] = c[i];
+    }
+    lane->msg = msg;
+    lane->head_pending = 0;
+    lane->scattered = 0;
+
+    if (head_len > 0 && head_len + len >= 64) {
+        /* Complete the midstate's partial block with the start of data */
+        size_t take = 64 - head_len;
+        memcpy(lane->head, head, head_len);
+        memcpy(lane->head + head_len, data, take);
+        lane->head_pending = 1;
+        data += take;
+        len -= take;
+        head_len = 0;
+    }
+
+    lane->data = data;
+    lane->full_blocks = len / 64;
+    remaining = head_len + len % 64;
+    total = (remaining < 56) ? 64 : 128;
+    lane->tail_blocks = (int)(total / 64);
+    lane->tail_pos = 0;
+    HARMONIA_STAT(pad_blocks, total / 64);
+
+    if (head_len > 0) {
+        memcpy(lane->tail, head, head_len);
+    }
+    if (len % 64 > 0) {
+        memcpy(lane->tail + head_len, data + len - len % 64, len % 64);
+    }
+    lane->tail[remaining] = 0x80;
+    memset(lane->tail + remaining + 1, 0, total - 8 - remaining - 1);
+
+    /* Append length (big-endian) */
+    for (i = 0; i < 8; i++) {
+        lane->tail[total - 8 + i] = (uint8_t)(bit_len >> (56 - 8 * i));
+    }
+}
+
+/*
+ * Load message `msg` into lane `l` from the IV. A non-zero flags word tweaks
+ * the IV (tree mode): flags into g[7], the 64-bit counter into c[6..7].
+ */
+static void lane_start(ng_lane *lane, int l, size_t msg, const uint8_t *data, size_t len,
+                       uint64_t counter, uint32_t flags,
+                       uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    uint32_t g[8], c[8];
+
+    memcpy(g, NG_INITIAL_HASH_G, sizeof(g));
+    memcpy(c, NG_INITIAL_HASH_C, sizeof(c));
+    g[7] ^= flags;
+    c[6] ^= (uint32_t)counter;
+    c[7] ^= (uint32_t)(counter >> 32);
+
+    lane_resume(lane, l, msg, g, c, 0, NULL, 0, data, len, state_g, state_c);
+}
+
+/*
+ * Load the scattered message `msg` (iovcnt fragments) into lane `l` from
+ * the IV. Only the partial last block is copied, into the padding.
+ */
+static void lane_start_iov(ng_lane *lane, int l, size_t msg, const struct iovec *iov, int iovcnt,
+                           uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    uint8_t tail[64];
+    size_t len = harmonia_iov_total(iov, iovcnt);
+    size_t full = len & ~(size_t)63;
+    harmonia_iov_cursor end;
+
+    harmonia_iov_init(&end, NULL, 0, iov, iovcnt);
+    harmonia_iov_skip(&end, full);
+    harmonia_iov_copy(&end, tail, len - full);
+    lane_resume(lane, l, msg, NG_INITIAL_HASH_G, NG_INITIAL_HASH_C, full, NULL, 0, tail, len - full,
+                state_g, state_c);
+
+    lane->data = NULL;
+    lane->full_blocks = full / 64;
+    lane->scattered = 1;
+    harmonia_iov_init(&lane->cur, NULL, 0, iov, iovcnt);
+}
+
+/* Finalize the message in lane `l` from its column of the lane state */
+static void lane_finish(int l, uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES],
+                        uint8_t *digest)
+{
+    uint32_t g[8], c[8];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        g[i] = state_g[i][l];
+        c[i] = state_c[i][l];
+    }
+    finalize_simd(g, c, digest);
+}
+
+/*
+ * Hash n messages of arbitrary lengths, keeping every SIMD lane busy.
+ *
+ * digests must hold n * HARMONIA_NG_DIGEST_SIZE bytes; digest k is written
+ * to digests + 32*k.
+ */
+void harmonia_ng_multi(const uint8_t *const *msgs, const size_t *lens, uint8_t *digests, size_t n)
+{
+    harmonia_ng_multi_tweaked(msgs, lens, NULL, NULL, digests, n);
+}
+
+/* Start message `next` in lane `l`: from the prefix midstate when given, else the (tweaked) IV */
+static void lane_load(ng_lane *lane, int l, size_t next, const harmonia_ng_ctx *prefix,
+                      const uint8_t *const *msgs, const size_t *lens,
+                      const struct iovec *const *iovs, const int *iovcnts,
+                      const uint64_t *counters, const uint32_t *flags,
+                      uint32_t state_g[8][NG_MAX_LANES], uint32_t state_c[8][NG_MAX_LANES])
+{
+    if (iovs) {
+        lane_start_iov(lane, l, next, iovs[next], iovcnts[next], state_g, state_c);
+    } else if (prefix) {
+        lane_resume(lane, l, next, prefix->state_g, prefix->state_c,
+                    prefix->total_len - prefix->buffer_len, prefix->buffer, prefix->buffer_len,
+                    msgs[next], lens[next], state_g, state_c);
+    } else {
+        lane_start(lane, l, next, msgs[next], lens[next],
+                   counters ? counters[next] : 0, flags ? flags[next] : 0,
+                   state_g, state_c);
+    }
+}
+
+static void multi_schedule(ng_lanes *ws, const harmonia_ng_ctx *prefix,
+                           const uint8_t *const *msgs, const size_t *lens,
+                           const struct iovec *const *iovs, const int *iovcnts,
+                           const uint64_t *counters, const uint32_t *flags,
+                           uint8_t *digests, size_t n)
+{
+    static const uint8_t idle_block[64];
+    ng_lane *lane = ws->lane;
+    const uint8_t *blocks[NG_MAX_LANES];
+    int active[NG_MAX_LANES];
+    int l, lanes, busy = 0;
+    size_t next = 0;
+
+    pthread_once(&lane_engine_once, bind_lane_engine);
+    lanes = lane_engine.lanes;
+
+    for (l = 0; l < lanes; l++) {
+        active[l] = (next < n);
+        if (active[l]) {
+            lane_load(&lane[l], l, next, prefix, msgs, lens, iovs, iovcnts, counters, flags,
+                      ws->state_g, ws->state_c);
+            next++;
+            busy++;
+        }
+    }
+
+    while (busy > 0) {
+        for (l = 0; l < lanes; l++) {
+            if (!active[l]) {
+                blocks[l] = idle_block;
+            } else if (lane[l].head_pending) {
+                blocks[l] = lane[l].head;
+            } else if (lane[l].full_blocks > 0) {
+                blocks[l] = lane[l].scattered ? harmonia_iov_block(&lane[l].cur, lane[l].block)
+                                              : lane[l].data;
+            } else {
+                blocks[l] = lane[l].tail + 64 * lane[l].tail_pos;
+            }
+        }
+
+        lane_engine.compress(blocks, ws->state_g, ws->state_c);
+        HARMONIA_PROBE2(lane__step, lanes, busy);
+        HARMONIA_STAT(lane_calls, 1);
+        HARMONIA_STAT(lane_slots, lanes);
+        HARMONIA_STAT(lane_busy, busy);
+        /* The x1 engine runs compress_simd, which counts its own blocks */
+        if (lanes > 1) {
+            HARMONIA_STAT(blocks, busy);
+            HARMONIA_STAT(simd_blocks, busy);
+        }
+
+        for (l = 0; l < lanes; l++) {
+            if (!active[l]) continue;
+
+            if (lane[l].head_pending) {
+                lane[l].head_pending = 0;
+                continue;
+            }
+            if (lane[l].full_blocks > 0) {
+                if (!lane[l].scattered) lane[l].data += 64;
+                lane[l].full_blocks--;
+                continue;
+            }
+            if (++lane[l].tail_pos < lane[l].tail_blocks) continue;
+
+            /* Message done: emit digest and refill the lane */
+            lane_finish(l, ws->state_g, ws->state_c, digests + 32 * lane[l].msg);
+            if (next < n) {
+                lane_load(&lane[l], l, next, prefix, msgs, lens, iovs, iovcnts, counters, flags,
+                          ws->state_g, ws->state_c);
+                next++;
+            } else {
+                active[l] = 0;
+                busy--;
+            }
+        }
+    }
+}
+
+/*
+ * harmonia_ng_multi with an optional per-message IV tweak (counters/flags may
+ * be NULL for the plain IV). This is the lane primitive of the tree mode.
+ */
+void harmonia_ng_multi_tweaked(const uint8_t *const *msgs, const size_t *lens,
+                               const uint64_t *counters, const uint32_t *flags,
+                               uint8_t *digests, size_t n)
+{
+    ng_lanes ws;
+
+    multi_schedule(&ws, NULL, msgs, lens, NULL, NULL, counters, flags, digests, n);
+}
+
+/*
+ * Hash prefix || suffixes[k] for every k, resuming each lane from the
+ * prefix midstate instead of recompressing the shared prefix.
+ */
+void harmonia_ng_multi_prefixed(const harmonia_ng_ctx *prefix,
+                                const uint8_t *const *suffixes, const size_t *lens,
+                                uint8_t *digests, size_t n)
+{
+    ng_lanes ws;
+
+    multi_schedule(&ws, prefix, suffixes, lens, NULL, NULL, NULL, NULL, digests, n);
+}
+
+void harmonia_ng_multiv(const struct iovec *const *iovs, const int *iovcnts,
+                        uint8_t *digests, size_t n)
+{
+    ng_lanes ws;
+
+    multi_schedule(&ws, NULL, NULL, NULL, iovs, iovcnts, NULL, NULL, digests, n);
+}
+
+void harmonia_ng_x4v(const struct iovec *const iovs[4], const int iovcnts[4], uint8_t *digests[4])
+{
+    uint8_t out[4][HARMONIA_NG_DIGEST_SIZE];
+    int i;
+
+    harmonia_ng_multiv(iovs, iovcnts, out[0], 4);
+    for (i = 0; i < 4; i++) {
+        memcpy(digests[i], out[i], HARMONIA_NG_DIGEST_SIZE);
+    }
+}
+
+/* ============================================================================
+ * BATCH ARENA
+ * ============================================================================
+ *
+ * One cache-line aligned allocation holding the scheduler workspace (lane
+ * state as state[word][lane], staging padding blocks), the message table
+ * and the digest slab. Reset only rewinds the message count, so a server
+ * thread that keeps one arena per thread hashes each request without
+ * touching the allocator, and no two threads share a line of it.
+ */
+
+#define ARENA_ALIGN     64
+#define ARENA_ROUND(x)  (((x) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+struct harmonia_batch_arena {
+    ng_lanes lanes;             /* First, so lane vectors load aligned */
+    uint8_t *digests;           /* capacity * 32, cache-line aligned */
+    const uint8_t **msgs;
+    size_t *lens;
+    size_t count;
+    size_t capacity;
+};
+
+harmonia_batch_arena *harmonia_batch_arena_create(size_t capacity)
+{
+    const size_t per_msg = HARMONIA_NG_DIGEST_SIZE + sizeof(const uint8_t *) + sizeof(size_t);
+    size_t head = ARENA_ROUND(sizeof(harmonia_batch_arena));
+    size_t slab, table;
+    harmonia_batch_arena *arena;
+    void *mem;
+
+    if (capacity == 0 || capacity > (SIZE_MAX - head - ARENA_ALIGN) / per_msg) {
+        return NULL;
+    }
+    slab = ARENA_ROUND(capacity * HARMONIA_NG_DIGEST_SIZE);
+    table = capacity * (sizeof(const uint8_t *) + sizeof(size_t));
+    if (posix_memalign(&mem, ARENA_ALIGN, head + slab + table) != 0) {
+        return NULL;
+    }
+
+    arena = (harmonia_batch_arena *)mem;
+    arena->digests = (uint8_t *)mem + head;
+    arena->msgs = (const uint8_t **)(arena->digests + slab);
+    arena->lens = (size_t *)(arena->msgs + capacity);
+    arena->count = 0;
+    arena->capacity = capacity;
+    return arena;
+}
+
+void harmonia_batch_arena_destroy(harmonia_batch_arena *arena)
+{
+    free(arena);
+}
+
+void harmonia_batch_arena_reset(harmonia_batch_arena *arena)
+{
+    arena->count = 0;
+}
+
+size_t harmonia_batch_arena_add(harmonia_batch_arena *arena, const uint8_t *msg, size_t len)
+{
+    if (arena->count == arena->capacity) {
+        return HARMONIA_BATCH_ARENA_FULL;
+    }
+    arena->msgs[arena->count] = msg;
+    arena->lens[arena->count] = len;
+    return arena->count++;
+}
+
+size_t harmonia_batch_arena_count(const harmonia_batch_arena *arena)
+{
+    return arena->count;
+}
+
+const uint8_t *harmonia_batch_arena_digest(const harmonia_batch_arena *arena, size_t slot)
+{
+    return arena->digests + slot * HARMONIA_NG_DIGEST_SIZE;
+}
+
+void harmonia_ng_arena_hash(harmonia_batch_arena *arena)
+{
+    multi_schedule(&arena->lanes, NULL, arena->msgs, arena->lens, NULL, NULL, NULL, NULL,
+                   arena->digests, arena->count);
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+int harmonia_ng_simd_self_test(void)
+{
+    static const struct {
+        const char *input;
+        const char *expected;
+    } tests[] = {
+        {"", "f0861e3ad1a2a438b4ceea78d14f21074dcd712b073917b28d7ae7fad8f6a562"},
+        {"Harmonia", "11cd23650f8fd4818848bc6f09da18b06403ed6f5250447c5d1036730cb8987c"},
+        {"HARMONIA-NG", "6d310650be2092be611cf35ea8dcc46b8199a3f6299398fa68dcf73f80f8a334"},
+        {NULL, NULL}
+    };
+
+    char hex[65];
+    int i, failed = 0;
+
+    pthread_once(&lane_engine_once, bind_lane_engine);
+
+    printf("HARMONIA-NG SIMD Self-Test (multi-buffer: %s)\n", lane_engine.name);
+    printf("============================================================\n");
+
+    for (i = 0; tests[i].input != NULL; i++) {
+        harmonia_ng_simd_hex((const uint8_t*)tests[i].input,
+                             strlen(tests[i].input), hex);
+
+        if (strcmp(hex, tests[i].expected) == 0) {
+            printf("  OK   %s\n", tests[i].input[0] ? tests[i].input : "(empty)");
+        } else {
+            printf("  FAIL %s\n", tests[i].input[0] ? tests[i].input : "(empty)");
+            printf("       Expected: %s\n", tests[i].expected);
+            printf("       Got:      %s\n", hex);
+            failed++;
+        }
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+
+    return failed;
+}
+
+/* ============================================================================
+ * BENCHMARK (standalone build only)
+ * ============================================================================ */
+
+#ifdef HARMONIA_NG_SIMD_MAIN
+#include <stdlib.h>
+#include <time.h>
+
+/* Test harmonia_ng_x4 correctness */
+static int test_x4(void)
+{
+    const char *inputs[4] = {"", "Harmonia", "HARMONIA-NG", "Test message"};
+
+    printf("\nHARMONIA-NG x4 Test\n");
+    printf("============================================================\n");
+
+    /* Test with same-length messages (required by x4 API) */
+    uint8_t data[4][64];
+    const uint8_t *msgs[4];
+    uint8_t digests_mem[4][32];
+    uint8_t *digests[4];
+
+    /* Pad all messages to same length */
+    memset(data, 0, sizeof(data));
+    for (int i = 0; i < 4; i++) {
+        memcpy(data[i], inputs[i], strlen(inputs[i]));
+        msgs[i] = data[i];
+        digests[i] = digests_mem[i];
+    }
+
+    /* Hash using x4 - use max length of inputs */
+    size_t max_len = 12;  /* "Test message" is longest */
+    harmonia_ng_x4(msgs, max_len, digests);
+
+    /* Verify each result against scalar version */
+    int failed = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t scalar_digest[32];
+        harmonia_ng_simd(data[i], max_len, scalar_digest);
+
+        if (memcmp(digests[i], scalar_digest, 32) == 0) {
+            printf("  OK   msg %d\n", i);
+        } else {
+            printf("  FAIL msg %d (x4 != scalar)\n", i);
+            failed++;
+        }
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Test the streaming API against one-shot hashing for several chunkings */
+static int test_streaming(void)
+{
+    static const size_t chunks[] = {1, 7, 63, 64, 65, 128, 1000, 4096};
+    static uint8_t data[10000];
+    static const size_t lengths[] = {0, 55, 56, 64, 1000, 10000};
+    size_t c, t, k;
+    int failed = 0;
+
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)(k * 13 + 5);
+
+    printf("\nHARMONIA-NG Streaming Test\n");
+    printf("============================================================\n");
+
+    for (c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++) {
+        int ok = 1;
+
+        for (t = 0; t < sizeof(lengths) / sizeof(lengths[0]); t++) {
+            harmonia_ng_ctx ctx;
+            uint8_t expected[32], digest[32];
+            size_t pos;
+
+            harmonia_ng_simd(data, lengths[t], expected);
+
+            harmonia_ng_simd_init(&ctx);
+            for (pos = 0; pos < lengths[t]; pos += chunks[c]) {
+                size_t n = lengths[t] - pos;
+                harmonia_ng_simd_update(&ctx, data + pos, n < chunks[c] ? n : chunks[c]);
+            }
+            harmonia_ng_simd_final(&ctx, digest);
+
+            if (memcmp(digest, expected, 32) != 0) ok = 0;
+        }
+
+        if (ok) {
+            printf("  OK   %zu-byte chunks\n", chunks[c]);
+        } else {
+            printf("  FAIL %zu-byte chunks (streaming != one-shot)\n", chunks[c]);
+            failed++;
+        }
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+typedef void (*multi_hash_fn)(const uint8_t **msgs, size_t len, uint8_t **digests);
+
+/* Test an N-lane multi-buffer function against the scalar version over
+ * lengths that exercise every padding case (0, <56, 56-63, multi-block) */
+/* Split data[0..len) into at most 16 fragments, cycling sizes from `start` */
+static int split_fragments(const uint8_t *data, size_t len, int start, struct iovec iov[16])
+{
+    static const size_t sizes[] = {0, 1, 3, 64, 0, 5, 63, 17, 130, 2, 71};
+    size_t pos = 0;
+    int k;
+
+    for (k = 0; pos < len; k++) {
+        size_t size = (k == 15) ? len - pos : sizes[(k + start) % 11];
+        if (size > len - pos) size = len - pos;
+        iov[k].iov_base = (void *)(data + pos);
+        iov[k].iov_len = size;
+        pos += size;
+    }
+    return k;
+}
+
+static int test_scatter(void)
+{
+    enum { N = 37 };
+    static uint8_t data[N * 16 + 600];
+    struct iovec chains[N][16];
+    const struct iovec *iovs[N];
+    const uint8_t *msgs[N];
+    size_t lens[N];
+    int iovcnts[N];
+    uint8_t expected[N * 32], digests[N * 32], *x4[4];
+    harmonia_ng_ctx ctx;
+    size_t k, head;
+    int ok, failed = 0;
+
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)(k * 31 + 7);
+
+    printf("\nHARMONIA-NG Scatter/Gather Test\n");
+    printf("============================================================\n");
+
+    for (k = 0; k < N; k++) {
+        msgs[k] = data + 16 * k;
+        lens[k] = (k * 67) % 600;
+        iovcnts[k] = split_fragments(msgs[k], lens[k], (int)k, chains[k]);
+        iovs[k] = chains[k];
+        harmonia_ng_simd(msgs[k], lens[k], expected + 32 * k);
+    }
+
+    /* Streaming, after 0..69 buffered bytes */
+    ok = 1;
+    for (k = 0; k < N; k++) {
+        for (head = 0; head < 70 && head <= lens[k]; head += 23) {
+            struct iovec rest[16];
+            int cnt = split_fragments(msgs[k] + head, lens[k] - head, (int)(k + head), rest);
+
+            harmonia_ng_simd_init(&ctx);
+            harmonia_ng_simd_update(&ctx, msgs[k], head);
+            harmonia_ng_simd_updatev(&ctx, rest, cnt);
+            harmonia_ng_simd_final(&ctx, digests);
+            if (memcmp(digests, expected + 32 * k, 32) != 0) ok = 0;
+        }
+    }
+    printf("  %s harmonia_ng_simd_updatev\n", ok ? "OK  " : "FAIL");
+    failed += !ok;
+
+    memset(digests, 0, sizeof(digests));
+    harmonia_ng_multiv(iovs, iovcnts, digests, N);
+    ok = memcmp(digests, expected, sizeof(digests)) == 0;
+    printf("  %s harmonia_ng_multiv, %d messages\n", ok ? "OK  " : "FAIL", N);
+    failed += !ok;
+
+    memset(digests, 0, sizeof(digests));
+    for (k = 0; k < 4; k++) x4[k] = digests + 32 * k;
+    harmonia_ng_x4v(iovs + 5, iovcnts + 5, x4);
+    ok = memcmp(digests, expected + 5 * 32, 4 * 32) == 0;
+    printf("  %s harmonia_ng_x4v\n", ok ? "OK  " : "FAIL");
+    failed += !ok;
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+static int test_multi_lane(const char *name, multi_hash_fn fn, int lanes)
+{
+    static const size_t lengths[] = {0, 1, 12, 55, 56, 63, 64, 65, 119, 120, 128, 1000};
+    uint8_t data[16][1000];
+    uint8_t digests_mem[16][32];
+    const uint8_t *msgs[16];
+    uint8_t *digests[16];
+    size_t t;
+    int i, m, failed = 0;
+
+    for (m = 0; m < lanes; m++) {
+        for (i = 0; i < 1000; i++) data[m][i] = (uint8_t)(i * 7 + m * 31);
+        msgs[m] = data[m];
+        digests[m] = digests_mem[m];
+    }
+
+    printf("\nHARMONIA-NG %s Test\n", name);
+    printf("============================================================\n");
+
+    for (t = 0; t < sizeof(lengths) / sizeof(lengths[0]); t++) {
+        int ok = 1;
+        fn(msgs, lengths[t], digests);
+
+        for (m = 0; m < lanes; m++) {
+            uint8_t scalar_digest[32];
+            harmonia_ng_simd(data[m], lengths[t], scalar_digest);
+            if (memcmp(digests[m], scalar_digest, 32) != 0) ok = 0;
+        }
+
+        if (ok) {
+            printf("  OK   len %zu\n", lengths[t]);
+        } else {
+            printf("  FAIL len %zu (%s != scalar)\n", lengths[t], name);
+            failed++;
+        }
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Test harmonia_ng_multi with mixed lengths against the scalar version */
+static int test_multi(void)
+{
+    static uint8_t data[9000];
+    const uint8_t *msgs[53];
+    size_t lens[53];
+    uint8_t digests[53 * 32];
+    size_t n, k;
+    int i, failed = 0;
+
+    for (i = 0; i < 9000; i++) data[i] = (uint8_t)(i * 13 + 5);
+
+    printf("\nHARMONIA-NG multi (variable-length) Test\n");
+    printf("============================================================\n");
+
+    /* Lengths 0..~8 KB with every padding case; offsets vary alignment */
+    for (k = 0; k < 53; k++) {
+        lens[k] = (k * k * 37 + k) % 8200;
+        if (k < 8) lens[k] = k * 9;
+        msgs[k] = data + (k % 7);
+    }
+
+    for (n = 0; n <= 53; n += (n < 20) ? 1 : 11) {
+        int ok = 1;
+        harmonia_ng_multi(msgs, lens, digests, n);
+
+        for (k = 0; k < n; k++) {
+            uint8_t scalar_digest[32];
+            harmonia_ng_simd(msgs[k], lens[k], scalar_digest);
+            if (memcmp(digests + 32 * k, scalar_digest, 32) != 0) ok = 0;
+        }
+
+        if (!ok) {
+            printf("  FAIL n=%zu (multi != scalar)\n", n);
+            failed++;
+        }
+    }
+    if (!failed) printf("  OK   n=0..53, lengths 0..8199\n");
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Prefix midstate: ctx_copy and batched suffixes against one-shot hashing */
+static int test_prefixed(void)
+{
+    static const size_t prefix_lens[] = {0, 1, 40, 63, 64, 100, 200};
+    static uint8_t data[600];
+    const uint8_t *suffixes[37];
+    size_t lens[37];
+    uint8_t digests[37 * 32], expect[32], got[32];
+    harmonia_ng_ctx prefix, clone;
+    size_t p, k;
+    int i, failed = 0;
+
+    for (i = 0; i < 600; i++) data[i] = (uint8_t)(i * 29 + 3);
+
+    printf("\nHARMONIA-NG prefix midstate Test\n");
+    printf("============================================================\n");
+
+    for (k = 0; k < 37; k++) {
+        lens[k] = (k * 23) % 150;        /* every head / tail combination */
+        suffixes[k] = data + 300 + k;
+    }
+
+    for (p = 0; p < sizeof(prefix_lens) / sizeof(prefix_lens[0]); p++) {
+        size_t plen = prefix_lens[p];
+        int ok = 1;
+
+        harmonia_ng_simd_init(&prefix);
+        harmonia_ng_simd_update(&prefix, data, plen);
+
+        harmonia_ng_multi_prefixed(&prefix, suffixes, lens, digests, 37);
+
+        for (k = 0; k < 37; k++) {
+            uint8_t msg[400];
+            memcpy(msg, data, plen);
+            memcpy(msg + plen, suffixes[k], lens[k]);
+            harmonia_ng_simd(msg, plen + lens[k], expect);
+            if (memcmp(digests + 32 * k, expect, 32) != 0) ok = 0;
+
+            /* A copy continues independently of the original */
+            harmonia_ng_ctx_copy(&clone, &prefix);
+            harmonia_ng_simd_update(&clone, suffixes[k], lens[k]);
+            harmonia_ng_simd_final(&clone, got);
+            if (memcmp(got, expect, 32) != 0) ok = 0;
+        }
+
+        if (ok) {
+            printf("  OK   prefix %3zu bytes, 37 suffixes (0..149 bytes)\n", plen);
+        } else {
+            printf("  FAIL prefix %3zu bytes\n", plen);
+            failed++;
+        }
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Batch arena: capacity, reuse after reset, digests against one-shot hashing */
+static int test_arena(void)
+{
+    static uint8_t data[3000];
+    harmonia_batch_arena *arena;
+    uint8_t expect[32];
+    size_t k, round;
+    int failed = 0;
+
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)(k * 29 + 3);
+
+    printf("\nHARMONIA-NG batch arena Test\n");
+    printf("============================================================\n");
+
+    arena = harmonia_batch_arena_create(40);
+    if (!arena || harmonia_batch_arena_create(0) != NULL) {
+        printf("  FAIL create\n");
+        harmonia_batch_arena_destroy(arena);
+        failed = 1;
+        goto out;
     }
+    if (((uintptr_t)arena | (uintptr_t)harmonia_batch_arena_digest(arena, 0)) % 64 != 0) {
+        printf("  FAIL arena or digest slab not cache-line aligned\n");
+        failed++;
+    }
+
+    /* Batches of different sizes through the same arena */
+    for (round = 0; round < 4; round++) {
+        size_t n = (round == 0) ? 40 : 3 + round * 11;
+        int ok = 1;
+
+        harmonia_batch_arena_reset(arena);
+        for (k = 0; k < n; k++) {
+            size_t len = (k * 131 + round * 17) % 2900;
+            if (harmonia_batch_arena_add(arena, data + (k % 5), len) != k) ok = 0;
+        }
+        if (round == 0 && harmonia_batch_arena_add(arena, data, 1) != HARMONIA_BATCH_ARENA_FULL) ok = 0;
+        if (harmonia_batch_arena_count(arena) != n) ok = 0;
+
+        harmonia_ng_arena_hash(arena);
+        for (k = 0; k < n; k++) {
+            size_t len = (k * 131 + round * 17) % 2900;
+            harmonia_ng_simd(data + (k % 5), len, expect);
+            if (memcmp(harmonia_batch_arena_digest(arena, k), expect, 32) != 0) ok = 0;
+        }
+
+        if (ok) {
+            printf("  OK   batch %zu: %2zu messages%s\n", round, n, round == 0 ? " (full, add refused)" : "");
+        } else {
+            printf("  FAIL batch %zu: %2zu messages\n", round, n);
+            failed++;
+        }
+    }
+
+    /* Empty batch */
+    harmonia_batch_arena_reset(arena);
+    harmonia_ng_arena_hash(arena);
+    if (harmonia_batch_arena_count(arena) != 0) {
+        printf("  FAIL empty batch\n");
+        failed++;
+    }
+    harmonia_batch_arena_destroy(arena);
+
+out:
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Fixed-size keys of harmonia_ng_inline.h: len is a literal at each call */
+#define INLINE_FIXED_SIZES(X) X(16) X(20) X(32) X(55) X(56) X(64)
+
+static int test_inline(void)
+{
+    static uint8_t data[300];
+    const uint8_t *msgs[301];
+    size_t lens[301];
+    static uint8_t digests[301 * 32];
+    uint8_t expect[32], got[32];
+    size_t k;
+    int failed = 0, ok = 1;
+
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)(k * 29 + 3);
+
+    printf("\nHARMONIA-NG inline header Test\n");
+    printf("============================================================\n");
+
+    /* Run-time lengths against the lane kernels */
+    for (k = 0; k <= 300; k++) {
+        msgs[k] = data;
+        lens[k] = k;
+    }
+    harmonia_ng_multi(msgs, lens, digests, 301);
+    for (k = 0; k <= 300; k++) {
+        harmonia_ng_inline(data, k, got);
+        if (memcmp(got, digests + 32 * k, 32) != 0) ok = 0;
+    }
+    if (ok) {
+        printf("  OK   run-time lengths 0..300\n");
+    } else {
+        printf("  FAIL run-time lengths 0..300\n");
+        failed++;
+    }
+
+#define CHECK_FIXED(n) \
+    harmonia_ng_inline(data + 1, n, got); \
+    harmonia_ng_simd(data + 1, n, expect); \
+    if (memcmp(got, expect, 32) == 0) { \
+        printf("  OK   constant %2d-byte key\n", n); \
+    } else { \
+        printf("  FAIL constant %2d-byte key\n", n); \
+        failed++; \
+    }
+    INLINE_FIXED_SIZES(CHECK_FIXED)
+#undef CHECK_FIXED
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* Big-endian 64-bit prefix of a digest */
+static uint64_t digest_u64(const uint8_t *d)
+{
+    uint64_t v = 0;
+    int i;
+
+    for (i = 0; i < 8; i++) v = (v << 8) | d[i];
+    return v;
+}
+
+static int test_u64(void)
+{
+    static uint8_t keys[64 * 32 + 7];
+    uint8_t digest[32];
+    size_t k;
+    int failed = 0;
+
+    for (k = 0; k < sizeof(keys); k++) keys[k] = (uint8_t)(k * 131 + 7);
+
+    printf("\nHARMONIA-NG 64-bit fixed-size keys Test (%s)\n",
+           (harmonia_cpu_features() & HARMONIA_CPU_AVX2) ? "AVX2 x8" : "scalar");
+    printf("============================================================\n");
+
+    /* Keys at odd offsets; each batch walks its own keys */
+#define CHECK_U64(n) do { \
+    const uint8_t *batch[8]; \
+    uint64_t out4[4], out8[8]; \
+    int key, lane, ok = 1; \
+    \
+    for (key = 0; key < 64; key += 8) { \
+        for (lane = 0; lane < 8; lane++) batch[lane] = keys + 1 + (size_t)(key + lane) * n; \
+        harmonia_ng_u64_fixed##n##_x8(batch, out8); \
+        harmonia_ng_u64_fixed##n##_x4(batch + 4, out4); \
+        for (lane = 0; lane < 8; lane++) { \
+            harmonia_ng_simd(batch[lane], n, digest); \
+            if (harmonia_ng_u64_fixed##n(batch[lane]) != digest_u64(digest) || \
+                out8[lane] != digest_u64(digest) || \
+                (lane >= 4 && out4[lane - 4] != digest_u64(digest))) ok = 0; \
+        } \
+    } \
+    if (ok) { \
+        printf("  OK   %2d-byte keys: single, x4 and x8 match harmonia_ng\n", n); \
+    } else { \
+        printf("  FAIL %2d-byte keys\n", n); \
+        failed++; \
+    } \
+} while (0);
+    NG_U64_KEY_SIZES(CHECK_U64)
+#undef CHECK_U64
 
     printf("============================================================\n");
     printf("Result: %s\n", failed ? "FAIL" : "PASS");
@@ -1005,16 +2557,520 @@ static void benchmark_x4(void)
     printf("============================================================\n");
 }
 
+/* Throughput of an N-lane multi-buffer function */
+static void benchmark_multi_lane(const char *name, multi_hash_fn fn, int lanes)
+{
+    static uint8_t data[16][10240];
+    uint8_t digests_mem[16][32];
+    const uint8_t *msgs[16];
+    uint8_t *digests[16];
+    static const size_t sizes[] = {64, 1024, 10240};
+    int i, m, s, iterations;
+    clock_t start, end;
+    double elapsed, throughput;
+
+    for (m = 0; m < lanes; m++) {
+        for (i = 0; i < 10240; i++) data[m][i] = (uint8_t)((i + m) & 0xFF);
+        msgs[m] = data[m];
+        digests[m] = digests_mem[m];
+    }
+
+    printf("\nHARMONIA-NG %s (SIMD parallel) Benchmark\n", name);
+    printf("============================================================\n");
+
+    for (s = 0; s < 3; s++) {
+        iterations = (int)(6400000 / sizes[s] / lanes);
+        start = clock();
+        for (i = 0; i < iterations; i++) {
+            fn(msgs, sizes[s], digests);
+        }
+        end = clock();
+        elapsed = (double)(end - start) / CLOCKS_PER_SEC;
+        throughput = ((double)sizes[s] * lanes * iterations) / elapsed / 1024 / 1024;
+        printf("%-6zu bytes: %.1f MB/s (%dx%d iterations)\n", sizes[s], throughput, lanes, iterations);
+    }
+
+    printf("============================================================\n");
+}
+
+/* Mixed 40 B - 8 KB request stream: lane-scheduled batch vs one at a time */
+/* Tree mode on one large input: 1 thread vs one per CPU, against the serial chain */
+/* Shared 256-byte prefix + 32-byte suffixes: full messages vs prefix midstate */
+static void benchmark_prefixed(void)
+{
+    enum { N = 4096, PREFIX = 256, SUFFIX = 32 };
+    static uint8_t full[N][PREFIX + SUFFIX];
+    static uint8_t digests[N * 32];
+    const uint8_t *msgs[N], *suffixes[N];
+    size_t lens[N], suffix_lens[N];
+    harmonia_ng_ctx prefix;
+    clock_t start;
+    double t_full, t_prefixed;
+    int i, k, iterations = 20;
+
+    for (k = 0; k < N; k++) {
+        for (i = 0; i < PREFIX + SUFFIX; i++) {
+            full[k][i] = (uint8_t)(i < PREFIX ? i : k + i);
+        }
+        msgs[k] = full[k];
+        lens[k] = PREFIX + SUFFIX;
+        suffixes[k] = full[k] + PREFIX;
+        suffix_lens[k] = SUFFIX;
+    }
+
+    printf("\nHARMONIA-NG Prefix Midstate Benchmark (%d x %d+%d bytes)\n", N, PREFIX, SUFFIX);
+    printf("============================================================\n");
+
+    start = clock();
+    for (i = 0; i < iterations; i++) {
+        harmonia_ng_multi(msgs, lens, digests, N);
+    }
+    t_full = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (i = 0; i < iterations; i++) {
+        harmonia_ng_simd_init(&prefix);
+        harmonia_ng_simd_update(&prefix, full[0], PREFIX);
+        harmonia_ng_multi_prefixed(&prefix, suffixes, suffix_lens, digests, N);
+    }
+    t_prefixed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("full messages:   %.2f M msg/s\n", N * iterations / t_full / 1e6);
+    printf("prefix midstate: %.2f M msg/s (%.1fx)\n",
+           N * iterations / t_prefixed / 1e6, t_full / t_prefixed);
+    printf("============================================================\n");
+}
+
+static void benchmark_tree(void)
+{
+    const size_t len = 64 * 1024 * 1024;
+    uint8_t *data = (uint8_t *)malloc(len);
+    uint8_t digest[32];
+    clock_t start;
+    double t_chain, t_tree1, t_tree;
+    size_t k;
+
+    if (!data) return;
+    for (k = 0; k < len; k++) data[k] = (uint8_t)k;
+
+    printf("\nHARMONIA-NG-Tree (64 MB) Benchmark\n");
+    printf("============================================================\n");
+
+    start = clock();
+    harmonia_ng_simd(data, len, digest);
+    t_chain = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    harmonia_ng_tree(data, len, digest, 1);
+    t_tree1 = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    /* clock() is process CPU time: measure wall time for the threaded run */
+    {
+        struct timespec a, b;
+        clock_gettime(CLOCK_MONOTONIC, &a);
+        harmonia_ng_tree(data, len, digest, 0);
+        clock_gettime(CLOCK_MONOTONIC, &b);
+        t_tree = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+    }
+
+    printf("chain (harmonia_ng_simd): %7.1f MB/s\n", len / t_chain / 1e6);
+    printf("tree, 1 thread:           %7.1f MB/s\n", len / t_tree1 / 1e6);
+    printf("tree, all CPUs:           %7.1f MB/s\n", len / t_tree / 1e6);
+
+    free(data);
+}
+
+/* Merkle root of 2^20 leaves: pairwise x4 loop vs the level builder */
+static void benchmark_merkle(void)
+{
+    const size_t n = 1u << 20;
+    uint8_t *leaves = (uint8_t *)malloc(n * 32);
+    uint8_t *level = (uint8_t *)malloc(n / 2 * 32);
+    uint8_t root[32];
+    struct timespec a, b;
+    double t_x4, t_one, t_all;
+    size_t k, count;
+
+    if (!leaves || !level) {
+        free(leaves);
+        free(level);
+        return;
+    }
+    for (k = 0; k < n * 32; k++) leaves[k] = (uint8_t)(k * 7);
+
+    printf("\nHARMONIA-NG-Merkle (%zu leaves) Benchmark\n", n);
+    printf("============================================================\n");
+
+    /* Groups of four pairs through harmonia_ng_x4, one level at a time */
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    {
+        const uint8_t *src = leaves;
+        for (count = n; count > 1; count /= 2) {
+            for (k = 0; k < count / 2; k += 4) {
+                const uint8_t *msgs[4];
+                uint8_t *out[4];
+                int i;
+                for (i = 0; i < 4; i++) {
+                    size_t p = (k + i < count / 2) ? k + i : k;
+                    msgs[i] = src + 64 * p;
+                    out[i] = level + 32 * p;
+                }
+                harmonia_ng_x4(msgs, 64, out);
+            }
+            src = level;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_x4 = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    harmonia_ng_merkle_root(leaves, n, root, 1);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_one = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    harmonia_ng_merkle_root(leaves, n, root, 0);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_all = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    printf("x4 pair loop:            %6.2f M nodes/s\n", (n - 1) / t_x4 / 1e6);
+    printf("merkle_root, 1 thread:   %6.2f M nodes/s (%.1fx)\n", (n - 1) / t_one / 1e6, t_x4 / t_one);
+    printf("merkle_root, all CPUs:   %6.2f M nodes/s (%.1fx)\n", (n - 1) / t_all / 1e6, t_x4 / t_all);
+    printf("============================================================\n");
+
+    free(leaves);
+    free(level);
+}
+
+/* 40k records of 16-512 bytes: one at a time vs multi vs the batch pool */
+static void benchmark_batch(void)
+{
+    enum { N = 40000 };
+    static uint8_t data[512 + 64];
+    static const uint8_t *msgs[N];
+    static size_t lens[N];
+    static uint8_t digests[N * 32];
+    struct timespec a, b;
+    double t_single, t_multi, t_batch;
+    uint32_t seed = 99;
+    size_t k;
+    int i, iterations = 5;
+
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)k;
+    for (k = 0; k < N; k++) {
+        seed = seed * 1103515245U + 12345U;
+        lens[k] = 16 + (seed >> 8) % (512 - 16);
+        msgs[k] = data + (k & 63);
+    }
+
+    printf("\nHARMONIA-NG-Batch (%d records, 16-512 B) Benchmark\n", N);
+    printf("============================================================\n");
+
+    harmonia_ng_batch(msgs, lens, digests, N, 0);   /* start the pool */
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < iterations; i++) {
+        for (k = 0; k < N; k++) harmonia_ng_simd(msgs[k], lens[k], digests + 32 * k);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_single = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < iterations; i++) harmonia_ng_multi(msgs, lens, digests, N);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_multi = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < iterations; i++) harmonia_ng_batch(msgs, lens, digests, N, 0);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_batch = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    printf("one by one:            %6.2f M msg/s\n", N * iterations / t_single / 1e6);
+    printf("harmonia_ng_multi:     %6.2f M msg/s (%.1fx)\n", N * iterations / t_multi / 1e6, t_single / t_multi);
+    printf("harmonia_ng_batch:     %6.2f M msg/s (%.1fx, all CPUs)\n", N * iterations / t_batch / 1e6, t_single / t_batch);
+    printf("============================================================\n");
+    harmonia_ng_batch_shutdown();
+}
+
+/* Request loop: 32 messages per request, malloc'd tables vs one reused arena */
+static void benchmark_arena(void)
+{
+    enum { REQ = 32, ROUNDS = 20000 };
+    static uint8_t data[256 + 64];
+    harmonia_batch_arena *arena = harmonia_batch_arena_create(REQ);
+    struct timespec a, b;
+    double t_malloc, t_arena;
+    size_t k;
+    int i;
+
+    if (!arena) return;
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)k;
+
+    printf("\nHARMONIA-NG batch arena (%d x 16-256 B per request) Benchmark\n", REQ);
+    printf("============================================================\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < ROUNDS; i++) {
+        const uint8_t **msgs = (const uint8_t **)malloc(REQ * sizeof(*msgs));
+        size_t *lens = (size_t *)malloc(REQ * sizeof(*lens));
+        uint8_t *digests = (uint8_t *)malloc(REQ * 32);
+
+        for (k = 0; k < REQ; k++) {
+            msgs[k] = data + (k & 63);
+            lens[k] = 16 + (k * 37 + (size_t)i) % 240;
+        }
+        harmonia_ng_multi(msgs, lens, digests, REQ);
+        free(msgs);
+        free(lens);
+        free(digests);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_malloc = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < ROUNDS; i++) {
+        harmonia_batch_arena_reset(arena);
+        for (k = 0; k < REQ; k++) {
+            harmonia_batch_arena_add(arena, data + (k & 63), 16 + (k * 37 + (size_t)i) % 240);
+        }
+        harmonia_ng_arena_hash(arena);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_arena = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    printf("malloc per request:    %6.2f M msg/s\n", (double)REQ * ROUNDS / t_malloc / 1e6);
+    printf("reused arena:          %6.2f M msg/s (%.2fx)\n", (double)REQ * ROUNDS / t_arena / 1e6, t_malloc / t_arena);
+    printf("============================================================\n");
+    harmonia_batch_arena_destroy(arena);
+}
+
+/* 16- and 32-byte keys: library call against the inline header */
+static void benchmark_inline(void)
+{
+    enum { KEYS = 4096, ROUNDS = 100 };
+    static uint8_t keys[KEYS * 32];
+    uint8_t digest[32];
+    uint32_t sink = 0;
+    struct timespec a, b;
+    double t_call, t_inline;
+    size_t k;
+    int i;
+
+    for (k = 0; k < sizeof(keys); k++) keys[k] = (uint8_t)(k * 131 + 7);
+
+    printf("\nHARMONIA-NG inline fixed-size keys Benchmark\n");
+    printf("============================================================\n");
+
+#define BENCH_KEYS(n) \
+    clock_gettime(CLOCK_MONOTONIC, &a); \
+    for (i = 0; i < ROUNDS; i++) { \
+        for (k = 0; k < KEYS; k++) { \
+            harmonia_ng_simd(keys + 32 * k, n, digest); \
+            sink += digest[0]; \
+        } \
+    } \
+    clock_gettime(CLOCK_MONOTONIC, &b); \
+    t_call = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9; \
+    clock_gettime(CLOCK_MONOTONIC, &a); \
+    for (i = 0; i < ROUNDS; i++) { \
+        for (k = 0; k < KEYS; k++) { \
+            harmonia_ng_inline(keys + 32 * k, n, digest); \
+            sink += digest[0]; \
+        } \
+    } \
+    clock_gettime(CLOCK_MONOTONIC, &b); \
+    t_inline = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9; \
+    printf("%2d-byte keys: harmonia_ng_simd %6.2f M keys/s, inline %6.2f M keys/s (%.2fx)\n", n, \
+           (double)KEYS * ROUNDS / t_call / 1e6, (double)KEYS * ROUNDS / t_inline / 1e6, \
+           t_call / t_inline);
+
+    BENCH_KEYS(16)
+    BENCH_KEYS(32)
+#undef BENCH_KEYS
+
+    printf("(checksum %u)\n", (unsigned)sink);
+    printf("============================================================\n");
+}
+
+/* 16-byte bucket keys: full digest against the truncated single and x8 forms */
+static void benchmark_u64(void)
+{
+    enum { KEYS = 4096, ROUNDS = 100 };
+    static uint8_t keys[KEYS * 16];
+    const uint8_t *batch[8];
+    uint64_t out[8], sink = 0;
+    uint8_t digest[32];
+    struct timespec a, b;
+    double t_full, t_u64, t_x8;
+    size_t k;
+    int i, lane;
+
+    for (k = 0; k < sizeof(keys); k++) keys[k] = (uint8_t)(k * 131 + 7);
+
+    printf("\nHARMONIA-NG 64-bit 16-byte keys (%s) Benchmark\n",
+           (harmonia_cpu_features() & HARMONIA_CPU_AVX2) ? "AVX2 x8" : "scalar");
+    printf("============================================================\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < ROUNDS; i++) {
+        for (k = 0; k < KEYS; k++) {
+            harmonia_ng_simd(keys + 16 * k, 16, digest);
+            sink += digest[0];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_full = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < ROUNDS; i++) {
+        for (k = 0; k < KEYS; k++) {
+            sink += harmonia_ng_u64_fixed16(keys + 16 * k);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_u64 = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < ROUNDS; i++) {
+        for (k = 0; k < KEYS; k += 8) {
+            for (lane = 0; lane < 8; lane++) batch[lane] = keys + 16 * (k + lane);
+            harmonia_ng_u64_fixed16_x8(batch, out);
+            sink += out[0] ^ out[7];
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_x8 = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    printf("harmonia_ng_simd (256-bit): %6.2f M keys/s\n", (double)KEYS * ROUNDS / t_full / 1e6);
+    printf("u64_fixed16:                %6.2f M keys/s (%.2fx)\n",
+           (double)KEYS * ROUNDS / t_u64 / 1e6, t_full / t_u64);
+    printf("u64_fixed16_x8:             %6.2f M keys/s (%.2fx)\n",
+           (double)KEYS * ROUNDS / t_x8 / 1e6, t_full / t_x8);
+    printf("(checksum %llu)\n", (unsigned long long)sink);
+    printf("============================================================\n");
+}
+
+/* CDC records kept for the one-by-one comparison */
+typedef struct {
+    harmonia_ng_chunk *chunks;
+    size_t n;
+} cdc_bench_records;
+
+static void cdc_bench_collect(void *arg, const harmonia_ng_chunk *chunks, size_t n)
+{
+    cdc_bench_records *rec = (cdc_bench_records *)arg;
+
+    memcpy(rec->chunks + rec->n, chunks, n * sizeof(*chunks));
+    rec->n += n;
+}
+
+static void benchmark_cdc(void)
+{
+    const size_t len = (size_t)64 << 20, update = (size_t)1 << 20;
+    uint8_t *data = (uint8_t *)malloc(len);
+    cdc_bench_records rec;
+    harmonia_ng_cdc cdc;
+    struct timespec a, b;
+    double t_cdc, t_single;
+    uint8_t digest[32];
+    uint32_t s = 1;
+    size_t k;
+
+    rec.chunks = (harmonia_ng_chunk *)malloc(len / HARMONIA_NG_CDC_MIN * sizeof(harmonia_ng_chunk));
+    rec.n = 0;
+    if (!data || !rec.chunks) {
+        free(data);
+        free(rec.chunks);
+        return;
+    }
+    for (k = 0; k < len; k++) {
+        s ^= s << 13;
+        s ^= s >> 17;
+        s ^= s << 5;
+        data[k] = (uint8_t)(s >> 24);
+    }
+
+    printf("\nHARMONIA-NG-CDC (64 MB, 8 KB average chunks, 1 MB updates) Benchmark\n");
+    printf("============================================================\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    harmonia_ng_cdc_init(&cdc, 0, 0, 0, 1, cdc_bench_collect, &rec);
+    for (k = 0; k < len; k += update) harmonia_ng_cdc_update(&cdc, data + k, update);
+    harmonia_ng_cdc_final(&cdc);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_cdc = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    /* Hashing alone, one chunk per call */
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (k = 0; k < rec.n; k++) harmonia_ng_simd(data + rec.chunks[k].offset, rec.chunks[k].len, digest);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    t_single = (double)(b.tv_sec - a.tv_sec) + (double)(b.tv_nsec - a.tv_nsec) / 1e9;
+
+    printf("chunk + lane batches:  %7.1f MB/s (%zu chunks)\n", len / t_cdc / 1e6, rec.n);
+    printf("harmonia_ng per chunk: %7.1f MB/s (hashing only)\n", len / t_single / 1e6);
+    printf("============================================================\n");
+    free(data);
+    free(rec.chunks);
+}
+
+static void benchmark_multi(void)
+{
+    enum { N = 4096 };
+    static uint8_t data[8192 + 64];
+    static const uint8_t *msgs[N];
+    static size_t lens[N];
+    static uint8_t digests[N * 32];
+    size_t k, total = 0;
+    uint32_t seed = 12345;
+    clock_t start;
+    double t_multi, t_single;
+
+    for (k = 0; k < sizeof(data); k++) data[k] = (uint8_t)k;
+    for (k = 0; k < N; k++) {
+        seed = seed * 1103515245U + 12345U;
+        lens[k] = 40 + (seed >> 8) % (8192 - 40);
+        msgs[k] = data + (k & 63);
+        total += lens[k];
+    }
+
+    start = clock();
+    harmonia_ng_multi(msgs, lens, digests, N);
+    t_multi = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("\nHARMONIA-NG multi (%s, 40 B - 8 KB mixed) Benchmark\n", lane_engine.name);
+    printf("============================================================\n");
+
+    start = clock();
+    for (k = 0; k < N; k++) {
+        harmonia_ng_simd(msgs[k], lens[k], digests + 32 * k);
+    }
+    t_single = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("multi:      %.1f MB/s (%d messages)\n", total / t_multi / 1024 / 1024, N);
+    printf("one by one: %.1f MB/s (%d messages)\n", total / t_single / 1024 / 1024, N);
+    printf("============================================================\n");
+}
+
 /* ============================================================================
  * MAIN
  * ============================================================================ */
 
-#ifdef HARMONIA_NG_SIMD_MAIN
 int main(int argc, char *argv[])
 {
     if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
         benchmark_simd();
         benchmark_x4();
+        benchmark_multi_lane("x8", harmonia_ng_x8, 8);
+        benchmark_multi_lane("x16", harmonia_ng_x16, 16);
+        benchmark_multi();
+        benchmark_prefixed();
+        benchmark_tree();
+        benchmark_merkle();
+        benchmark_batch();
+        benchmark_arena();
+        benchmark_inline();
+        benchmark_u64();
+        benchmark_cdc();
         return 0;
     }
     if (argc > 1 && strcmp(argv[1], "--test-x4") == 0) {
@@ -1027,6 +3083,19 @@ int main(int argc, char *argv[])
     if (argc > 1 && strcmp(argv[1], "--test") == 0) {
         int failed = harmonia_ng_simd_self_test();
         failed += test_x4();
+        failed += test_streaming();
+        failed += test_scatter();
+        failed += test_multi_lane("x8", harmonia_ng_x8, 8);
+        failed += test_multi_lane("x16", harmonia_ng_x16, 16);
+        failed += test_multi();
+        failed += test_prefixed();
+        failed += test_arena();
+        failed += test_inline();
+        failed += test_u64();
+        failed += harmonia_ng_tree_self_test();
+        failed += harmonia_ng_merkle_self_test();
+        failed += harmonia_ng_batch_self_test();
+        failed += harmonia_ng_cdc_self_test();
         return failed;
     }
     if (argc > 1) {
@@ -1038,6 +3107,19 @@ int main(int argc, char *argv[])
     /* Default: run all tests */
     int failed = harmonia_ng_simd_self_test();
     failed += test_x4();
+    failed += test_streaming();
+    failed += test_scatter();
+    failed += test_multi_lane("x8", harmonia_ng_x8, 8);
+    failed += test_multi_lane("x16", harmonia_ng_x16, 16);
+    failed += test_multi();
+    failed += test_prefixed();
+    failed += test_arena();
+    failed += test_inline();
+    failed += test_u64();
+    failed += harmonia_ng_tree_self_test();
+    failed += harmonia_ng_merkle_self_test();
+    failed += harmonia_ng_batch_self_test();
+    failed += harmonia_ng_cdc_self_test();
     return failed;
 }
 #endif
@@ -0,0 +1,481 @@
+/*
+ * HARMONIA-NG-Tree - Parallel Tree Hashing Mode
+ *
+ * Splits one large input into fixed-size chunks hashed as independent leaves
+ * and combines their chaining values in a left-complete binary tree, so a
+ * single input can be spread across all cores (threads) and all SIMD lanes
+ * (harmonia_ng_multi_tweaked) instead of one Merkle-Damgard chain.
+ *
+ * Layout (see harmonia_ng.h for the exact definition):
+ *   leaf k   = NG(chunk k)            IV tweak: counter k, LEAF
+ *   parent   = NG(left_cv || right_cv) IV tweak: counter 0, PARENT
+ *   root     = top node with ROOT added to its flags
+ *
+ * License: MIT
+ */
+
+#include "harmonia_ng.h"
+#include "harmonia_cpu.h"
+#include "harmonia_stats.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#define CHUNK            HARMONIA_NG_TREE_CHUNK
+#define CV_SIZE          HARMONIA_NG_DIGEST_SIZE
+
+/*
+ * Work unit: SUBTREE_CHUNKS aligned chunks (1 MB). Aligned power-of-two
+ * groups of chunks are exact subtrees of the left-complete tree, so each
+ * unit reduces to one chaining value independently; the final (partial)
+ * unit is the left-complete tree of its remaining chunks.
+ */
+#define SUBTREE_CHUNKS   256
+
+/* ============================================================================
+ * TREE REDUCTION
+ * ============================================================================ */
+
+/*
+ * Reduce count chaining values to one, level by level: adjacent pairs become
+ * parents and an odd last value is carried up unchanged, which yields the
+ * left-complete layout. Parents of each level go through the lane engine
+ * together. The result is left in cvs[0]; scratch holds (count/2) values.
+ */
+static void reduce_cvs(uint8_t *cvs, size_t count, uint8_t *scratch, int is_root)
+{
+    const uint8_t *msgs[SUBTREE_CHUNKS / 2];
+    size_t lens[SUBTREE_CHUNKS / 2];
+    uint32_t flags[SUBTREE_CHUNKS / 2];
+
+    while (count > 1) {
+        size_t pairs = count / 2;
+        size_t done, k;
+
+        /* Level in batches so the pointer arrays stay on the stack */
+        for (done = 0; done < pairs; done += SUBTREE_CHUNKS / 2) {
+            size_t batch = pairs - done;
+            if (batch > SUBTREE_CHUNKS / 2) batch = SUBTREE_CHUNKS / 2;
+
+            for (k = 0; k < batch; k++) {
+                msgs[k] = cvs + 2 * CV_SIZE * (done + k);
+                lens[k] = 2 * CV_SIZE;
+                flags[k] = HARMONIA_NG_TREE_PARENT;
+            }
+            if (is_root && count == 2) {
+                flags[0] |= HARMONIA_NG_TREE_ROOT;
+            }
+            harmonia_ng_multi_tweaked(msgs, lens, NULL, flags, scratch + CV_SIZE * done, batch);
+        }
+
+        memcpy(cvs, scratch, pairs * CV_SIZE);
+        if (count & 1) {
+            memmove(cvs + pairs * CV_SIZE, cvs + (count - 1) * CV_SIZE, CV_SIZE);
+        }
+        count = pairs + (count & 1);
+    }
+}
+
+/* Hash `count` consecutive chunks starting at chunk `first` into one CV */
+static void hash_subtree(const uint8_t *data, size_t len, size_t first, size_t count,
+                         int is_root, uint8_t *cv)
+{
+    const uint8_t *msgs[SUBTREE_CHUNKS];
+    size_t lens[SUBTREE_CHUNKS];
+    uint64_t counters[SUBTREE_CHUNKS];
+    uint32_t flags[SUBTREE_CHUNKS];
+    uint8_t cvs[SUBTREE_CHUNKS * CV_SIZE];
+    uint8_t scratch[SUBTREE_CHUNKS / 2 * CV_SIZE];
+    size_t k;
+
+    for (k = 0; k < count; k++) {
+        size_t offset = (first + k) * CHUNK;
+        size_t n = len - offset;
+
+        msgs[k] = data + offset;
+        lens[k] = (n < CHUNK) ? n : CHUNK;
+        counters[k] = first + k;
+        flags[k] = HARMONIA_NG_TREE_LEAF;
+    }
+    if (is_root && count == 1) {
+        flags[0] |= HARMONIA_NG_TREE_ROOT;
+    }
+
+    harmonia_ng_multi_tweaked(msgs, lens, counters, flags, cvs, count);
+    reduce_cvs(cvs, count, scratch, is_root);
+    memcpy(cv, cvs, CV_SIZE);
+}
+
+/* ============================================================================
+ * THREAD POOL
+ * ============================================================================ */
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t nchunks;
+    size_t nsubtrees;
+    size_t next;             /* Next subtree to claim (atomic) */
+    uint8_t *subtree_cvs;    /* nsubtrees * CV_SIZE */
+#ifdef HARMONIA_STATS
+    pthread_mutex_t lock;
+    harmonia_stats stats;    /* Worker counters, merged into the caller's */
+#endif
+} tree_job;
+
+/* Claim and hash subtrees until none are left */
+static void tree_subtrees(tree_job *job)
+{
+    size_t s;
+
+    while ((s = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->nsubtrees) {
+        size_t first = s * SUBTREE_CHUNKS;
+        size_t count = job->nchunks - first;
+        if (count > SUBTREE_CHUNKS) count = SUBTREE_CHUNKS;
+
+        hash_subtree(job->data, job->len, first, count, job->nsubtrees == 1,
+                     job->subtree_cvs + s * CV_SIZE);
+    }
+}
+
+static void *tree_worker(void *arg)
+{
+    tree_job *job = (tree_job *)arg;
+#ifdef HARMONIA_STATS
+    harmonia_stats before;
+
+    harmonia_stats_get(&before);
+#endif
+    tree_subtrees(job);
+#ifdef HARMONIA_STATS
+    /* Credit the work to the caller of harmonia_ng_tree() */
+    pthread_mutex_lock(&job->lock);
+    harmonia_stats_accumulate(&job->stats, &before);
+    pthread_mutex_unlock(&job->lock);
+#endif
+    return NULL;
+}
+
+/* ============================================================================
+ * PUBLIC API
+ * ============================================================================ */
+
+/*
+ * Node covering chunks [first, first + count). Spans of up to SUBTREE_CHUNKS
+ * (always aligned here) come from subtree_cvs when the workers have computed
+ * them, otherwise they are hashed in place; larger spans split at the largest
+ * power of two below count, as in the left-complete layout.
+ */
+static void tree_node(const tree_job *job, size_t first, size_t count, int is_root, uint8_t *cv)
+{
+    uint8_t pair[2 * CV_SIZE];
+    const uint8_t *msg = pair;
+    const size_t len = sizeof(pair);
+    uint32_t flags = HARMONIA_NG_TREE_PARENT;
+    size_t left = SUBTREE_CHUNKS;
+
+    if (count <= SUBTREE_CHUNKS) {
+        if (job->subtree_cvs) {
+            memcpy(cv, job->subtree_cvs + (first / SUBTREE_CHUNKS) * CV_SIZE, CV_SIZE);
+        } else {
+            hash_subtree(job->data, job->len, first, count, is_root, cv);
+        }
+        return;
+    }
+
+    while (left * 2 < count) left *= 2;
+    tree_node(job, first, left, 0, pair);
+    tree_node(job, first + left, count - left, 0, pair + CV_SIZE);
+
+    if (is_root) flags |= HARMONIA_NG_TREE_ROOT;
+    harmonia_ng_multi_tweaked(&msg, &len, NULL, &flags, cv, 1);
+}
+
+void harmonia_ng_tree(const uint8_t *data, size_t len, uint8_t *digest, int nthreads)
+{
+    tree_job job;
+    pthread_t *threads = NULL;
+    int t, started = 0;
+
+    job.data = data;
+    job.len = len;
+    job.nchunks = (len == 0) ? 1 : (len + CHUNK - 1) / CHUNK;
+    job.nsubtrees = (job.nchunks + SUBTREE_CHUNKS - 1) / SUBTREE_CHUNKS;
+    job.next = 0;
+    job.subtree_cvs = NULL;
+
+    /* Small inputs: a single unit, no allocation or threads */
+    if (job.nsubtrees == 1) {
+        hash_subtree(data, len, 0, job.nchunks, 1, digest);
+        return;
+    }
+
+    /* Without the CV array the tree is walked serially (no allocation) */
+    job.subtree_cvs = (uint8_t *)malloc(job.nsubtrees * CV_SIZE);
+    if (job.subtree_cvs) {
+        if (nthreads <= 0) nthreads = harmonia_cpu_count();
+        if ((size_t)nthreads > job.nsubtrees) nthreads = (int)job.nsubtrees;
+
+        /* The calling thread is worker 0 */
+        if (nthreads > 1) {
+            threads = (pthread_t *)malloc((size_t)(nthreads - 1) * sizeof(pthread_t));
+        }
+#ifdef HARMONIA_STATS
+        pthread_mutex_init(&job.lock, NULL);
+        memset(&job.stats, 0, sizeof(job.stats));
+#endif
+        for (t = 0; threads && t < nthreads - 1; t++) {
+            if (pthread_create(&threads[t], NULL, tree_worker, &job) != 0) break;
+            started++;
+        }
+        tree_subtrees(&job);
+        for (t = 0; t < started; t++) {
+            pthread_join(threads[t], NULL);
+        }
+#ifdef HARMONIA_STATS
+        harmonia_stats_merge(&job.stats);
+        pthread_mutex_destroy(&job.lock);
+#endif
+        free(threads);
+    }
+
+    tree_node(&job, 0, job.nchunks, 1, digest);
+    free(job.subtree_cvs);
+}
+
+/* ============================================================================
+ * STREAMING
+ * ============================================================================ */
+
+/*
+ * A chunk is folded into the stack only once input beyond it has arrived,
+ * so no node built there can be the root. Pushing chunk t merges one stack
+ * entry per trailing zero bit of t: the completed power-of-two subtrees of
+ * the left-complete layout. The final chunk and the remaining entries are
+ * combined right to left in final, with ROOT on the last node.
+ */
+
+static void stream_parent(const uint8_t *left, const uint8_t *right, uint32_t flags, uint8_t *cv)
+{
+    uint8_t pair[2 * CV_SIZE];
+    const uint8_t *msg = pair;
+    const size_t len = sizeof(pair);
+
+    memcpy(pair, left, CV_SIZE);
+    memcpy(pair + CV_SIZE, right, CV_SIZE);
+    harmonia_ng_multi_tweaked(&msg, &len, NULL, &flags, cv, 1);
+}
+
+static void stream_push(harmonia_ng_tree_ctx *ctx, const uint8_t *leaf_cv)
+{
+    uint8_t cv[CV_SIZE];
+    uint64_t t = ++ctx->chunks;
+
+    memcpy(cv, leaf_cv, CV_SIZE);
+    while ((t & 1) == 0) {
+        ctx->stack_len--;
+        stream_parent(ctx->stack[ctx->stack_len], cv, HARMONIA_NG_TREE_PARENT, cv);
+        t >>= 1;
+    }
+    memcpy(ctx->stack[ctx->stack_len++], cv, CV_SIZE);
+}
+
+/* Hash count whole chunks at data as leaves and fold them into the stack */
+static void stream_chunks(harmonia_ng_tree_ctx *ctx, const uint8_t *data, size_t count)
+{
+    const uint8_t *msgs[SUBTREE_CHUNKS];
+    size_t lens[SUBTREE_CHUNKS];
+    uint64_t counters[SUBTREE_CHUNKS];
+    uint32_t flags[SUBTREE_CHUNKS];
+    uint8_t cvs[SUBTREE_CHUNKS * CV_SIZE];
+    size_t k;
+
+    for (k = 0; k < count; k++) {
+        msgs[k] = data + k * CHUNK;
+        lens[k] = CHUNK;
+        counters[k] = ctx->chunks + k;
+        flags[k] = HARMONIA_NG_TREE_LEAF;
+    }
+    harmonia_ng_multi_tweaked(msgs, lens, counters, flags, cvs, count);
+    for (k = 0; k < count; k++) {
+        stream_push(ctx, cvs + k * CV_SIZE);
+    }
+}
+
+void harmonia_ng_tree_init(harmonia_ng_tree_ctx *ctx)
+{
+    ctx->stack_len = 0;
+    ctx->chunks = 0;
+    ctx->buffer_len = 0;
+}
+
+void harmonia_ng_tree_update(harmonia_ng_tree_ctx *ctx, const uint8_t *data, size_t len)
+{
+    while (len > 0) {
+        size_t n;
+
+        /* More input: the buffered chunk is not the last one */
+        if (ctx->buffer_len == CHUNK) {
+            stream_chunks(ctx, ctx->buffer, 1);
+            ctx->buffer_len = 0;
+        }
+
+        /* Whole chunks in place, always keeping the last byte back */
+        if (ctx->buffer_len == 0 && len > CHUNK) {
+            n = (len - 1) / CHUNK;
+            if (n > SUBTREE_CHUNKS) n = SUBTREE_CHUNKS;
+            stream_chunks(ctx, data, n);
+            data += n * CHUNK;
+            len -= n * CHUNK;
+            continue;
+        }
+
+        n = CHUNK - ctx->buffer_len;
+        if (n > len) n = len;
+        memcpy(ctx->buffer + ctx->buffer_len, data, n);
+        ctx->buffer_len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+void harmonia_ng_tree_final(harmonia_ng_tree_ctx *ctx, uint8_t *digest)
+{
+    const uint8_t *msg = ctx->buffer;
+    size_t len = ctx->buffer_len;
+    uint64_t counter = ctx->chunks;
+    uint32_t flags = HARMONIA_NG_TREE_LEAF;
+    uint8_t cv[CV_SIZE];
+
+    if (ctx->stack_len == 0) flags |= HARMONIA_NG_TREE_ROOT;
+    harmonia_ng_multi_tweaked(&msg, &len, &counter, &flags, cv, 1);
+
+    while (ctx->stack_len > 0) {
+        ctx->stack_len--;
+        flags = HARMONIA_NG_TREE_PARENT;
+        if (ctx->stack_len == 0) flags |= HARMONIA_NG_TREE_ROOT;
+        stream_parent(ctx->stack[ctx->stack_len], cv, flags, cv);
+    }
+    memcpy(digest, cv, CV_SIZE);
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+/* One node through the streaming API with an explicitly tweaked IV */
+static void ref_node(const uint8_t *msg, size_t len, uint64_t counter, uint32_t flags,
+                     uint8_t *cv)
+{
+    harmonia_ng_ctx ctx;
+
+    harmonia_ng_simd_init(&ctx);
+    ctx.state_g[7] ^= flags;
+    ctx.state_c[6] ^= (uint32_t)counter;
+    ctx.state_c[7] ^= (uint32_t)(counter >> 32);
+    harmonia_ng_simd_update(&ctx, msg, len);
+    harmonia_ng_simd_final(&ctx, cv);
+}
+
+/* Serial reference: recursive left-complete tree over chunks [first, first+count) */
+static void ref_tree(const uint8_t *data, size_t len, size_t first, size_t count,
+                     uint32_t root, uint8_t *cv)
+{
+    uint8_t pair[2 * CV_SIZE];
+    size_t left = 1;
+
+    if (count == 1) {
+        size_t offset = first * CHUNK;
+        size_t n = len - offset;
+        ref_node(data + offset, (n < CHUNK) ? n : CHUNK, first,
+                 HARMONIA_NG_TREE_LEAF | root, cv);
+        return;
+    }
+
+    while (left * 2 < count) left *= 2;
+    ref_tree(data, len, first, left, 0, pair);
+    ref_tree(data, len, first + left, count - left, 0, pair + CV_SIZE);
+    ref_node(pair, sizeof(pair), 0, HARMONIA_NG_TREE_PARENT | root, cv);
+}
+
+int harmonia_ng_tree_self_test(void)
+{
+    static const size_t lengths[] = {
+        0, 1, CHUNK - 1, CHUNK, CHUNK + 1, 3 * CHUNK, 7 * CHUNK + 100,
+        SUBTREE_CHUNKS * CHUNK, SUBTREE_CHUNKS * CHUNK + 1,
+        (5 * SUBTREE_CHUNKS / 2) * CHUNK + 17
+    };
+    static const struct {
+        const char *input;
+        const char *expected;
+    } vectors[] = {
+        {"", "97af43d752fbfeb8384183606795164622216e149719734d5d7c56aea22c2367"},
+        {"HARMONIA-NG", "d1c8641c94dd1ed2527c01629cb57f37bfc4e6c906461935ce4804139d5d92fa"},
+        {NULL, NULL}
+    };
+    size_t max_len = (5 * SUBTREE_CHUNKS / 2) * CHUNK + 17;
+    uint8_t *data;
+    size_t t, k;
+    int i, failed = 0;
+
+    printf("\nHARMONIA-NG-Tree Self-Test\n");
+    printf("============================================================\n");
+
+    for (i = 0; vectors[i].input != NULL; i++) {
+        uint8_t digest[CV_SIZE];
+        char hex[65];
+
+        harmonia_ng_tree((const uint8_t *)vectors[i].input, strlen(vectors[i].input), digest, 1);
+        for (k = 0; k < CV_SIZE; k++) sprintf(hex + 2 * k, "%02x", digest[k]);
+
+        if (strcmp(hex, vectors[i].expected) == 0) {
+            printf("  OK   %s\n", vectors[i].input[0] ? vectors[i].input : "(empty)");
+        } else {
+            printf("  FAIL %s\n", vectors[i].input[0] ? vectors[i].input : "(empty)");
+            printf("       Expected: %s\n", vectors[i].expected);
+            printf("       Got:      %s\n", hex);
+            failed++;
+        }
+    }
+
+    data = (uint8_t *)malloc(max_len);
+    if (!data) {
+        printf("  FAIL allocation\n");
+        return failed + 1;
+    }
+    for (k = 0; k < max_len; k++) data[k] = (uint8_t)(k * 131 + (k >> 9));
+
+    for (t = 0; t < sizeof(lengths) / sizeof(lengths[0]); t++) {
+        size_t nchunks = (lengths[t] == 0) ? 1 : (lengths[t] + CHUNK - 1) / CHUNK;
+        uint8_t expected[CV_SIZE], d1[CV_SIZE], d3[CV_SIZE], ds[CV_SIZE];
+        harmonia_ng_tree_ctx ctx;
+        size_t pos, piece;
+
+        ref_tree(data, lengths[t], 0, nchunks, HARMONIA_NG_TREE_ROOT, expected);
+        harmonia_ng_tree(data, lengths[t], d1, 1);
+        harmonia_ng_tree(data, lengths[t], d3, 3);
+
+        /* Streamed in pieces that cross chunk edges and run many chunks */
+        harmonia_ng_tree_init(&ctx);
+        for (pos = 0, piece = 1000; pos < lengths[t]; pos += piece, piece = piece * 7 + 1) {
+            if (piece > lengths[t] - pos) piece = lengths[t] - pos;
+            harmonia_ng_tree_update(&ctx, data + pos, piece);
+        }
+        harmonia_ng_tree_final(&ctx, ds);
+
+        if (memcmp(d1, expected, CV_SIZE) == 0 && memcmp(d3, expected, CV_SIZE) == 0 &&
+            memcmp(ds, expected, CV_SIZE) == 0) {
+            printf("  OK   len %zu (%zu chunks)\n", lengths[t], nchunks);
+        } else {
+            printf("  FAIL len %zu (tree or stream != serial reference)\n", lengths[t]);
+            failed++;
+        }
+    }
+
+    free(data);
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
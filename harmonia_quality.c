@@ -0,0 +1,1302 @@
+/*
+ * harmonia_quality - Native statistical test driver
+ *
+ *   harmonia_quality [-a engine[,engine...]] [-t test[,test...]]
+ *                    [-n [test=]samples] [-j threads] [--seed S]
+ *   harmonia_quality --rounds [-n [test=]samples] [-j threads]
+ *   harmonia_quality --test
+ *
+ * The metrics of crypto_tests.py (avalanche, bit distribution, bit
+ * independence, byte chi-square, near-collision, SAC, length sensitivity)
+ * and the reduced-round tables of reduced_rounds_test.py, with the same
+ * message generators, scores and report layout, ending in the README
+ * comparison table. Messages are hashed in batches through the
+ * multi-buffer engines (harmonia_multi / harmonia_ng_multi), and samples
+ * are split into CHUNK-sized work items claimed by -j threads.
+ *
+ * Every chunk draws from its own random stream derived from the seed and
+ * the chunk index, and the per-thread results only ever meet through sums,
+ * minima and maxima, so a run's numbers depend on the seed and the sample
+ * counts but not on the thread count. Sample counts go up to 10^12 per test
+ * (all counters are 64-bit); "-n 1e9" or "-n sac=2M" are accepted.
+ *
+ * License: MIT
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "harmonia.h"
+#include "harmonia_ng.h"
+#include "harmonia_fast.h"
+#include "harmonia_cpu.h"
+
+#ifdef USE_OPENSSL
+#include <openssl/sha.h>
+#endif
+
+#define DIGEST_SIZE     32
+#define DIGEST_BITS     256
+#define CHUNK           4096    /* samples per work item (one random stream each) */
+#define WORK_MSGS       256     /* messages per engine call */
+#define MAX_MSG         128     /* longest generated message */
+#define NEAR_WINDOW     100     /* earlier digests each near-collision sample meets */
+#define SAC_BITS        64      /* input bits flipped per SAC sample */
+#define SAC_GROUP       (WORK_MSGS / (SAC_BITS + 1))
+#define MAX_ENGINES     8
+#define MAX_THREADS     256
+#define MAX_SAMPLES     1000000000000ULL
+
+/* ============================================================================
+ * ENGINES
+ * ============================================================================ */
+
+typedef struct quality_engine quality_engine;
+
+struct quality_engine {
+    char name[24];
+    char label[24];             /* column heading, as in crypto_tests.py */
+    void (*batch)(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                  uint8_t *digests, size_t n);
+    int rounds;                 /* harmonia-rN only */
+};
+
+static void v22_batch(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                      uint8_t *digests, size_t n)
+{
+    (void)e;
+    harmonia_multi(msgs, lens, digests, n);
+}
+
+static void ng_batch(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                     uint8_t *digests, size_t n)
+{
+    (void)e;
+    harmonia_ng_multi(msgs, lens, digests, n);
+}
+
+static void fast_batch(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                       uint8_t *digests, size_t n)
+{
+    size_t k;
+
+    (void)e;
+    for (k = 0; k < n; k++) harmonia_fast(msgs[k], lens[k], digests + k * DIGEST_SIZE);
+}
+
+static void rounds_batch(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                         uint8_t *digests, size_t n)
+{
+    size_t k;
+
+    for (k = 0; k < n; k++) harmonia_rounds(msgs[k], lens[k], digests + k * DIGEST_SIZE, e->rounds);
+}
+
+#ifdef USE_OPENSSL
+static void sha256_batch(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                         uint8_t *digests, size_t n)
+{
+    size_t k;
+
+    (void)e;
+    for (k = 0; k < n; k++) SHA256(msgs[k], lens[k], digests + k * DIGEST_SIZE);
+}
+#endif
+
+/* Self-test only: the message itself, zero-padded, so every metric must fail */
+static void identity_batch(const quality_engine *e, const uint8_t *const *msgs, const size_t *lens,
+                           uint8_t *digests, size_t n)
+{
+    size_t k;
+
+    (void)e;
+    for (k = 0; k < n; k++) {
+        memset(digests + k * DIGEST_SIZE, 0, DIGEST_SIZE);
+        memcpy(digests + k * DIGEST_SIZE, msgs[k], lens[k] < DIGEST_SIZE ? lens[k] : DIGEST_SIZE);
+    }
+}
+
+static const quality_engine ENGINES[] = {
+    {"harmonia",    "HARMONIA",    v22_batch,    64},
+    {"harmonia-ng", "HARMONIA-NG", ng_batch,     32},
+    {"harmonia-fast", "HARMONIA-FAST", fast_batch, 32},
+#ifdef USE_OPENSSL
+    {"sha256",      "SHA-256",     sha256_batch, 64},
+#endif
+    {"", "", NULL, 0}
+};
+
+static const quality_engine IDENTITY = {"identity", "IDENTITY", identity_batch, 0};
+
+/* Table entry, or harmonia-rN for N in 8, 16, ..., 64 (the v2.2 compressor cut to N rounds) */
+static int find_engine(const char *name, quality_engine *out)
+{
+    const quality_engine *e;
+    int rounds;
+    char tail;
+
+    for (e = ENGINES; e->batch; e++) {
+        if (strcmp(e->name, name) == 0) {
+            *out = *e;
+            return 0;
+        }
+    }
+    if (sscanf(name, "harmonia-r%d%c", &rounds, &tail) == 1 &&
+        rounds >= 8 && rounds <= 64 && rounds % 8 == 0) {
+        snprintf(out->name, sizeof(out->name), "harmonia-r%d", rounds);
+        snprintf(out->label, sizeof(out->label), "HARMONIA-R%d", rounds);
+        out->batch = rounds_batch;
+        out->rounds = rounds;
+        return 0;
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * RESULTS
+ * ============================================================================ */
+
+/* Everything any test counts; chunks merge by sum / min / max only */
+typedef struct {
+    uint64_t samples;
+    uint64_t hashes;
+    uint64_t aval_sum, aval_sumsq;              /* avalanche: changed output bits */
+    uint32_t aval_min, aval_max;
+    uint64_t ones;                              /* bit distribution */
+    uint64_t position_ones[DIGEST_BITS];
+    uint64_t pairs[4];                          /* bit independence: 00 01 10 11 */
+    uint64_t byte_counts[256];                  /* byte chi-square */
+    uint32_t near_min;                          /* near-collision */
+    uint64_t flips[SAC_BITS][DIGEST_BITS];      /* SAC: output bit j flipped by input bit i */
+    uint64_t length_sum;                        /* length sensitivity */
+    uint32_t length_min;
+} quality_acc;
+
+static void acc_init(quality_acc *a)
+{
+    memset(a, 0, sizeof(*a));
+    a->aval_min = DIGEST_BITS;
+    a->near_min = DIGEST_BITS;
+    a->length_min = DIGEST_BITS;
+}
+
+static void acc_merge(quality_acc *a, const quality_acc *b)
+{
+    size_t k;
+
+    a->samples += b->samples;
+    a->hashes += b->hashes;
+    a->aval_sum += b->aval_sum;
+    a->aval_sumsq += b->aval_sumsq;
+    if (b->aval_min < a->aval_min) a->aval_min = b->aval_min;
+    if (b->aval_max > a->aval_max) a->aval_max = b->aval_max;
+    a->ones += b->ones;
+    for (k = 0; k < DIGEST_BITS; k++) a->position_ones[k] += b->position_ones[k];
+    for (k = 0; k < 4; k++) a->pairs[k] += b->pairs[k];
+    for (k = 0; k < 256; k++) a->byte_counts[k] += b->byte_counts[k];
+    if (b->near_min < a->near_min) a->near_min = b->near_min;
+    for (k = 0; k < SAC_BITS; k++) {
+        size_t j;
+        for (j = 0; j < DIGEST_BITS; j++) a->flips[k][j] += b->flips[k][j];
+    }
+    a->length_sum += b->length_sum;
+    if (b->length_min < a->length_min) a->length_min = b->length_min;
+}
+
+/* ============================================================================
+ * BIT HELPERS
+ * ============================================================================ */
+
+/* Digest as 4 big-endian words: bit m of the digest (MSB first) is bit 63 - m % 64 of word m / 64 */
+static void digest_words(const uint8_t *d, uint64_t w[4])
+{
+    int i;
+
+    memcpy(w, d, DIGEST_SIZE);
+    for (i = 0; i < 4; i++) w[i] = __builtin_bswap64(w[i]);
+}
+
+/* Hamming distance; byte order does not matter here */
+static uint32_t distance(const uint8_t *a, const uint8_t *b)
+{
+    uint64_t wa[4], wb[4];
+    uint32_t d = 0;
+    int i;
+
+    memcpy(wa, a, DIGEST_SIZE);
+    memcpy(wb, b, DIGEST_SIZE);
+    for (i = 0; i < 4; i++) d += (uint32_t)__builtin_popcountll(wa[i] ^ wb[i]);
+    return d;
+}
+
+/*
+ * 256 per-bit counters kept as bytes, eight to a word: byte k of lanes[i][j]
+ * counts digest bit 64i + 63 - (8k + j) (MSB-first numbering), so adding a
+ * digest costs 32 shift-mask-adds instead of one increment per set bit.
+ * Flushed into 64-bit counts before a byte can overflow and at chunk end.
+ */
+typedef struct {
+    uint64_t lanes[4][8];
+    unsigned pending;
+} bit_counter;
+
+static void bits_flush(bit_counter *c, uint64_t *counts)
+{
+    int i, j, k;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 8; j++) {
+            for (k = 0; k < 8; k++) counts[64 * i + 63 - (8 * k + j)] += (c->lanes[i][j] >> (8 * k)) & 0xFF;
+        }
+    }
+    memset(c, 0, sizeof(*c));
+}
+
+static void bits_add(bit_counter *c, const uint64_t w[4], uint64_t *counts)
+{
+    int i, j;
+
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < 8; j++) c->lanes[i][j] += (w[i] >> j) & 0x0101010101010101ULL;
+    }
+    if (++c->pending == 255) bits_flush(c, counts);
+}
+
+/*
+ * Smallest distance from digest i to the NEAR_WINDOW before it, for i in
+ * [first, first + count); near[] holds the digests from start on. x86 CPUs
+ * with AVX2 all have POPCNT, the rest get the compiler's popcount.
+ */
+#define NEAR_SCAN_BODY \
+    uint64_t i, j; \
+    for (i = first; i < first + count; i++) { \
+        const uint64_t *a = near + 4 * (i - start); \
+        for (j = (i >= NEAR_WINDOW ? i - NEAR_WINDOW : 0); j < i; j++) { \
+            const uint64_t *b = near + 4 * (j - start); \
+            uint32_t d = (uint32_t)(__builtin_popcountll(a[0] ^ b[0]) + __builtin_popcountll(a[1] ^ b[1]) + \
+                                    __builtin_popcountll(a[2] ^ b[2]) + __builtin_popcountll(a[3] ^ b[3])); \
+            if (d < best) best = d; \
+        } \
+    } \
+    return best;
+
+static uint32_t near_scan_generic(const uint64_t *near, uint64_t start, uint64_t first,
+                                  uint64_t count, uint32_t best)
+{
+    NEAR_SCAN_BODY
+}
+
+#ifdef HARMONIA_X86
+__attribute__((target("popcnt")))
+static uint32_t near_scan_popcnt(const uint64_t *near, uint64_t start, uint64_t first,
+                                 uint64_t count, uint32_t best)
+{
+    NEAR_SCAN_BODY
+}
+#endif
+
+static uint32_t near_scan(const uint64_t *near, uint64_t start, uint64_t first,
+                          uint64_t count, uint32_t best)
+{
+#ifdef HARMONIA_X86
+    if (harmonia_cpu_features() & HARMONIA_CPU_AVX2) return near_scan_popcnt(near, start, first, count, best);
+#endif
+    return near_scan_generic(near, start, first, count, best);
+}
+
+/* splitmix64 */
+static uint64_t rng_next(uint64_t *s)
+{
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void rng_bytes(uint64_t *s, uint8_t *out, size_t len)
+{
+    while (len > 0) {
+        uint64_t r = rng_next(s);
+        size_t take = len < 8 ? len : 8;
+        memcpy(out, &r, take);
+        out += take;
+        len -= take;
+    }
+}
+
+/* i.to_bytes(minimal, 'big'), one zero byte for 0 */
+static size_t int_bytes(uint64_t i, uint8_t *out)
+{
+    size_t len = 1, k;
+
+    while (len < 8 && (i >> (8 * len)) != 0) len++;
+    for (k = 0; k < len; k++) out[k] = (uint8_t)(i >> (8 * (len - 1 - k)));
+    return len;
+}
+
+/* ============================================================================
+ * TESTS
+ * ============================================================================ */
+
+typedef struct {
+    const quality_engine *engine;
+    int min_len, max_len;               /* avalanche message lengths */
+    quality_acc acc;
+    const uint8_t *msgs[WORK_MSGS];
+    size_t lens[WORK_MSGS];
+    uint8_t data[WORK_MSGS][MAX_MSG];
+    uint8_t digests[WORK_MSGS * DIGEST_SIZE];
+    bit_counter dist;                   /* bit distribution */
+    bit_counter sac[SAC_BITS];          /* SAC, one per flipped input bit */
+    uint64_t *near;                     /* (CHUNK + NEAR_WINDOW) digests as words */
+} quality_worker;
+
+static void hash_msgs(quality_worker *w, size_t n)
+{
+    w->engine->batch(w->engine, w->msgs, w->lens, w->digests, n);
+    w->acc.hashes += n;
+}
+
+/* Random message of min_len..max_len bytes against itself with one bit flipped */
+static void avalanche_chunk(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng)
+{
+    uint64_t done;
+    size_t n, k;
+
+    (void)first;
+    for (done = 0; done < count; done += n) {
+        n = (count - done < WORK_MSGS / 2) ? (size_t)(count - done) : WORK_MSGS / 2;
+        for (k = 0; k < n; k++) {
+            size_t len = (size_t)w->min_len + rng_next(rng) % (uint64_t)(w->max_len - w->min_len + 1);
+            uint64_t bit = rng_next(rng) % (8 * len);
+
+            rng_bytes(rng, w->data[2 * k], len);
+            memcpy(w->data[2 * k + 1], w->data[2 * k], len);
+            w->data[2 * k + 1][bit / 8] ^= (uint8_t)(0x80 >> (bit % 8));
+            w->lens[2 * k] = w->lens[2 * k + 1] = len;
+        }
+        hash_msgs(w, 2 * n);
+        for (k = 0; k < n; k++) {
+            uint32_t d = distance(w->digests + 2 * k * DIGEST_SIZE, w->digests + (2 * k + 1) * DIGEST_SIZE);
+            w->acc.aval_sum += d;
+            w->acc.aval_sumsq += (uint64_t)d * d;
+            if (d < w->acc.aval_min) w->acc.aval_min = d;
+            if (d > w->acc.aval_max) w->acc.aval_max = d;
+        }
+    }
+}
+
+/* Counter messages 0, 1, 2, ...: ones per output bit position */
+static void bit_dist_chunk(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng)
+{
+    uint64_t done;
+    size_t n, k;
+
+    (void)rng;
+    for (done = 0; done < count; done += n) {
+        n = (count - done < WORK_MSGS) ? (size_t)(count - done) : WORK_MSGS;
+        for (k = 0; k < n; k++) w->lens[k] = int_bytes(first + done + k, w->data[k]);
+        hash_msgs(w, n);
+        for (k = 0; k < n; k++) {
+            uint64_t words[4];
+            int i;
+
+            digest_words(w->digests + k * DIGEST_SIZE, words);
+            for (i = 0; i < 4; i++) w->acc.ones += (uint64_t)__builtin_popcountll(words[i]);
+            bits_add(&w->dist, words, w->acc.position_ones);
+        }
+    }
+    bits_flush(&w->dist, w->acc.position_ones);
+}
+
+/* Random messages of 1..50 bytes: the 255 adjacent output bit pairs */
+static void bit_corr_chunk(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng)
+{
+    uint64_t done;
+    size_t n, k;
+
+    (void)first;
+    for (done = 0; done < count; done += n) {
+        n = (count - done < WORK_MSGS) ? (size_t)(count - done) : WORK_MSGS;
+        for (k = 0; k < n; k++) {
+            w->lens[k] = 1 + (size_t)(rng_next(rng) % 50);
+            rng_bytes(rng, w->data[k], w->lens[k]);
+        }
+        hash_msgs(w, n);
+        for (k = 0; k < n; k++) {
+            uint64_t words[4], ones = 0, both = 0, first_ones, second_ones;
+            int i;
+
+            digest_words(w->digests + k * DIGEST_SIZE, words);
+            for (i = 0; i < 4; i++) {
+                ones += (uint64_t)__builtin_popcountll(words[i]);
+                both += (uint64_t)__builtin_popcountll(words[i] & (words[i] << 1));
+                if (i < 3) both += (words[i] & 1) & (words[i + 1] >> 63);
+            }
+            first_ones = ones - (words[3] & 1);         /* bits 0..254 */
+            second_ones = ones - (words[0] >> 63);      /* bits 1..255 */
+            w->acc.pairs[3] += both;
+            w->acc.pairs[2] += first_ones - both;
+            w->acc.pairs[1] += second_ones - both;
+            w->acc.pairs[0] += (DIGEST_BITS - 1) - first_ones - second_ones + both;
+        }
+    }
+}
+
+/* Counter messages: output byte histogram */
+static void chi_square_chunk(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng)
+{
+    uint64_t done;
+    size_t n, k, j;
+
+    (void)rng;
+    for (done = 0; done < count; done += n) {
+        n = (count - done < WORK_MSGS) ? (size_t)(count - done) : WORK_MSGS;
+        for (k = 0; k < n; k++) w->lens[k] = int_bytes(first + done + k, w->data[k]);
+        hash_msgs(w, n);
+        for (j = 0; j < n * DIGEST_SIZE; j++) w->acc.byte_counts[w->digests[j]]++;
+    }
+}
+
+/*
+ * 8-byte big-endian counters, each digest against the NEAR_WINDOW before
+ * it. A chunk rehashes the window ahead of its first sample, so chunks
+ * see the same neighbours as one sequential run.
+ */
+static void near_coll_chunk(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng)
+{
+    uint64_t start = first >= NEAR_WINDOW ? first - NEAR_WINDOW : 0;
+    uint64_t total = first + count - start, done;
+    size_t n, k;
+
+    (void)rng;
+    for (done = 0; done < total; done += n) {
+        n = (total - done < WORK_MSGS) ? (size_t)(total - done) : WORK_MSGS;
+        for (k = 0; k < n; k++) {
+            uint64_t v = start + done + k;
+            int b;
+            for (b = 0; b < 8; b++) w->data[k][b] = (uint8_t)(v >> (56 - 8 * b));
+            w->lens[k] = 8;
+        }
+        hash_msgs(w, n);
+        memcpy(w->near + 4 * done, w->digests, n * DIGEST_SIZE);
+    }
+    w->acc.near_min = near_scan(w->near, start, first, count, w->acc.near_min);
+}
+
+/* Random 8-byte message and its 64 one-bit flips: which output bits change */
+static void sac_chunk(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng)
+{
+    uint64_t done;
+    size_t n, k;
+
+    (void)first;
+    for (done = 0; done < count; done += n) {
+        n = (count - done < SAC_GROUP) ? (size_t)(count - done) : SAC_GROUP;
+        for (k = 0; k < n; k++) {
+            uint8_t *base = w->data[k * (SAC_BITS + 1)];
+            int b;
+
+            rng_bytes(rng, base, 8);
+            w->lens[k * (SAC_BITS + 1)] = 8;
+            for (b = 0; b < SAC_BITS; b++) {
+                uint8_t *m = w->data[k * (SAC_BITS + 1) + 1 + b];
+                memcpy(m, base, 8);
+                m[b / 8] ^= (uint8_t)(0x80 >> (b % 8));
+                w->lens[k * (SAC_BITS + 1) + 1 + b] = 8;
+            }
+        }
+        hash_msgs(w, n * (SAC_BITS + 1));
+        for (k = 0; k < n; k++) {
+            const uint8_t *d = w->digests + k * (SAC_BITS + 1) * DIGEST_SIZE;
+            uint64_t orig[4], mod[4];
+            int b, i;
+
+            digest_words(d, orig);
+            for (b = 0; b < SAC_BITS; b++) {
+                digest_words(d + (1 + b) * DIGEST_SIZE, mod);
+                for (i = 0; i < 4; i++) mod[i] ^= orig[i];
+                bits_add(&w->sac[b], mod, w->acc.flips[b]);
+            }
+        }
+    }
+    for (k = 0; k < SAC_BITS; k++) bits_flush(&w->sac[k], w->acc.flips[k]);
+}
+
+/* "test" * L against "test" * (L + 1), L = 1..64 (fixed, not sampled) */
+static void length_run(quality_worker *w)
+{
+    uint8_t a[4 * 64], b[4 * 65];
+    int len;
+
+    for (len = 1; len <= 64; len++) {
+        const uint8_t *msgs[2];
+        size_t lens[2];
+        uint8_t digests[2 * DIGEST_SIZE];
+        uint32_t d;
+        int k;
+
+        for (k = 0; k < len + 1; k++) memcpy(b + 4 * k, "test", 4);
+        memcpy(a, b, 4 * (size_t)len);
+        msgs[0] = a;
+        msgs[1] = b;
+        lens[0] = 4 * (size_t)len;
+        lens[1] = 4 * (size_t)(len + 1);
+        w->engine->batch(w->engine, msgs, lens, digests, 2);
+        w->acc.hashes += 2;
+        d = distance(digests, digests + DIGEST_SIZE);
+        w->acc.length_sum += d;
+        if (d < w->acc.length_min) w->acc.length_min = d;
+    }
+}
+
+/* ============================================================================
+ * REPORTS (the layout of crypto_tests.py)
+ * ============================================================================ */
+
+static void banner(FILE *out, int number, const char *title, const char *label)
+{
+    fprintf(out, "\n============================================================\n");
+    fprintf(out, "TEST %d: %s - %s\n", number, title, label);
+    fprintf(out, "============================================================\n");
+}
+
+static double avalanche_pct(const quality_acc *a)
+{
+    return a->samples ? (double)a->aval_sum / (double)a->samples / DIGEST_BITS * 100 : 0.0;
+}
+
+static double avalanche_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    double n = (double)(a->samples ? a->samples : 1);
+    double avg = (double)a->aval_sum / n;
+    double var = (double)a->aval_sumsq / n - avg * avg;
+    double pct = avg / DIGEST_BITS * 100;
+    double score = 100 - fabs(50 - pct) * 2;
+
+    banner(out, 1, "AVALANCHE EFFECT", label);
+    fprintf(out, "  Samples:          %llu\n", (unsigned long long)a->samples);
+    fprintf(out, "  Average bits changed: %.2f / 256 (%.2f%%)\n", avg, pct);
+    fprintf(out, "  Standard deviation:   %.2f\n", sqrt(var > 0 ? var : 0));
+    fprintf(out, "  Min/Max:              %u / %u\n", a->aval_min, a->aval_max);
+    fprintf(out, "  Ideal:                128.00 / 256 (50.00%%)\n");
+    fprintf(out, "  Score:                %.1f/100\n", score);
+    sprintf(metric, "%.2f%%", pct);
+    return score;
+}
+
+static double bit_dist_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    double expected = (double)a->samples / 2;
+    double total_bits = (double)a->samples * DIGEST_BITS;
+    double pct = total_bits > 0 ? (double)a->ones / total_bits * 100 : 0.0;
+    double max_dev = 0, sum_dev = 0, score;
+    int k;
+
+    for (k = 0; k < DIGEST_BITS; k++) {
+        double dev = expected > 0 ? fabs((double)a->position_ones[k] - expected) / expected * 100 : 0.0;
+        if (dev > max_dev) max_dev = dev;
+        sum_dev += dev;
+    }
+    score = 100 - fabs(50 - pct) * 10 - sum_dev / DIGEST_BITS;
+    if (score < 0) score = 0;
+    if (score > 100) score = 100;
+
+    banner(out, 2, "BIT DISTRIBUTION", label);
+    fprintf(out, "  Samples:              %llu\n", (unsigned long long)a->samples);
+    fprintf(out, "  Total bits:           %llu\n", (unsigned long long)a->samples * DIGEST_BITS);
+    fprintf(out, "  Ones:                 %.4f%%\n", pct);
+    fprintf(out, "  Zeros:                %.4f%%\n", 100 - pct);
+    fprintf(out, "  Ideal:                50.0000%%\n");
+    fprintf(out, "  Per-position max dev: %.2f%%\n", max_dev);
+    fprintf(out, "  Per-position avg dev: %.2f%%\n", sum_dev / DIGEST_BITS);
+    fprintf(out, "  Score:                %.1f/100\n", score);
+    sprintf(metric, "%.2f%%", pct);
+    return score;
+}
+
+static double bit_corr_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    static const char *names[4] = {"(0, 0)", "(0, 1)", "(1, 0)", "(1, 1)"};
+    double total = (double)(a->pairs[0] + a->pairs[1] + a->pairs[2] + a->pairs[3]);
+    double expected = total / 4, chi = 0, score;
+    int k;
+
+    banner(out, 3, "BIT INDEPENDENCE", label);
+    fprintf(out, "  Samples:      %llu\n", (unsigned long long)a->samples);
+    fprintf(out, "  Bit pairs:    %.0f\n", total);
+    fprintf(out, "  Distribution:\n");
+    for (k = 0; k < 4; k++) {
+        double observed = (double)a->pairs[k];
+        if (expected > 0) chi += (observed - expected) * (observed - expected) / expected;
+        fprintf(out, "    %s: %.2f%% (ideal: 25.00%%)\n", names[k], total > 0 ? observed / total * 100 : 0.0);
+    }
+    score = 100 - chi * 5;
+    if (score < 0) score = 0;
+    fprintf(out, "  Chi-square:   %.4f\n", chi);
+    fprintf(out, "  (Lower is better, critical value at p=0.05: 7.815)\n");
+    fprintf(out, "  Score:        %.1f/100\n", score);
+    sprintf(metric, "%.2f", chi);
+    return score;
+}
+
+static double chi_square_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    double total = (double)a->samples * DIGEST_SIZE;
+    double expected = total / 256, chi = 0, score;
+    int k;
+
+    for (k = 0; k < 256; k++) {
+        double d = (double)a->byte_counts[k] - expected;
+        if (expected > 0) chi += d * d / expected;
+    }
+    score = 100 - (chi - 255) / 2;
+    if (score < 0) score = 0;
+    if (score > 100) score = 100;
+
+    banner(out, 4, "CHI-SQUARE (BYTE DISTRIBUTION)", label);
+    fprintf(out, "  Samples:          %llu\n", (unsigned long long)a->samples);
+    fprintf(out, "  Total bytes:      %.0f\n", total);
+    fprintf(out, "  Expected/byte:    %.2f\n", expected);
+    fprintf(out, "  Chi-square:       %.2f\n", chi);
+    fprintf(out, "  Critical (p=0.05): 293.25\n");
+    fprintf(out, "  Critical (p=0.01): 310.46\n");
+    fprintf(out, "  Result:           %s\n", chi < 293.25 ? "PASS (p > 0.05)" :
+           chi < 310.46 ? "MARGINAL (0.01 < p < 0.05)" : "FAIL (p < 0.01)");
+    fprintf(out, "  Score:            %.1f/100\n", score);
+    sprintf(metric, "%.2f", chi);
+    return score;
+}
+
+static double near_coll_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    const char *result;
+    double score;
+
+    if (a->near_min >= 80) {
+        result = "EXCELLENT";
+        score = 100;
+    } else if (a->near_min >= 60) {
+        result = "GOOD";
+        score = 80;
+    } else if (a->near_min >= 40) {
+        result = "ACCEPTABLE";
+        score = 60;
+    } else {
+        result = "POOR";
+        score = a->near_min;
+    }
+
+    banner(out, 5, "NEAR-COLLISION RESISTANCE", label);
+    fprintf(out, "  Samples:              %llu\n", (unsigned long long)a->samples);
+    fprintf(out, "  Minimum distance:     %u bits\n", a->near_min);
+    fprintf(out, "  Expected (random):    ~90-110 bits\n");
+    fprintf(out, "  Result:               %s\n", result);
+    fprintf(out, "  Score:                %.1f/100\n", score);
+    sprintf(metric, "%u", a->near_min);
+    return score;
+}
+
+static double sac_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    double expected = (double)a->samples / 2, sum = 0, max_dev = 0, avg, score;
+    int i, j;
+
+    for (i = 0; i < SAC_BITS; i++) {
+        for (j = 0; j < DIGEST_BITS; j++) {
+            double dev = expected > 0 ? fabs((double)a->flips[i][j] - expected) / expected : 0.0;
+            sum += dev;
+            if (dev > max_dev) max_dev = dev;
+        }
+    }
+    avg = sum / (SAC_BITS * DIGEST_BITS) * 100;
+    max_dev *= 100;
+    score = 100 - avg * 5 - max_dev / 2;
+    if (score < 0) score = 0;
+
+    banner(out, 6, "STRICT AVALANCHE CRITERION", label);
+    fprintf(out, "  Samples:              %llu\n", (unsigned long long)a->samples);
+    fprintf(out, "  Input bits tested:    %d\n", SAC_BITS);
+    fprintf(out, "  Output bits:          %d\n", DIGEST_BITS);
+    fprintf(out, "  Avg deviation from 50%%: %.2f%%\n", avg);
+    fprintf(out, "  Max deviation:        %.2f%%\n", max_dev);
+    fprintf(out, "  Score:                %.1f/100\n", score);
+    sprintf(metric, "%.2f%%", avg);
+    return score;
+}
+
+static double length_report(FILE *out, const char *label, const quality_acc *a, char *metric)
+{
+    double avg = (double)a->length_sum / 64;
+    double score = avg / 128 * 100;
+
+    if (score > 100) score = 100;
+    banner(out, 7, "LENGTH SENSITIVITY", label);
+    fprintf(out, "  Length range:     1-64 repetitions\n");
+    fprintf(out, "  Avg bit difference: %.1f / 256 (%.1f%%)\n", avg, avg / 256 * 100);
+    fprintf(out, "  Min bit difference: %u / 256\n", a->length_min);
+    fprintf(out, "  Ideal:              ~128 / 256 (50%%)\n");
+    fprintf(out, "  Score:              %.1f/100\n", score);
+    sprintf(metric, "%.1f", avg);
+    return score;
+}
+
+typedef struct {
+    const char *key;
+    const char *summary;                /* FINAL COMPARISON SUMMARY row */
+    const char *readme;                 /* README table row, NULL if not listed there */
+    uint64_t samples;                   /* crypto_tests.py default */
+    void (*chunk)(quality_worker *w, uint64_t first, uint64_t count, uint64_t *rng);
+    double (*report)(FILE *out, const char *label, const quality_acc *a, char *metric);
+} quality_test;
+
+static const quality_test TESTS[] = {
+    {"avalanche",  "Avalanche Effect",   "Avalanche Effect",          1000,  avalanche_chunk,  avalanche_report},
+    {"bit_dist",   "Bit Distribution",   "Bit Distribution",          10000, bit_dist_chunk,   bit_dist_report},
+    {"bit_corr",   "Bit Independence",   "Bit Independence (\xcf\x87\xc2\xb2)", 5000, bit_corr_chunk, bit_corr_report},
+    {"chi_square", "Chi-Square",         "Byte Distribution (\xcf\x87\xc2\xb2)", 10000, chi_square_chunk, chi_square_report},
+    {"near_coll",  "Near-Collision",     "Near-Collision (min bits)", 50000, near_coll_chunk,  near_coll_report},
+    {"sac",        "SAC",                "SAC Deviation",             500,   sac_chunk,        sac_report},
+    {"length",     "Length Sensitivity", NULL,                        0,     NULL,             length_report},
+};
+
+#define NUM_TESTS ((int)(sizeof(TESTS) / sizeof(TESTS[0])))
+
+static int find_test(const char *key, size_t len)
+{
+    int t;
+
+    for (t = 0; t < NUM_TESTS; t++) {
+        if (strlen(TESTS[t].key) == len && strncmp(TESTS[t].key, key, len) == 0) return t;
+    }
+    return -1;
+}
+
+/* ============================================================================
+ * PARALLEL RUNNER
+ * ============================================================================ */
+
+typedef struct {
+    const quality_test *test;
+    const quality_engine *engine;
+    uint64_t seed;
+    uint64_t samples;
+    int min_len, max_len;
+    uint64_t next_chunk;                /* claimed with an atomic add */
+    pthread_mutex_t lock;
+    quality_acc *total;
+    int failed;
+} quality_job;
+
+static quality_worker *worker_new(const quality_job *job)
+{
+    quality_worker *w = (quality_worker *)malloc(sizeof(*w));
+    int k;
+
+    if (!w) return NULL;
+    w->near = (uint64_t *)malloc((CHUNK + NEAR_WINDOW) * DIGEST_SIZE);
+    if (!w->near) {
+        free(w);
+        return NULL;
+    }
+    w->engine = job->engine;
+    w->min_len = job->min_len;
+    w->max_len = job->max_len;
+    acc_init(&w->acc);
+    memset(&w->dist, 0, sizeof(w->dist));
+    memset(w->sac, 0, sizeof(w->sac));
+    for (k = 0; k < WORK_MSGS; k++) w->msgs[k] = w->data[k];
+    return w;
+}
+
+static void worker_free(quality_worker *w)
+{
+    if (w) free(w->near);
+    free(w);
+}
+
+static void *job_thread(void *arg)
+{
+    quality_job *job = (quality_job *)arg;
+    uint64_t nchunks = (job->samples + CHUNK - 1) / CHUNK;
+    quality_worker *w = worker_new(job);
+
+    if (!w) {
+        pthread_mutex_lock(&job->lock);
+        job->failed = 1;
+        pthread_mutex_unlock(&job->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        uint64_t c = __atomic_fetch_add(&job->next_chunk, 1, __ATOMIC_RELAXED);
+        uint64_t first = c * CHUNK, count, rng;
+
+        if (c >= nchunks) break;
+        count = (job->samples - first < CHUNK) ? job->samples - first : CHUNK;
+        /* Stream of this chunk only: the result does not depend on who runs it */
+        rng = job->seed ^ (c * 0xD1B54A32D192ED03ULL);
+        rng_next(&rng);
+        job->test->chunk(w, first, count, &rng);
+        w->acc.samples += count;
+    }
+
+    pthread_mutex_lock(&job->lock);
+    acc_merge(job->total, &w->acc);
+    pthread_mutex_unlock(&job->lock);
+    worker_free(w);
+    return NULL;
+}
+
+/* Run one test on one engine into total (initialized here); -1 on allocation failure */
+static int run_test(const quality_test *test, const quality_engine *engine, uint64_t samples,
+                    uint64_t seed, int threads, int min_len, int max_len, quality_acc *total)
+{
+    pthread_t tids[MAX_THREADS];
+    quality_job job;
+    uint64_t nchunks = (samples + CHUNK - 1) / CHUNK;
+    int t, started = 0;
+
+    acc_init(total);
+    memset(&job, 0, sizeof(job));
+    job.test = test;
+    job.engine = engine;
+    job.seed = seed;
+    job.samples = samples;
+    job.min_len = min_len;
+    job.max_len = max_len;
+    job.total = total;
+    pthread_mutex_init(&job.lock, NULL);
+
+    if (!test->chunk) {
+        quality_worker *w = worker_new(&job);
+        if (!w) return -1;
+        length_run(w);
+        acc_merge(total, &w->acc);
+        worker_free(w);
+        return 0;
+    }
+
+    if ((uint64_t)threads > nchunks) threads = (int)nchunks;
+    for (t = 1; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, job_thread, &job) != 0) break;
+        started++;
+    }
+    job_thread(&job);
+    for (t = 1; t <= started; t++) pthread_join(tids[t], NULL);
+    pthread_mutex_destroy(&job.lock);
+    return job.failed ? -1 : 0;
+}
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+/* ============================================================================
+ * DRIVERS
+ * ============================================================================ */
+
+typedef struct {
+    quality_engine engines[MAX_ENGINES];
+    int nengines;
+    int selected[16];                   /* indices into TESTS */
+    int ntests;
+    uint64_t samples[16];               /* per test */
+    int samples_set[16];                /* given with -n */
+    uint64_t seed;
+    int threads;
+} quality_options;
+
+/* The crypto_tests.py comparison: every test on every engine, then the summary and README table */
+static int run_comparison(const quality_options *o)
+{
+    static quality_acc acc;
+    double scores[16][MAX_ENGINES], totals[MAX_ENGINES];
+    char metrics[16][MAX_ENGINES][32];
+    uint64_t hashes = 0;
+    double t0 = now_seconds(), elapsed;
+    int i, e;
+
+    printf("\n============================================================\n");
+    printf("  ");
+    for (e = 0; e < o->nengines; e++) printf("%s%s", e ? " vs " : "", o->engines[e].label);
+    printf(" - CRYPTOGRAPHIC QUALITY COMPARISON\n");
+    printf("============================================================\n");
+
+    for (i = 0; i < o->ntests; i++) {
+        const quality_test *test = &TESTS[o->selected[i]];
+
+        for (e = 0; e < o->nengines; e++) {
+            if (run_test(test, &o->engines[e], o->samples[o->selected[i]], o->seed, o->threads,
+                         1, 100, &acc) != 0) {
+                fprintf(stderr, "harmonia_quality: out of memory\n");
+                return 1;
+            }
+            hashes += acc.hashes;
+            scores[i][e] = test->report(stdout, o->engines[e].label, &acc, metrics[i][e]);
+        }
+    }
+    elapsed = now_seconds() - t0;
+
+    printf("\n============================================================\n");
+    printf("  FINAL COMPARISON SUMMARY\n");
+    printf("============================================================\n");
+    printf("\n%-25s", "Test");
+    for (e = 0; e < o->nengines; e++) printf(" %12s", o->engines[e].label);
+    printf("%s\n", o->nengines == 2 ? "       Winner" : "");
+    printf("------------------------------------------------------------\n");
+    for (e = 0; e < o->nengines; e++) totals[e] = 0;
+    for (i = 0; i < o->ntests; i++) {
+        printf("%-25s", TESTS[o->selected[i]].summary);
+        for (e = 0; e < o->nengines; e++) {
+            printf(" %11.1f", scores[i][e]);
+            totals[e] += scores[i][e];
+        }
+        if (o->nengines == 2) {
+            printf(" %12s", scores[i][0] > scores[i][1] + 1 ? o->engines[0].label :
+                   scores[i][1] > scores[i][0] + 1 ? o->engines[1].label : "TIE");
+        }
+        printf("\n");
+    }
+    printf("------------------------------------------------------------\n");
+    printf("%-25s", "TOTAL SCORE");
+    for (e = 0; e < o->nengines; e++) printf(" %11.1f", totals[e]);
+    printf("\n%-25s", "AVERAGE");
+    for (e = 0; e < o->nengines; e++) printf(" %11.1f", totals[e] / o->ntests);
+    printf("\n");
+    if (o->nengines == 2) {
+        printf("\n============================================================\n");
+        if (totals[0] != totals[1]) {
+            printf("  RESULT: %s shows BETTER cryptographic properties\n",
+                   o->engines[totals[0] > totals[1] ? 0 : 1].label);
+        } else {
+            printf("  RESULT: EQUIVALENT cryptographic properties\n");
+        }
+        printf("============================================================\n");
+    }
+
+    /* README "Cryptographic Properties" table */
+    printf("\n| Test |");
+    for (e = 0; e < o->nengines; e++) printf(" %s |", o->engines[e].label);
+    printf("\n|------|");
+    for (e = 0; e < o->nengines; e++) printf("----------|");
+    printf("\n");
+    for (i = 0; i < o->ntests; i++) {
+        if (!TESTS[o->selected[i]].readme) continue;
+        printf("| %s |", TESTS[o->selected[i]].readme);
+        for (e = 0; e < o->nengines; e++) printf(" %s |", metrics[i][e]);
+        printf("\n");
+    }
+    printf("\n**Total Score:");
+    for (e = 0; e < o->nengines; e++) printf("%s %s %.1f", e ? " vs" : "", o->engines[e].label, totals[e]);
+    printf("**\n");
+
+    printf("\n%llu hashes in %.2f s on %d threads (%.2f M hashes/s)\n",
+           (unsigned long long)hashes, elapsed, o->threads, (double)hashes / elapsed / 1e6);
+    return 0;
+}
+
+/* The reduced_rounds_test.py tables over harmonia-r8 ... harmonia-r64 */
+static int run_rounds(const quality_options *o, uint64_t aval_samples, uint64_t dist_samples)
+{
+    static quality_acc acc;
+    int secure_aval = 0, secure_dist = 0, rounds;
+
+    printf("======================================================================\n");
+    printf("HARMONIA - REDUCED ROUNDS SECURITY ANALYSIS (v2.2 compressor, native)\n");
+    printf("======================================================================\n");
+
+    printf("\n### AVALANCHE EFFECT TEST ###\n\n");
+    printf("%-8s %-12s %-10s %-8s %-10s %-10s\n", "Rounds", "Avg Bits", "Percent", "Min", "Std Dev", "Status");
+    printf("----------------------------------------------------------------------\n");
+    for (rounds = 8; rounds <= 64; rounds += 8) {
+        quality_engine e;
+        char name[24];
+        double n, avg, var, pct;
+        int secure;
+
+        snprintf(name, sizeof(name), "harmonia-r%d", rounds);
+        find_engine(name, &e);
+        if (run_test(&TESTS[0], &e, aval_samples, o->seed, o->threads, 8, 64, &acc) != 0) return 1;
+        n = (double)(acc.samples ? acc.samples : 1);
+        avg = (double)acc.aval_sum / n;
+        var = (double)acc.aval_sumsq / n - avg * avg;
+        pct = avalanche_pct(&acc);
+        secure = pct >= 45 && acc.aval_min >= 60;
+        if (secure && !secure_aval) secure_aval = rounds;
+        printf("%-8d %-12.2f %-10.2f%% %-8u %-10.2f %-10s\n", rounds, avg, pct, acc.aval_min,
+               sqrt(var > 0 ? var : 0), secure ? "SECURE" : "WEAK");
+    }
+
+    printf("\n### BIT DISTRIBUTION TEST ###\n\n");
+    printf("%-8s %-12s %-12s %-10s\n", "Rounds", "Ones %", "Deviation", "Status");
+    printf("--------------------------------------------------\n");
+    for (rounds = 8; rounds <= 64; rounds += 8) {
+        quality_engine e;
+        char name[24];
+        double pct, dev;
+
+        snprintf(name, sizeof(name), "harmonia-r%d", rounds);
+        find_engine(name, &e);
+        if (run_test(&TESTS[1], &e, dist_samples, o->seed, o->threads, 1, 100, &acc) != 0) return 1;
+        pct = acc.samples ? (double)acc.ones / ((double)acc.samples * DIGEST_BITS) * 100 : 0.0;
+        dev = fabs(50 - pct);
+        if (dev < 2.0 && !secure_dist) secure_dist = rounds;
+        printf("%-8d %-12.4f %-12.4f %-10s\n", rounds, pct, dev, dev < 2.0 ? "SECURE" : "BIASED");
+    }
+
+    printf("\n======================================================================\n");
+    printf("ANALYSIS SUMMARY\n");
+    printf("======================================================================\n");
+    if (secure_aval && secure_dist) {
+        int min_secure = secure_aval > secure_dist ? secure_aval : secure_dist;
+        int recommended = min_secure + 16;
+
+        printf("\nMinimum rounds for avalanche (>= 45%%): %d\n", secure_aval);
+        printf("Minimum rounds for distribution (<2%% dev): %d\n", secure_dist);
+        printf("Minimum secure rounds (combined): %d\n", min_secure);
+        printf("Current rounds: 64\n");
+        printf("Security margin: %d rounds (%.1f%%)\n", 64 - min_secure, (64 - min_secure) / 64.0 * 100);
+        if (recommended < 64) {
+            printf("\nRECOMMENDATION: Could reduce to %d rounds\n", recommended);
+            printf("               Expected speedup: ~%.1fx\n", 64.0 / recommended);
+            printf("               Security margin: 16 rounds\n");
+        }
+    } else {
+        printf("\nWARNING: Could not determine minimum secure configuration!\n");
+    }
+    return 0;
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+static int quality_self_test(void)
+{
+    static quality_acc a, b;
+    quality_engine v22, ng;
+    char metric[32];
+    int t, failed = 0;
+
+    printf("harmonia_quality Self-Test (v2.2 lanes: %s)\n", harmonia_multi_engine());
+    printf("============================================================\n");
+
+    find_engine("harmonia", &v22);
+    find_engine("harmonia-ng", &ng);
+
+    /* Chunked runs on 1 and 3 threads give identical counts */
+    for (t = 0; t < NUM_TESTS; t++) {
+        uint64_t n = TESTS[t].chunk == sac_chunk ? CHUNK + 5 : 3 * CHUNK + 77;
+        int ok = run_test(&TESTS[t], &v22, n, 99, 1, 1, 100, &a) == 0 &&
+                 run_test(&TESTS[t], &v22, n, 99, 3, 1, 100, &b) == 0 &&
+                 memcmp(&a, &b, sizeof(a)) == 0 && a.samples == (TESTS[t].chunk ? n : 0);
+
+        printf("  %s %-10s 1 and 3 threads agree\n", ok ? "OK  " : "FAIL", TESTS[t].key);
+        if (!ok) failed++;
+    }
+
+    /*
+     * Near-collision chunks rehash their window: the minimum over several
+     * chunks equals that of a brute-force sequential pass
+     */
+    {
+        const uint64_t n = 2 * CHUNK + 300;
+        uint8_t *all = (uint8_t *)malloc(n * DIGEST_SIZE);
+        uint32_t best = DIGEST_BITS;
+        uint64_t i, j;
+        int ok = all != NULL;
+
+        for (i = 0; ok && i < n; i++) {
+            uint8_t m[8];
+            int k;
+            for (k = 0; k < 8; k++) m[k] = (uint8_t)(i >> (56 - 8 * k));
+            harmonia(m, 8, all + i * DIGEST_SIZE);
+            for (j = (i >= NEAR_WINDOW ? i - NEAR_WINDOW : 0); j < i; j++) {
+                uint32_t d = distance(all + i * DIGEST_SIZE, all + j * DIGEST_SIZE);
+                if (d < best) best = d;
+            }
+        }
+        ok = ok && run_test(&TESTS[4], &v22, n, 1, 2, 1, 100, &a) == 0 && a.near_min == best;
+        printf("  %s near_coll  chunk windows match a sequential pass (%u bits)\n", ok ? "OK  " : "FAIL", best);
+        if (!ok) failed++;
+        free(all);
+    }
+
+    /* The real engines score like a random function */
+    {
+        int ok = run_test(&TESTS[0], &v22, 20000, 5, 2, 1, 100, &a) == 0 &&
+                 fabs(avalanche_pct(&a) - 50) < 0.5 &&
+                 run_test(&TESTS[0], &ng, 20000, 5, 2, 1, 100, &b) == 0 &&
+                 fabs(avalanche_pct(&b) - 50) < 0.5;
+        printf("  %s avalanche  v2.2 %.2f%%, NG %.2f%% (50 +- 0.5)\n", ok ? "OK  " : "FAIL",
+               avalanche_pct(&a), avalanche_pct(&b));
+        if (!ok) failed++;
+    }
+
+    /* ... and a non-hash fails every scored metric */
+    {
+        FILE *null = fopen("/dev/null", "w");
+        int ok = null != NULL;
+
+        for (t = 0; ok && t < NUM_TESTS; t++) {
+            uint64_t n = TESTS[t].chunk == sac_chunk ? 200 : 2000;
+            if (run_test(&TESTS[t], &IDENTITY, n, 7, 2, 1, 100, &a) != 0 ||
+                TESTS[t].report(null, IDENTITY.label, &a, metric) > 70) {
+                ok = 0;
+            }
+        }
+        if (null) fclose(null);
+        printf("  %s identity   \"hash\" scores <= 70 on every test\n", ok ? "OK  " : "FAIL");
+        if (!ok) failed++;
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+static void usage(const char *prog)
+{
+    const quality_engine *e;
+    int t;
+
+    fprintf(stderr,
+            "Usage: %s [-a engine[,engine...]] [-t test[,test...]] [-n [test=]samples]\n"
+            "          [-j threads] [--seed S]\n"
+            "       %s --rounds [-n [avalanche|bit_dist=]samples] [-j threads]\n"
+            "       %s --test\n\n"
+            "  -a, --algorithm LIST  engines to compare (default harmonia,sha256)\n"
+            "  -t, --tests LIST      tests to run (default all)\n"
+            "  -n, --samples N       samples for every test, or test=N for one (1e9, 2M, ...)\n"
+            "  -j, --jobs N          threads (default: one per CPU)\n"
+            "      --seed S          random stream seed (default 1)\n"
+            "      --rounds          reduced-round tables for harmonia-r8 ... harmonia-r64\n\n"
+            "Engines:",
+            prog, prog, prog);
+    for (e = ENGINES; e->batch; e++) fprintf(stderr, " %s", e->name);
+    fprintf(stderr, " harmonia-rN (N = 8, 16, ..., 64)\nTests:");
+    for (t = 0; t < NUM_TESTS; t++) fprintf(stderr, " %s", TESTS[t].key);
+    fprintf(stderr, "\n");
+}
+
+/* 1000000, 1e9, 250k, 2M, 3G */
+static int parse_count(const char *s, uint64_t *out)
+{
+    char *end;
+    double v = strtod(s, &end);
+
+    if (end == s || v < 0) return -1;
+    if (*end == 'k' || *end == 'K') v *= 1e3, end++;
+    else if (*end == 'm' || *end == 'M') v *= 1e6, end++;
+    else if (*end == 'g' || *end == 'G') v *= 1e9, end++;
+    if (*end != '\0' || v > (double)MAX_SAMPLES) return -1;
+    *out = (uint64_t)v;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static quality_options o;
+    const char *engines = NULL;
+    int rounds_mode = 0, i, t;
+
+    for (t = 0; t < NUM_TESTS; t++) {
+        o.selected[t] = t;
+        o.samples[t] = TESTS[t].samples;
+    }
+    o.ntests = NUM_TESTS;
+    o.seed = 1;
+    o.threads = 0;
+
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+
+        if ((strcmp(arg, "-a") == 0 || strcmp(arg, "--algorithm") == 0) && i + 1 < argc) {
+            engines = argv[++i];
+        } else if ((strcmp(arg, "-t") == 0 || strcmp(arg, "--tests") == 0) && i + 1 < argc) {
+            const char *p = argv[++i];
+            o.ntests = 0;
+            while (*p) {
+                size_t len = strcspn(p, ",");
+                int found = find_test(p, len);
+                if (found < 0 || o.ntests == NUM_TESTS) {
+                    fprintf(stderr, "harmonia_quality: unknown test '%.*s'\n", (int)len, p);
+                    return 1;
+                }
+                o.selected[o.ntests++] = found;
+                p += len + (p[len] == ',');
+            }
+        } else if ((strcmp(arg, "-n") == 0 || strcmp(arg, "--samples") == 0) && i + 1 < argc) {
+            const char *p = argv[++i], *eq = strchr(p, '=');
+            uint64_t n;
+            int which = eq ? find_test(p, (size_t)(eq - p)) : -1;
+
+            if ((eq && which < 0) || parse_count(eq ? eq + 1 : p, &n) != 0) {
+                fprintf(stderr, "harmonia_quality: bad sample count '%s'\n", p);
+                return 1;
+            }
+            for (t = 0; t < NUM_TESTS; t++) {
+                if (TESTS[t].chunk && (!eq || t == which)) {
+                    o.samples[t] = n;
+                    o.samples_set[t] = 1;
+                }
+            }
+        } else if ((strcmp(arg, "-j") == 0 || strcmp(arg, "--jobs") == 0) && i + 1 < argc) {
+            o.threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--seed") == 0 && i + 1 < argc) {
+            o.seed = strtoull(argv[++i], NULL, 0);
+        } else if (strcmp(arg, "--rounds") == 0) {
+            rounds_mode = 1;
+        } else if (strcmp(arg, "--test") == 0) {
+            return quality_self_test();
+        } else {
+            usage(argv[0]);
+            return strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0 ? 0 : 1;
+        }
+    }
+
+    if (o.threads <= 0) o.threads = harmonia_cpu_count();
+    if (o.threads > MAX_THREADS) o.threads = MAX_THREADS;
+
+    if (rounds_mode) {
+        /* reduced_rounds_test.py defaults unless -n was given */
+        uint64_t aval = o.samples_set[0] ? o.samples[0] : 200;
+        uint64_t dist = o.samples_set[1] ? o.samples[1] : 300;
+        return run_rounds(&o, aval, dist);
+    }
+
+    if (!engines) {
+        quality_engine probe;
+        engines = find_engine("sha256", &probe) == 0 ? "harmonia,sha256" : "harmonia,harmonia-ng";
+    }
+    while (*engines) {
+        size_t len = strcspn(engines, ",");
+        char name[32];
+
+        snprintf(name, sizeof(name), "%.*s", (int)len, engines);
+        if (o.nengines == MAX_ENGINES || find_engine(name, &o.engines[o.nengines]) != 0) {
+            fprintf(stderr, "harmonia_quality: unknown engine '%s'\n", name);
+            usage(argv[0]);
+            return 1;
+        }
+        o.nengines++;
+        engines += len + (engines[len] == ',');
+    }
+    if (o.nengines == 0) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    return run_comparison(&o);
+}
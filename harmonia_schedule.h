@@ -0,0 +1,216 @@
+/*
+ * HARMONIA v2.2 - Constants and resolved compression schedule
+ *
+ * Internal header shared by the v2.2 sources (harmonia.c, harmonia_simd.c
+ * and the multi-buffer kernels in harmonia_multi.c); not part of the public
+ * API.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_SCHEDULE_H
+#define HARMONIA_SCHEDULE_H
+
+#include <stdint.h>
+#include "harmonia_constants.h"
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+/* Fibonacci word for round scheduling (A=1, B=0) */
+/* "ABAABABAABAABABAABABAABAABABAABAABABAABABAABAABABAABAABABAABABAAB" */
+static const uint8_t FIBONACCI_WORD[64] = {
+    1,0,1,1,0,1,0,1,1,0,1,1,0,1,0,1,
+    1,0,1,0,1,1,0,1,1,0,1,0,1,1,0,1,
+    1,0,1,0,1,1,0,1,0,1,1,0,1,1,0,1,
+    0,1,1,0,1,1,0,1,0,1,1,0,1,0,1,1
+};
+
+/* Pre-computed quasicrystal rotation table [66][10] */
+static const uint8_t QUASICRYSTAL_ROTATIONS[66][10] = {
+    {14, 11, 5, 4, 11, 13, 11, 5, 3, 10},
+    {5, 11, 13, 11, 4, 5, 11, 13, 11, 5},
+    {20, 6, 11, 2, 5, 21, 7, 10, 1, 5},
+    {14, 18, 7, 7, 17, 14, 18, 9, 9, 15},
+    {6, 12, 18, 1, 3, 10, 9, 16, 2, 6},
+    {16, 2, 6, 14, 13, 18, 6, 11, 10, 11},
+    {19, 15, 14, 17, 3, 12, 12, 16, 2, 12},
+    {16, 20, 6, 12, 4, 7, 6, 16, 8, 9},
+    {16, 1, 6, 6, 21, 11, 10, 5, 5, 4},
+    {14, 16, 16, 5, 12, 19, 11, 10, 21, 2},
+    {11, 16, 14, 9, 17, 20, 8, 19, 10, 10},
+    {18, 3, 10, 13, 13, 1, 20, 20, 18, 4},
+    {4, 5, 11, 13, 11, 5, 4, 11, 13, 11},
+    {13, 10, 3, 5, 12, 13, 11, 4, 5, 11},
+    {12, 3, 5, 19, 5, 11, 2, 5, 20, 7},
+    {5, 5, 20, 15, 18, 7, 6, 18, 14, 18},
+    {20, 21, 21, 5, 14, 18, 1, 2, 8, 11},
+    {3, 20, 15, 16, 21, 4, 16, 14, 17, 5},
+    {10, 6, 10, 1, 16, 13, 14, 1, 15, 13},
+    {21, 17, 18, 11, 5, 11, 14, 2, 2, 12},
+    {20, 17, 2, 17, 18, 19, 15, 7, 13, 6},
+    {21, 1, 7, 7, 5, 18, 19, 19, 13, 1},
+    {11, 19, 2, 19, 15, 17, 3, 20, 8, 7},
+    {13, 10, 16, 20, 3, 8, 18, 8, 5, 2},
+    {12, 13, 10, 4, 5, 11, 13, 11, 4, 5},
+    {2, 6, 12, 13, 10, 3, 6, 12, 13, 10},
+    {5, 18, 4, 13, 3, 5, 19, 5, 12, 2},
+    {1, 16, 17, 5, 4, 20, 15, 18, 6, 6},
+    {17, 1, 17, 20, 21, 20, 3, 15, 19, 1},
+    {17, 13, 15, 5, 1, 16, 15, 20, 2, 18},
+    {1, 10, 19, 8, 3, 14, 4, 17, 12, 11},
+    {9, 15, 3, 4, 18, 16, 6, 10, 15, 15},
+    {2, 21, 3, 12, 5, 8, 19, 14, 11, 3},
+    {1, 15, 17, 1, 14, 14, 21, 15, 19, 12},
+    {2, 12, 20, 13, 13, 2, 5, 14, 19, 18},
+    {15, 10, 19, 10, 15, 10, 21, 3, 7, 2},
+    {10, 3, 6, 12, 13, 10, 3, 6, 12, 13},
+    {12, 13, 9, 2, 7, 12, 13, 10, 3, 6},
+    {2, 15, 4, 5, 18, 3, 13, 3, 5, 19},
+    {16, 2, 1, 2, 16, 17, 4, 3, 21, 15},
+    {21, 21, 19, 16, 2, 19, 20, 20, 18, 2},
+    {9, 12, 7, 18, 12, 13, 7, 3, 17, 14},
+    {21, 3, 14, 5, 13, 20, 7, 21, 17, 6},
+    {2, 18, 20, 6, 10, 9, 8, 18, 13, 1},
+    {6, 3, 15, 8, 1, 19, 3, 14, 15, 20},
+    {6, 1, 5, 8, 8, 5, 1, 6, 1, 15},
+    {2, 7, 17, 21, 18, 18, 14, 6, 2, 12},
+    {4, 4, 9, 9, 8, 15, 6, 19, 4, 21},
+    {7, 12, 13, 10, 2, 6, 12, 13, 10, 3},
+    {9, 1, 7, 12, 13, 9, 2, 7, 12, 13},
+    {4, 4, 16, 1, 15, 4, 5, 17, 2, 14},
+    {3, 4, 17, 16, 2, 1, 2, 16, 17, 3},
+    {18, 12, 7, 1, 1, 19, 15, 4, 20, 21},
+    {12, 19, 9, 7, 14, 9, 18, 12, 12, 9},
+    {3, 17, 21, 21, 1, 11, 8, 15, 20, 5},
+    {21, 17, 13, 7, 21, 21, 4, 5, 14, 12},
+    {3, 6, 1, 1, 15, 3, 14, 1, 14, 16},
+    {15, 21, 15, 14, 1, 17, 15, 1, 14, 1},
+    {17, 13, 5, 21, 8, 9, 20, 3, 16, 16},
+    {2, 3, 8, 18, 18, 13, 2, 6, 11, 1},
+    {13, 9, 1, 7, 12, 13, 9, 2, 7, 12},
+    {8, 13, 13, 8, 1, 8, 13, 13, 9, 2},
+    {15, 2, 17, 4, 4, 16, 1, 15, 4, 4},
+    {18, 15, 20, 4, 5, 17, 16, 1, 2, 3},
+    {12, 5, 2, 17, 11, 8, 2, 1, 18, 14},
+    {6, 21, 1, 14, 20, 8, 5, 17, 10, 19}
+};
+
+/*
+ * Fully resolved compression schedule.
+ *
+ * Derived offline from QUASICRYSTAL_ROTATIONS, penrose_index(), FIBONACCI and
+ * FIBONACCI_WORD with the same per-index formulas the round functions use
+ * (see mix_golden, exchange_quasi_periodic); the self-test vectors pin the
+ * result. Expanding these lists inline
+ * turns every rotation and shift into an immediate and leaves no table
+ * lookups or modulo in the per-block code.
+ */
+
+/* Message expansion: X(idx, rot1, rot2, shift) */
+#define EXPANSION_SCHEDULE(X) \
+    X(16, 20, 21, 1) X(17, 3, 20, 8) X(18, 10, 6, 3) X(19, 21, 17, 16) \
+    X(20, 20, 17, 5) X(21, 21, 1, 8) X(22, 11, 19, 11) X(23, 13, 10, 10) \
+    X(24, 12, 13, 9) X(25, 2, 6, 10) X(26, 5, 18, 15) X(27, 1, 16, 14) \
+    X(28, 17, 1, 5) X(29, 17, 13, 6) X(30, 1, 10, 15) X(31, 9, 15, 4) \
+    X(32, 2, 21, 1) X(33, 1, 15, 4) X(34, 2, 12, 15) X(35, 15, 10, 4) \
+    X(36, 10, 3, 5) X(37, 12, 13, 12) X(38, 2, 15, 15) X(39, 16, 2, 10) \
+    X(40, 21, 21, 9) X(41, 9, 12, 10) X(42, 21, 3, 15) X(43, 2, 18, 6) \
+    X(44, 6, 3, 5) X(45, 6, 1, 14) X(46, 2, 7, 3) X(47, 4, 4, 8) \
+    X(48, 7, 12, 1) X(49, 9, 1, 16) X(50, 4, 4, 3) X(51, 3, 4, 8) \
+    X(52, 18, 12, 13) X(53, 12, 19, 16) X(54, 3, 17, 11) X(55, 21, 17, 8) \
+    X(56, 3, 6, 9) X(57, 15, 21, 10) X(58, 17, 13, 11) X(59, 2, 3, 6) \
+    X(60, 13, 9, 13) X(61, 8, 13, 14) X(62, 15, 2, 7) X(63, 18, 15, 2)
+
+/*
+ * Rounds: X(r, i, j, type, g_rot1, g_rot2, c_rot1, c_rot2, exchange_mask,
+ *           edge_rot_l, edge_rot_r)
+ * g_rot1/g_rot2 and c_rot1/c_rot2 are the mix rotations of the golden and
+ * complementary words, exchange_mask has bit k set where a type A round
+ * exchanges word k, and the edge rotations apply after rounds 7, 15, ..., 63.
+ */
+#define ROUND_SCHEDULE(X) \
+    X( 0, 0, 1, 1, 14, 11, 14, 11, 0x5F,  0,  0) \
+    X( 1, 1, 2, 0, 11, 11, 13,  2, 0x00,  0,  0) \
+    X( 2, 2, 4, 1, 11,  7, 11,  7, 0x57,  0,  0) \
+    X( 3, 3, 6, 1,  7,  3,  7,  3, 0x2B,  0,  0) \
+    X( 4, 4, 1, 0,  3, 18, 12,  6, 0x00,  0,  0) \
+    X( 5, 5, 5, 1, 18, 12, 18, 12, 0x8A,  0,  0) \
+    X( 6, 6, 3, 0, 12, 16, 17,  4, 0x00,  0,  0) \
+    X( 7, 7, 4, 1, 16,  5, 16,  5, 0xA2, 16, 16) \
+    X( 8, 0, 2, 1, 16, 16, 16, 16, 0x51,  0,  0) \
+    X( 9, 1, 0, 0, 16, 14, 14, 16, 0x00,  0,  0) \
+    X(10, 2, 3, 1, 14, 13, 14, 13, 0x14,  0,  0) \
+    X(11, 3, 3, 1, 13, 11, 13, 11, 0x8A,  0,  0) \
+    X(12, 4, 5, 0, 11, 13,  5, 11, 0x00,  0,  0) \
+    X(13, 5, 6, 1, 13,  2, 13,  2, 0x62,  0,  0) \
+    X(14, 6, 0, 0,  2, 18, 12,  5, 0x00,  0,  0) \
+    X(15, 7, 2, 1, 18,  8, 18,  8, 0x18,  5, 18) \
+    X(16, 0, 5, 1, 20, 20, 20, 20, 0x0C,  0,  0) \
+    X(17, 1, 1, 0, 20, 10, 20, 10, 0x00,  0,  0) \
+    X(18, 2, 7, 1, 10, 11, 10, 11, 0xC3,  0,  0) \
+    X(19, 3, 0, 0, 11, 18, 21, 17, 0x00,  0,  0) \
+    X(20, 4, 6, 1, 18, 18, 18, 18, 0x30,  0,  0) \
+    X(21, 5, 4, 1, 18,  3, 18,  3, 0x18,  0,  0) \
+    X(22, 6, 7, 0,  3,  8, 20,  5, 0x00,  0,  0) \
+    X(23, 7, 7, 1,  8,  4,  8,  4, 0x86, 13,  8) \
+    X(24, 0, 1, 1, 12,  6, 12,  6, 0xC3,  0,  0) \
+    X(25, 1, 2, 0,  6,  4, 12, 13, 0x00,  0,  0) \
+    X(26, 2, 4, 1,  4,  5,  4,  5, 0xF0,  0,  0) \
+    X(27, 3, 6, 0,  5, 21, 15, 15, 0x00,  0,  0) \
+    X(28, 4, 1, 1, 21, 16, 21, 16, 0xBC,  0,  0) \
+    X(29, 5, 5, 1, 16,  4, 16,  4, 0x5E,  0,  0) \
+    X(30, 6, 3, 0,  4, 10,  8, 18, 0x00,  0,  0) \
+    X(31, 7, 4, 1, 10, 11, 10, 11, 0xD7,  9, 10) \
+    X(32, 0, 2, 1,  2, 15,  2, 15, 0x6B,  0,  0) \
+    X(33, 1, 0, 0, 15, 20,  1, 12, 0x00,  0,  0) \
+    X(34, 2, 3, 1, 20, 10, 20, 10, 0x9A,  0,  0) \
+    X(35, 3, 3, 0, 10, 13, 10, 13, 0x00,  0,  0) \
+    X(36, 4, 5, 1, 13, 12, 13, 12, 0xA6,  0,  0) \
+    X(37, 5, 6, 1, 12, 13, 12, 13, 0x53,  0,  0) \
+    X(38, 6, 0, 0, 13,  3,  2,  2, 0x00,  0,  0) \
+    X(39, 7, 2, 1,  3, 18,  3, 18, 0x94, 16,  3) \
+    X(40, 0, 5, 0, 21, 12, 19,  7, 0x00,  0,  0) \
+    X(41, 1, 1, 1, 12, 14, 12, 14, 0x25,  0,  0) \
+    X(42, 2, 7, 1, 14,  6, 14,  6, 0x92,  0,  0) \
+    X(43, 3, 0, 0,  6,  1,  2,  3, 0x00,  0,  0) \
+    X(44, 4, 6, 1,  1,  5,  1,  5, 0x64,  0,  0) \
+    X(45, 5, 4, 1,  5, 14,  5, 14, 0x32,  0,  0) \
+    X(46, 6, 7, 0, 14, 19,  6,  4, 0x00,  0,  0) \
+    X(47, 7, 7, 1, 19, 10, 19, 10, 0x0C,  4, 19) \
+    X(48, 0, 1, 0,  7,  1, 12,  7, 0x00,  0,  0) \
+    X(49, 1, 2, 1,  1, 16,  1, 16, 0x03,  0,  0) \
+    X(50, 2, 4, 1, 16, 16, 16, 16, 0x81,  0,  0) \
+    X(51, 3, 6, 0, 16,  1,  2,  4, 0x00,  0,  0) \
+    X(52, 4, 1, 1,  1,  9,  1,  9, 0x20,  0,  0) \
+    X(53, 5, 5, 1,  9,  8,  9,  8, 0x10,  0,  0) \
+    X(54, 6, 3, 0,  8,  5, 21, 21, 0x00,  0,  0) \
+    X(55, 7, 4, 1,  5, 14,  5, 14, 0x84, 21,  5) \
+    X(56, 0, 2, 0,  3, 21,  1, 14, 0x00,  0,  0) \
+    X(57, 1, 0, 1, 21,  5, 21,  5, 0xA1,  0,  0) \
+    X(58, 2, 3, 1,  5, 18,  5, 18, 0xD0,  0,  0) \
+    X(59, 3, 3, 0, 18, 12, 18, 12, 0x00,  0,  0) \
+    X(60, 4, 5, 1, 12,  8, 12,  8, 0xF4,  0,  0) \
+    X(61, 5, 6, 0,  8,  1, 13, 15, 0x00,  0,  0) \
+    X(62, 6, 0, 1,  1,  1,  1,  1, 0xBD,  0,  0) \
+    X(63, 7, 2, 1,  1, 18,  1, 18, 0xDE, 18,  1)
+
+/*
+ * Finalization: edge protection as for rounds 64 (golden stream) and 65
+ * (complementary), X(rot_l, rot_r, fib) with rot_l/rot_r the round's
+ * quasicrystal rotations 0 and 7 and fib = FIBONACCI[round % 12]; then
+ * stream fusion X(i, rot, penrose) with rot = quasicrystal_rotation(i, i)
+ * and penrose = penrose_index(i).
+ */
+#define FINAL_EDGE_G(X) X(12, 1, 5)
+#define FINAL_EDGE_C(X) X(6, 17, 8)
+
+#define FUSION_SCHEDULE(X) \
+    X(0, 14, 0) X(1, 11, 3) X(2, 11, 6) X(3, 7, 3) \
+    X(4, 3, 12) X(5, 18, 5) X(6, 12, 6) X(7, 16, 25)
+
+/* PHI for penrose_index calculation (fixed-point approximation) */
+#define PHI_FIXED 0x19E3779B9ULL  /* φ * 2^32 */
+
+#endif /* HARMONIA_SCHEDULE_H */
@@ -0,0 +1,335 @@
+/*
+ * HARMONIA - Hot-Path Instrumentation Counters
+ *
+ * Storage and accessors for the per-thread counters declared in
+ * harmonia_stats.h. Without HARMONIA_STATS the accessors report zeros.
+ *
+ * License: MIT
+ */
+
+#include "harmonia_stats.h"
+#include <string.h>
+
+#ifdef HARMONIA_STATS
+
+__thread harmonia_stats harmonia_thread_stats;
+
+void harmonia_stats_get(harmonia_stats *out)
+{
+    *out = harmonia_thread_stats;
+}
+
+void harmonia_stats_reset(void)
+{
+    memset(&harmonia_thread_stats, 0, sizeof(harmonia_thread_stats));
+}
+
+int harmonia_stats_enabled(void)
+{
+    return 1;
+}
+
+void harmonia_stats_accumulate(harmonia_stats *acc, const harmonia_stats *since)
+{
+#define ACCUMULATE(name) acc->name += harmonia_thread_stats.name - since->name;
+    HARMONIA_STATS_FIELDS(ACCUMULATE)
+#undef ACCUMULATE
+}
+
+void harmonia_stats_merge(const harmonia_stats *acc)
+{
+#define MERGE(name) harmonia_thread_stats.name += acc->name;
+    HARMONIA_STATS_FIELDS(MERGE)
+#undef MERGE
+}
+
+#else
+
+void harmonia_stats_get(harmonia_stats *out)
+{
+    memset(out, 0, sizeof(*out));
+}
+
+void harmonia_stats_reset(void)
+{
+}
+
+int harmonia_stats_enabled(void)
+{
+    return 0;
+}
+
+#endif /* HARMONIA_STATS */
+
+/* ============================================================================
+ * SELF-TEST (harmonia_stats_test)
+ * ============================================================================
+ *
+ * Built with HARMONIA_STATS_MAIN together with the v2.2 and NG engines;
+ * checks that each hook counts what its call pattern implies.
+ */
+
+#ifdef HARMONIA_STATS_MAIN
+#include "harmonia.h"
+#include "harmonia_ng.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Blocks of a len-byte message: full blocks plus 1 or 2 padding blocks */
+static uint64_t message_blocks(size_t len)
+{
+    return len / 64 + ((len % 64) < 56 ? 1 : 2);
+}
+
+static int check(const char *name, uint64_t got, uint64_t want)
+{
+    if (got == want) return 0;
+    printf("  FAIL %-22s %llu (expected %llu)\n", name,
+           (unsigned long long)got, (unsigned long long)want);
+    return 1;
+}
+
+static void print_stats(const harmonia_stats *s)
+{
+#define PRINT(name) printf("    %-14s %llu\n", #name, (unsigned long long)s->name);
+    HARMONIA_STATS_FIELDS(PRINT)
+#undef PRINT
+}
+
+/* Streaming v2.2: 10 + 60 + 100 bytes split the buffer every way */
+static int test_streaming(void)
+{
+    uint8_t data[170], digest[32];
+    harmonia_ctx ctx;
+    harmonia_stats s;
+    int failed = 0;
+
+    memset(data, 'a', sizeof(data));
+    harmonia_stats_reset();
+    harmonia_init(&ctx);
+    harmonia_update(&ctx, data, 10);        /* copy 10 */
+    harmonia_update(&ctx, data + 10, 60);   /* copy 54, compress, copy 6 */
+    harmonia_update(&ctx, data + 70, 100);  /* copy 58, compress, copy 42 */
+    harmonia_final(&ctx, digest);           /* 42-byte tail: one padding block */
+    harmonia_stats_get(&s);
+
+    failed += check("updates", s.updates, 3);
+    failed += check("buffer_copies", s.buffer_copies, 5);
+    failed += check("buffer_bytes", s.buffer_bytes, 170);
+    failed += check("blocks", s.blocks, 3);
+    failed += check("scalar+simd blocks", s.scalar_blocks + s.simd_blocks, 3);
+    failed += check("pad_blocks", s.pad_blocks, 1);
+    failed += check("digests", s.digests, 1);
+    if (failed) print_stats(&s);
+    printf("  %s  v2.2 streaming (buffer copies, padding)\n", failed ? "FAIL" : "OK  ");
+    return failed;
+}
+
+/* Streaming scalar NG: the same split as the v2.2 test */
+static int test_ng_streaming(void)
+{
+    uint8_t data[170], digest[32];
+    harmonia_ng_ctx ctx;
+    harmonia_stats s;
+    int failed = 0;
+
+    memset(data, 'a', sizeof(data));
+    harmonia_stats_reset();
+    harmonia_ng_init(&ctx);
+    harmonia_ng_update(&ctx, data, 10);
+    harmonia_ng_update(&ctx, data + 10, 60);
+    harmonia_ng_update(&ctx, data + 70, 100);
+    harmonia_ng_final(&ctx, digest);
+    harmonia_ng(data, 120, digest);         /* 56-byte tail: two padding blocks */
+    harmonia_stats_get(&s);
+
+    failed += check("updates", s.updates, 3);
+    failed += check("buffer_copies", s.buffer_copies, 5);
+    failed += check("buffer_bytes", s.buffer_bytes, 170);
+    failed += check("blocks", s.blocks, 3 + message_blocks(120));
+    failed += check("scalar_blocks", s.scalar_blocks, 3 + message_blocks(120));
+    failed += check("pad_blocks", s.pad_blocks, 1 + 2);
+    failed += check("digests", s.digests, 2);
+    if (failed) print_stats(&s);
+    printf("  %s  NG scalar streaming and one-shot\n", failed ? "FAIL" : "OK  ");
+    return failed;
+}
+
+/* One-shot v2.2 never stages input in a buffer */
+static int test_oneshot(void)
+{
+    uint8_t data[200], digest[32];
+    harmonia_stats s;
+    int failed = 0;
+
+    memset(data, 'b', sizeof(data));
+    harmonia_stats_reset();
+    harmonia(data, 120, digest);
+    harmonia(data, 200, digest);
+    harmonia_stats_get(&s);
+
+    failed += check("blocks", s.blocks, message_blocks(120) + message_blocks(200));
+    failed += check("pad_blocks", s.pad_blocks, 3);
+    failed += check("digests", s.digests, 2);
+    failed += check("buffer_copies", s.buffer_copies, 0);
+    if (failed) print_stats(&s);
+    printf("  %s  v2.2 one-shot\n", failed ? "FAIL" : "OK  ");
+    return failed;
+}
+
+/* Lane utilization of the v2.2 and NG multi-buffer schedulers */
+static int test_lanes(const char *name, int ng)
+{
+    enum { N = 37 };
+    const uint8_t *msgs[N];
+    size_t lens[N];
+    uint8_t data[300], digests[N * 32];
+    uint64_t want = 0;
+    harmonia_stats s;
+    int k, failed = 0;
+
+    memset(data, 'c', sizeof(data));
+    for (k = 0; k < N; k++) {
+        msgs[k] = data;
+        lens[k] = (size_t)(k * 37) % 300;
+        want += message_blocks(lens[k]);
+    }
+
+    harmonia_stats_reset();
+    if (ng) {
+        harmonia_ng_multi(msgs, lens, digests, N);
+    } else {
+        harmonia_multi(msgs, lens, digests, N);
+    }
+    harmonia_stats_get(&s);
+
+    failed += check("blocks", s.blocks, want);
+    failed += check("lane_busy", s.lane_busy, want);
+    failed += check("scalar+simd blocks", s.scalar_blocks + s.simd_blocks, want);
+    failed += check("digests", s.digests, N);
+    if (s.lane_calls == 0 || s.lane_slots % s.lane_calls != 0 || s.lane_busy > s.lane_slots) {
+        printf("  FAIL lane_slots %llu over %llu calls\n",
+               (unsigned long long)s.lane_slots, (unsigned long long)s.lane_calls);
+        failed++;
+    }
+    if (failed) print_stats(&s);
+    printf("  %s  %s lanes (%.0f%% utilization)\n", failed ? "FAIL" : "OK  ", name,
+           s.lane_slots ? 100.0 * (double)s.lane_busy / (double)s.lane_slots : 0.0);
+    return failed;
+}
+
+/* Pool workers hand their counters to the calling thread */
+static int test_batch(void)
+{
+    enum { N = 1000 };
+    const uint8_t **msgs = (const uint8_t **)malloc(N * sizeof(*msgs));
+    size_t *lens = (size_t *)malloc(N * sizeof(*lens));
+    uint8_t *digests = (uint8_t *)malloc(N * HARMONIA_NG_DIGEST_SIZE);
+    uint8_t data[512];
+    uint64_t want = 0;
+    harmonia_stats s;
+    int k, failed = 0;
+
+    if (!msgs || !lens || !digests) {
+        printf("  FAIL allocation\n");
+        free(msgs);
+        free(lens);
+        free(digests);
+        return 1;
+    }
+
+    memset(data, 'd', sizeof(data));
+    for (k = 0; k < N; k++) {
+        msgs[k] = data;
+        lens[k] = (size_t)(k * 61) % 512;
+        want += message_blocks(lens[k]);
+    }
+
+    harmonia_stats_reset();
+    harmonia_ng_batch(msgs, lens, digests, N, 4);
+    harmonia_ng_batch_shutdown();
+    harmonia_stats_get(&s);
+
+    failed += check("blocks", s.blocks, want);
+    failed += check("digests", s.digests, N);
+    if (failed) print_stats(&s);
+    printf("  %s  NG batch on 4 threads (worker counters merged)\n", failed ? "FAIL" : "OK  ");
+
+    free(msgs);
+    free(lens);
+    free(digests);
+    return failed;
+}
+
+/* Tree and Merkle workers: 4 threads count exactly what 1 thread does */
+static int test_tree_merkle(void)
+{
+    enum { TREE_LEN = (4 << 20) + 1000, LEAVES = 10000 };
+    uint8_t *data = (uint8_t *)malloc(TREE_LEN);
+    uint8_t digest[HARMONIA_NG_DIGEST_SIZE];
+    harmonia_stats one, four;
+    int failed = 0;
+
+    if (!data) {
+        printf("  FAIL allocation\n");
+        return 1;
+    }
+    memset(data, 'e', TREE_LEN);
+
+    harmonia_stats_reset();
+    harmonia_ng_tree(data, TREE_LEN, digest, 1);
+    harmonia_stats_get(&one);
+    harmonia_stats_reset();
+    harmonia_ng_tree(data, TREE_LEN, digest, 4);
+    harmonia_stats_get(&four);
+
+    failed += check("tree blocks", four.blocks, one.blocks);
+    failed += check("tree digests", four.digests, one.digests);
+    if (one.blocks < (uint64_t)TREE_LEN / 64) {
+        printf("  FAIL tree blocks %llu below the input's %d\n",
+               (unsigned long long)one.blocks, TREE_LEN / 64);
+        failed++;
+    }
+
+    harmonia_stats_reset();
+    harmonia_ng_merkle_root(data, LEAVES, digest, 1);
+    harmonia_stats_get(&one);
+    harmonia_stats_reset();
+    harmonia_ng_merkle_root(data, LEAVES, digest, 4);
+    harmonia_stats_get(&four);
+
+    failed += check("merkle blocks", four.blocks, one.blocks);
+    failed += check("merkle digests", four.digests, one.digests);
+    if (failed) print_stats(&four);
+    printf("  %s  NG tree and Merkle on 4 threads (worker counters merged)\n",
+           failed ? "FAIL" : "OK  ");
+
+    free(data);
+    return failed;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    printf("\nHARMONIA Instrumentation Self-Test (v2.2 lanes: %s)\n", harmonia_multi_engine());
+    printf("============================================================\n");
+
+    if (!harmonia_stats_enabled()) {
+        printf("  FAIL built without HARMONIA_STATS\n");
+        failed++;
+    } else {
+        failed += test_streaming();
+        failed += test_ng_streaming();
+        failed += test_oneshot();
+        failed += test_lanes("v2.2 multi-buffer", 0);
+        failed += test_lanes("NG multi-buffer", 1);
+        failed += test_batch();
+        failed += test_tree_merkle();
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
+#endif /* HARMONIA_STATS_MAIN */
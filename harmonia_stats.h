@@ -0,0 +1,96 @@
+/*
+ * HARMONIA - Hot-Path Instrumentation
+ *
+ * Optional per-thread counters for the v2.2 and NG engines (blocks
+ * compressed, partial-block copies into ctx->buffer, scalar vs. vector
+ * path, multi-buffer lane utilization) and USDT probe points around
+ * compression and finalization.
+ *
+ *   -DHARMONIA_STATS   count into the calling thread's harmonia_stats
+ *   -DHARMONIA_USDT    emit probes for perf / bpftrace (needs <sys/sdt.h>)
+ *
+ * Both are off by default; the hooks then expand to nothing, so the
+ * engines compile to the same code as without this header. The API below
+ * is always present and reports zeros when counting is compiled out.
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_STATS_H
+#define HARMONIA_STATS_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Counter fields, in struct order */
+#define HARMONIA_STATS_FIELDS(X) \
+    X(blocks)           /* message blocks compressed, every engine and lane */ \
+    X(scalar_blocks)    /* ... of which on a scalar kernel */ \
+    X(simd_blocks)      /* ... of which on a vector kernel */ \
+    X(pad_blocks)       /* padding blocks built by finalization (1 or 2 per digest) */ \
+    X(digests)          /* digests produced */ \
+    X(updates)          /* streaming update calls */ \
+    X(buffer_copies)    /* memcpys into ctx->buffer */ \
+    X(buffer_bytes)     /* bytes copied into ctx->buffer */ \
+    X(lane_calls)       /* multi-buffer kernel calls */ \
+    X(lane_slots)       /* lanes offered by those calls */ \
+    X(lane_busy)        /* lanes carrying a message block (lane_busy / lane_slots = utilization) */
+
+typedef struct {
+#define HARMONIA_STATS_MEMBER(name) uint64_t name;
+    HARMONIA_STATS_FIELDS(HARMONIA_STATS_MEMBER)
+#undef HARMONIA_STATS_MEMBER
+} harmonia_stats;
+
+/*
+ * Counters of the calling thread. Work done by harmonia_ng_batch() pool
+ * workers is credited to the thread that called harmonia_ng_batch().
+ */
+void harmonia_stats_get(harmonia_stats *out);
+
+/* Zero the calling thread's counters */
+void harmonia_stats_reset(void);
+
+/* 1 when built with HARMONIA_STATS, else 0 */
+int harmonia_stats_enabled(void);
+
+/* ============================================================================
+ * ENGINE HOOKS (internal)
+ * ============================================================================ */
+
+#ifdef HARMONIA_STATS
+extern __thread harmonia_stats harmonia_thread_stats;
+
+#define HARMONIA_STAT(field, n) ((void)(harmonia_thread_stats.field += (uint64_t)(n)))
+
+/* acc += (current - since), for handing a worker's counters to the caller */
+void harmonia_stats_accumulate(harmonia_stats *acc, const harmonia_stats *since);
+
+/* current += acc */
+void harmonia_stats_merge(const harmonia_stats *acc);
+#else
+#define HARMONIA_STAT(field, n) ((void)0)
+#endif
+
+/*
+ * Probe points, provider "harmonia":
+ *   compress__start (state_g, nblocks)    before a run of blocks
+ *   compress__done  (state_g, input end)  after it
+ *   final__start / final__done (ctx or state_g, digest) around padding + output
+ *   lane__step      (lanes, busy lanes)   per multi-buffer kernel call
+ */
+#ifdef HARMONIA_USDT
+#include <sys/sdt.h>
+#define HARMONIA_PROBE2(name, a, b) DTRACE_PROBE2(harmonia, name, a, b)
+#else
+#define HARMONIA_PROBE2(name, a, b) ((void)0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARMONIA_STATS_H */
@@ -0,0 +1,542 @@
+/*
+ * HARMONIA-XOF - C Implementation
+ *
+ * Sponge over the 24-round HARMONIA permutation of harmonia_xof.py.
+ *
+ * Each permutation round mixes the four independent word pairs (i, i+4) of
+ * both streams, so the AVX2 path runs all eight mixes of a round in one
+ * 8-lane vector pair: lanes hold [g0..g3, c0..c3] and [g4..g7, c4..c7], with
+ * per-lane rotation amounts. The squeeze itself is a serial chain (each block
+ * is the permutation of the previous one), so single-stream throughput comes
+ * from the width inside the permutation. The backend is bound at runtime.
+ *
+ * License: MIT
+ */
+
+#include "harmonia_xof.h"
+#include "harmonia_cpu.h"
+#include "harmonia_constants.h"
+#include <string.h>
+#include <stdio.h>
+
+#if defined(HARMONIA_X86)
+#include <immintrin.h>
+#endif
+
+/* ============================================================================
+ * CONSTANTS
+ * ============================================================================ */
+
+/* First 24 letters of the Fibonacci word (A=1 golden, B=0 complementary) */
+static const uint8_t XOF_ROUND_TYPE[24] = {
+    1,0,1,1,0,1,0,1,1,0,1,1,0,1,0,1,1,0,1,0,1,1,0,1
+};
+
+/*
+ * Mix rotations per round, in lane order [g0..g3, c0..c3]. The golden word i
+ * uses quasicrystal_rotation(r, i) / (r+1, i+1); the complementary word uses
+ * the partner index j = i + 4 (as in harmonia_xof.py). Derived from
+ * QUASICRYSTAL_ROTATIONS; the self-test vectors pin them.
+ */
+static const uint8_t XOF_ROT1[24][8] = {
+    {14, 11,  5,  4, 11, 13, 11,  5},
+    { 5, 11, 13, 11,  4,  5, 11, 13},
+    {20,  6, 11,  2,  5, 21,  7, 10},
+    {14, 18,  7,  7, 17, 14, 18,  9},
+    { 6, 12, 18,  1,  3, 10,  9, 16},
+    {16,  2,  6, 14, 13, 18,  6, 11},
+    {19, 15, 14, 17,  3, 12, 12, 16},
+    {16, 20,  6, 12,  4,  7,  6, 16},
+    {16,  1,  6,  6, 21, 11, 10,  5},
+    {14, 16, 16,  5, 12, 19, 11, 10},
+    {11, 16, 14,  9, 17, 20,  8, 19},
+    {18,  3, 10, 13, 13,  1, 20, 20},
+    { 4,  5, 11, 13, 11,  5,  4, 11},
+    {13, 10,  3,  5, 12, 13, 11,  4},
+    {12,  3,  5, 19,  5, 11,  2,  5},
+    { 5,  5, 20, 15, 18,  7,  6, 18},
+    {20, 21, 21,  5, 14, 18,  1,  2},
+    { 3, 20, 15, 16, 21,  4, 16, 14},
+    {10,  6, 10,  1, 16, 13, 14,  1},
+    {21, 17, 18, 11,  5, 11, 14,  2},
+    {20, 17,  2, 17, 18, 19, 15,  7},
+    {21,  1,  7,  7,  5, 18, 19, 19},
+    {11, 19,  2, 19, 15, 17,  3, 20},
+    {13, 10, 16, 20,  3,  8, 18,  8},
+};
+static const uint8_t XOF_ROT2[24][8] = {
+    {11, 13, 11,  4,  5, 11, 13, 11},
+    { 6, 11,  2,  5, 21,  7, 10,  1},
+    {18,  7,  7, 17, 14, 18,  9,  9},
+    {12, 18,  1,  3, 10,  9, 16,  2},
+    { 2,  6, 14, 13, 18,  6, 11, 10},
+    {15, 14, 17,  3, 12, 12, 16,  2},
+    {20,  6, 12,  4,  7,  6, 16,  8},
+    { 1,  6,  6, 21, 11, 10,  5,  5},
+    {16, 16,  5, 12, 19, 11, 10, 21},
+    {16, 14,  9, 17, 20,  8, 19, 10},
+    { 3, 10, 13, 13,  1, 20, 20, 18},
+    { 5, 11, 13, 11,  5,  4, 11, 13},
+    {10,  3,  5, 12, 13, 11,  4,  5},
+    { 3,  5, 19,  5, 11,  2,  5, 20},
+    { 5, 20, 15, 18,  7,  6, 18, 14},
+    {21, 21,  5, 14, 18,  1,  2,  8},
+    {20, 15, 16, 21,  4, 16, 14, 17},
+    { 6, 10,  1, 16, 13, 14,  1, 15},
+    {17, 18, 11,  5, 11, 14,  2,  2},
+    {17,  2, 17, 18, 19, 15,  7, 13},
+    { 1,  7,  7,  5, 18, 19, 19, 13},
+    {19,  2, 19, 15, 17,  3, 20,  8},
+    {10, 16, 20,  3,  8, 18,  8,  5},
+    {13, 10,  4,  5, 11, 13, 11,  4},
+};
+
+/* Edge protection (rounds 8, 16) and cross-stream diffusion (rounds 4..20) */
+#define XOF_EDGE_ROT_L(r)   ((r) == 8 ? 16 : 20)
+#define XOF_EDGE_ROT_R(r)   ((r) == 8 ? 5 : 2)
+static const uint8_t XOF_CROSS_ROT[6] = {0, 3, 21, 11, 14, 18};  /* by r / 4 */
+
+/* ============================================================================
+ * PERMUTATION
+ * ============================================================================ */
+
+#define ROTR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+/* Edge protection and cross-stream steps that follow the mixes of round r */
+static void edge_and_cross(uint32_t *g, uint32_t *c, int r)
+{
+    int i;
+
+    if (r > 0 && r % 8 == 0) {
+        uint32_t fib_const = FIBONACCI[r % 12] * 0x9E3779B9U;
+        uint32_t *s[2] = {g, c};
+        int k;
+
+        for (k = 0; k < 2; k++) {
+            uint32_t interaction;
+
+            s[k][0] = ROTR32(s[k][0], XOF_EDGE_ROT_L(r)) ^ fib_const;
+            s[k][7] = ROTL32(s[k][7], XOF_EDGE_ROT_R(r)) ^ ~fib_const;
+            interaction = (s[k][0] ^ s[k][7]) >> 16;
+            s[k][0] += interaction;
+            s[k][7] += interaction;
+        }
+    }
+
+    if (r > 0 && r % 4 == 0) {
+        uint32_t rot = XOF_CROSS_ROT[r / 4];
+
+        for (i = 0; i < 8; i++) {
+            uint32_t temp = g[i] ^ c[(i + 3) % 8];
+            g[i] += ROTR32(temp, rot);
+            c[i] ^= ROTL32(temp, rot);
+        }
+    }
+}
+
+/* Golden / complementary mix of one word pair with resolved rotations */
+static inline void mix_golden(uint32_t *a, uint32_t *b, uint32_t k, uint32_t rot1, uint32_t rot2)
+{
+    uint32_t va = *a, vb = *b, mix;
+
+    va = ROTR32(va, rot1);
+    va = (va + vb) ^ k;
+    vb = ROTL32(vb, rot2);
+    vb = (vb ^ va) + k;
+    mix = (va * 3) ^ (vb * 5);
+    *a = va ^ (mix >> 11);
+    *b = vb ^ (mix << 7);
+}
+
+static inline void mix_complementary(uint32_t *a, uint32_t *b, uint32_t k, uint32_t rot1, uint32_t rot2)
+{
+    uint32_t va = *a, vb = *b;
+
+    va = ROTL32(va ^ vb, rot1) + (k >> 1);
+    vb = ROTR32(vb + va, rot2) ^ (k >> 1);
+    *a = va;
+    *b = vb;
+}
+
+static void permute_scalar(uint32_t *g, uint32_t *c)
+{
+    int r, i;
+
+    for (r = 0; r < HARMONIA_XOF_ROUNDS; r++) {
+        uint32_t k_phi = PHI_CONSTANTS[r % 16];
+        uint32_t k_rec = RECIPROCAL_CONSTANTS[r % 16];
+
+        for (i = 0; i < 4; i++) {
+            if (XOF_ROUND_TYPE[r]) {
+                mix_golden(&g[i], &g[i + 4], k_phi, XOF_ROT1[r][i], XOF_ROT2[r][i]);
+                mix_golden(&c[i], &c[i + 4], k_rec, XOF_ROT1[r][i + 4], XOF_ROT2[r][i + 4]);
+            } else {
+                mix_complementary(&g[i], &g[i + 4], k_phi, XOF_ROT1[r][i], XOF_ROT2[r][i]);
+                mix_complementary(&c[i], &c[i + 4], k_rec, XOF_ROT1[r][i + 4], XOF_ROT2[r][i + 4]);
+            }
+        }
+
+        edge_and_cross(g, c, r);
+    }
+}
+
+#if defined(HARMONIA_X86)
+/* Per-lane variable rotations */
+#define ROTL_V8(x, n) _mm256_or_si256(_mm256_sllv_epi32((x), (n)), \
+                                      _mm256_srlv_epi32((x), _mm256_sub_epi32(_mm256_set1_epi32(32), (n))))
+#define ROTR_V8(x, n) _mm256_or_si256(_mm256_srlv_epi32((x), (n)), \
+                                      _mm256_sllv_epi32((x), _mm256_sub_epi32(_mm256_set1_epi32(32), (n))))
+
+HARMONIA_TARGET_AVX2
+static void permute_avx2(uint32_t *g, uint32_t *c)
+{
+    /* lo = [g0..g3, c0..c3], hi = [g4..g7, c4..c7] */
+    __m256i lo = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)g)),
+                                         _mm_loadu_si128((const __m128i *)c), 1);
+    __m256i hi = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(g + 4))),
+                                         _mm_loadu_si128((const __m128i *)(c + 4)), 1);
+    int r;
+
+    for (r = 0; r < HARMONIA_XOF_ROUNDS; r++) {
+        __m256i rot1 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)XOF_ROT1[r]));
+        __m256i rot2 = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)XOF_ROT2[r]));
+        __m256i k = _mm256_inserti128_si256(_mm256_set1_epi32((int)PHI_CONSTANTS[r % 16]),
+                                            _mm_set1_epi32((int)RECIPROCAL_CONSTANTS[r % 16]), 1);
+        __m256i a = lo, b = hi;
+
+        if (XOF_ROUND_TYPE[r]) {
+            __m256i mix;
+
+            a = _mm256_xor_si256(_mm256_add_epi32(ROTR_V8(a, rot1), b), k);
+            b = _mm256_add_epi32(_mm256_xor_si256(ROTL_V8(b, rot2), a), k);
+            /* (a * 3) ^ (b * 5) without multiplies */
+            mix = _mm256_xor_si256(_mm256_add_epi32(a, _mm256_slli_epi32(a, 1)),
+                                   _mm256_add_epi32(b, _mm256_slli_epi32(b, 2)));
+            a = _mm256_xor_si256(a, _mm256_srli_epi32(mix, 11));
+            b = _mm256_xor_si256(b, _mm256_slli_epi32(mix, 7));
+        } else {
+            __m256i kh = _mm256_srli_epi32(k, 1);
+
+            a = _mm256_add_epi32(ROTL_V8(_mm256_xor_si256(a, b), rot1), kh);
+            b = _mm256_xor_si256(ROTR_V8(_mm256_add_epi32(b, a), rot2), kh);
+        }
+        lo = a;
+        hi = b;
+
+        /* Edge and cross-stream steps touch word positions across lanes:
+         * run them on the scalar layout (7 of 24 rounds) */
+        if (r > 0 && r % 4 == 0) {
+            _mm_storeu_si128((__m128i *)g, _mm256_castsi256_si128(lo));
+            _mm_storeu_si128((__m128i *)c, _mm256_extracti128_si256(lo, 1));
+            _mm_storeu_si128((__m128i *)(g + 4), _mm256_castsi256_si128(hi));
+            _mm_storeu_si128((__m128i *)(c + 4), _mm256_extracti128_si256(hi, 1));
+            edge_and_cross(g, c, r);
+            lo = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)g)),
+                                         _mm_loadu_si128((const __m128i *)c), 1);
+            hi = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(g + 4))),
+                                         _mm_loadu_si128((const __m128i *)(c + 4)), 1);
+        }
+    }
+
+    _mm_storeu_si128((__m128i *)g, _mm256_castsi256_si128(lo));
+    _mm_storeu_si128((__m128i *)c, _mm256_extracti128_si256(lo, 1));
+    _mm_storeu_si128((__m128i *)(g + 4), _mm256_castsi256_si128(hi));
+    _mm_storeu_si128((__m128i *)(c + 4), _mm256_extracti128_si256(hi, 1));
+}
+#endif /* HARMONIA_X86 */
+
+/* ============================================================================
+ * RUNTIME DISPATCH
+ * ============================================================================ */
+
+typedef void (*permute_fn)(uint32_t *g, uint32_t *c);
+
+static permute_fn permute = NULL;
+static const char *backend_name = "scalar";
+
+static void bind_backend(void)
+{
+    unsigned features = harmonia_cpu_features();
+    permute_fn fn = permute_scalar;
+    const char *name = "scalar";
+
+#if defined(HARMONIA_X86)
+    if (features & HARMONIA_CPU_AVX2) {
+        fn = permute_avx2;
+        name = "AVX2";
+    }
+#else
+    (void)features;
+#endif
+
+    backend_name = name;
+    permute = fn;
+}
+
+/* ============================================================================
+ * SPONGE
+ * ============================================================================ */
+
+/* XOR a 32-byte block (big-endian words) into the rate and permute */
+static void absorb_block(harmonia_xof_ctx *ctx, const uint8_t *block)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        ctx->state_g[i] ^= ((uint32_t)block[i*4] << 24) |
+                           ((uint32_t)block[i*4+1] << 16) |
+                           ((uint32_t)block[i*4+2] << 8) |
+                           ((uint32_t)block[i*4+3]);
+    }
+    permute(ctx->state_g, ctx->state_c);
+}
+
+/* Serialize the rate into the output buffer */
+static void extract_block(harmonia_xof_ctx *ctx)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        ctx->buffer[i*4]     = (uint8_t)(ctx->state_g[i] >> 24);
+        ctx->buffer[i*4 + 1] = (uint8_t)(ctx->state_g[i] >> 16);
+        ctx->buffer[i*4 + 2] = (uint8_t)(ctx->state_g[i] >> 8);
+        ctx->buffer[i*4 + 3] = (uint8_t)(ctx->state_g[i]);
+    }
+    ctx->buffer_len = 0;
+}
+
+void harmonia_xof_init(harmonia_xof_ctx *ctx)
+{
+    if (permute == NULL) {
+        bind_backend();
+    }
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+int harmonia_xof_absorb(harmonia_xof_ctx *ctx, const uint8_t *data, size_t len)
+{
+    if (ctx->squeezing) {
+        return -1;
+    }
+
+    if (ctx->buffer_len > 0) {
+        size_t to_copy = HARMONIA_XOF_RATE - ctx->buffer_len;
+        if (to_copy > len) to_copy = len;
+
+        memcpy(ctx->buffer + ctx->buffer_len, data, to_copy);
+        ctx->buffer_len += to_copy;
+        data += to_copy;
+        len -= to_copy;
+
+        if (ctx->buffer_len < HARMONIA_XOF_RATE) return 0;
+        absorb_block(ctx, ctx->buffer);
+        ctx->buffer_len = 0;
+    }
+
+    while (len >= HARMONIA_XOF_RATE) {
+        absorb_block(ctx, data);
+        data += HARMONIA_XOF_RATE;
+        len -= HARMONIA_XOF_RATE;
+    }
+
+    if (len > 0) {
+        memcpy(ctx->buffer, data, len);
+        ctx->buffer_len = len;
+    }
+    return 0;
+}
+
+/* Pad (0x1F ... 0x80), absorb the last block and expose the first output block */
+static void finalize_absorb(harmonia_xof_ctx *ctx)
+{
+    size_t used = ctx->buffer_len;
+
+    memset(ctx->buffer + used, 0, HARMONIA_XOF_RATE - used);
+    ctx->buffer[used] ^= 0x1F;
+    ctx->buffer[HARMONIA_XOF_RATE - 1] ^= 0x80;
+
+    absorb_block(ctx, ctx->buffer);
+    extract_block(ctx);
+    ctx->squeezing = 1;
+}
+
+void harmonia_xof_squeeze(harmonia_xof_ctx *ctx, uint8_t *out, size_t len)
+{
+    if (!ctx->squeezing) {
+        finalize_absorb(ctx);
+    }
+
+    while (len > 0) {
+        size_t take;
+
+        if (ctx->buffer_len == HARMONIA_XOF_RATE) {
+            permute(ctx->state_g, ctx->state_c);
+            extract_block(ctx);
+        }
+
+        take = HARMONIA_XOF_RATE - ctx->buffer_len;
+        if (take > len) take = len;
+
+        memcpy(out, ctx->buffer + ctx->buffer_len, take);
+        ctx->buffer_len += take;
+        out += take;
+        len -= take;
+    }
+}
+
+void harmonia_xof(const uint8_t *data, size_t len, uint8_t *out, size_t out_len)
+{
+    harmonia_xof_ctx ctx;
+
+    harmonia_xof_init(&ctx);
+    harmonia_xof_absorb(&ctx, data, len);
+    harmonia_xof_squeeze(&ctx, out, out_len);
+}
+
+/* ============================================================================
+ * SELF-TEST
+ * ============================================================================ */
+
+int harmonia_xof_self_test(void)
+{
+    /* Output of harmonia_xof.py for the same inputs */
+    static const struct {
+        const char *input;
+        size_t out_len;
+        const char *expected;
+    } vectors[] = {
+        {"", 32, "1db5adf2f89e12b932035e14fa12aea7ce7a42d87848673faf925aee853dc763"},
+        {"", 64, "1db5adf2f89e12b932035e14fa12aea7ce7a42d87848673faf925aee853dc763"
+                 "dc1c968a358423ee0067e530485c4a434e7875e441f208b3f46a01e02564fda2"},
+        {"HARMONIA", 32, "b3b38c0e3bf1eb189a6c96860c21f59975b7f035fe3b20931fc6a6bc15d430b7"},
+        {"HARMONIA", 128, "b3b38c0e3bf1eb189a6c96860c21f59975b7f035fe3b20931fc6a6bc15d430b7"
+                          "eac574f5d98ecafdfad38bba7de90a963e07366594c8059240b530238ed4af58"
+                          "9287a1283dd2e613bd1c4d383ee460f1ec2058fae4321b026b344a8facf7344a"
+                          "010d16dbfeb72ade363d48ab867a18c0263516295c227a444725a7daeb76e80c"},
+        {"The quick brown fox", 32, "4f5595cb800787b6b194f0ee9e6c8f3455762dbacb2d92696a566e6dcdd68f42"},
+        {"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx", 32,
+         "d97b2509a7b57653e67cf741729264b2736a196e965624fd32009c599724a5dd"},
+        {"yyyyyyyyyyyyyyyyyyyyyyyyyyyyyyyy", 48,
+         "c4bdf00120c727f63ff30cc152c20ab2e7f823ebef4e1a1d2e9d4f386ad3c6c1"
+         "8ec76af8cde5bd0c3fdf63b5b3a364fd"},
+        {NULL, 0, NULL}
+    };
+
+    uint8_t out[128], ref[128];
+    char hex[257];
+    harmonia_xof_ctx ctx;
+    size_t k;
+    int i, failed = 0;
+
+    if (permute == NULL) {
+        bind_backend();
+    }
+
+    printf("HARMONIA-XOF v%s Self-Test (%s permutation)\n", HARMONIA_XOF_VERSION, backend_name);
+    printf("============================================================\n");
+
+    for (i = 0; vectors[i].input != NULL; i++) {
+        harmonia_xof((const uint8_t *)vectors[i].input, strlen(vectors[i].input),
+                     out, vectors[i].out_len);
+        for (k = 0; k < vectors[i].out_len; k++) sprintf(hex + 2 * k, "%02x", out[k]);
+
+        if (strcmp(hex, vectors[i].expected) == 0) {
+            printf("  OK   \"%s\" (%zu bytes)\n", vectors[i].input, vectors[i].out_len);
+        } else {
+            printf("  FAIL \"%s\" (%zu bytes)\n", vectors[i].input, vectors[i].out_len);
+            printf("       Expected: %s\n", vectors[i].expected);
+            printf("       Got:      %s\n", hex);
+            failed++;
+        }
+    }
+
+    /* Chunked absorb must match a single absorb */
+    harmonia_xof((const uint8_t *)"Hello, World!", 13, ref, 32);
+    harmonia_xof_init(&ctx);
+    harmonia_xof_absorb(&ctx, (const uint8_t *)"Hello, ", 7);
+    harmonia_xof_absorb(&ctx, (const uint8_t *)"World!", 6);
+    harmonia_xof_squeeze(&ctx, out, 32);
+    if (memcmp(out, ref, 32) == 0) {
+        printf("  OK   chunked absorb\n");
+    } else {
+        printf("  FAIL chunked absorb\n");
+        failed++;
+    }
+
+    /* Incremental squeezes (across block boundaries) continue one stream */
+    harmonia_xof((const uint8_t *)"test", 4, ref, 128);
+    harmonia_xof_init(&ctx);
+    harmonia_xof_absorb(&ctx, (const uint8_t *)"test", 4);
+    harmonia_xof_squeeze(&ctx, out, 16);
+    harmonia_xof_squeeze(&ctx, out + 16, 16);
+    harmonia_xof_squeeze(&ctx, out + 32, 40);
+    harmonia_xof_squeeze(&ctx, out + 72, 56);
+    if (memcmp(out, ref, 128) == 0 && harmonia_xof_absorb(&ctx, out, 1) == -1) {
+        printf("  OK   incremental squeeze\n");
+    } else {
+        printf("  FAIL incremental squeeze\n");
+        failed++;
+    }
+
+    printf("============================================================\n");
+    printf("Result: %s\n", failed ? "FAIL" : "PASS");
+
+    return failed;
+}
+
+/* ============================================================================
+ * MAIN
+ * ============================================================================ */
+
+#ifdef HARMONIA_XOF_MAIN
+#include <stdlib.h>
+#include <time.h>
+
+static void benchmark_squeeze(void)
+{
+    const size_t len = 8 * 1024 * 1024;
+    uint8_t *out = (uint8_t *)malloc(len);
+    harmonia_xof_ctx ctx;
+    clock_t start;
+    double elapsed;
+
+    if (!out) return;
+
+    harmonia_xof_init(&ctx);
+    harmonia_xof_absorb(&ctx, (const uint8_t *)"HARMONIA", 8);
+
+    start = clock();
+    harmonia_xof_squeeze(&ctx, out, len);
+    elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf("\nHARMONIA-XOF Squeeze Benchmark (%s)\n", backend_name);
+    printf("============================================================\n");
+    printf("8 MB output: %.1f MB/s\n", len / elapsed / 1e6);
+
+    free(out);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        if (permute == NULL) bind_backend();
+        benchmark_squeeze();
+        return 0;
+    }
+    if (argc > 1 && strcmp(argv[1], "--test") != 0) {
+        /* Hash a string: 32 bytes by default, or argv[2] bytes */
+        size_t out_len = (argc > 2) ? (size_t)strtoul(argv[2], NULL, 10) : 32;
+        uint8_t *out = (uint8_t *)malloc(out_len ? out_len : 1);
+        size_t k;
+
+        if (!out) return 1;
+        harmonia_xof((const uint8_t *)argv[1], strlen(argv[1]), out, out_len);
+        for (k = 0; k < out_len; k++) printf("%02x", out[k]);
+        printf("\n");
+        free(out);
+        return 0;
+    }
+    return harmonia_xof_self_test();
+}
+#endif
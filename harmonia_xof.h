@@ -0,0 +1,68 @@
+/*
+ * HARMONIA-XOF: Extendable Output Function based on HARMONIA
+ *
+ * Sponge construction over the HARMONIA v2.2 mixing functions, matching
+ * harmonia_xof.py:
+ *   - Rate: 256 bits (32 bytes, the golden stream)
+ *   - Capacity: 256 bits (the complementary stream)
+ *   - Permutation: 24 rounds
+ *   - Padding: 0x1F || 0x00... || 0x80 (0x9F when one byte remains)
+ *
+ * License: MIT
+ */
+
+#ifndef HARMONIA_XOF_H
+#define HARMONIA_XOF_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HARMONIA_XOF_RATE     32
+#define HARMONIA_XOF_ROUNDS   24
+#define HARMONIA_XOF_VERSION  "1.0"
+
+/* Sponge state */
+typedef struct {
+    uint32_t state_g[8];    /* Rate part */
+    uint32_t state_c[8];    /* Capacity part */
+    uint8_t  buffer[32];    /* Absorb: partial block; squeeze: current output block */
+    size_t   buffer_len;    /* Absorb: bytes buffered; squeeze: bytes of buffer used */
+    int      squeezing;     /* Set once the input has been padded */
+} harmonia_xof_ctx;
+
+/*
+ * Initialize a context (all-zero state).
+ */
+void harmonia_xof_init(harmonia_xof_ctx *ctx);
+
+/*
+ * Absorb data. Returns 0 on success, -1 if squeezing has already started.
+ */
+int harmonia_xof_absorb(harmonia_xof_ctx *ctx, const uint8_t *data, size_t len);
+
+/*
+ * Squeeze len output bytes. May be called repeatedly; consecutive calls
+ * continue the same output stream.
+ */
+void harmonia_xof_squeeze(harmonia_xof_ctx *ctx, uint8_t *out, size_t len);
+
+/*
+ * One-shot: absorb data and squeeze out_len bytes.
+ */
+void harmonia_xof(const uint8_t *data, size_t len, uint8_t *out, size_t out_len);
+
+/*
+ * Self-test against the harmonia_xof.py test vectors.
+ * Returns 0 on success, non-zero on failure.
+ */
+int harmonia_xof_self_test(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HARMONIA_XOF_H */
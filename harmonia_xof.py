@@ -96,6 +96,7 @@ class HarmoniaXOF:
         self._buffer = bytearray()
         self._absorbing = True
         self._squeeze_buffer = bytearray()
+        self._blocks_out = 0
 
     def _absorb_block(self, block: bytes):
         """Absorb a RATE-sized block into the state."""
@@ -171,6 +172,11 @@ class HarmoniaXOF:
 
         # Squeeze more blocks as needed
         while length > 0:
+            # Every block after the first is the permutation of the previous
+            if self._blocks_out > 0:
+                self._state_g, self._state_c = _permutation(self._state_g, self._state_c)
+            self._blocks_out += 1
+
             # Extract rate portion
             block = struct.pack('>8I', *self._state_g)
 
@@ -182,10 +188,6 @@ class HarmoniaXOF:
             if take < len(block):
                 self._squeeze_buffer.extend(block[take:])
 
-            # Apply permutation for next block
-            if length > 0:
-                self._state_g, self._state_c = _permutation(self._state_g, self._state_c)
-
         return bytes(output)
 
     def hexdigest(self, length: int) -> str:
@@ -200,6 +202,7 @@ class HarmoniaXOF:
         new._buffer = self._buffer[:]
         new._absorbing = self._absorbing
         new._squeeze_buffer = self._squeeze_buffer[:]
+        new._blocks_out = self._blocks_out
         return new
 
 
@@ -7,7 +7,9 @@
 #include <string.h>
 #include <time.h>
 #include <sys/time.h>
+#include <errno.h>
 #include "harmonia.h"
+#include "harmonia_file.h"
 
 /* Optional: OpenSSL for comparison */
 #ifdef USE_OPENSSL
@@ -57,6 +59,92 @@ static void benchmark(const char *name, size_t data_size, int iterations) {
     free(data);
 }
 
+/*
+ * Streaming benchmark: hash data_size bytes through harmonia_update in
+ * `chunk`-byte pieces. With chunk = 64 every block is a separate compress
+ * call; larger chunks go through the multi-block kernel in one call.
+ */
+static double benchmark_stream(const char *name, size_t data_size, size_t chunk, int iterations) {
+    uint8_t *data;
+    uint8_t digest[32];
+    harmonia_ctx ctx;
+    double start, elapsed;
+    double throughput;
+    size_t pos;
+    int i;
+
+    data = (uint8_t*)malloc(data_size);
+    if (!data) {
+        printf("Memory allocation failed\n");
+        return 0.0;
+    }
+    memset(data, 'x', data_size);
+
+    start = get_time_sec();
+    for (i = 0; i < iterations; i++) {
+        harmonia_init(&ctx);
+        for (pos = 0; pos < data_size; pos += chunk) {
+            size_t n = data_size - pos;
+            harmonia_update(&ctx, data + pos, n < chunk ? n : chunk);
+        }
+        harmonia_final(&ctx, digest);
+    }
+    elapsed = get_time_sec() - start;
+
+    throughput = (data_size * iterations) / elapsed / (1024.0 * 1024.0);
+
+    printf("  %-20s %8zu bytes x %6d = %8.2f MB/s  (%zu-byte updates)\n",
+           name, data_size, iterations, throughput, chunk);
+
+    free(data);
+    return throughput;
+}
+
+/*
+ * Multi-buffer benchmark: hash `count` independent messages of data_size
+ * bytes with one harmonia_multi call, which spreads them over the lanes.
+ */
+static void benchmark_multi(const char *name, size_t data_size, size_t count, int iterations) {
+    const uint8_t **msgs;
+    size_t *lens;
+    uint8_t *data, *digests;
+    double start, elapsed;
+    double throughput;
+    size_t k;
+    int i;
+
+    msgs = (const uint8_t **)malloc(count * sizeof(*msgs));
+    lens = (size_t *)malloc(count * sizeof(*lens));
+    data = (uint8_t*)malloc(data_size * count);
+    digests = (uint8_t*)malloc(count * HARMONIA_DIGEST_SIZE);
+    if (!msgs || !lens || !data || !digests) {
+        printf("Memory allocation failed\n");
+        goto out;
+    }
+    memset(data, 'x', data_size * count);
+    for (k = 0; k < count; k++) {
+        msgs[k] = data + k * data_size;
+        lens[k] = data_size;
+    }
+
+    start = get_time_sec();
+    for (i = 0; i < iterations; i++) {
+        harmonia_multi(msgs, lens, digests, count);
+    }
+    elapsed = get_time_sec() - start;
+
+    throughput = (data_size * count * iterations) / elapsed / (1024.0 * 1024.0);
+
+    printf("  %-20s %8zu bytes x %6d = %8.2f MB/s  (%zu messages/call)\n",
+           name, data_size, iterations, throughput, count);
+
+out:
+    free(msgs);
+    free(lens);
+    free(data);
+    free(digests);
+}
+
 #ifdef USE_OPENSSL
 static void benchmark_sha256(const char *name, size_t data_size, int iterations) {
     uint8_t *data;
@@ -104,6 +192,20 @@ static void run_benchmarks(void) {
     benchmark("XL (100 KB)",      102400, 500);
     benchmark("XXL (1 MB)",       1048576, 50);
 
+    printf("\nMulti-block compression (XXL, streaming):\n");
+    {
+        double per_block = benchmark_stream("XXL (1 MB)", 1048576, 64, 50);
+        double multi = benchmark_stream("XXL (1 MB)", 1048576, 65536, 50);
+        if (per_block > 0.0) {
+            printf("  %-20s %8.2fx\n", "Multi-block gain", multi / per_block);
+        }
+    }
+
+    printf("\nMulti-buffer (%s lanes):\n", harmonia_multi_engine());
+    benchmark_multi("Small (64 B)",     64,     64, 2000);
+    benchmark_multi("Medium (1 KB)",    1024,   64, 500);
+    benchmark_multi("Large (16 KB)",    16384,  64, 40);
+
 #ifdef USE_OPENSSL
     printf("\nSHA-256 (OpenSSL):\n");
     benchmark_sha256("Small (64 B)",     64,     100000);
@@ -116,22 +218,175 @@ static void run_benchmarks(void) {
     printf("\n============================================================\n");
 }
 
+/*
+ * Manifest verification: each line is "<64 hex digits>  <path>", as printed
+ * by harmonia_sum with the same -a engine. For the v2.2 engine, mapped files
+ * are collected into batches of at most VERIFY_BATCH entries and
+ * VERIFY_BATCH_BYTES bytes and checked with harmonia_multi_verify();
+ * anything larger or unmappable, and every file for the other engines, is
+ * hashed on its own through the harmonia_file pipeline. Only mismatching
+ * or unreadable paths are reported, as they are found.
+ */
+#define VERIFY_BATCH        4096
+#define VERIFY_BATCH_BYTES  ((size_t)64 << 20)
+
+typedef struct {
+    char *paths[VERIFY_BATCH];
+    const uint8_t *msgs[VERIFY_BATCH];
+    size_t lens[VERIFY_BATCH];
+    uint8_t expected[VERIFY_BATCH * HARMONIA_DIGEST_SIZE];
+    size_t mismatches[VERIFY_BATCH];
+    size_t count;
+    size_t bytes;
+} verify_batch;
+
+static int hex_value(int c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* Check and release the batch; returns the number of failed entries */
+static size_t verify_flush(verify_batch *b, int threads) {
+    size_t bad = harmonia_multi_verify(b->msgs, b->lens, b->expected, b->count, b->mismatches, threads);
+    size_t k;
+
+    for (k = 0; k < bad; k++) {
+        printf("%s: FAILED\n", b->paths[b->mismatches[k]]);
+    }
+    for (k = 0; k < b->count; k++) {
+        harmonia_file_unmap(b->msgs[k], b->lens[k]);
+        free(b->paths[k]);
+    }
+    b->count = 0;
+    b->bytes = 0;
+    return bad;
+}
+
+static int verify_manifest(const char *manifest, const harmonia_file_engine *e, int threads) {
+    const int lanes = (e == &harmonia_file_engines[0]);
+    verify_batch *b;
+    FILE *f;
+    char *line = NULL;
+    size_t cap = 0, lineno = 0, total = 0, failed = 0, unreadable = 0;
+    ssize_t n;
+
+    f = (strcmp(manifest, "-") == 0) ? stdin : fopen(manifest, "r");
+    if (!f) {
+        perror(manifest);
+        return 1;
+    }
+    b = (verify_batch*)calloc(1, sizeof(*b));
+    if (!b) {
+        printf("Memory allocation failed\n");
+        if (f != stdin) fclose(f);
+        return 1;
+    }
+    harmonia_file_tree_threads = threads;
+
+    while ((n = getline(&line, &cap, f)) > 0) {
+        uint8_t digest[HARMONIA_DIGEST_SIZE], actual[HARMONIA_DIGEST_SIZE];
+        const char *path = line + 2 * HARMONIA_DIGEST_SIZE + 2;
+        const uint8_t *data = NULL;
+        size_t len = 0;
+        int i, err, ok = 1;
+
+        lineno++;
+        while (n > 0 && (line[n - 1] == '\n' || line[n - 1] == '\r')) line[--n] = '\0';
+        if (n == 0) continue;
+        for (i = 0; ok && i < HARMONIA_DIGEST_SIZE && 2 * i + 1 < n; i++) {
+            int hi = hex_value(line[2 * i]), lo = (hi < 0) ? -1 : hex_value(line[2 * i + 1]);
+            ok = hi >= 0 && lo >= 0;
+            digest[i] = (uint8_t)((hi << 4) | lo);
+        }
+        if (!ok || n < 2 * HARMONIA_DIGEST_SIZE + 3 || line[2 * HARMONIA_DIGEST_SIZE] != ' ') {
+            fprintf(stderr, "%s:%zu: malformed line\n", manifest, lineno);
+            unreadable++;
+            continue;
+        }
+        /* Accept the "  path" text and " *path" binary forms */
+        if (line[2 * HARMONIA_DIGEST_SIZE + 1] != ' ' && line[2 * HARMONIA_DIGEST_SIZE + 1] != '*') {
+            path--;
+        }
+        total++;
+
+        err = lanes ? harmonia_file_map(path, &data, &len) : -1;
+        if (err == 0 && len <= VERIFY_BATCH_BYTES) {
+            if (b->bytes + len > VERIFY_BATCH_BYTES) {
+                failed += verify_flush(b, threads);
+            }
+            b->paths[b->count] = strdup(path);
+            if (!b->paths[b->count]) {
+                harmonia_file_unmap(data, len);
+                err = ENOMEM;
+            } else {
+                b->msgs[b->count] = data;
+                b->lens[b->count] = len;
+                memcpy(b->expected + b->count * HARMONIA_DIGEST_SIZE, digest, HARMONIA_DIGEST_SIZE);
+                b->bytes += len;
+                if (++b->count == VERIFY_BATCH) {
+                    failed += verify_flush(b, threads);
+                }
+                continue;
+            }
+        } else if (err == 0) {
+            /* Too large to batch: its own pass over the mapping */
+            e->oneshot(data, len, actual);
+            harmonia_file_unmap(data, len);
+        } else if (err < 0) {
+            err = harmonia_file_hash(path, e, actual);
+        }
+
+        if (err) {
+            fprintf(stderr, "%s: %s\n", path, strerror(err));
+            unreadable++;
+        } else if (memcmp(actual, digest, HARMONIA_DIGEST_SIZE) != 0) {
+            printf("%s: FAILED\n", path);
+            failed++;
+        }
+    }
+    failed += verify_flush(b, threads);
+
+    if (f != stdin) fclose(f);
+    free(line);
+    free(b);
+    fflush(stdout);
+
+    if (failed || unreadable) {
+        fprintf(stderr, "%zu of %zu checksums did not match, %zu entries unreadable\n",
+                failed, total, unreadable);
+        if (failed > 0 && failed == total) {
+            fprintf(stderr, "No checksum matched: was the manifest written with another -a engine than %s?\n",
+                    e->name);
+        }
+        return 1;
+    }
+    if (lanes) {
+        fprintf(stderr, "%zu checksums OK (%s lanes)\n", total, harmonia_multi_engine());
+    } else {
+        fprintf(stderr, "%zu checksums OK (%s)\n", total, e->name);
+    }
+    return 0;
+}
+
 static void print_usage(const char *prog) {
     printf("HARMONIA v%s - Cryptographic Hash Function\n\n", HARMONIA_VERSION);
     printf("Usage:\n");
     printf("  %s --test        Run self-test\n", prog);
     printf("  %s --benchmark   Run performance benchmark\n", prog);
+    printf("  %s --verify MANIFEST [-a engine] [-j N]\n", prog);
+    printf("                   Check harmonia_sum \"<digest>  <path>\" lines with the\n");
+    printf("                   engine that wrote them (default harmonia), N threads\n");
+    printf("                   (default: all CPUs)\n");
     printf("  %s <string>      Hash a string\n", prog);
     printf("  %s               Run self-test (default)\n", prog);
 }
 
 int main(int argc, char **argv) {
-    if (argc < 2) {
-        return harmonia_self_test() ? 0 : 1;
-    }
-
-    if (strcmp(argv[1], "--test") == 0 || strcmp(argv[1], "-t") == 0) {
-        return harmonia_self_test() ? 0 : 1;
+    if (argc < 2 || strcmp(argv[1], "--test") == 0 || strcmp(argv[1], "-t") == 0) {
+        int ok = harmonia_self_test();
+        return (ok && harmonia_multi_self_test() == 0) ? 0 : 1;
     }
 
     if (strcmp(argv[1], "--benchmark") == 0 || strcmp(argv[1], "-b") == 0) {
@@ -140,6 +395,27 @@ int main(int argc, char **argv) {
         return 0;
     }
 
+    if (strcmp(argv[1], "--verify") == 0 && argc >= 3) {
+        const harmonia_file_engine *e = &harmonia_file_engines[0];
+        int threads = 0, i;
+
+        for (i = 3; i < argc; i++) {
+            if ((strcmp(argv[i], "-a") == 0 || strcmp(argv[i], "--algorithm") == 0) && i + 1 < argc) {
+                e = harmonia_file_find_engine(argv[++i]);
+                if (!e) {
+                    fprintf(stderr, "unknown engine '%s'\n", argv[i]);
+                    return 1;
+                }
+            } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--jobs") == 0) && i + 1 < argc) {
+                threads = atoi(argv[++i]);
+            } else {
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        return verify_manifest(argv[2], e, threads);
+    }
+
     if (strcmp(argv[1], "--help") == 0 || strcmp(argv[1], "-h") == 0) {
         print_usage(argv[0]);
         return 0;
@@ -4,6 +4,11 @@ HARMONIA - Reduced Rounds Security Analysis
 
 Tests avalanche effect and bit distribution with varying round counts
 to determine minimum secure round count.
+
+    python3 reduced_rounds_test.py            # round-limited model below
+    python3 reduced_rounds_test.py --v22      # v2.2 itself, cut to r rounds
+                                              # (native harmonia_rounds() when
+                                              # the _harmonia extension is built)
 """
 
 import random
@@ -180,8 +185,18 @@ def test_bit_distribution_reduced(num_rounds: int, samples: int = 500) -> dict:
 
 
 def main():
+    global harmonia_reduced
+    import sys
+
+    if "--v22" in sys.argv:
+        import harmonia_hashlib
+        harmonia_reduced = harmonia_hashlib.harmonia_rounds
+        model = "v2.2 compressor, " + ("native" if harmonia_hashlib.NATIVE else "pure Python")
+    else:
+        model = "round-limited model"
+
     print("=" * 70)
-    print("HARMONIA - REDUCED ROUNDS SECURITY ANALYSIS")
+    print(f"HARMONIA - REDUCED ROUNDS SECURITY ANALYSIS ({model})")
     print("=" * 70)
 
     round_counts = [8, 16, 24, 32, 40, 48, 56, 64]
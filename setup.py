@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+"""
+Build and install the HARMONIA Python package with the native _harmonia
+extension (same sources as `make python`).
+
+    pip install .
+"""
+
+from setuptools import Extension, setup
+
+native = Extension(
+    "_harmonia",
+    sources=[
+        "harmonia_module.c", "harmonia.c", "harmonia_ng_simd.c",
+        "harmonia_ng_tree.c", "harmonia_fast.c", "harmonia_cpu.c",
+        "harmonia_stats.c",
+    ],
+    extra_compile_args=["-O3", "-pthread"],
+    extra_link_args=["-pthread"],
+)
+
+setup(
+    name="harmonia-crypto",
+    version="2.2",
+    description="HARMONIA golden-ratio hash functions (native engines with pure-Python fallback)",
+    license="MIT",
+    py_modules=["harmonia_hashlib", "harmonia", "harmonia_fast", "harmonia_ng", "harmonia_xof"],
+    ext_modules=[native],
+)